@@ -20,9 +20,11 @@
 #include "arch/types.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "arch/runtime/runtime.hpp"
+#include "arch/io/disk/aio.hpp"
 #include "arch/io/disk/filestat.hpp"
 #include "arch/io/disk/pool.hpp"
 #include "arch/io/disk/conflict_resolving.hpp"
+#include "arch/io/disk/datasync_coordinator.hpp"
 #include "arch/io/disk/stats.hpp"
 #include "arch/io/disk/accounting.hpp"
 #include "backtrace.hpp"
@@ -50,14 +52,17 @@ public:
     linux_disk_manager_t(linux_event_queue_t *queue,
                          int batch_factor,
                          int max_concurrent_io_requests,
+                         file_io_backend_t io_backend,
+                         file_direct_io_mode_t direct_io_mode,
                          perfmon_collection_t *stats) :
         stack_stats(stats, "stack"),
         conflict_resolver(stats),
         accounter(batch_factor),
         backend_stats(stats, "backend", accounter.producer),
-        backend(queue, backend_stats.producer, max_concurrent_io_requests),
         outstanding_txn(0)
     {
+        init_backend(queue, max_concurrent_io_requests, io_backend, direct_io_mode);
+
         /* Hook up the `submit_fun`s of the parts of the IO stack that are above the
         queue. (The parts below the queue use the `passive_producer_t` interface instead
         of a callback function.) */
@@ -67,7 +72,16 @@ public:
                                                  &accounter, ph::_1);
 
         /* Hook up everything's `done_fun`. */
-        backend.done_fun = std::bind(&stats_diskmgr_2_t::done, &backend_stats, ph::_1);
+#if AIO_DISKMGR_AVAILABLE
+        if (aio_backend.has()) {
+            aio_backend->done_fun = std::bind(&stats_diskmgr_2_t::done,
+                                              &backend_stats, ph::_1);
+        }
+#endif
+        if (pool_backend.has()) {
+            pool_backend->done_fun = std::bind(&stats_diskmgr_2_t::done,
+                                               &backend_stats, ph::_1);
+        }
         backend_stats.done_fun = std::bind(&accounting_diskmgr_t::done, &accounter, ph::_1);
         accounter.done_fun = std::bind(&conflict_resolving_diskmgr_t::done,
                                        &conflict_resolver, ph::_1);
@@ -174,13 +188,48 @@ public:
     }
 
 private:
+    void init_backend(linux_event_queue_t *queue,
+                      int max_concurrent_io_requests,
+                      file_io_backend_t io_backend,
+                      UNUSED file_direct_io_mode_t direct_io_mode) {
+#if AIO_DISKMGR_AVAILABLE
+        scoped_ptr_t<kernel_io_context_t> context;
+        if (io_backend == file_io_backend_t::io_uring) {
+            context = kernel_io_context_t::create(io_backend, max_concurrent_io_requests);
+            if (!context.has()) {
+                logWRN("io_uring is not available, trying Linux AIO instead.");
+                io_backend = file_io_backend_t::linux_aio;
+            }
+        }
+        if (io_backend == file_io_backend_t::linux_aio) {
+            if (direct_io_mode != file_direct_io_mode_t::direct_desired) {
+                logWRN("Linux AIO only avoids blocking the event loop when direct I/O "
+                       "is enabled. Consider running with --direct-io.");
+            }
+            context = kernel_io_context_t::create(io_backend, max_concurrent_io_requests);
+        }
+        if (context.has()) {
+            aio_backend.init(new aio_diskmgr_t(queue, backend_stats.producer,
+                                               std::move(context),
+                                               max_concurrent_io_requests));
+            return;
+        }
+#endif
+        if (io_backend != file_io_backend_t::blocker_pool) {
+            logWRN("Falling back to the blocker pool for disk I/O.");
+        }
+        pool_backend.init(new pool_diskmgr_t(queue, backend_stats.producer,
+                                             max_concurrent_io_requests));
+    }
+
     /* These fields describe the entire IO stack. At the top level, we allocate a new
     action_t object for each operation and record its callback. Then it passes through
     the conflict resolver, which enforces ordering constraints between IO operations by
     holding back operations that must be run after other, currently-running, operations.
     Then it goes to the account manager, which queues up running IO operations according
     to which account they are part of. Finally the "backend" pops the IO operations
-    from the queue.
+    from the queue. The backend is either a `pool_diskmgr_t` or, if the user asked for
+    it and the kernel supports it, an `aio_diskmgr_t`.
 
     At two points in the process--once as soon as it is submitted, and again right
     as the backend pops it off the queue--its statistics are recorded. The "stack stats"
@@ -193,7 +242,10 @@ private:
     conflict_resolving_diskmgr_t conflict_resolver;
     accounting_diskmgr_t accounter;
     stats_diskmgr_2_t backend_stats;
-    pool_diskmgr_t backend;
+    scoped_ptr_t<pool_diskmgr_t> pool_backend;
+#if AIO_DISKMGR_AVAILABLE
+    scoped_ptr_t<aio_diskmgr_t> aio_backend;
+#endif
 
 
     intptr_t outstanding_txn;
@@ -202,12 +254,18 @@ private:
 };
 
 io_backender_t::io_backender_t(file_direct_io_mode_t _direct_io_mode,
-                               int max_concurrent_io_requests)
+                               int max_concurrent_io_requests,
+                               file_io_backend_t io_backend)
     : direct_io_mode(_direct_io_mode),
+      stats_membership(&get_global_perfmon_collection(), &stats, "io"),
       diskmgr(new linux_disk_manager_t(&linux_thread_pool_t::get_thread()->queue,
                                        DEFAULT_IO_BATCH_FACTOR,
                                        max_concurrent_io_requests,
-                                       &stats)) { }
+                                       io_backend,
+                                       _direct_io_mode,
+                                       &stats)),
+      datasync_coordinator(new datasync_coordinator_t(
+          &stats, &perform_datasync_in_blocker_pool)) { }
 
 io_backender_t::~io_backender_t() { }
 
@@ -216,8 +274,11 @@ file_direct_io_mode_t io_backender_t::get_direct_io_mode() const { return direct
 
 /* Disk file object */
 
-linux_file_t::linux_file_t(scoped_fd_t &&_fd, int64_t _file_size, linux_disk_manager_t *_diskmgr)
-    : fd(std::move(_fd)), file_size(_file_size), diskmgr(_diskmgr) {
+linux_file_t::linux_file_t(scoped_fd_t &&_fd, int64_t _file_size,
+                           linux_disk_manager_t *_diskmgr,
+                           datasync_coordinator_t *_datasync_coordinator)
+    : fd(std::move(_fd)), file_size(_file_size), diskmgr(_diskmgr),
+      datasync_coordinator(_datasync_coordinator) {
     // TODO: Why do we care whether we're in a thread pool?  (Maybe it's that you can't create a
     // file_account_t outside of the thread pool?  But they're associated with the diskmgr,
     // aren't they?)
@@ -284,12 +345,55 @@ void linux_file_t::write_async(int64_t offset, size_t length, const void *buf,
                                wrap_in_datasyncs_t wrap_in_datasyncs) {
     rassert(diskmgr, "No diskmgr has been constructed (are we running without an event queue?)");
     verify_aligned_file_access(file_size, offset, length, buf);
-    diskmgr->submit_write(fd.get(), buf, length, offset,
-                          account == DEFAULT_DISK_ACCOUNT ? default_account->get_account() : account->get_account(),
-                          callback,
+    void *acct = account == DEFAULT_DISK_ACCOUNT
+        ? default_account->get_account()
+        : account->get_account();
+    if (wrap_in_datasyncs == WRAP_IN_DATASYNCS && datasync_coordinator != nullptr) {
+        coro_t::spawn_sometime(std::bind(&linux_file_t::coordinated_write, this,
+                                         offset, length, buf, acct, callback,
+                                         coordinated_writes_drainer.lock()));
+        return;
+    }
+    diskmgr->submit_write(fd.get(), buf, length, offset, acct, callback,
                           wrap_in_datasyncs == WRAP_IN_DATASYNCS);
 }
 
+void linux_file_t::coordinated_write(int64_t offset, size_t length, const void *buf,
+                                     void *account, linux_iocallback_t *callback,
+                                     UNUSED auto_drainer_t::lock_t keepalive) {
+    struct write_callback_t : public linux_iocallback_t, public cond_t {
+        write_callback_t() : errsv(0) { }
+        void on_io_complete() {
+            pulse();
+        }
+        void on_io_failure(int _errsv, int64_t, int64_t) {
+            errsv = _errsv;
+            pulse();
+        }
+        int errsv;
+    };
+
+    // The first datasync makes everything that was written before durable before
+    // the write, like `pool_diskmgr_t` does for `WRAP_IN_DATASYNCS`.
+    int errsv = datasync_coordinator->datasync(fd.get());
+    if (errsv == 0) {
+        write_callback_t write_cb;
+        diskmgr->submit_write(fd.get(), buf, length, offset, account, &write_cb,
+                              false);
+        write_cb.wait_lazily_unordered();
+        errsv = write_cb.errsv;
+    }
+    if (errsv == 0) {
+        errsv = datasync_coordinator->datasync(fd.get());
+    }
+
+    if (errsv == 0) {
+        callback->on_io_complete();
+    } else {
+        callback->on_io_failure(errsv, offset, length);
+    }
+}
+
 void linux_file_t::writev_async(int64_t offset, size_t length,
                                 scoped_array_t<iovec> &&bufs,
                                 file_account_t *account, linux_iocallback_t *callback) {
@@ -580,7 +684,8 @@ file_open_result_t open_file(const char *path, const int mode, io_backender_t *b
     // created file's directory entry is persisted to disk.
     warn_fsync_parent_directory(path);
 
-    out->init(new linux_file_t(std::move(fd), file_size, backender->get_diskmgr_ptr()));
+    out->init(new linux_file_t(std::move(fd), file_size, backender->get_diskmgr_ptr(),
+                                     backender->get_datasync_coordinator()));
 
     return open_res;
 }
@@ -23,21 +23,32 @@ class linux_iocallback_t;
 
 class linux_disk_manager_t;
 
+class datasync_coordinator_t;
+
 class io_backender_t : public home_thread_mixin_debug_only_t {
 public:
     // This takes what is effectively a global flag whether to use O_DIRECT here.  Nothing technical
     // stops us from specifying this on a file-by-file basis, but right now there's no desire for
     // that.  See https://github.com/rethinkdb/rethinkdb/issues/97#issuecomment-19778177 .
+    //
+    // `io_backend` is what we'd like to use for talking to the kernel.  If the running
+    // kernel doesn't support it, we log a warning and fall back to the blocker pool.
     io_backender_t(file_direct_io_mode_t direct_io_mode,
-                   int max_concurrent_io_requests = DEFAULT_MAX_CONCURRENT_IO_REQUESTS);
+                   int max_concurrent_io_requests = DEFAULT_MAX_CONCURRENT_IO_REQUESTS,
+                   file_io_backend_t io_backend = file_io_backend_t::blocker_pool);
     ~io_backender_t();
     linux_disk_manager_t *get_diskmgr_ptr() { return diskmgr.get(); }
+    datasync_coordinator_t *get_datasync_coordinator() {
+        return datasync_coordinator.get();
+    }
     file_direct_io_mode_t get_direct_io_mode() const;
 
 protected:
     const file_direct_io_mode_t direct_io_mode;
     perfmon_collection_t stats;
+    perfmon_membership_t stats_membership;
     scoped_ptr_t<linux_disk_manager_t> diskmgr;
+    scoped_ptr_t<datasync_coordinator_t> datasync_coordinator;
 
 private:
     DISABLE_COPYING(io_backender_t);
@@ -89,7 +100,14 @@ public:
     ~linux_file_t();
 
 private:
-    linux_file_t(scoped_fd_t &&fd, int64_t file_size, linux_disk_manager_t *diskmgr);
+    linux_file_t(scoped_fd_t &&fd, int64_t file_size, linux_disk_manager_t *diskmgr,
+                 datasync_coordinator_t *datasync_coordinator);
+
+    // Implements `WRAP_IN_DATASYNCS` by running the datasyncs through the
+    // `datasync_coordinator_t`, so that they are grouped with those of other files.
+    void coordinated_write(int64_t offset, size_t length, const void *buf,
+                           void *account, linux_iocallback_t *callback,
+                           auto_drainer_t::lock_t keepalive);
     friend file_open_result_t open_file(const char *path, int mode,
                                         io_backender_t *backender,
                                         scoped_ptr_t<file_t> *out);
@@ -98,6 +116,7 @@ private:
     int64_t file_size;
 
     linux_disk_manager_t *diskmgr;
+    datasync_coordinator_t *datasync_coordinator;
 
     scoped_ptr_t<file_account_t> default_account;
 
@@ -105,6 +124,9 @@ private:
     // operations have completed.
     auto_drainer_t file_size_ops_drainer;
 
+    // Keeps the file alive while `coordinated_write` runs.
+    auto_drainer_t coordinated_writes_drainer;
+
     DISABLE_COPYING(linux_file_t);
 };
 
@@ -0,0 +1,432 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/disk/aio.hpp"
+
+#if AIO_DISKMGR_AVAILABLE
+
+#include <limits.h>
+#include <linux/aio_abi.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef __NR_io_uring_setup
+#include <linux/io_uring.h>
+#endif
+
+#include "arch/io/disk.hpp"
+#include "logger.hpp"
+
+/* Linux AIO, through the raw system calls so that we don't need libaio. The kernel
+only performs these asynchronously on files opened with O_DIRECT; on buffered files
+`io_submit()` does the I/O synchronously before returning. */
+
+class linux_aio_context_t : public kernel_io_context_t {
+public:
+    linux_aio_context_t(aio_context_t _kernel_ctx, int queue_depth)
+        : kernel_ctx(_kernel_ctx), iocbs(queue_depth),
+          events(queue_depth) {
+        for (size_t i = 0; i < iocbs.size(); ++i) {
+            free_iocbs.push_back(&iocbs[i]);
+        }
+    }
+
+    ~linux_aio_context_t() {
+        rassert(free_iocbs.size() == iocbs.size());
+        int res = syscall(SYS_io_destroy, kernel_ctx);
+        guarantee_err(res == 0, "Could not destroy AIO context");
+    }
+
+    static scoped_ptr_t<kernel_io_context_t> create(int queue_depth) {
+        aio_context_t kernel_ctx = 0;
+        int res = syscall(SYS_io_setup, queue_depth, &kernel_ctx);
+        if (res != 0) {
+            logWRN("Could not set up Linux AIO (errno %d - %s).",
+                   get_errno(), errno_string(get_errno()).c_str());
+            return scoped_ptr_t<kernel_io_context_t>();
+        }
+        return scoped_ptr_t<kernel_io_context_t>(
+            new linux_aio_context_t(kernel_ctx, queue_depth));
+    }
+
+    size_t submit(pool_diskmgr_action_t **actions, size_t count, int *errsv_out) {
+        std::vector<iocb *> batch;
+        batch.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            guarantee(!free_iocbs.empty());
+            iocb *cb = free_iocbs.back();
+            free_iocbs.pop_back();
+
+            iovec *vecs;
+            size_t vecs_len;
+            actions[i]->get_bufs(&vecs, &vecs_len);
+
+            memset(cb, 0, sizeof(*cb));
+            cb->aio_data = reinterpret_cast<uintptr_t>(actions[i]);
+            cb->aio_lio_opcode = actions[i]->get_is_read()
+                ? IOCB_CMD_PREADV
+                : IOCB_CMD_PWRITEV;
+            cb->aio_fildes = actions[i]->get_fd();
+            cb->aio_buf = reinterpret_cast<uintptr_t>(vecs);
+            cb->aio_nbytes = vecs_len;
+            cb->aio_offset = actions[i]->get_offset();
+            cb->aio_flags = IOCB_FLAG_RESFD;
+            cb->aio_resfd = completion_event.get_notify_fd();
+            batch.push_back(cb);
+        }
+
+        long res;  // NOLINT(runtime/int)
+        do {
+            res = syscall(SYS_io_submit, kernel_ctx, batch.size(), batch.data());
+        } while (res == -1 && get_errno() == EINTR);
+
+        size_t accepted = res == -1 ? 0 : static_cast<size_t>(res);
+        if (accepted < count) {
+            *errsv_out = res == -1 ? get_errno() : EAGAIN;
+            for (size_t i = accepted; i < count; ++i) {
+                free_iocbs.push_back(batch[i]);
+            }
+        }
+        return accepted;
+    }
+
+    void reap(std::vector<std::pair<pool_diskmgr_action_t *, int64_t> > *completions_out) {
+        timespec no_wait;
+        no_wait.tv_sec = 0;
+        no_wait.tv_nsec = 0;
+        for (;;) {
+            long res = syscall(SYS_io_getevents, kernel_ctx, 0,  // NOLINT(runtime/int)
+                               events.size(), events.data(), &no_wait);
+            if (res == -1 && get_errno() == EINTR) {
+                continue;
+            }
+            guarantee_err(res >= 0, "io_getevents failed");
+            for (long i = 0; i < res; ++i) {  // NOLINT(runtime/int)
+                free_iocbs.push_back(reinterpret_cast<iocb *>(events[i].obj));
+                completions_out->push_back(std::make_pair(
+                    reinterpret_cast<pool_diskmgr_action_t *>(events[i].data),
+                    static_cast<int64_t>(events[i].res)));
+            }
+            if (static_cast<size_t>(res) < events.size()) {
+                break;
+            }
+        }
+    }
+
+    system_event_t *get_completion_event() { return &completion_event; }
+
+private:
+    const aio_context_t kernel_ctx;
+    scoped_array_t<iocb> iocbs;
+    std::vector<iocb *> free_iocbs;
+    scoped_array_t<io_event> events;
+    system_event_t completion_event;
+
+    DISABLE_COPYING(linux_aio_context_t);
+};
+
+#ifdef __NR_io_uring_setup
+
+/* io_uring, also through the raw system calls so that we don't need liburing. We only
+use `IORING_OP_READV` and `IORING_OP_WRITEV`, which every kernel that has io_uring
+supports. Unlike Linux AIO, it doesn't block on buffered files. */
+
+class io_uring_context_t : public kernel_io_context_t {
+public:
+    ~io_uring_context_t() {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqes_size);
+        }
+        if (cq_ring != MAP_FAILED) {
+            munmap(cq_ring, cq_ring_size);
+        }
+        if (sq_ring != MAP_FAILED) {
+            munmap(sq_ring, sq_ring_size);
+        }
+        if (ring_fd != -1) {
+            int res = close(ring_fd);
+            guarantee_err(res == 0 || get_errno() == EINTR, "Could not close io_uring");
+        }
+    }
+
+    static scoped_ptr_t<kernel_io_context_t> create(int queue_depth) {
+        scoped_ptr_t<io_uring_context_t> ctx(new io_uring_context_t);
+        int errsv = ctx->init(queue_depth);
+        if (errsv != 0) {
+            logWRN("Could not set up io_uring (errno %d - %s).",
+                   errsv, errno_string(errsv).c_str());
+            return scoped_ptr_t<kernel_io_context_t>();
+        }
+        return scoped_ptr_t<kernel_io_context_t>(ctx.release());
+    }
+
+    size_t submit(pool_diskmgr_action_t **actions, size_t count, int *errsv_out) {
+        // We're the only ones who write the tail; the kernel moves the head forward as
+        // it consumes entries.
+        unsigned tail = *sq_tail;
+        for (size_t i = 0; i < count; ++i) {
+            unsigned index = tail & *sq_mask;
+            io_uring_sqe *sqe = &sqes[index];
+
+            iovec *vecs;
+            size_t vecs_len;
+            actions[i]->get_bufs(&vecs, &vecs_len);
+
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = actions[i]->get_is_read() ? IORING_OP_READV : IORING_OP_WRITEV;
+            sqe->fd = actions[i]->get_fd();
+            sqe->off = actions[i]->get_offset();
+            sqe->addr = reinterpret_cast<uintptr_t>(vecs);
+            sqe->len = vecs_len;
+            sqe->user_data = reinterpret_cast<uintptr_t>(actions[i]);
+            sq_array[index] = index;
+            ++tail;
+        }
+        const unsigned old_head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+        __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+
+        int res;
+        do {
+            res = syscall(__NR_io_uring_enter, ring_fd, count, 0, 0, nullptr, 0);
+        } while (res == -1 && get_errno() == EINTR);
+
+        if (res == -1) {
+            *errsv_out = get_errno();
+            res = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) - old_head;
+        }
+        size_t accepted = static_cast<size_t>(res);
+        if (accepted < count) {
+            if (*errsv_out == 0) {
+                *errsv_out = EAGAIN;
+            }
+            // The kernel only looks at the submission queue while we're inside
+            // `io_uring_enter()`, so it's safe to take back the entries that it didn't
+            // consume.
+            __atomic_store_n(sq_tail, old_head + accepted, __ATOMIC_RELEASE);
+        }
+        return accepted;
+    }
+
+    void reap(std::vector<std::pair<pool_diskmgr_action_t *, int64_t> > *completions_out) {
+        unsigned head = *cq_head;
+        const unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe *cqe = &cqes[head & *cq_mask];
+            completions_out->push_back(std::make_pair(
+                reinterpret_cast<pool_diskmgr_action_t *>(cqe->user_data),
+                static_cast<int64_t>(cqe->res)));
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    system_event_t *get_completion_event() { return &completion_event; }
+
+private:
+    io_uring_context_t()
+        : ring_fd(-1),
+          sq_ring(MAP_FAILED), sq_ring_size(0),
+          cq_ring(MAP_FAILED), cq_ring_size(0),
+          sqes(static_cast<io_uring_sqe *>(MAP_FAILED)), sqes_size(0) { }
+
+    // Returns 0 or an errno value.
+    int init(int queue_depth) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ring_fd = syscall(__NR_io_uring_setup, queue_depth, &params);
+        if (ring_fd == -1) {
+            return get_errno();
+        }
+
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        if (sq_ring == MAP_FAILED) {
+            return get_errno();
+        }
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        if (cq_ring == MAP_FAILED) {
+            return get_errno();
+        }
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(
+            mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) {
+            return get_errno();
+        }
+
+        char *sq = static_cast<char *>(sq_ring);
+        sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        char *cq = static_cast<char *>(cq_ring);
+        cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        int notify_fd = completion_event.get_notify_fd();
+        int res = syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_EVENTFD,
+                          &notify_fd, 1);
+        if (res != 0) {
+            return get_errno();
+        }
+        return 0;
+    }
+
+    int ring_fd;
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    io_uring_cqe *cqes;
+
+    system_event_t completion_event;
+
+    DISABLE_COPYING(io_uring_context_t);
+};
+
+#endif  // __NR_io_uring_setup
+
+scoped_ptr_t<kernel_io_context_t> kernel_io_context_t::create(
+        file_io_backend_t backend, int queue_depth) {
+    switch (backend) {
+    case file_io_backend_t::linux_aio:
+        return linux_aio_context_t::create(queue_depth);
+    case file_io_backend_t::io_uring:
+#ifdef __NR_io_uring_setup
+        return io_uring_context_t::create(queue_depth);
+#else
+        logWRN("This build of RethinkDB was compiled without io_uring support.");
+        return scoped_ptr_t<kernel_io_context_t>();
+#endif
+    case file_io_backend_t::blocker_pool:
+    default:
+        unreachable();
+    }
+}
+
+aio_diskmgr_t::aio_diskmgr_t(linux_event_queue_t *_queue,
+                             passive_producer_t<action_t *> *_source,
+                             scoped_ptr_t<kernel_io_context_t> &&_context,
+                             int max_concurrent_io_requests)
+    : queue(_queue),
+      queue_depth(max_concurrent_io_requests),
+      source(_source),
+      context(std::move(_context)),
+      n_pending(0),
+      fallback(_queue, &fallback_queue, max_concurrent_io_requests) {
+    guarantee(context.has());
+    fallback.done_fun = std::bind(&aio_diskmgr_t::on_fallback_done, this, ph::_1);
+    queue->watch_event(context->get_completion_event(), this);
+    if (source->available->get()) { pump(); }
+    source->available->set_callback(this);
+}
+
+aio_diskmgr_t::~aio_diskmgr_t() {
+    assert_thread();
+    rassert(n_pending == 0);
+    source->available->unset_callback();
+    queue->forget_event(context->get_completion_event(), this);
+}
+
+bool aio_diskmgr_t::can_submit(action_t *action) {
+    if (action->get_is_resize() || action->wrap_in_datasyncs) {
+        return false;
+    }
+    iovec *vecs;
+    size_t vecs_len;
+    action->get_bufs(&vecs, &vecs_len);
+    return vecs_len <= IOV_MAX;
+}
+
+void aio_diskmgr_t::send_to_fallback(action_t *action) {
+    fallback_queue.push(action);
+}
+
+void aio_diskmgr_t::on_fallback_done(action_t *action) {
+    assert_thread();
+    n_pending--;
+    pump();
+    done_fun(action);
+}
+
+void aio_diskmgr_t::submit_batch(std::vector<action_t *> *batch) {
+    size_t submitted = 0;
+    while (submitted < batch->size()) {
+        int errsv = 0;
+        submitted += context->submit(batch->data() + submitted,
+                                     batch->size() - submitted, &errsv);
+        if (submitted < batch->size()) {
+            // The kernel refused this one. The blocker pool will either get it done or
+            // come up with a proper error for it.
+            rassert(errsv != 0);
+            send_to_fallback((*batch)[submitted]);
+            ++submitted;
+        }
+    }
+    batch->clear();
+}
+
+void aio_diskmgr_t::on_source_availability_changed() {
+    assert_thread();
+    if (source->available->get()) pump();
+}
+
+void aio_diskmgr_t::pump() {
+    assert_thread();
+    std::vector<action_t *> batch;
+    while (source->available->get() && n_pending < queue_depth) {
+        action_t *a = source->pop();
+        n_pending++;
+        if (can_submit(a)) {
+            batch.push_back(a);
+        } else {
+            send_to_fallback(a);
+        }
+    }
+    if (!batch.empty()) {
+        submit_batch(&batch);
+    }
+}
+
+void aio_diskmgr_t::on_event(DEBUG_VAR int event) {
+    assert_thread();
+    rassert(event == poll_event_in);
+    context->get_completion_event()->consume_wakey_wakeys();
+
+    std::vector<std::pair<action_t *, int64_t> > completions;
+    context->reap(&completions);
+
+    std::vector<action_t *> finished;
+    finished.reserve(completions.size());
+    for (const auto &pair : completions) {
+        action_t *a = pair.first;
+        if (pair.second == static_cast<int64_t>(a->get_count())) {
+            a->io_result = pair.second;
+            n_pending--;
+            finished.push_back(a);
+        } else {
+            // Errors and short reads or writes are retried on the blocker pool, which
+            // knows how to resume partial transfers and how to report running out of
+            // disk space.
+            send_to_fallback(a);
+        }
+    }
+
+    pump();
+    for (action_t *a : finished) {
+        done_fun(a);
+    }
+}
+
+#endif  // AIO_DISKMGR_AVAILABLE
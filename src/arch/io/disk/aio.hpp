@@ -0,0 +1,102 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_DISK_AIO_HPP_
+#define ARCH_IO_DISK_AIO_HPP_
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "arch/io/disk/pool.hpp"
+#include "arch/runtime/event_queue.hpp"
+#include "arch/runtime/system_event.hpp"
+#include "arch/types.hpp"
+#include "concurrency/queue/passive_producer.hpp"
+#include "concurrency/queue/unlimited_fifo.hpp"
+#include "containers/scoped.hpp"
+
+#if defined(__linux__) && !defined(NO_EVENTFD)
+#define AIO_DISKMGR_AVAILABLE 1
+#else
+#define AIO_DISKMGR_AVAILABLE 0
+#endif
+
+#if AIO_DISKMGR_AVAILABLE
+
+/* `kernel_io_context_t` wraps one of the kernel's native asynchronous I/O interfaces
+(Linux AIO or io_uring). It only knows how to do plain vectored reads and writes;
+everything else is left to the `pool_diskmgr_t`. Completions are signalled on the
+event returned by `get_completion_event()`. */
+
+class kernel_io_context_t {
+public:
+    virtual ~kernel_io_context_t() { }
+
+    /* Hands `actions` to the kernel in a single system call. Returns how many of them,
+    counting from the front, the kernel accepted. If that's fewer than `count`,
+    `*errsv_out` is set to the reason why the next one was refused. */
+    virtual size_t submit(pool_diskmgr_action_t **actions, size_t count,
+                          int *errsv_out) = 0;
+
+    /* Collects the requests that the kernel has completed so far, without blocking.
+    Each entry pairs the action with the number of bytes transferred or a negated
+    errno value. */
+    virtual void reap(
+        std::vector<std::pair<pool_diskmgr_action_t *, int64_t> > *completions_out) = 0;
+
+    virtual system_event_t *get_completion_event() = 0;
+
+    /* Returns an empty pointer if the running kernel doesn't support `backend` or
+    won't give us room for `queue_depth` requests. */
+    static scoped_ptr_t<kernel_io_context_t> create(file_io_backend_t backend,
+                                                    int queue_depth);
+};
+
+/* The AIO disk manager is a drop-in replacement for `pool_diskmgr_t` that submits
+reads and writes to the kernel directly from the event loop, in batches, instead of
+running each one as a blocking system call on a blocker pool thread.
+
+Resizes, writes wrapped in datasyncs and requests that the kernel refuses or completes
+only partially are passed on to an internal `pool_diskmgr_t`, which handles them exactly
+like the default backend would. */
+
+class aio_diskmgr_t : private availability_callback_t,
+                      private linux_event_callback_t,
+                      public home_thread_mixin_debug_only_t {
+public:
+    typedef pool_diskmgr_action_t action_t;
+
+    /* Like with `pool_diskmgr_t`, the `aio_diskmgr_t` draws actions to run from
+    `source` and calls `done_fun` on each one when it's done. */
+    aio_diskmgr_t(linux_event_queue_t *queue, passive_producer_t<action_t *> *source,
+                  scoped_ptr_t<kernel_io_context_t> &&context,
+                  int max_concurrent_io_requests);
+    std::function<void(action_t *)> done_fun;
+    ~aio_diskmgr_t();
+
+private:
+    bool can_submit(action_t *action);
+    void submit_batch(std::vector<action_t *> *batch);
+    void send_to_fallback(action_t *action);
+    void on_fallback_done(action_t *action);
+
+    void on_source_availability_changed();
+    void on_event(int events);
+    void pump();
+
+    linux_event_queue_t *const queue;
+    const int queue_depth;
+    passive_producer_t<action_t *> *source;
+    scoped_ptr_t<kernel_io_context_t> context;
+
+    // Counts both the requests that are in the kernel and those on the fallback.
+    int n_pending;
+
+    unlimited_fifo_queue_t<action_t *> fallback_queue;
+    pool_diskmgr_t fallback;
+
+    DISABLE_COPYING(aio_diskmgr_t);
+};
+
+#endif  // AIO_DISKMGR_AVAILABLE
+
+#endif  // ARCH_IO_DISK_AIO_HPP_
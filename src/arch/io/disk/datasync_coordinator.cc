@@ -0,0 +1,78 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/disk/datasync_coordinator.hpp"
+
+#include <functional>
+
+#include "arch/io/disk.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "arch/timing.hpp"
+#include "threading.hpp"
+
+datasync_coordinator_t::datasync_coordinator_t(
+        perfmon_collection_t *stats,
+        const std::function<int(fd_t)> &_datasync_fn)
+    : datasync_fn(_datasync_fn),
+      pm_datasyncs(secs_to_ticks(1)),
+      pm_writes_per_datasync(secs_to_ticks(1), false),
+      pm_membership(stats,
+                    &pm_datasyncs, "datasyncs",
+                    &pm_writes_per_datasync, "writes_per_datasync") { }
+
+int datasync_coordinator_t::datasync(fd_t fd) {
+    on_thread_t thread_switcher(home_thread());
+
+    file_state_t *file = &files[fd];
+    if (!file->pending.has()) {
+        file->pending = make_counted<sync_t>();
+        coro_t::spawn_sometime(std::bind(&datasync_coordinator_t::run_sync, this,
+                                         fd, file->pending, drainer.lock()));
+    }
+    counted_t<sync_t> sync = file->pending;
+    ++sync->num_requests;
+
+    sync->done.wait_lazily_unordered();
+    return sync->result;
+}
+
+void datasync_coordinator_t::run_sync(fd_t fd,
+                                      counted_t<sync_t> sync,
+                                      UNUSED auto_drainer_t::lock_t keepalive) {
+    assert_thread();
+
+    // The running datasync might not cover writes that completed after it started,
+    // so we wait for it to finish. Meanwhile, new requests join `sync`.
+    auto it = files.find(fd);
+    guarantee(it != files.end());
+    while (it->second.running.has()) {
+        counted_t<sync_t> running = it->second.running;
+        running->done.wait_lazily_unordered();
+        it = files.find(fd);
+        guarantee(it != files.end());
+    }
+
+    // Requests that arrive from now on can't be covered by this datasync.
+    rassert(it->second.pending.get() == sync.get());
+    it->second.pending.reset();
+    it->second.running = sync;
+
+    sync->result = datasync_fn(fd);
+
+    pm_datasyncs.record();
+    pm_writes_per_datasync.record(static_cast<double>(sync->num_requests));
+
+    it = files.find(fd);
+    guarantee(it != files.end() && it->second.running.get() == sync.get());
+    it->second.running.reset();
+    if (!it->second.pending.has()) {
+        files.erase(it);
+    }
+    sync->done.pulse();
+}
+
+int perform_datasync_in_blocker_pool(fd_t fd) {
+    int result;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        result = perform_datasync(fd);
+    });
+    return result;
+}
@@ -0,0 +1,77 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_DISK_DATASYNC_COORDINATOR_HPP_
+#define ARCH_IO_DISK_DATASYNC_COORDINATOR_HPP_
+
+#include <functional>
+#include <map>
+
+#include "arch/io/io_utils.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/cond_var.hpp"
+#include "containers/counted.hpp"
+#include "perfmon/perfmon.hpp"
+
+/* `datasync_coordinator_t` implements group commit for the files that are opened
+through one `io_backender_t`. Every serializer wraps its metablock writes in
+datasyncs, and without coordination each of them issues its own pair of `fdatasync`
+calls, even when the datasyncs of concurrent writes to the same file could be shared.
+
+Instead, files hand their datasyncs to the coordinator. Each file has at most one
+datasync running at a time. Requests that arrive while it runs can't be covered by
+it, so they all wait for, and share, the next datasync of that file. The datasyncs of
+different files don't wait for each other, so a slow device or a busy table doesn't
+hold up the others.
+
+`fdatasync` works on a single file, so the datasyncs of different files can't be
+merged. `syncfs` could merge them per filesystem, but it would also flush unrelated
+dirty data, and before Linux 5.8 it didn't report write-back errors. */
+
+class datasync_coordinator_t : public home_thread_mixin_t {
+public:
+    /* `datasync_fn` performs a single datasync of a file and returns 0 on success
+    and the errno value otherwise. It's called in a coroutine on the home thread. */
+    datasync_coordinator_t(perfmon_collection_t *stats,
+                           const std::function<int(fd_t)> &datasync_fn);
+
+    /* Blocks until every write to `fd` that completed before the call has been made
+    durable. Can be called on any thread. Returns 0 on success and the errno value
+    otherwise. */
+    int datasync(fd_t fd);
+
+private:
+    struct sync_t : public single_threaded_countable_t<sync_t> {
+        sync_t() : num_requests(0), result(0) { }
+        int64_t num_requests;
+        int result;
+        cond_t done;
+    };
+
+    struct file_state_t {
+        // The datasync that is running for the file, if any.
+        counted_t<sync_t> running;
+        // The datasync that new requests for the file join. It starts once `running`
+        // is done.
+        counted_t<sync_t> pending;
+    };
+
+    void run_sync(fd_t fd, counted_t<sync_t> sync, auto_drainer_t::lock_t keepalive);
+
+    const std::function<int(fd_t)> datasync_fn;
+
+    // Only contains the files that have a datasync running or pending.
+    std::map<fd_t, file_state_t> files;
+
+    perfmon_rate_monitor_t pm_datasyncs;
+    perfmon_sampler_t pm_writes_per_datasync;
+    perfmon_multi_membership_t pm_membership;
+
+    auto_drainer_t drainer;
+
+    DISABLE_COPYING(datasync_coordinator_t);
+};
+
+/* Runs `perform_datasync()` in the blocker pool. This is what the `io_backender_t`
+uses as the `datasync_fn` of its coordinator. */
+int perform_datasync_in_blocker_pool(fd_t fd);
+
+#endif  // ARCH_IO_DISK_DATASYNC_COORDINATOR_HPP_
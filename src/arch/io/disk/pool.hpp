@@ -102,6 +102,7 @@ struct pool_diskmgr_action_t
 
 private:
     friend class pool_diskmgr_t;
+    friend class aio_diskmgr_t;
     pool_diskmgr_t *parent;
 
     enum action_type_t {ACTION_READ, ACTION_WRITE, ACTION_RESIZE};
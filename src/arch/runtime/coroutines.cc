@@ -133,10 +133,13 @@ TLS_with_init(coro_globals_t *, cglobals, nullptr);
 // These must be initialized after TLS_cglobals, because perfmon_multi_membership_t
 // construction depends on coro_t::coroutines_have_been_initialized() which in turn
 // depends on cglobals.
-static perfmon_counter_t pm_active_coroutines, pm_allocated_coroutines;
+static perfmon_counter_t pm_active_coroutines, pm_allocated_coroutines,
+    pm_stealable_coroutines, pm_stolen_coroutines;
 static perfmon_multi_membership_t pm_coroutines_membership(&get_global_perfmon_collection(),
     &pm_active_coroutines, "active_coroutines",
-    &pm_allocated_coroutines, "allocated_coroutines");
+    &pm_allocated_coroutines, "allocated_coroutines",
+    &pm_stealable_coroutines, "stealable_coroutines",
+    &pm_stolen_coroutines, "stolen_coroutines");
 
 coro_runtime_t::coro_runtime_t() {
     rassert(!TLS_get_cglobals(), "coro runtime initialized twice on this thread");
@@ -386,6 +389,31 @@ void coro_t::yield_ordered() {  /* class method */
     self()->wait();
 }
 
+void coro_t::yield_stealable() {  /* class method */
+    rassert(self(), "Not in a coroutine context");
+    coro_t *coro = self();
+    /* As in `move_to_thread()`, we must leave the `protected_coros_lru` list of this
+    thread, because we might get resumed on another one. */
+    if (coro->protected_stack_lru_entry_.in_a_list()) {
+        TLS_get_cglobals()->protected_coros_lru.remove(
+            &coro->protected_stack_lru_entry_);
+    }
+    rassert(!coro->notified_);
+    coro->notified_ = true;
+    ++pm_stealable_coroutines;
+    linux_thread_pool_t::get_thread()->message_hub.store_stealable_coro(coro);
+    wait();
+}
+
+void coro_t::resume_stealable(bool stolen) {
+    --pm_stealable_coroutines;
+    if (stolen) {
+        ++pm_stolen_coroutines;
+    }
+    current_thread_ = threadnum_t(linux_thread_pool_t::get_thread_id());
+    on_thread_switch();
+}
+
 void coro_t::notify_now_deprecated() {
     rassert(waiting_);
     rassert(!notified_);
@@ -104,6 +104,10 @@ public:
     /* Like `yield()`, but guarantees that the ordering of coroutines calling
     `yield_ordered()` is maintained. */
     static void yield_ordered();
+    /* Like `yield()`, but lets any idle thread pick the coroutine up, so it may
+    return on a different thread. Don't call this directly; use a
+    `migratable_section_t` instead. */
+    static void yield_stealable();
 
     /* Returns a pointer to the current coroutine, or `NULL` if we are not in a
     coroutine. */
@@ -170,8 +174,15 @@ private:
     the given thread and then suspends the coroutine until that other thread
     picks it up again. Do not call this directly; use `on_thread_t` instead. */
     friend class on_thread_t;
+    friend class migratable_section_t;
     static void move_to_thread(threadnum_t thread);
 
+    /* Called by the message hub that resumes a coroutine stored with
+    `yield_stealable()`. `stolen` is true if that's not the hub of the thread that
+    the coroutine yielded on. */
+    friend class linux_message_hub_t;
+    void resume_stealable(bool stolen);
+
     // Constructor sets up the stack, get_and_init_coro will load a function to be run
     //  at which point the coroutine can be notified
     coro_t();
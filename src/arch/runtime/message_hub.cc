@@ -22,6 +22,7 @@ linux_message_hub_t::linux_message_hub_t(linux_event_queue_t *queue,
     : queue_(queue),
       thread_pool_(thread_pool),
       is_woken_up_(false),
+      is_idle_(true),
       current_thread_(current_thread) {
 
 #ifndef NDEBUG
@@ -31,6 +32,8 @@ linux_message_hub_t::linux_message_hub_t(linux_event_queue_t *queue,
     }
 #endif
 
+    ++thread_pool_->num_idle_threads;
+
     queue_->watch_event(&event_, this);
 }
 
@@ -46,6 +49,10 @@ linux_message_hub_t::~linux_message_hub_t() {
     }
 
     guarantee(incoming_messages_.empty());
+    guarantee(local_stealable_coros_.empty());
+    guarantee(stealable_coros_.empty());
+
+    set_idle(false);
 }
 
 void linux_message_hub_t::do_store_message(threadnum_t nthread, linux_thread_message_t *msg) {
@@ -92,19 +99,40 @@ void linux_message_hub_t::store_message_sometime(threadnum_t nthread, linux_thre
 
 
 void linux_message_hub_t::insert_external_message(linux_thread_message_t *msg) {
-    bool do_wake_up;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        do_wake_up = !check_and_set_is_woken_up();
-        incoming_messages_.push_back(msg);
-    }
+    msg_list_t msgs;
+    msgs.push_back(msg);
+    incoming_messages_.push_all(&msgs);
 
     // Wakey wakey eggs and bakey
-    if (do_wake_up) {
+    if (!check_and_set_is_woken_up()) {
+        event_.wakey_wakey();
+    }
+}
+
+void linux_message_hub_t::store_stealable_coro(coro_t *coro) {
+    local_stealable_coros_.push_back(coro);
+}
+
+bool linux_message_hub_t::has_idle_threads() const {
+    return thread_pool_->num_idle_threads.load() > (is_idle_.load() ? 1 : 0);
+}
+
+void linux_message_hub_t::wake_up() {
+    if (!check_and_set_is_woken_up()) {
         event_.wakey_wakey();
     }
 }
 
+void linux_message_hub_t::set_idle(bool idle) {
+    if (is_idle_.exchange(idle) != idle) {
+        if (idle) {
+            ++thread_pool_->num_idle_threads;
+        } else {
+            --thread_pool_->num_idle_threads;
+        }
+    }
+}
+
 linux_message_hub_t::msg_list_t &linux_message_hub_t::get_priority_msg_list(int priority) {
     rassert(priority >= MESSAGE_SCHEDULER_MIN_PRIORITY);
     rassert(priority <= MESSAGE_SCHEDULER_MAX_PRIORITY);
@@ -120,6 +148,8 @@ void linux_message_hub_t::on_event(int events) {
     // up and so that poll-based event triggering doesn't infinite-loop.
     event_.consume_wakey_wakeys();
 
+    set_idle(false);
+
     // Sort incoming messages into the respective priority_msg_lists_
     sort_incoming_messages_by_priority();
 
@@ -169,6 +199,8 @@ void linux_message_hub_t::on_event(int events) {
         }
     }
 
+    resume_own_stealable_coros();
+
     // We might have left some messages unprocessed.
     // Check if that is the case, and if yes, make sure we are called again.
     for (int i = 0; i < NUM_SCHEDULER_PRIORITIES; ++i) {
@@ -176,32 +208,82 @@ void linux_message_hub_t::on_event(int events) {
             // Place wakey_wakey and then yield to the event processing.
             // It will wake us up again immediately, but can handle a few
             // OS events (such as timers, network messages etc.) in the meantime.
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&incoming_messages_lock_);
-                do_wake_up = !check_and_set_is_woken_up();
+            wake_up();
+            return;
+        }
+    }
+
+    // We have nothing left to do, so help out another thread if we can. We only
+    // steal one coroutine at a time and then go through the event loop again, so
+    // that our own messages don't have to wait behind a series of stolen ones.
+    if (steal_coro()) {
+        wake_up();
+    } else {
+        set_idle(true);
+    }
+}
+
+void linux_message_hub_t::resume_own_stealable_coros() {
+    // Coroutines that make themselves stealable again while we're in here go onto
+    // `local_stealable_coros_`, so this terminates.
+    for (;;) {
+        coro_t *coro;
+        {
+            spinlock_acq_t acq(&stealable_coros_lock_);
+            coro = stealable_coros_.head();
+            if (coro == nullptr) {
+                break;
             }
-            if (do_wake_up) {
-                event_.wakey_wakey();
+            stealable_coros_.remove(coro);
+        }
+        coro->resume_stealable(false);
+    }
+}
+
+bool linux_message_hub_t::steal_coro() {
+    // Start with our right-hand neighbour so that the threads don't all go after
+    // the same victim.
+    for (int i = 1; i < thread_pool_->n_threads; ++i) {
+        linux_message_hub_t *victim = &thread_pool_->threads[
+            (current_thread_.threadnum + i) % thread_pool_->n_threads]->message_hub;
+        coro_t *coro;
+        {
+            spinlock_acq_t acq(&victim->stealable_coros_lock_);
+            coro = victim->stealable_coros_.tail();
+            if (coro != nullptr) {
+                victim->stealable_coros_.remove(coro);
             }
-            break;
+        }
+        if (coro != nullptr) {
+            coro->resume_stealable(true);
+            return true;
         }
     }
+    return false;
 }
 
-void linux_message_hub_t::sort_incoming_messages_by_priority() {
-    // We do this in two steps to release the spinlock faster.
-    // append_and_clear is a very cheap operation, while
-    // assigning each message to a different priority queue
-    // is more expensive.
+bool linux_message_hub_t::wake_idle_thread() {
+    for (int i = 1; i < thread_pool_->n_threads; ++i) {
+        linux_message_hub_t *hub = &thread_pool_->threads[
+            (current_thread_.threadnum + i) % thread_pool_->n_threads]->message_hub;
+        // Whoever flips `is_idle_` gets to wake the thread up, so that several
+        // threads with stealable coroutines don't all pick the same idle one.
+        bool expected = true;
+        if (hub->is_idle_.compare_exchange_strong(expected, false)) {
+            --thread_pool_->num_idle_threads;
+            hub->wake_up();
+            return true;
+        }
+    }
+    return false;
+}
 
-    // 1. Pull the messages
+void linux_message_hub_t::sort_incoming_messages_by_priority() {
+    // 1. Pull the messages. We have to reset `is_woken_up_` first: a message that
+    // gets pushed after we've pulled will then make its sender signal us again.
     msg_list_t new_messages;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        new_messages.append_and_clear(&incoming_messages_);
-        is_woken_up_ = false;
-    }
+    is_woken_up_ = false;
+    incoming_messages_.pop_all(&new_messages);
 
     // 2. Sort the messages into their respective priority queues
     while (linux_thread_message_t *m = new_messages.head()) {
@@ -220,9 +302,7 @@ void linux_message_hub_t::sort_incoming_messages_by_priority() {
 }
 
 bool linux_message_hub_t::check_and_set_is_woken_up() {
-    const bool was_woken_up = is_woken_up_;
-    is_woken_up_ = true;
-    return was_woken_up;
+    return is_woken_up_.exchange(true);
 }
 
 // Pushes messages collected locally global lists available to all
@@ -234,22 +314,31 @@ void linux_message_hub_t::push_messages() {
         thread_queue_t *queue = &queues_[i];
         if (!queue->msg_local_list.empty()) {
             // Transfer messages to the other core
+            linux_message_hub_t *hub = &thread_pool_->threads[i]->message_hub;
+            hub->incoming_messages_.push_all(&queue->msg_local_list);
 
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&thread_pool_->threads[i]->message_hub.incoming_messages_lock_);
-
-                // We only need to do a wake up if we're the first people to do a
-                // wake up.
-                do_wake_up =
-                    !thread_pool_->threads[i]->message_hub.check_and_set_is_woken_up();
-
-                thread_pool_->threads[i]->message_hub.incoming_messages_.append_and_clear(&queue->msg_local_list);
+            // We only need to do a wake up if we're the first people to do a
+            // wake up. Wakey wakey, perhaps eggs and bakey
+            if (!hub->check_and_set_is_woken_up()) {
+                hub->event_.wakey_wakey();
             }
+        }
+    }
 
-            // Wakey wakey, perhaps eggs and bakey
-            if (do_wake_up) {
-                thread_pool_->threads[i]->message_hub.event_.wakey_wakey();
+    // Publish the coroutines that became stealable since the last time. We run them
+    // ourselves unless some idle threads get to them first; we wake up one idle
+    // thread for each of them but the first.
+    if (!local_stealable_coros_.empty()) {
+        size_t num_stealable;
+        {
+            spinlock_acq_t acq(&stealable_coros_lock_);
+            stealable_coros_.append_and_clear(&local_stealable_coros_);
+            num_stealable = stealable_coros_.size();
+        }
+        wake_up();
+        for (size_t i = 1; i < num_stealable; ++i) {
+            if (!wake_idle_thread()) {
+                break;
             }
         }
     }
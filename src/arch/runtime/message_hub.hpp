@@ -4,12 +4,16 @@
 
 #include <pthread.h>
 
+#include <atomic>
+
+#include "arch/runtime/coroutines.hpp"
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/runtime_utils.hpp"
 #include "arch/runtime/system_event.hpp"
 #include "arch/spinlock.hpp"
 #include "config/args.hpp"
 #include "containers/intrusive_list.hpp"
+#include "containers/intrusive_mpsc_queue.hpp"
 #include "threading.hpp"
 
 
@@ -48,6 +52,16 @@ public:
     // (which does not have an event queue)
     void insert_external_message(linux_thread_message_t *msg);
 
+    /* Makes the given coroutine available to every thread. Whichever thread gets to
+    it first resumes it; if no other thread steals it, we run it ourselves. It only
+    becomes visible to the other threads in the next `push_messages()`, so that
+    nobody can resume it before it has finished switching out on this thread. */
+    void store_stealable_coro(coro_t *coro);
+
+    // Returns true if some thread other than this one is idle and could steal a
+    // coroutine from us.
+    bool has_idle_threads() const;
+
     ~linux_message_hub_t();
 
 private:
@@ -61,6 +75,22 @@ private:
 
     msg_list_t &get_priority_msg_list(int priority);
 
+    // Signals our own event so that `on_event()` gets called again.
+    void wake_up();
+
+    // Runs the stealable coroutines that no other thread has stolen from us yet.
+    void resume_own_stealable_coros();
+
+    // Takes a stealable coroutine from another thread and runs it here. Returns false
+    // if there were none to take.
+    bool steal_coro();
+
+    // Wakes up one idle thread other than us, so that it steals one of our
+    // coroutines. Returns false if there were no idle threads.
+    bool wake_idle_thread();
+
+    void set_idle(bool idle);
+
     linux_event_queue_t *const queue_;
     linux_thread_pool_t *const thread_pool_;
 
@@ -68,16 +98,20 @@ private:
     struct thread_queue_t {
         //TODO this doesn't need to be a class anymore
 
-        /* Messages are cached here before being pushed to the global list so that we don't
-        have to acquire the spinlock as often */
+        /* Messages are cached here before being pushed to the other thread's
+        incoming queue, so that we only have to touch memory that's shared with
+        that thread once per event loop iteration */
         msg_list_t msg_local_list;
     } queues_[MAX_THREADS];
 
-    // Must only be used with acquired incoming_messages_lock_
+    // Returns true if somebody has already signalled `event_` since the last time
+    // that we've pulled the incoming messages.
     bool check_and_set_is_woken_up();
-    bool is_woken_up_;
-    msg_list_t incoming_messages_;
-    spinlock_t incoming_messages_lock_;
+    std::atomic<bool> is_woken_up_;
+
+    // Other threads push their messages for us here, we pull them in
+    // `sort_incoming_messages_by_priority()`.
+    intrusive_mpsc_queue_t<linux_thread_message_t> incoming_messages_;
 
     // Use `sort_incoming_messages_by_priority()` to sort incoming_messages_ into
     // these lists.
@@ -87,6 +121,21 @@ private:
     // MESSAGE_SCHEDULER_ORDERED_PRIORITY)
     msg_list_t priority_msg_lists_[NUM_SCHEDULER_PRIORITIES];
 
+    typedef intrusive_list_t<coro_t> coro_list_t;
+
+    // Stealable coroutines that have been stored since the last `push_messages()`.
+    coro_list_t local_stealable_coros_;
+
+    // Stealable coroutines that any thread can resume. We resume them from the front,
+    // other threads steal them from the back.
+    coro_list_t stealable_coros_;
+    spinlock_t stealable_coros_lock_;
+
+    // True while `on_event()` has found nothing left to do. Other threads use this to
+    // decide whom to wake up when they have coroutines to be stolen. The number of
+    // idle threads is kept in `thread_pool_->num_idle_threads`.
+    std::atomic<bool> is_idle_;
+
     void on_event(int events);
 
     // The eventfd (or pipe-based alternative) notified after the first incoming
@@ -8,6 +8,7 @@
 
 #include "config/args.hpp"
 #include "containers/intrusive_list.hpp"
+#include "containers/intrusive_mpsc_queue.hpp"
 
 #ifdef _WIN32
 
@@ -43,7 +44,9 @@ inline fd_t socket_to_fd(int fd) {
 #endif
 
 
-class linux_thread_message_t : public intrusive_list_node_t<linux_thread_message_t> {
+class linux_thread_message_t
+    : public intrusive_list_node_t<linux_thread_message_t>,
+      public intrusive_mpsc_queue_node_t<linux_thread_message_t> {
 public:
     explicit linux_thread_message_t(int _priority)
         : priority(_priority),
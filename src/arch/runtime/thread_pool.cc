@@ -69,7 +69,8 @@ linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affini
       interrupt_message(nullptr),
       generic_blocker_pool(nullptr),
       n_threads(worker_threads + 1),    // we create an extra utility thread
-      do_set_affinity(_do_set_affinity)
+      do_set_affinity(_do_set_affinity),
+      num_idle_threads(0)
 {
     rassert(n_threads > 1);             // we want at least one non-utility thread
     rassert(n_threads <= MAX_THREADS);
@@ -103,6 +103,10 @@ public:
     int n_threads;
     bool do_set_affinity;
 
+    // How many threads' message hubs currently have nothing to do. Used to decide
+    // whether it's worth making a coroutine stealable.
+    std::atomic<int> num_idle_threads;
+
 #ifdef _WIN32
     static linux_thread_pool_t *get_global_thread_pool();
 #endif
@@ -105,6 +105,14 @@ enum class file_direct_io_mode_t {
     buffered_desired
 };
 
+// How the disk manager hands reads and writes to the kernel.  See
+// arch/io/disk/pool.hpp and arch/io/disk/aio.hpp.
+enum class file_io_backend_t {
+    blocker_pool,  // blocking system calls on a pool of helper threads
+    linux_aio,     // native Linux AIO, submitted from the event loop
+    io_uring       // io_uring, submitted from the event loop
+};
+
 // A linux file.  It expects reads and writes and buffers to have an
 // alignment of DEVICE_BLOCK_SIZE.
 class file_t {
@@ -37,7 +37,7 @@ public:
 
     const btree_key_t *key() const {
         guarantee(buf_.has());
-        return key_;
+        return key_.btree_key();
     }
     const void *value() const {
         guarantee(buf_.has());
@@ -50,7 +50,9 @@ public:
     void reset();
 
 private:
-    const btree_key_t *key_;
+    // A copy, because the keys of leaf nodes that store them relative to a prefix
+    // only stay valid until the leaf iterator moves on.
+    store_key_t key_;
     const void *value_;
     movable_t<counted_buf_lock_and_read_t> buf_;
 
@@ -82,6 +82,146 @@ const int SKIP_ENTRY_RESERVED = 251;
 // itself three bytes, so it can't fit in a slot of size one or two. We don't
 // expect to actually see many entries of size one or two, but it pays to be
 // thorough.
+//
+// A node in the prefix-compressed format (see `prefix_leaf_magic()`) also
+// stores a key prefix, right after the pair offsets, and stores the keys of
+// its entries relative to that prefix:
+//
+// [magic]...[tstamp_cutpoint][off0][off1]...[offN-1][prefix size][prefix]........[tstamp][entry]...
+//
+//   [key size][shared][suffix][btree value]        -- a live entry
+//   [255][key size][shared][suffix]                -- a deletion entry
+//
+// Such a key consists of the first "shared" bytes of the node's prefix,
+// followed by the "key size - shared" bytes of the suffix.  Each entry says how
+// much of the prefix it uses, so that inserting a key that doesn't start with
+// the prefix never makes us rewrite the other entries.  Skip entries look the
+// same in both formats.
+//
+// Nodes start out in the plain format.  When `garbage_collect()` makes room
+// for a new entry, it stores the keys relative to their longest common prefix
+// if that saves space (see `choose_key_prefix()`).
+
+
+// The last byte of the magic of a prefix-compressed leaf node; the rest is the
+// value type's `btree_leaf_magic()`.  Checking for it lets the functions that
+// don't get a `value_sizer_t` (such as `find_key()` and the iterators) tell
+// the two formats apart.
+const char PREFIX_LEAF_MAGIC_TAG = '+';
+
+block_magic_t prefix_leaf_magic(value_sizer_t *sizer) {
+    block_magic_t magic = sizer->btree_leaf_magic();
+    rassert(magic.bytes[sizeof(magic.bytes) - 1] != PREFIX_LEAF_MAGIC_TAG);
+    magic.bytes[sizeof(magic.bytes) - 1] = PREFIX_LEAF_MAGIC_TAG;
+    return magic;
+}
+
+bool is_leaf_magic(value_sizer_t *sizer, block_magic_t magic) {
+    return magic == sizer->btree_leaf_magic() || magic == prefix_leaf_magic(sizer);
+}
+
+bool has_key_prefix(const leaf_node_t *node) {
+    return node->magic.bytes[sizeof(node->magic.bytes) - 1] == PREFIX_LEAF_MAGIC_TAG;
+}
+
+// The prefix that a node's keys are stored relative to.  `compressed` is false
+// for plain-format nodes, which store whole keys.
+struct key_prefix_t {
+    bool compressed;
+    int size;
+    const uint8_t *bytes;
+};
+
+key_prefix_t plain_key_prefix() {
+    key_prefix_t ret;
+    ret.compressed = false;
+    ret.size = 0;
+    ret.bytes = nullptr;
+    return ret;
+}
+
+const uint8_t *key_prefix_storage(const leaf_node_t *node) {
+    return reinterpret_cast<const uint8_t *>(node->pair_offsets + node->num_pairs);
+}
+
+uint8_t *key_prefix_storage(leaf_node_t *node) {
+    return reinterpret_cast<uint8_t *>(node->pair_offsets + node->num_pairs);
+}
+
+key_prefix_t get_key_prefix(const leaf_node_t *node) {
+    if (!has_key_prefix(node)) {
+        return plain_key_prefix();
+    }
+    const uint8_t *storage = key_prefix_storage(node);
+    key_prefix_t ret;
+    ret.compressed = true;
+    ret.size = storage[0];
+    ret.bytes = storage + 1;
+    return ret;
+}
+
+int key_prefix_storage_size(const key_prefix_t &prefix) {
+    return prefix.compressed ? 1 + prefix.size : 0;
+}
+
+bool same_key_prefix(const key_prefix_t &x, const key_prefix_t &y) {
+    return x.compressed == y.compressed && x.size == y.size
+        && (x.bytes == y.bytes || memcmp(x.bytes, y.bytes, x.size) == 0);
+}
+
+// The offset right after the pair offsets and the key prefix, i.e. the lowest
+// offset that `frontmost` may have.
+int pair_offsets_end(const leaf_node_t *node) {
+    return offsetof(leaf_node_t, pair_offsets) + sizeof(uint16_t) * node->num_pairs
+        + key_prefix_storage_size(get_key_prefix(node));
+}
+
+// Changes `num_pairs`, moving the key prefix along.  When adding pair offsets,
+// call this before writing them.  When removing some, call it after moving the
+// ones that remain into place.
+void set_num_pairs(leaf_node_t *node, int num_pairs) {
+    if (has_key_prefix(node)) {
+        const uint8_t *storage = key_prefix_storage(node);
+        memmove(node->pair_offsets + num_pairs, storage, 1 + storage[0]);
+    }
+    node->num_pairs = num_pairs;
+}
+
+int common_prefix_size(const uint8_t *x, int x_size, const uint8_t *y, int y_size) {
+    int n = std::min(x_size, y_size);
+    int i = 0;
+    while (i < n && x[i] == y[i]) {
+        ++i;
+    }
+    return i;
+}
+
+// How many bytes `key` shares with `prefix`.
+int shared_size(const key_prefix_t &prefix, const btree_key_t *key) {
+    return common_prefix_size(prefix.bytes, prefix.size, key->contents, key->size);
+}
+
+// The size of `key` once it's stored relative to `prefix`.
+int encoded_key_size(const key_prefix_t &prefix, const btree_key_t *key) {
+    if (prefix.compressed) {
+        return 2 + key->size - shared_size(prefix, key);
+    } else {
+        return key->full_size();
+    }
+}
+
+// Stores `key` relative to `prefix` at `out`.
+void encode_key(const key_prefix_t &prefix, const btree_key_t *key, char *out) {
+    if (prefix.compressed) {
+        int shared = shared_size(prefix, key);
+        uint8_t *p = reinterpret_cast<uint8_t *>(out);
+        p[0] = key->size;
+        p[1] = shared;
+        memcpy(p + 2, key->contents + shared, key->size - shared);
+    } else {
+        memcpy(out, key, key->full_size());
+    }
+}
 
 
 struct entry_t;
@@ -104,27 +244,85 @@ bool entry_is_skip(const entry_t *p) {
     return !entry_is_deletion(p) && !entry_is_live(p);
 }
 
-const btree_key_t *entry_key(const entry_t *p) {
-    if (entry_is_deletion(p)) {
-        return reinterpret_cast<const btree_key_t *>(1 + reinterpret_cast<const char *>(p));
+// Returns the key as it's stored in a live or deletion entry.
+const uint8_t *entry_encoded_key(const entry_t *p) {
+    const uint8_t *q = reinterpret_cast<const uint8_t *>(p);
+    return entry_is_deletion(p) ? q + 1 : q;
+}
+
+// The size of a key that's stored relative to `prefix` at `encoded_key`.
+int encoded_key_size(const key_prefix_t &prefix, const uint8_t *encoded_key) {
+    if (prefix.compressed) {
+        return 2 + encoded_key[0] - encoded_key[1];
     } else {
-        return reinterpret_cast<const btree_key_t *>(p);
+        return 1 + encoded_key[0];
     }
 }
 
-const void *entry_value(const entry_t *p) {
+// Returns the key of a live or deletion entry.  Plain-format nodes store whole
+// keys, so we return a pointer into the node; otherwise we assemble the key in
+// `*buf`.
+const btree_key_t *entry_key(const key_prefix_t &prefix, const entry_t *p,
+                             store_key_t *buf) {
+    const uint8_t *encoded = entry_encoded_key(p);
+    if (!prefix.compressed) {
+        return reinterpret_cast<const btree_key_t *>(encoded);
+    }
+    int size = encoded[0];
+    int shared = encoded[1];
+    rassert(shared <= size && shared <= prefix.size);
+    buf->set_size(size);
+    memcpy(buf->contents(), prefix.bytes, shared);
+    memcpy(buf->contents() + shared, encoded + 2, size - shared);
+    return buf->btree_key();
+}
+
+const btree_key_t *entry_key(const leaf_node_t *node, const entry_t *p,
+                             store_key_t *buf) {
+    return entry_key(get_key_prefix(node), p, buf);
+}
+
+// Compares `key` to the key of a live or deletion entry, like
+// `btree_key_cmp()` does, without assembling the latter.  `key_shared` must be
+// `shared_size(prefix, key)`.
+int key_cmp_entry(const key_prefix_t &prefix, const btree_key_t *key, int key_shared,
+                  const entry_t *p) {
+    const uint8_t *encoded = entry_encoded_key(p);
+    if (!prefix.compressed) {
+        return btree_key_cmp(key, reinterpret_cast<const btree_key_t *>(encoded));
+    }
+    int size = encoded[0];
+    int shared = encoded[1];
+    if (key_shared < shared) {
+        // Both keys start with the first `key_shared` bytes of the prefix.  The
+        // entry's key continues with the prefix, and `key` doesn't.
+        if (key_shared == key->size) {
+            return -1;
+        }
+        return key->contents[key_shared] < prefix.bytes[key_shared] ? -1 : 1;
+    }
+    // Both keys start with the first `shared` bytes of the prefix.
+    return sized_strcmp(key->contents + shared, key->size - shared,
+                        encoded + 2, size - shared);
+}
+
+const void *entry_value(const key_prefix_t &prefix, const entry_t *p) {
     if (entry_is_deletion(p)) {
         return nullptr;
     } else {
-        return reinterpret_cast<const char *>(p) + entry_key(p)->full_size();
+        return reinterpret_cast<const char *>(p) + encoded_key_size(prefix, entry_encoded_key(p));
     }
 }
 
-int entry_size(value_sizer_t *sizer, const entry_t *p) {
+const void *entry_value(const leaf_node_t *node, const entry_t *p) {
+    return entry_value(get_key_prefix(node), p);
+}
+
+int entry_size(value_sizer_t *sizer, const key_prefix_t &prefix, const entry_t *p) {
     uint8_t code = *reinterpret_cast<const uint8_t *>(p);
     switch (code) {
     case DELETE_ENTRY_CODE:
-        return 1 + entry_key(p)->full_size();
+        return 1 + encoded_key_size(prefix, entry_encoded_key(p));
     case SKIP_ENTRY_CODE_ONE:
         return 1;
     case SKIP_ENTRY_CODE_TWO:
@@ -133,7 +331,62 @@ int entry_size(value_sizer_t *sizer, const entry_t *p) {
         return 3 + *reinterpret_cast<const uint16_t *>(1 + reinterpret_cast<const char *>(p));
     default:
         rassert(code <= MAX_KEY_SIZE);
-        return entry_key(p)->full_size() + sizer->size(entry_value(p));
+        return encoded_key_size(prefix, entry_encoded_key(p)) + sizer->size(entry_value(prefix, p));
+    }
+}
+
+int entry_size(value_sizer_t *sizer, const leaf_node_t *node, const entry_t *p) {
+    return entry_size(sizer, get_key_prefix(node), p);
+}
+
+// The size of a live entry for `key` and `value`, or of a deletion entry for
+// `key` if `value` is null, with the key stored relative to `prefix`.
+int new_entry_size(value_sizer_t *sizer, const key_prefix_t &prefix,
+                   const btree_key_t *key, const void *value) {
+    if (value == nullptr) {
+        return 1 + encoded_key_size(prefix, key);
+    } else {
+        return encoded_key_size(prefix, key) + sizer->size(value);
+    }
+}
+
+// Writes the entry that `new_entry_size()` describes to `out`.
+void write_entry(value_sizer_t *sizer, const key_prefix_t &prefix,
+                 const btree_key_t *key, const void *value, char *out) {
+    if (value == nullptr) {
+        *out = static_cast<char>(DELETE_ENTRY_CODE);
+        encode_key(prefix, key, out + 1);
+    } else {
+        encode_key(prefix, key, out);
+        memcpy(out + encoded_key_size(prefix, key), value, sizer->size(value));
+    }
+}
+
+// The size of the live or deletion entry `p` of `fro` once its key is stored
+// relative to `prefix`.
+int copied_entry_size(value_sizer_t *sizer, const leaf_node_t *fro, const entry_t *p,
+                      const key_prefix_t &prefix) {
+    const key_prefix_t fro_prefix = get_key_prefix(fro);
+    if (same_key_prefix(fro_prefix, prefix)) {
+        return entry_size(sizer, fro_prefix, p);
+    }
+    store_key_t buf;
+    return new_entry_size(sizer, prefix, entry_key(fro_prefix, p, &buf),
+                          entry_value(fro_prefix, p));
+}
+
+// Copies the live or deletion entry `p` of `fro` to `out`, storing its key
+// relative to `prefix`.  `out` may overlap the entry if the key doesn't need to
+// be stored differently.
+void copy_entry(value_sizer_t *sizer, const leaf_node_t *fro, const entry_t *p,
+                const key_prefix_t &prefix, char *out) {
+    const key_prefix_t fro_prefix = get_key_prefix(fro);
+    if (same_key_prefix(fro_prefix, prefix)) {
+        memmove(out, p, entry_size(sizer, fro_prefix, p));
+    } else {
+        store_key_t buf;
+        write_entry(sizer, prefix, entry_key(fro_prefix, p, &buf),
+                    entry_value(fro_prefix, p), out);
     }
 }
 
@@ -159,7 +412,7 @@ struct entry_iter_t {
     void step(value_sizer_t *sizer, const leaf_node_t *node) {
         rassert(!done(sizer));
 
-        offset += entry_size(sizer, get_entry(node, offset)) + (offset < node->tstamp_cutpoint ? sizeof(repli_timestamp_t) : 0);
+        offset += entry_size(sizer, node, get_entry(node, offset)) + (offset < node->tstamp_cutpoint ? sizeof(repli_timestamp_t) : 0);
     }
 
     bool done(value_sizer_t *sizer) const {
@@ -175,17 +428,19 @@ struct entry_iter_t {
     }
 };
 
-void strprint_entry(std::string *out, value_sizer_t *sizer, const entry_t *entry) {
+void strprint_entry(std::string *out, value_sizer_t *sizer, const leaf_node_t *node,
+                    const entry_t *entry) {
+    store_key_t buf;
     if (entry_is_live(entry)) {
-        const btree_key_t *key = entry_key(entry);
+        const btree_key_t *key = entry_key(node, entry, &buf);
         *out += strprintf("%.*s:", static_cast<int>(key->size), key->contents);
-        *out += strprintf("[entry size=%d]", entry_size(sizer, entry));
-        *out += strprintf("[value size=%d]", sizer->size(entry_value(entry)));
+        *out += strprintf("[entry size=%d]", entry_size(sizer, node, entry));
+        *out += strprintf("[value size=%d]", sizer->size(entry_value(node, entry)));
     } else if (entry_is_deletion(entry)) {
-        const btree_key_t *key = entry_key(entry);
+        const btree_key_t *key = entry_key(node, entry, &buf);
         *out += strprintf("%.*s:[deletion]", static_cast<int>(key->size), key->contents);
     } else if (entry_is_skip(entry)) {
-        *out += strprintf("[skip %d]", entry_size(sizer, entry));
+        *out += strprintf("[skip %d]", entry_size(sizer, node, entry));
     } else {
         *out += strprintf("[code %d]", *reinterpret_cast<const uint8_t *>(entry));
     }
@@ -203,10 +458,15 @@ std::string strprint_leaf(value_sizer_t *sizer, const leaf_node_t *node) {
     }
     out += strprintf("\n");
 
+    if (has_key_prefix(node)) {
+        const key_prefix_t prefix = get_key_prefix(node);
+        out += strprintf("  Key prefix: %.*s\n", prefix.size, prefix.bytes);
+    }
+
     out += strprintf("  By Key:");
     for (int i = 0; i < node->num_pairs; ++i) {
         out += strprintf(" %d:", node->pair_offsets[i]);
-        strprint_entry(&out, sizer, get_entry(node, node->pair_offsets[i]));
+        strprint_entry(&out, sizer, node, get_entry(node, node->pair_offsets[i]));
     }
     out += strprintf("\n");
 
@@ -219,7 +479,7 @@ std::string strprint_leaf(value_sizer_t *sizer, const leaf_node_t *node) {
             repli_timestamp_t tstamp = get_timestamp(node, iter.offset);
             out += strprintf("[t=%" PRIu64 "]", tstamp.longtime);
         }
-        strprint_entry(&out, sizer, get_entry(node, iter.offset));
+        strprint_entry(&out, sizer, node, get_entry(node, iter.offset));
         iter.step(sizer, node);
     }
     out += strprintf("\n");
@@ -228,17 +488,19 @@ std::string strprint_leaf(value_sizer_t *sizer, const leaf_node_t *node) {
 }
 
 
-void print_entry(FILE *fp, value_sizer_t *sizer, const entry_t *entry) {
+void print_entry(FILE *fp, value_sizer_t *sizer, const leaf_node_t *node,
+                 const entry_t *entry) {
+    store_key_t buf;
     if (entry_is_live(entry)) {
-        const btree_key_t *key = entry_key(entry);
+        const btree_key_t *key = entry_key(node, entry, &buf);
         fprintf(fp, "%.*s:", static_cast<int>(key->size), key->contents);
-        fprintf(fp, "[entry size=%d]", entry_size(sizer, entry));
-        fprintf(fp, "[value size=%d]", sizer->size(entry_value(entry)));
+        fprintf(fp, "[entry size=%d]", entry_size(sizer, node, entry));
+        fprintf(fp, "[value size=%d]", sizer->size(entry_value(node, entry)));
     } else if (entry_is_deletion(entry)) {
-        const btree_key_t *key = entry_key(entry);
+        const btree_key_t *key = entry_key(node, entry, &buf);
         fprintf(fp, "%.*s:[deletion]", static_cast<int>(key->size), key->contents);
     } else if (entry_is_skip(entry)) {
-        fprintf(fp, "[skip %d]", entry_size(sizer, entry));
+        fprintf(fp, "[skip %d]", entry_size(sizer, node, entry));
     } else {
         fprintf(fp, "[code %d]", *reinterpret_cast<const uint8_t *>(entry));
     }
@@ -257,10 +519,16 @@ void print(FILE *fp, value_sizer_t *sizer, const leaf_node_t *node) {
     fprintf(fp, "\n");
     fflush(fp);
 
+    if (has_key_prefix(node)) {
+        const key_prefix_t prefix = get_key_prefix(node);
+        fprintf(fp, "  Key prefix: %.*s\n", prefix.size, prefix.bytes);
+        fflush(fp);
+    }
+
     fprintf(fp, "  By Key:");
     for (int i = 0; i < node->num_pairs; ++i) {
         fprintf(fp, " %d:", node->pair_offsets[i]);
-        print_entry(fp, sizer, get_entry(node, node->pair_offsets[i]));
+        print_entry(fp, sizer, node, get_entry(node, node->pair_offsets[i]));
     }
     fprintf(fp, "\n");
 
@@ -276,7 +544,7 @@ void print(FILE *fp, value_sizer_t *sizer, const leaf_node_t *node) {
             fprintf(fp, "[t=%" PRIu64 "]", tstamp.longtime);
             fflush(fp);
         }
-        print_entry(fp, sizer, get_entry(node, iter.offset));
+        print_entry(fp, sizer, node, get_entry(node, iter.offset));
         iter.step(sizer, node);
     }
     fprintf(fp, "\n");
@@ -309,10 +577,10 @@ bool fsck(value_sizer_t *sizer, const btree_key_t *left_exclusive_or_null, const
     // correct magic, that the keys are in order, that there are no
     // deletion entries after tstamp_cutpoint, and that
     // tstamp_cutpoint lies on an entry boundary, and that frontmost
-    // is not before the end of pair_offsets
+    // is not before the end of pair_offsets (and the key prefix)
 
     // Basic sanity checks on fields' values.
-    if (failed(node->magic == sizer->btree_leaf_magic(),
+    if (failed(is_leaf_magic(sizer, node->magic),
                "bad leaf magic")
         || failed(node->frontmost >= offsetof(leaf_node_t, pair_offsets) + node->num_pairs * sizeof(uint16_t),
                   "frontmost offset is before the end of pair_offsets")
@@ -322,10 +590,16 @@ bool fsck(value_sizer_t *sizer, const btree_key_t *left_exclusive_or_null, const
                   "timestamp cut offset below frontmost offset")
         || failed(node->tstamp_cutpoint <= sizer->block_size().value(),
                   "timestamp cut offset larger than block size")
+        || failed(!has_key_prefix(node)
+                  || (offsetof(leaf_node_t, pair_offsets) + node->num_pairs * sizeof(uint16_t) < node->frontmost
+                      && pair_offsets_end(node) <= node->frontmost),
+                  "frontmost offset is before the end of the key prefix")
         ) {
         return false;
     }
 
+    const key_prefix_t prefix = get_key_prefix(node);
+
     // sizeof(offs) is guaranteed to be less than the block_size() thanks to assertions above.
     scoped_array_t<uint16_t> offs(node->num_pairs);
     memcpy(offs.data(), node->pair_offsets, node->num_pairs * sizeof(uint16_t));
@@ -375,21 +649,31 @@ bool fsck(value_sizer_t *sizer, const btree_key_t *left_exclusive_or_null, const
         }
 
         const entry_t *ent = get_entry(node, offset);
+        if (prefix.compressed && !entry_is_skip(ent)) {
+            const uint8_t *encoded = entry_encoded_key(ent);
+            if (failed(encoded[1] <= encoded[0] && encoded[1] <= prefix.size,
+                       "entry shares more bytes with the key prefix than possible")) {
+                return false;
+            }
+        }
+
         if (entry_is_live(ent)) {
-            const void *value = entry_value(ent);
+            store_key_t key_buf;
+            const btree_key_t *key = entry_key(prefix, ent, &key_buf);
+            const void *value = entry_value(prefix, ent);
             int space = sizer->block_size().value() - (reinterpret_cast<const char *>(value) - reinterpret_cast<const char *>(node));
             if (!sizer->fits(value, space)) {
-                *msg_out = strprintf("problem with key %.*s: value does not fit\n", entry_key(ent)->size, entry_key(ent)->contents);
+                *msg_out = strprintf("problem with key %.*s: value does not fit\n", key->size, key->contents);
                 return false;
             }
 
             std::string fscker_msg;
-            if (!fscker->fsck(sizer, entry_key(ent), value, &fscker_msg)) {
-                *msg_out = strprintf("Problem with key %.*s: %s\n", entry_key(ent)->size, entry_key(ent)->contents, fscker_msg.c_str());
+            if (!fscker->fsck(sizer, key, value, &fscker_msg)) {
+                *msg_out = strprintf("Problem with key %.*s: %s\n", key->size, key->contents, fscker_msg.c_str());
                 return false;
             }
 
-            observed_live_size += sizeof(uint16_t) + entry_size(sizer, ent);
+            observed_live_size += sizeof(uint16_t) + entry_size(sizer, prefix, ent);
             if (failed(i < node->num_pairs, "missing entry offsets")) {
                 return false;
             }
@@ -422,14 +706,17 @@ bool fsck(value_sizer_t *sizer, const btree_key_t *left_exclusive_or_null, const
 
     // Entries look valid, check key ordering.
 
+    store_key_t last_buf;
     const btree_key_t *last = left_exclusive_or_null;
     for (int k = 0; k < node->num_pairs; ++k) {
-        const btree_key_t *key = entry_key(get_entry(node, node->pair_offsets[k]));
+        store_key_t key_buf;
+        const btree_key_t *key = entry_key(prefix, get_entry(node, node->pair_offsets[k]), &key_buf);
         if (failed(last == nullptr || btree_key_cmp(last, key) < 0,
                    "keys out of order")) {
             return false;
         }
-        last = key;
+        last_buf.assign(key);
+        last = last_buf.btree_key();
     }
 
     if (failed(last == nullptr || right_inclusive_or_null == nullptr
@@ -451,12 +738,22 @@ void validate(DEBUG_VAR value_sizer_t *sizer, DEBUG_VAR const leaf_node_t *node)
 #endif
 }
 
-void init(value_sizer_t *sizer, leaf_node_t *node) {
-    node->magic = sizer->btree_leaf_magic();
+// Initializes an empty node that stores its keys relative to `prefix`.
+void init(value_sizer_t *sizer, leaf_node_t *node, const key_prefix_t &prefix) {
+    node->magic = prefix.compressed ? prefix_leaf_magic(sizer) : sizer->btree_leaf_magic();
     node->num_pairs = 0;
     node->live_size = 0;
     node->frontmost = sizer->block_size().value();
     node->tstamp_cutpoint = node->frontmost;
+    if (prefix.compressed) {
+        uint8_t *storage = key_prefix_storage(node);
+        storage[0] = prefix.size;
+        memcpy(storage + 1, prefix.bytes, prefix.size);
+    }
+}
+
+void init(value_sizer_t *sizer, leaf_node_t *node) {
+    init(sizer, node, plain_key_prefix());
 }
 
 int free_space(value_sizer_t *sizer) {
@@ -467,7 +764,7 @@ int free_space(value_sizer_t *sizer) {
 // in the closed interval [0, free_space(sizer)].  Outputs the offset
 // of the first entry for which storing a timestamp is not mandatory.
 int mandatory_cost(value_sizer_t *sizer, const leaf_node_t *node, int required_timestamps, int *tstamp_back_offset_out) {
-    int size = node->live_size;
+    int size = node->live_size + key_prefix_storage_size(get_key_prefix(node));
 
     // node->live_size does not include deletion entries, deletion
     // entries' timestamps, and live entries' timestamps.  We add that
@@ -484,7 +781,7 @@ int mandatory_cost(value_sizer_t *sizer, const leaf_node_t *node, int required_t
                 break;
             }
 
-            int this_entry_cost = sizeof(uint16_t) + sizeof(repli_timestamp_t) + entry_size(sizer, ent);
+            int this_entry_cost = sizeof(uint16_t) + sizeof(repli_timestamp_t) + entry_size(sizer, node, ent);
             deletions_cost += this_entry_cost;
             size += this_entry_cost;
             ++count;
@@ -510,7 +807,9 @@ int leaf_epsilon(value_sizer_t *sizer) {
     // Returns the maximum possible entry size, i.e. the key cost plus
     // the value cost plus pair_offsets plus timestamp cost.
 
-    int key_cost = sizeof(uint8_t) + MAX_KEY_SIZE;
+    // A key that's stored relative to a prefix it doesn't share anything with
+    // costs one more byte than a plain key.
+    int key_cost = sizeof(uint8_t) + sizeof(uint8_t) + MAX_KEY_SIZE;
 
     // If the value is always empty, the DELETE_ENTRY_CODE byte needs to be considered.
     int n = std::max(sizer->max_possible_size(), 1);
@@ -524,6 +823,77 @@ bool is_empty(const leaf_node_t *node) {
     return node->num_pairs == 0;
 }
 
+// Picks the prefix that `garbage_collect()` should store the keys of `node`
+// relative to when it's making room for an entry for `new_key`.  Only the keys
+// of the entries that survive the garbage collection count, i.e. those of the
+// live entries and of the deletion entries before `mand_offset`.  Returns the
+// number of bytes that storing these keys and `new_key` relative to
+// `*prefix_out` instead of the node's current prefix saves, or 0 (without
+// touching `*prefix_out`) if that doesn't save anything.  `*prefix_out` points
+// into `new_key`.
+int choose_key_prefix(value_sizer_t *sizer, const leaf_node_t *node, int mand_offset,
+                      const btree_key_t *new_key, key_prefix_t *prefix_out) {
+    if (!sizer->btree_leaf_key_prefixes()) {
+        return 0;
+    }
+
+    const key_prefix_t prefix = get_key_prefix(node);
+    auto survives = [&](int index) {
+        int offset = node->pair_offsets[index];
+        const entry_t *ent = get_entry(node, offset);
+        return entry_is_live(ent) || (offset < mand_offset && entry_is_deletion(ent));
+    };
+
+    int first = 0;
+    while (first < node->num_pairs && !survives(first)) {
+        ++first;
+    }
+    int last = node->num_pairs - 1;
+    while (last > first && !survives(last)) {
+        --last;
+    }
+
+    // The entries are sorted by key, so the longest common prefix of the keys
+    // is that of `new_key`, the first key and the last key.
+    key_prefix_t candidate;
+    candidate.compressed = true;
+    candidate.size = new_key->size;
+    candidate.bytes = new_key->contents;
+    if (first < node->num_pairs) {
+        store_key_t first_buf, last_buf;
+        const btree_key_t *first_key
+            = entry_key(prefix, get_entry(node, node->pair_offsets[first]), &first_buf);
+        const btree_key_t *last_key
+            = entry_key(prefix, get_entry(node, node->pair_offsets[last]), &last_buf);
+        candidate.size = std::min(
+            common_prefix_size(first_key->contents, first_key->size,
+                               last_key->contents, last_key->size),
+            common_prefix_size(first_key->contents, first_key->size,
+                               new_key->contents, new_key->size));
+    }
+
+    if (same_key_prefix(prefix, candidate)) {
+        return 0;
+    }
+
+    int savings = key_prefix_storage_size(prefix) - key_prefix_storage_size(candidate)
+        + encoded_key_size(prefix, new_key) - encoded_key_size(candidate, new_key);
+    for (int i = first; i <= last && i < node->num_pairs; ++i) {
+        if (survives(i)) {
+            // Every key starts with all of `candidate`.
+            const uint8_t *encoded
+                = entry_encoded_key(get_entry(node, node->pair_offsets[i]));
+            savings += encoded_key_size(prefix, encoded) - (2 + encoded[0] - candidate.size);
+        }
+    }
+
+    if (savings <= 0) {
+        return 0;
+    }
+    *prefix_out = candidate;
+    return savings;
+}
+
 bool is_full(value_sizer_t *sizer, const leaf_node_t *node, const btree_key_t *key, const void *value) {
 
     // Upon an insertion, we preserve `MANDATORY_TIMESTAMPS - 1`
@@ -537,13 +907,24 @@ bool is_full(value_sizer_t *sizer, const leaf_node_t *node, const btree_key_t *k
     // be which allows us to get into a situation where is_full returns false
     // but when we call prepare_space_for_new_entry we fail with an insertion
     // because it doesn't actually fit.
-    int size = mandatory_cost(sizer, node, MANDATORY_TIMESTAMPS);
+    int tstamp_back_offset;
+    int size = mandatory_cost(sizer, node, MANDATORY_TIMESTAMPS, &tstamp_back_offset);
 
     // Add the space we'll need for the new key/value pair we would
     // insert.  We conservatively assume the key is not already
     // contained in the node.
 
-    size += sizeof(uint16_t) + sizeof(repli_timestamp_t) + key->full_size() + sizer->size(value);
+    size += sizeof(uint16_t) + sizeof(repli_timestamp_t)
+        + new_entry_size(sizer, get_key_prefix(node), key, value);
+
+    // If that doesn't fit, the garbage collection in
+    // `prepare_space_for_new_entry()` might still make it fit by storing the
+    // keys relative to a longer prefix.  It keeps at most the entries that we
+    // counted, so it saves at least as much as we compute here.
+    if (size > free_space(sizer)) {
+        key_prefix_t ignored;
+        size -= choose_key_prefix(sizer, node, tstamp_back_offset, key, &ignored);
+    }
 
     // The node is full if we can't fit all that data within the free space.
     return size > free_space(sizer);
@@ -583,12 +964,15 @@ private:
 };
 
 
+// If `new_key` is given, we're making room for an entry for it, and store the
+// keys relative to a different prefix if that saves space.
 void garbage_collect(
         value_sizer_t *sizer,
         leaf_node_t *node,
         int num_tstamped,
         int *preserved_index,
-        boost::optional<int> tstamp_cutoff_upper_bound = boost::optional<int>()) {
+        boost::optional<int> tstamp_cutoff_upper_bound = boost::optional<int>(),
+        const btree_key_t *new_key = nullptr) {
     scoped_array_t<uint16_t> indices(node->num_pairs);
 
     for (int i = 0; i < node->num_pairs; ++i) {
@@ -605,6 +989,20 @@ void garbage_collect(
         mand_offset = std::min(*tstamp_cutoff_upper_bound, mand_offset);
     }
 
+    // If the keys get stored relative to a new prefix, we can't move the
+    // entries around in place, so we read them from a copy of the node.
+    key_prefix_t prefix = get_key_prefix(node);
+    scoped_malloc_t<leaf_node_t> copy;
+    const leaf_node_t *src = node;
+    const bool new_prefix = new_key != nullptr
+        && choose_key_prefix(sizer, node, mand_offset, new_key, &prefix) > 0;
+    if (new_prefix) {
+        copy = scoped_malloc_t<leaf_node_t>(sizer->block_size().value());
+        memcpy(copy.get(), node, sizer->block_size().value());
+        src = copy.get();
+    }
+
+    int live_size = 0;
     int w = sizer->block_size().value();
     int i = node->num_pairs - 1;
     for (; i >= 0; --i) {
@@ -614,12 +1012,13 @@ void garbage_collect(
             break;
         }
 
-        entry_t *ent = get_entry(node, offset);
+        const entry_t *ent = get_entry(src, offset);
         if (entry_is_live(ent)) {
-            int sz = entry_size(sizer, ent);
+            int sz = copied_entry_size(sizer, src, ent, prefix);
             w -= sz;
-            memmove(get_at_offset(node, w), ent, sz);
+            copy_entry(sizer, src, ent, prefix, get_at_offset(node, w));
             node->pair_offsets[indices[i]] = w;
+            live_size += sizeof(uint16_t) + sz;
         } else {
             node->pair_offsets[indices[i]] = 0;
         }
@@ -631,16 +1030,23 @@ void garbage_collect(
 
     for (; i >= 0; --i) {
         int offset = node->pair_offsets[indices[i]];
-        entry_t *ent = get_entry(node, offset);
+        const entry_t *ent = get_entry(src, offset);
         rassert(!entry_is_skip(ent));
 
         // Preserve the timestamp.
-        int sz = sizeof(repli_timestamp_t) + entry_size(sizer, ent);
+        int entsz = copied_entry_size(sizer, src, ent, prefix);
+        repli_timestamp_t tstamp = get_timestamp(src, offset);
 
-        w -= sz;
+        w -= sizeof(repli_timestamp_t) + entsz;
 
-        memmove(get_at_offset(node, w), get_at_offset(node, offset), sz);
+        // We copy the entry first, because the timestamp might overwrite it.
+        copy_entry(sizer, src, ent, prefix,
+                   get_at_offset(node, w + sizeof(repli_timestamp_t)));
+        *reinterpret_cast<repli_timestamp_t *>(get_at_offset(node, w)) = tstamp;
         node->pair_offsets[indices[i]] = w;
+        if (entry_is_live(ent)) {
+            live_size += sizeof(uint16_t) + entsz;
+        }
     }
 
     node->frontmost = w;
@@ -662,7 +1068,19 @@ void garbage_collect(
         *preserved_index = j;
     }
 
-    node->num_pairs = j;
+    if (new_prefix) {
+        node->magic = prefix_leaf_magic(sizer);
+        node->num_pairs = j;
+        uint8_t *storage = key_prefix_storage(node);
+        storage[0] = prefix.size;
+        memcpy(storage + 1, prefix.bytes, prefix.size);
+        guarantee(pair_offsets_end(node) <= node->frontmost);
+    } else {
+        set_num_pairs(node, j);
+    }
+
+    rassert(new_prefix || live_size == node->live_size);
+    node->live_size = live_size;
 
     validate(sizer, node);
 }
@@ -696,7 +1114,8 @@ void clean_entry(void *p, int sz) {
 }
 
 // Moves entries with pair_offsets indices in the clopen range [beg,
-// end) from fro to tow.
+// end) from fro to tow.  Their keys get stored relative to tow's key
+// prefix, so `fro_copysize` must be computed with `moved_size()`.
 void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
                    int wpoint, leaf_node_t *tow, int fro_copysize,
                    int fro_mand_offset,
@@ -712,9 +1131,10 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
     garbage_collect(sizer, tow, MANDATORY_TIMESTAMPS, &wpoint);
 
     // Now resize and move tow's pair_offsets.
-    memmove(tow->pair_offsets + wpoint + (end - beg), tow->pair_offsets + wpoint, sizeof(uint16_t) * (tow->num_pairs - wpoint));
+    const int old_tow_num_pairs = tow->num_pairs;
+    set_num_pairs(tow, old_tow_num_pairs + (end - beg));
 
-    tow->num_pairs += end - beg;
+    memmove(tow->pair_offsets + wpoint + (end - beg), tow->pair_offsets + wpoint, sizeof(uint16_t) * (old_tow_num_pairs - wpoint));
 
     // pos a
 
@@ -767,6 +1187,9 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
 
     int fro_live_size_adjustment = 0;
 
+    // We can't hold on to this across changes to `tow->num_pairs`.
+    const key_prefix_t tow_prefix = get_key_prefix(tow);
+
     for (;;) {
         rassert(tow_offset <= tow->tstamp_cutpoint);
         if (tow_offset == tow->tstamp_cutpoint || fro_index == fro_index_end) {
@@ -787,16 +1210,19 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
         // Greater timestamps go first.
         if (tow_tstamp < fro_tstamp) {
             entry_t *ent = get_entry(fro, fro_offset);
-            int entsz = entry_size(sizer, ent);
+            int fro_entsz = entry_size(sizer, fro, ent);
+            int entsz = copied_entry_size(sizer, fro, ent, tow_prefix);
             int sz = sizeof(repli_timestamp_t) + entsz;
-            memmove(get_at_offset(tow, wri_offset), get_at_offset(fro, fro_offset), sz);
+            *reinterpret_cast<repli_timestamp_t *>(get_at_offset(tow, wri_offset)) = fro_tstamp;
+            copy_entry(sizer, fro, ent, tow_prefix,
+                       get_at_offset(tow, wri_offset + sizeof(repli_timestamp_t)));
 
             if (entry_is_live(ent)) {
                 livesize += entsz + sizeof(uint16_t);
-                fro_live_size_adjustment -= entsz + sizeof(uint16_t);
+                fro_live_size_adjustment -= fro_entsz + sizeof(uint16_t);
             }
 
-            clean_entry(ent, entsz);
+            clean_entry(ent, fro_entsz);
 
             // Update the pair offset in fro to be the offset in tow
             // -- we'll never use the old value again and we'll copy
@@ -808,7 +1234,7 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
             fro_index++;
 
         } else {
-            int sz = sizeof(repli_timestamp_t) + entry_size(sizer, get_entry(tow, tow_offset));
+            int sz = sizeof(repli_timestamp_t) + entry_size(sizer, tow_prefix, get_entry(tow, tow_offset));
             memmove(get_at_offset(tow, wri_offset), get_at_offset(tow, tow_offset), sz);
 
             // Update the pair offset of the entry we've moved.
@@ -836,10 +1262,11 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
         int fro_offset = fro->pair_offsets[beg + tow->pair_offsets[fro_index]];
         entry_t *ent = get_entry(fro, fro_offset);
         if (entry_is_live(ent)) {
-            int sz = entry_size(sizer, ent);
-            memmove(get_at_offset(tow, wri_offset), ent, sz);
-            clean_entry(ent, sz);
-            fro_live_size_adjustment -= sz + sizeof(uint16_t);
+            int fro_sz = entry_size(sizer, fro, ent);
+            int sz = copied_entry_size(sizer, fro, ent, tow_prefix);
+            copy_entry(sizer, fro, ent, tow_prefix, get_at_offset(tow, wri_offset));
+            clean_entry(ent, fro_sz);
+            fro_live_size_adjustment -= fro_sz + sizeof(uint16_t);
 
             fro->pair_offsets[beg + tow->pair_offsets[fro_index]] = wri_offset;
 
@@ -853,7 +1280,7 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
             // This is a dead entry.  We'll need to squash this dead entry later.
             fro->pair_offsets[beg + tow->pair_offsets[fro_index]] = 0;
 
-            int sz = entry_size(sizer, ent);
+            int sz = entry_size(sizer, fro, ent);
             clean_entry(ent, sz);
         }
     }
@@ -867,7 +1294,7 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
         rassert(wri_offset <= tow_offset);
 
         entry_t *ent = get_entry(tow, tow_offset);
-        int sz = entry_size(sizer, ent);
+        int sz = entry_size(sizer, tow_prefix, ent);
         if (entry_is_live(ent)) {
             memmove(get_at_offset(tow, wri_offset), ent, sz);
 
@@ -918,7 +1345,7 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
     memcpy(tow->pair_offsets + wpoint, fro->pair_offsets + beg,
            sizeof(uint16_t) * (end - beg));
     memmove(fro->pair_offsets + beg, fro->pair_offsets + end, sizeof(uint16_t) * (fro->num_pairs - end));
-    fro->num_pairs -= end - beg;
+    set_num_pairs(fro, fro->num_pairs - (end - beg));
 
     tow->frontmost = new_frontmost;
 
@@ -939,7 +1366,7 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
                 const entry_t *entry = get_entry(tow, offset);
                 // Skip deletions
                 if (entry_is_live(entry)) {
-                    moved_values_out->push_back(entry_value(entry));
+                    moved_values_out->push_back(entry_value(tow, entry));
                 }
             }
         }
@@ -956,13 +1383,44 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
                 j += 1;
             }
         }
-        tow->num_pairs = j;
+        set_num_pairs(tow, j);
     }
 
     validate(sizer, fro);
     validate(sizer, tow);
 }
 
+// The number of bytes that the mandatory entries with indices in [beg, end) of
+// `fro` take up once `move_elements()` has moved them to a node whose keys are
+// stored relative to `tow_prefix`, not counting their pair offsets.  That's
+// what `move_elements()` expects as its `fro_copysize`.
+int moved_size(value_sizer_t *sizer, const leaf_node_t *fro, int beg, int end,
+               int fro_mand_offset, const key_prefix_t &tow_prefix) {
+    int size = 0;
+    for (int i = beg; i < end; ++i) {
+        int offset = fro->pair_offsets[i];
+        const entry_t *ent = get_entry(fro, offset);
+        if (offset < fro_mand_offset) {
+            size += sizeof(repli_timestamp_t) + copied_entry_size(sizer, fro, ent, tow_prefix);
+        } else if (entry_is_live(ent)) {
+            size += copied_entry_size(sizer, fro, ent, tow_prefix);
+        }
+    }
+    return size;
+}
+
+// The number of mandatory entries with indices in [beg, end) of `fro`.
+int num_mandatory_entries(const leaf_node_t *fro, int beg, int end, int fro_mand_offset) {
+    int count = 0;
+    for (int i = beg; i < end; ++i) {
+        int offset = fro->pair_offsets[i];
+        if (offset < fro_mand_offset || entry_is_live(get_entry(fro, offset))) {
+            ++count;
+        }
+    }
+    return count;
+}
+
 void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *rnode, btree_key_t *median_out) {
     int tstamp_back_offset;
     int mandatory = mandatory_cost(sizer, node, MANDATORY_TIMESTAMPS, &tstamp_back_offset);
@@ -987,7 +1445,7 @@ void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *rnode, btree_ke
 
         if (entry_is_live(ent)) {
             prev_rcost = rcost;
-            rcost += entry_size(sizer, ent) + sizeof(uint16_t) + (offset < tstamp_back_offset ? sizeof(repli_timestamp_t) : 0);
+            rcost += entry_size(sizer, node, ent) + sizeof(uint16_t) + (offset < tstamp_back_offset ? sizeof(repli_timestamp_t) : 0);
 
             ++num_mandatories;
         } else {
@@ -995,7 +1453,7 @@ void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *rnode, btree_ke
 
             if (offset < tstamp_back_offset) {
                 prev_rcost = rcost;
-                rcost += entry_size(sizer, ent) + sizeof(uint16_t) + sizeof(repli_timestamp_t);
+                rcost += entry_size(sizer, node, ent) + sizeof(uint16_t) + sizeof(repli_timestamp_t);
 
                 ++num_mandatories;
             }
@@ -1029,14 +1487,17 @@ void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *rnode, btree_ke
     guarantee(mandatory - end_rcost >= free_space(sizer) / 2 - leaf_epsilon(sizer));
 
     // Now we wish to move the elements at indices [s, num_pairs) to rnode.
+    // It stores its keys relative to the same prefix, so that they can be
+    // copied as they are.
 
-    init(sizer, rnode);
+    init(sizer, rnode, get_key_prefix(node));
 
     int node_copysize = end_rcost - num_mandatories * sizeof(uint16_t);
     move_elements(sizer, node, s, node->num_pairs, 0, rnode, node_copysize,
                   tstamp_back_offset, nullptr);
 
-    keycpy(median_out, entry_key(get_entry(node, node->pair_offsets[s - 1])));
+    store_key_t buf;
+    keycpy(median_out, entry_key(node, get_entry(node, node->pair_offsets[s - 1]), &buf));
 }
 
 void merge(value_sizer_t *sizer, leaf_node_t *left, leaf_node_t *right) {
@@ -1046,18 +1507,12 @@ void merge(value_sizer_t *sizer, leaf_node_t *left, leaf_node_t *right) {
     rassert(is_underfull(sizer, right));
 
     int tstamp_back_offset;
-    int mandatory = mandatory_cost(sizer, left, MANDATORY_TIMESTAMPS, &tstamp_back_offset);
-
-    int left_copysize = mandatory;
-    // Uncount the uint16_t cost of mandatory entries.  Sigh.
-    // This includes deletion entries *before* the `tstamp_back_offset`, as well
-    // as all non-deletion entries.
-    for (int i = 0; i < left->num_pairs; ++i) {
-        if (left->pair_offsets[i] < tstamp_back_offset
-            || !entry_is_deletion(get_entry(left, left->pair_offsets[i]))) {
-            left_copysize -= sizeof(uint16_t);
-        }
-    }
+    mandatory_cost(sizer, left, MANDATORY_TIMESTAMPS, &tstamp_back_offset);
+
+    // The mandatory entries of `left` are the deletion entries *before* the
+    // `tstamp_back_offset`, as well as all non-deletion entries.
+    int left_copysize = moved_size(sizer, left, 0, left->num_pairs, tstamp_back_offset,
+                                   get_key_prefix(right));
 
     move_elements(sizer, left, 0, left->num_pairs, 0, right, left_copysize,
                   tstamp_back_offset, nullptr);
@@ -1070,9 +1525,14 @@ bool level(value_sizer_t *sizer, int nodecmp_node_with_sib,
            std::vector<const void *> *moved_values_out) {
     rassert(node != sibling);
 
-    // If sibling were underfull, we'd just merge the nodes.
+    // If we could, we'd just merge the nodes.  We can't always: the keys of
+    // the sibling might take up more space once they're stored relative to
+    // node's key prefix, so the sibling might be underfull too.
     rassert(is_underfull(sizer, node));
-    rassert(!is_underfull(sizer, sibling));
+
+    if (sibling->num_pairs <= 1) {
+        return false;
+    }
 
     // First figure out the inclusive range [beg, end] of elements we want to move
     // from sibling.
@@ -1083,7 +1543,9 @@ bool level(value_sizer_t *sizer, int nodecmp_node_with_sib,
     int sibling_weight = mandatory_cost(sizer, sibling, MANDATORY_TIMESTAMPS,
                                         &tstamp_back_offset);
 
-    guarantee(node_weight < sibling_weight);
+    if (node_weight >= sibling_weight) {
+        return false;
+    }
 
     if (nodecmp_node_with_sib < 0) {
         // node is to the left of sibling, so we want to move elements
@@ -1103,63 +1565,58 @@ bool level(value_sizer_t *sizer, int nodecmp_node_with_sib,
         wstep = -1;
     }
 
-    guarantee(end - beg != sibling->num_pairs - 1);
+    const key_prefix_t node_prefix = get_key_prefix(node);
 
-    int prev_weight_movement = 0;
-    int weight_movement = 0;
-    int num_mandatories = 0;
+    // Whether we have to leave the last element we looked at in sibling.
+    bool step_back = false;
     int prev_diff = sizer->block_size().value();  // some impossibly large value
     for (;;) {
         int offset = sibling->pair_offsets[*w];
-        entry_t *ent = get_entry(sibling, offset);
+        const entry_t *ent = get_entry(sibling, offset);
 
         // We only take mandatory entries' costs into consideration.
-        if (entry_is_live(ent)) {
-            int sz = entry_size(sizer, ent) + sizeof(uint16_t) + (offset < tstamp_back_offset ? sizeof(repli_timestamp_t) : 0);
-            prev_diff = sibling_weight - node_weight;
-            prev_weight_movement = weight_movement;
-            weight_movement += sz;
-            node_weight += sz;
-            sibling_weight -= sz;
-
-            ++num_mandatories;
-        } else {
-            rassert(entry_is_deletion(ent));
+        if (offset < tstamp_back_offset || entry_is_live(ent)) {
+            int tstamp_size = offset < tstamp_back_offset ? sizeof(repli_timestamp_t) : 0;
+            int node_sz = copied_entry_size(sizer, sibling, ent, node_prefix)
+                + sizeof(uint16_t) + tstamp_size;
+            int sibling_sz = entry_size(sizer, sibling, ent)
+                + sizeof(uint16_t) + tstamp_size;
+
+            if (node_weight + node_sz > free_space(sizer)) {
+                step_back = true;
+                break;
+            }
 
-            if (offset < tstamp_back_offset) {
-                int sz = entry_size(sizer, ent) + sizeof(uint16_t) + sizeof(repli_timestamp_t);
-                prev_diff = sibling_weight - node_weight;
-                prev_weight_movement = weight_movement;
-                weight_movement += sz;
-                node_weight += sz;
-                sibling_weight -= sz;
+            prev_diff = sibling_weight - node_weight;
+            node_weight += node_sz;
+            sibling_weight -= sibling_sz;
+        }
 
-                ++num_mandatories;
-            }
+        if (end - beg == sibling->num_pairs - 1) {
+            // We must leave at least one element in sibling.
+            step_back = true;
+            break;
         }
 
-        if (end - beg == sibling->num_pairs - 1 || node_weight >= sibling_weight) {
+        if (node_weight >= sibling_weight) {
             break;
         }
 
         *w += wstep;
     }
 
-    guarantee(end - beg < sibling->num_pairs - 1);
-
-    if (prev_diff <= sibling_weight - node_weight) {
+    if (step_back || prev_diff <= sibling_weight - node_weight) {
         *w -= wstep;
-        --num_mandatories;
-        weight_movement = prev_weight_movement;
     }
 
-    if (end < beg) {
+    if (end < beg
+        || num_mandatory_entries(sibling, beg, end + 1, tstamp_back_offset) == 0) {
         // Alas, there is no actual leveling to do.
-        guarantee(end + 1 == beg);
         return false;
     }
 
-    int sib_copysize = weight_movement - num_mandatories * sizeof(uint16_t);
+    int sib_copysize = moved_size(sizer, sibling, beg, end + 1, tstamp_back_offset,
+                                  node_prefix);
     move_elements(sizer, sibling, beg, end + 1,
                   nodecmp_node_with_sib < 0 ? node->num_pairs : 0, node,
                   sib_copysize, tstamp_back_offset, moved_values_out);
@@ -1167,17 +1624,51 @@ bool level(value_sizer_t *sizer, int nodecmp_node_with_sib,
     guarantee(node->num_pairs > 0);
     guarantee(sibling->num_pairs > 0);
 
+    store_key_t buf;
     if (nodecmp_node_with_sib < 0) {
-        keycpy(replacement_key_out, entry_key(get_entry(node, node->pair_offsets[node->num_pairs - 1])));
+        keycpy(replacement_key_out, entry_key(node, get_entry(node, node->pair_offsets[node->num_pairs - 1]), &buf));
     } else {
-        keycpy(replacement_key_out, entry_key(get_entry(sibling, sibling->pair_offsets[sibling->num_pairs - 1])));
+        keycpy(replacement_key_out, entry_key(sibling, get_entry(sibling, sibling->pair_offsets[sibling->num_pairs - 1]), &buf));
     }
 
     return true;
 }
 
+// The mandatory cost that `tow` would have after `merge()` moved all of `fro`
+// into it (or an upper bound of it).
+int merged_mandatory_cost(value_sizer_t *sizer, const leaf_node_t *fro, const leaf_node_t *tow) {
+    int fro_mand_offset;
+    mandatory_cost(sizer, fro, MANDATORY_TIMESTAMPS, &fro_mand_offset);
+    return mandatory_cost(sizer, tow, MANDATORY_TIMESTAMPS)
+        + moved_size(sizer, fro, 0, fro->num_pairs, fro_mand_offset, get_key_prefix(tow))
+        + sizeof(uint16_t) * num_mandatory_entries(fro, 0, fro->num_pairs, fro_mand_offset);
+}
+
 bool is_mergable(value_sizer_t *sizer, const leaf_node_t *node, const leaf_node_t *sibling) {
-    return is_underfull(sizer, node) && is_underfull(sizer, sibling);
+    if (!is_underfull(sizer, node) || !is_underfull(sizer, sibling)) {
+        return false;
+    }
+
+    // `merge()` stores the keys of the left node relative to the right node's
+    // key prefix, and they might take up more space there.  When neither node
+    // stores a key prefix, the merged node always fits because both nodes are
+    // underfull.
+    int limit = free_space(sizer) - 2 * leaf_epsilon(sizer);
+    if (node->num_pairs == 0 || sibling->num_pairs == 0) {
+        // We can't tell which one is the left node, so we check both ways.
+        return merged_mandatory_cost(sizer, node, sibling) < limit
+            && merged_mandatory_cost(sizer, sibling, node) < limit;
+    }
+    store_key_t node_buf, sibling_buf;
+    const btree_key_t *node_key
+        = entry_key(node, get_entry(node, node->pair_offsets[0]), &node_buf);
+    const btree_key_t *sibling_key
+        = entry_key(sibling, get_entry(sibling, sibling->pair_offsets[0]), &sibling_buf);
+    if (btree_key_cmp(node_key, sibling_key) < 0) {
+        return merged_mandatory_cost(sizer, node, sibling) < limit;
+    } else {
+        return merged_mandatory_cost(sizer, sibling, node) < limit;
+    }
 }
 
 // Sets *index_out to the index for the live entry or deletion entry
@@ -1187,6 +1678,9 @@ bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
     int beg = 0;
     int end = node->num_pairs;
 
+    const key_prefix_t prefix = get_key_prefix(node);
+    const int key_shared = prefix.compressed ? shared_size(prefix, key) : 0;
+
     // beg == 0 or key > *(beg - 1).
     // end == num_pairs or key < *end.
 
@@ -1194,9 +1688,8 @@ bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
         // when (end - beg) > 0, (end - beg) / 2 is always less than (end - beg).  So beg <= test_point < end.
         int test_point = beg + (end - beg) / 2;
 
-        const btree_key_t *ek = entry_key(get_entry(node, node->pair_offsets[test_point]));
-
-        int res = btree_key_cmp(key, ek);
+        int res = key_cmp_entry(prefix, key, key_shared,
+                                get_entry(node, node->pair_offsets[test_point]));
 
         if (res < 0) {
             // key < *test_point.
@@ -1223,7 +1716,7 @@ bool lookup(value_sizer_t *sizer, const leaf_node_t *node, const btree_key_t *ke
     if (find_key(node, key, &index)) {
         const entry_t *ent = get_entry(node, node->pair_offsets[index]);
         if (entry_is_live(ent)) {
-            const void *val = entry_value(ent);
+            const void *val = entry_value(node, ent);
             memcpy(value_out, val, sizer->size(val));
             return true;
         }
@@ -1243,8 +1736,10 @@ appropriate, and maintaining `frontmost` and `tstamp_cutpoint`. The caller is
 responsible for writing the actual entry itself (including the key) and for
 updating `live_size` if the newly created entry is live.
 
-`new_entry_size` is the total size of the new entry, including key, value,
-and/or code byte, but not including repli timestamp.
+The new entry is a live entry for `key` and `value`, or a deletion entry for
+`key` if `value` is null.  The caller must write it with `write_entry()` and the
+node's key prefix at the time this returns; the garbage collection in here might
+change the prefix.
 
 It is an error to put a deletion entry after `tstamp_cutpoint`. If the caller
 intends to insert a deletion entry, it should pass `false` for
@@ -1258,7 +1753,7 @@ MUST_USE bool prepare_space_for_new_entry(
         value_sizer_t *sizer,
         leaf_node_t *node,
         const btree_key_t *key,
-        int new_entry_size,
+        const void *value,
         repli_timestamp_t tstamp,
         /* Used to derive the highest possible timestamp that non-timestamped
         entries might have. Usually the recency of the buf_t that node is in. */
@@ -1294,7 +1789,7 @@ MUST_USE bool prepare_space_for_new_entry(
         int offset = node->pair_offsets[index];
         entry_t *ent = get_entry(node, offset);
 
-        int sz = entry_size(sizer, ent);
+        int sz = entry_size(sizer, node, ent);
 
         if (entry_is_live(ent)) {
             node->live_size -= sizeof(uint16_t) + sz;
@@ -1322,8 +1817,10 @@ MUST_USE bool prepare_space_for_new_entry(
     We check for this condition further down, and recover from it by dropping
     all existing timestamps and discarding the delete entry by returning `false`. */
 
-    if (offsetof(leaf_node_t, pair_offsets) +
-            sizeof(uint16_t) * (node->num_pairs + (found ? 0 : 1)) +
+    int new_entry_size = leaf::new_entry_size(sizer, get_key_prefix(node), key, value);
+
+    if (pair_offsets_end(node) +
+            sizeof(uint16_t) * (found ? 0 : 1) +
             sizeof(repli_timestamp_t) +
             new_entry_size >
             node->frontmost) {
@@ -1335,14 +1832,16 @@ MUST_USE bool prepare_space_for_new_entry(
                 node->pair_offsets + index,
                 node->pair_offsets + index + 1,
                 sizeof(uint16_t) * (node->num_pairs - index - 1));
-            --node->num_pairs;
+            set_num_pairs(node, node->num_pairs - 1);
         }
 
         /* Passing `&index` as a parameter to `garbage_collect()`
         guarantees that it will remain valid even as `pair_offsets` entries are
-        moved around. */
+        moved around.  Passing `key` lets it store the keys relative to a longer
+        prefix, which changes the size of the new entry. */
         garbage_collect(sizer, node, MANDATORY_TIMESTAMPS - 1, &index,
-                        boost::make_optional(gc_tstamp_cutoff_upper_bound));
+                        boost::make_optional(gc_tstamp_cutoff_upper_bound), key);
+        new_entry_size = leaf::new_entry_size(sizer, get_key_prefix(node), key, value);
 
         /* Make sure that `index` still refers to where the new key should be
         inserted. */
@@ -1401,8 +1900,8 @@ MUST_USE bool prepare_space_for_new_entry(
     bool drop_timestamps = false;
     if (actually_create_entry
         && !allow_after_tstamp_cutpoint
-        && offsetof(leaf_node_t, pair_offsets)
-           + sizeof(uint16_t) * (node->num_pairs + (found ? 0 : 1))
+        && pair_offsets_end(node)
+           + sizeof(uint16_t) * (found ? 0 : 1)
            + new_entry_size
            + sizeof(repli_timestamp_t)
            > node->frontmost) {
@@ -1419,7 +1918,7 @@ MUST_USE bool prepare_space_for_new_entry(
                 node->pair_offsets + index,
                 node->pair_offsets + index + 1,
                 sizeof(uint16_t) * (node->num_pairs - index - 1));
-            --node->num_pairs;
+            set_num_pairs(node, node->num_pairs - 1);
         }
 
         if (drop_timestamps) {
@@ -1435,11 +1934,11 @@ MUST_USE bool prepare_space_for_new_entry(
     create a new entry or not. */
 
     if (!found) {
+        set_num_pairs(node, node->num_pairs + 1);
         memmove(
             node->pair_offsets + index + 1,
             node->pair_offsets + index,
-            sizeof(uint16_t) * (node->num_pairs - index));
-        ++node->num_pairs;
+            sizeof(uint16_t) * (node->num_pairs - 1 - index));
     }
 
     /* Now that we know where in the leaf node to write our entry, make space if
@@ -1469,8 +1968,7 @@ MUST_USE bool prepare_space_for_new_entry(
     }
 
     node->frontmost -= total_space_for_new_entry;
-    guarantee(offsetof(leaf_node_t, pair_offsets)
-              + sizeof(uint16_t) * node->num_pairs <= node->frontmost);
+    guarantee(pair_offsets_end(node) <= node->frontmost);
 
     /* Write the timestamp if we need one, and update `node->tstamp_cutpoint` if
     we don't. */
@@ -1515,18 +2013,17 @@ void insert(
 
     char *location_to_write_data;
     bool should_write = prepare_space_for_new_entry(sizer, node,
-        key, key->full_size() + sizer->size(value), tstamp, maximum_existing_tstamp,
+        key, value, tstamp, maximum_existing_tstamp,
         true,
         &location_to_write_data);
     guarantee(should_write);
 
     /* Now copy the data into the node itself */
 
-    memcpy(location_to_write_data, key, key->full_size());
-    location_to_write_data += key->full_size();
-    memcpy(location_to_write_data, value, sizer->size(value));
+    const key_prefix_t prefix = get_key_prefix(node);
+    write_entry(sizer, prefix, key, value, location_to_write_data);
 
-    node->live_size += sizeof(uint16_t) + key->full_size() + sizer->size(value);
+    node->live_size += sizeof(uint16_t) + new_entry_size(sizer, prefix, key, value);
 
     validate(sizer, node);
 }
@@ -1546,14 +2043,12 @@ void remove(
     char *location_to_write_data;
     if (prepare_space_for_new_entry(sizer, node,
             key,
-            1 + key->full_size(),   /* 1 for `DELETE_ENTRY_CODE` */
+            nullptr,   /* a deletion entry */
             tstamp,
             maximum_existing_tstamp,
             false,
             &location_to_write_data)) {
-        *location_to_write_data = static_cast<char>(DELETE_ENTRY_CODE);
-        ++location_to_write_data;
-        memcpy(location_to_write_data, key, key->full_size());
+        write_entry(sizer, get_key_prefix(node), key, nullptr, location_to_write_data);
     }
 
     validate(sizer, node);
@@ -1567,7 +2062,7 @@ void erase_presence(value_sizer_t *sizer, leaf_node_t *node, const btree_key_t *
         int offset = node->pair_offsets[index];
         entry_t *ent = get_entry(node, offset);
 
-        int sz = entry_size(sizer, ent);
+        int sz = entry_size(sizer, node, ent);
         if (entry_is_live(ent)) {
             node->live_size -= sizeof(uint16_t) + sz;
         }
@@ -1575,7 +2070,7 @@ void erase_presence(value_sizer_t *sizer, leaf_node_t *node, const btree_key_t *
         clean_entry(ent, sz);
 
         memmove(node->pair_offsets + index, node->pair_offsets + index + 1, (node->num_pairs - (index + 1)) * sizeof(uint16_t));
-        node->num_pairs -= 1;
+        set_num_pairs(node, node->num_pairs - 1);
     }
 
     validate(sizer, node);
@@ -1640,7 +2135,7 @@ void erase_deletions(
         if (entry_is_deletion(ent)) {
             clean_entry(
                 get_at_offset(node, off),
-                sizeof(repli_timestamp_t) + entry_size(sizer, ent));
+                sizeof(repli_timestamp_t) + entry_size(sizer, node, ent));
             deletion_offsets.insert(off);
         } else {
             /* This is the code path for both skip entries and live entries, because skip
@@ -1669,7 +2164,7 @@ void erase_deletions(
         }
     }
     guarantee(deletion_offsets.empty());
-    node->num_pairs -= num_deleted;
+    set_num_pairs(node, node->num_pairs - num_deleted);
 
     /* Finally, update `node->tstamp_cutpoint` */
     node->tstamp_cutpoint = new_tstamp_cutpoint;
@@ -1688,6 +2183,8 @@ continue_bool_t visit_entries(
             const void *value   /* null for deletion */
             )> &cb) {
     repli_timestamp_t earliest_so_far = maximum_existing_timestamp;
+    const key_prefix_t prefix = get_key_prefix(node);
+    store_key_t key_buf;
     for (entry_iter_t iter = entry_iter_t::make(node);
             !iter.done(sizer); iter.step(sizer, node)) {
         repli_timestamp_t tstamp;
@@ -1704,7 +2201,8 @@ continue_bool_t visit_entries(
             continue;
         }
 
-        if (continue_bool_t::ABORT == cb(entry_key(ent), tstamp, entry_value(ent))) {
+        if (continue_bool_t::ABORT == cb(entry_key(prefix, ent, &key_buf), tstamp,
+                                         entry_value(prefix, ent))) {
             return continue_bool_t::ABORT;
         }
     }
@@ -1721,7 +2219,7 @@ std::pair<const btree_key_t *, const void *> iterator::operator*() const {
     guarantee(index_ < static_cast<int>(node_->num_pairs));
     guarantee(index_ >= 0);
     const entry_t *entree = get_entry(node_, node_->pair_offsets[index_]);
-    return std::make_pair(entry_key(entree), entry_value(entree));
+    return std::make_pair(entry_key(node_, entree, &key_buf_), entry_value(node_, entree));
 }
 
 iterator &iterator::operator++() {
@@ -1809,12 +2307,10 @@ leaf::iterator inclusive_lower_bound(const btree_key_t *key, const leaf_node_t &
 
 leaf::reverse_iterator exclusive_upper_bound(const btree_key_t *key, const leaf_node_t &leaf_node) {
     int index;
-    leaf::find_key(&leaf_node, key, &index);
-    if (index < leaf_node.num_pairs) {
+    bool found = leaf::find_key(&leaf_node, key, &index);
+    if (found) {
         const leaf::entry_t *entry = leaf::get_entry(&leaf_node, leaf_node.pair_offsets[index]);
-        const btree_key_t *ekey = leaf::entry_key(entry);
-        if (entry_is_live(entry) &&
-            btree_key_cmp(ekey, key) == 0) {
+        if (entry_is_live(entry)) {
             // We have to skip this entry to make the iterator exclusive,
             // hence the ++.
             return ++leaf_node_t::reverse_iterator(&leaf_node, index);
@@ -1824,4 +2320,20 @@ leaf::reverse_iterator exclusive_upper_bound(const btree_key_t *key, const leaf_
     return ++leaf_node_t::reverse_iterator(&leaf_node, index);
 }
 
+int count_live_entries(const leaf_node_t &leaf_node, const key_range_t &range) {
+    int begin_index;
+    leaf::find_key(&leaf_node, range.left.btree_key(), &begin_index);
+    int end_index = leaf_node.num_pairs;
+    if (!range.right.unbounded) {
+        leaf::find_key(&leaf_node, range.right.key().btree_key(), &end_index);
+    }
+    int count = 0;
+    for (int i = begin_index; i < end_index; ++i) {
+        if (entry_is_live(leaf::get_entry(&leaf_node, leaf_node.pair_offsets[i]))) {
+            ++count;
+        }
+    }
+    return count;
+}
+
 }  // namespace leaf
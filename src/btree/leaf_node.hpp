@@ -11,6 +11,7 @@
 #include <boost/optional.hpp>
 
 #include "arch/compiler.hpp"
+#include "btree/keys.hpp"
 #include "btree/types.hpp"
 #include "buffer_cache/types.hpp"
 
@@ -60,7 +61,8 @@ ATTR_PACKED(struct leaf_node_t {
     // The first offset whose entry is not accompanied by a timestamp.
     uint16_t tstamp_cutpoint;
 
-    // The pair offsets.
+    // The pair offsets.  In the prefix-compressed format, they are
+    // followed by the key prefix (see leaf_node.cc).
     uint16_t pair_offsets[];
 
     //Iteration
@@ -79,6 +81,10 @@ leaf_node_t::reverse_iterator rend(const leaf_node_t &leaf_node);
 leaf_node_t::iterator inclusive_lower_bound(const btree_key_t *key, const leaf_node_t &leaf_node);
 leaf_node_t::reverse_iterator exclusive_upper_bound(const btree_key_t *key, const leaf_node_t &leaf_node);
 
+// Returns the number of live entries in the node whose keys lie in `range`, without
+// decoding any keys besides the ones needed to find the range's bounds.
+int count_live_entries(const leaf_node_t &leaf_node, const key_range_t &range);
+
 
 
 // We must maintain timestamps and deletion entries as best we can,
@@ -101,6 +107,15 @@ const int DELETION_RESERVE_FRACTION = 10;
 
 
 
+// Leaf nodes come in two formats: the plain one, which has the value type's
+// `btree_leaf_magic()`, and the prefix-compressed one, which has this magic
+// instead.  Either kind of node can be loaded; nodes are only converted to the
+// prefix-compressed format when that saves space.
+block_magic_t prefix_leaf_magic(value_sizer_t *sizer);
+
+// Returns true if `magic` is the magic of a leaf node, in either format.
+bool is_leaf_magic(value_sizer_t *sizer, block_magic_t magic);
+
 std::string strprint_leaf(value_sizer_t *sizer, const leaf_node_t *node);
 
 void print(FILE *fp, value_sizer_t *sizer, const leaf_node_t *node);
@@ -189,7 +204,8 @@ void erase_deletions(
 
 /* Calls `cb` on every entry in the node, whether a real entry or a deletion. The calls
 will be in order from most recent to least recent. For entries with no timestamp, the
-callback will get `min_deletion_timestamp() - 1`. */
+callback will get `min_deletion_timestamp() - 1`. The key is only valid for the duration
+of the call. */
 continue_bool_t visit_entries(
     value_sizer_t *sizer,
     const leaf_node_t *node,
@@ -201,6 +217,8 @@ continue_bool_t visit_entries(
         const void *value   /* null for deletion */
         )> &cb);
 
+// The key that `operator*()` returns is only valid until the iterator is changed or
+// destroyed.
 class iterator {
 public:
     iterator();
@@ -219,6 +237,9 @@ private:
     int cmp(const iterator &other) const;
     const leaf_node_t *node_;
     int index_;
+    // Holds the key for `operator*()` if the node stores its keys relative to a
+    // prefix.
+    mutable store_key_t key_buf_;
 };
 
 class reverse_iterator {
@@ -25,6 +25,10 @@ public:
     virtual bool fits(const void *value, int length_available) const = 0;
     virtual int max_possible_size() const = 0;
     virtual block_magic_t btree_leaf_magic() const = 0;
+    // Whether leaf nodes may store their keys relative to a common prefix.  Such
+    // nodes have a different magic (see `leaf::prefix_leaf_magic()`), which older
+    // versions can't read.
+    virtual bool btree_leaf_key_prefixes() const = 0;
     virtual max_block_size_t block_size() const = 0;
 
 private:
@@ -104,7 +104,8 @@ cache_t::cache_t(serializer_t *serializer,
                  cache_balancer_t *balancer,
                  perfmon_collection_t *perfmon_collection)
     : throttler_(MINIMUM_SOFT_UNWRITTEN_CHANGES_LIMIT),
-      page_cache_(serializer, balancer, &throttler_),
+      page_cache_(serializer, balancer, &throttler_,
+                  alt::eviction_policy_type_t::two_queue),
       stats_(make_scoped<alt_cache_stats_t>(&page_cache_, perfmon_collection)) { }
 
 cache_t::~cache_t() {
@@ -808,12 +809,16 @@ buf_read_t::~buf_read_t() {
     lock_->access_ref_count_--;
 }
 
-const void *buf_read_t::get_data_read(uint32_t *block_size_out) {
+void buf_read_t::start_loading() {
     page_t *page = lock_->get_held_page_for_read();
     if (!page_acq_.has()) {
         page_acq_.init(page, &lock_->cache()->page_cache_,
                        lock_->txn()->account());
     }
+}
+
+const void *buf_read_t::get_data_read(uint32_t *block_size_out) {
+    start_loading();
     page_acq_.buf_ready_signal()->wait();
     *block_size_out = page_acq_.get_buf_size().value();
     return page_acq_.get_buf_read();
@@ -327,6 +327,11 @@ public:
     explicit buf_read_t(buf_lock_t *lock);
     ~buf_read_t();
 
+    // Starts loading the block without waiting for the load to finish, so that the
+    // loads of many blocks can be in flight at the same time.  `get_data_read` does
+    // this implicitly.
+    void start_loading();
+
     const void *get_data_read(uint32_t *block_size_out);
     const void *get_data_read() {
         uint32_t block_size;
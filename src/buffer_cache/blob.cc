@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #include <limits>
+#include <vector>
 
 #include "buffer_cache/alt.hpp"
 #include "concurrency/pmap.hpp"
@@ -49,11 +50,23 @@ make_tree_from_block_ids(buf_parent_t parent, access_t mode, int levels,
 // touches_end_t specifies whether the [offset, offset + size) region given to
 // expose_tree_from_block_ids touches the end of the data in the blob.
 enum class touches_end_t { yes, no };
+
+// A leaf block that is being loaded for reading, and the part of its data that
+// belongs to the exposed region.
+struct leaf_read_t {
+    buf_read_t *buf_read;
+    int64_t offset;
+    int64_t size;
+};
+
+// In read mode, the leaves' data isn't added to buffer_group_out.  Their loads are
+// only started, and they are appended to leaf_reads_out instead.
 void expose_tree_from_block_ids(buf_parent_t parent, access_t mode,
                                 int levels, int64_t offset, int64_t size,
                                 temporary_acq_tree_node_t *tree,
                                 touches_end_t touches_end,
                                 buffer_group_t *buffer_group_out,
+                                std::vector<leaf_read_t> *leaf_reads_out,
                                 blob_acq_t *acq_group_out);
 
 
@@ -343,6 +356,7 @@ void blob_t::expose_region(buf_parent_t parent, access_t mode,
                                              blob::block_ids(ref_, maxreflen_));
 
         // Exposing and writing to the buffer group is done serially.
+        std::vector<blob::leaf_read_t> leaf_reads;
         blob::expose_tree_from_block_ids(parent, mode, levels,
                                          offset, size,
                                          tree,
@@ -350,7 +364,23 @@ void blob_t::expose_region(buf_parent_t parent, access_t mode,
                                          ? blob::touches_end_t::yes
                                          : blob::touches_end_t::no,
                                          buffer_group_out,
+                                         &leaf_reads,
                                          acq_group_out);
+
+        // All leaves are loading by now, so the serializer gets to see their reads
+        // at the same time and can merge the ones that are adjacent on disk, instead
+        // of us waiting for one block after another.
+        for (const blob::leaf_read_t &leaf : leaf_reads) {
+            // We can't assert a specific block size here (without undesirably
+            // intricate logic), because immediately after creation, the blob has
+            // size max_value_size, but after we've written to the block, its
+            // size could be shrunken.
+            uint32_t block_size;
+            void *leaf_buf
+                = const_cast<void *>(leaf.buf_read->get_data_read(&block_size));
+            buffer_group_out->add_buffer(leaf.size,
+                                         blob::leaf_node_data(leaf_buf) + leaf.offset);
+        }
     }
 }
 
@@ -432,6 +462,7 @@ void expose_tree_from_block_ids(buf_parent_t parent, access_t mode,
                                 temporary_acq_tree_node_t *tree,
                                 touches_end_t touches_end,
                                 buffer_group_t *buffer_group_out,
+                                std::vector<leaf_read_t> *leaf_reads_out,
                                 blob_acq_t *acq_group_out) {
     rassert(size > 0);
 
@@ -447,24 +478,21 @@ void expose_tree_from_block_ids(buf_parent_t parent, access_t mode,
             expose_tree_from_block_ids(parent, mode, levels - 1, suboffset,
                                        subsize, tree[i].child, touches_end,
                                        buffer_group_out,
+                                       leaf_reads_out,
                                        acq_group_out);
         } else {
             rassert(0 < subsize && subsize <= blob::leaf_size(parent.cache()->max_block_size()));
             rassert(0 <= suboffset && suboffset + subsize <= blob::leaf_size(parent.cache()->max_block_size()));
 
             buf_lock_t *buf = tree[i].buf;
-            void *leaf_buf;
             if (mode == access_t::read) {
                 buf_read_t *buf_read = new buf_read_t(buf);
-                // We can't assert a specific block size here (without undesirably
-                // intricate logic), because immediately after creation, the blob has
-                // size max_value_size, but after we've written to the block, its
-                // size could be shrunken.
-                uint32_t block_size;
-                leaf_buf = const_cast<void *>(buf_read->get_data_read(&block_size));
+                buf_read->start_loading();
                 acq_group_out->add_buf(buf, buf_read);
+                leaf_reads_out->push_back(leaf_read_t{buf_read, suboffset, subsize});
             } else {
                 buf_write_t *buf_write = new buf_write_t(buf);
+                void *leaf_buf;
                 if (touches_end == touches_end_t::yes) {
                     // Using suboffset + subsize is valid because we know that, when
                     // appending, there are no bytes in this block past suboffset +
@@ -476,10 +504,10 @@ void expose_tree_from_block_ids(buf_parent_t parent, access_t mode,
                 }
 
                 acq_group_out->add_buf(buf, buf_write);
-            }
 
-            char *data = blob::leaf_node_data(leaf_buf);
-            buffer_group_out->add_buffer(subsize, data + suboffset);
+                char *data = blob::leaf_node_data(leaf_buf);
+                buffer_group_out->add_buffer(subsize, data + suboffset);
+            }
         }
     }
 
@@ -8,7 +8,7 @@
 
 namespace alt {
 
-evicter_t::evicter_t()
+evicter_t::evicter_t(eviction_policy_type_t policy_type)
     : initialized_(false),
       page_cache_(nullptr),
       balancer_(nullptr),
@@ -17,7 +17,8 @@ evicter_t::evicter_t()
       bytes_loaded_counter_(0),
       access_count_counter_(0),
       access_time_counter_(INITIAL_ACCESS_TIME),
-      evict_if_necessary_active_(false) { }
+      evict_if_necessary_active_(false),
+      policy_(make_eviction_policy(policy_type)) { }
 
 evicter_t::~evicter_t() {
     assert_thread();
@@ -154,7 +155,8 @@ void evicter_t::add_to_evictable_unbacked(page_t *page) {
 void evicter_t::add_to_evictable_disk_backed(page_t *page) {
     assert_thread();
     guarantee(initialized_);
-    evictable_disk_backed_.add(page, page->hypothetical_memory_usage(page_cache_));
+    policy_->correct_bag(page)->add(page,
+                                    page->hypothetical_memory_usage(page_cache_));
     evict_if_necessary();
     notify_bytes_loading(page->hypothetical_memory_usage(page_cache_));
 }
@@ -165,7 +167,7 @@ void evicter_t::move_unevictable_to_evictable(page_t *page) {
     rassert(unevictable_.has_page(page));
     unevictable_.remove(page, page->hypothetical_memory_usage(page_cache_));
     eviction_bag_t *new_bag = correct_eviction_category(page);
-    rassert(new_bag == &evictable_disk_backed_
+    rassert(policy_->owns_bag(new_bag)
             || new_bag == &evictable_unbacked_);
     new_bag->add(page, page->hypothetical_memory_usage(page_cache_));
     evict_if_necessary();
@@ -190,7 +192,7 @@ eviction_bag_t *evicter_t::correct_eviction_category(page_t *page) {
     } else if (!page->is_loaded()) {
         return &evicted_;
     } else if (page->is_disk_backed()) {
-        return &evictable_disk_backed_;
+        return policy_->correct_bag(page);
     } else {
         return &evictable_unbacked_;
     }
@@ -208,10 +210,19 @@ uint64_t evicter_t::in_memory_size() const {
     assert_thread();
     guarantee(initialized_);
     return unevictable_.size()
-        + evictable_disk_backed_.size()
+        + policy_->size()
         + evictable_unbacked_.size();
 }
 
+void evicter_t::visit_bags(
+        const std::function<void(const char *, const eviction_bag_t *)> &cb) const {
+    assert_thread();
+    cb("unevictable", &unevictable_);
+    policy_->visit_bags(cb);
+    cb("evictable_unbacked", &evictable_unbacked_);
+    cb("evicted", &evicted_);
+}
+
 void evicter_t::evict_if_necessary() THROWS_NOTHING {
     assert_thread();
     guarantee(initialized_);
@@ -230,8 +241,7 @@ void evicter_t::evict_if_necessary() THROWS_NOTHING {
     evict_if_necessary_active_ = true;
     page_t *page;
     while (in_memory_size() > memory_limit_
-           && evictable_disk_backed_.remove_oldish(&page, access_time_counter_,
-                                                   page_cache_)) {
+           && policy_->remove_victim(&page, access_time_counter_, page_cache_)) {
         evicted_.add(page, page->hypothetical_memory_usage(page_cache_));
         page->evict_self(page_cache_);
         page_cache_->consider_evicting_current_page(page->block_id());
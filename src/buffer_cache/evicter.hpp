@@ -6,6 +6,7 @@
 #include <functional>
 
 #include "buffer_cache/eviction_bag.hpp"
+#include "buffer_cache/eviction_policy.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/cache_line_padded.hpp"
 #include "concurrency/pubsub.hpp"
@@ -36,7 +37,7 @@ public:
     void reloading_page(page_t *page);
 
     // Evicter will be unusable until initialize is called
-    evicter_t();
+    explicit evicter_t(eviction_policy_type_t policy_type);
     ~evicter_t();
 
     void initialize(page_cache_t *page_cache,
@@ -58,6 +59,10 @@ public:
 
     uint64_t in_memory_size() const;
 
+    // Calls `cb` with the name and contents of every eviction bag, for the stats.
+    void visit_bags(
+        const std::function<void(const char *, const eviction_bag_t *)> &cb) const;
+
     // This is decremented past UINT64_MAX to force code to be aware of access time
     // rollovers.
     static const uint64_t INITIAL_ACCESS_TIME = UINT64_MAX - 100;
@@ -93,9 +98,10 @@ private:
     // It avoids reentrant calls to that function.
     bool evict_if_necessary_active_;
 
-    // These track every page's eviction status.
+    // These track every page's eviction status.  The evictable, disk-backed pages
+    // are kept in the eviction policy's bags.
     eviction_bag_t unevictable_;
-    eviction_bag_t evictable_disk_backed_;
+    scoped_ptr_t<eviction_policy_t> policy_;
     eviction_bag_t evictable_unbacked_;
     eviction_bag_t evicted_;
 
@@ -9,7 +9,7 @@
 namespace alt {
 
 eviction_bag_t::eviction_bag_t()
-    : bag_(), size_(0) { }
+    : bag_(), size_(0), hits_(0), misses_(0) { }
 
 eviction_bag_t::~eviction_bag_t() {
     guarantee(bag_.size() == 0);
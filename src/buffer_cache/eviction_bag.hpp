@@ -33,11 +33,29 @@ public:
     bool remove_oldish(page_t **page_out, uint64_t access_time_offset,
                        page_cache_t *page_cache);
 
+    // Counts an acquisition of a page in this bag.  It's a hit if the page was
+    // already loaded.
+    void record_access(bool hit) {
+        if (hit) {
+            ++hits_;
+        } else {
+            ++misses_;
+        }
+    }
+
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+
 private:
     backindex_bag_t<page_t *> bag_;
     // The size in memory.
     uint64_t size_;
 
+    // How many acquisitions found their page in this bag, loaded or not.  These are
+    // only kept for the stats.
+    uint64_t hits_;
+    uint64_t misses_;
+
     DISABLE_COPYING(eviction_bag_t);
 };
 
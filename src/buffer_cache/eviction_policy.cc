@@ -0,0 +1,102 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "buffer_cache/eviction_policy.hpp"
+
+#include "buffer_cache/page.hpp"
+#include "config/args.hpp"
+
+namespace alt {
+
+class sampled_lru_eviction_policy_t final : public eviction_policy_t {
+public:
+    sampled_lru_eviction_policy_t() { }
+
+    eviction_bag_t *correct_bag(UNUSED page_t *page) final {
+        return &evictable_;
+    }
+
+    bool owns_bag(const eviction_bag_t *bag) const final {
+        return bag == &evictable_;
+    }
+
+    uint64_t size() const final {
+        return evictable_.size();
+    }
+
+    bool remove_victim(page_t **page_out, uint64_t access_time_offset,
+                       page_cache_t *page_cache) final {
+        return evictable_.remove_oldish(page_out, access_time_offset, page_cache);
+    }
+
+    void visit_bags(const std::function<void(const char *,
+                                             const eviction_bag_t *)> &cb) const final {
+        cb("evictable_disk_backed", &evictable_);
+    }
+
+private:
+    eviction_bag_t evictable_;
+
+    DISABLE_COPYING(sampled_lru_eviction_policy_t);
+};
+
+// This is a segmented LRU, which is close to what the 2Q paper calls the simplified
+// 2Q.  Pages start out in the probationary segment and get promoted to the protected
+// segment once they're acquired a second time.  We always evict from the
+// probationary segment first.  So that pages that have stopped being used can leave
+// the protected segment, it's only allowed to hold PAGE_REPL_PROTECTED_PERCENT of the
+// evictable pages, and the oldest protected pages get demoted back into the
+// probationary segment when it gets larger than that.
+class two_queue_eviction_policy_t final : public eviction_policy_t {
+public:
+    two_queue_eviction_policy_t() { }
+
+    eviction_bag_t *correct_bag(page_t *page) final {
+        return page->touch_count() >= 2 ? &protected_ : &probationary_;
+    }
+
+    bool owns_bag(const eviction_bag_t *bag) const final {
+        return bag == &probationary_ || bag == &protected_;
+    }
+
+    uint64_t size() const final {
+        return probationary_.size() + protected_.size();
+    }
+
+    bool remove_victim(page_t **page_out, uint64_t access_time_offset,
+                       page_cache_t *page_cache) final {
+        page_t *page;
+        while (protected_.size() * 100 > size() * PAGE_REPL_PROTECTED_PERCENT
+               && protected_.remove_oldish(&page, access_time_offset, page_cache)) {
+            page->set_touch_count(1);
+            rassert(correct_bag(page) == &probationary_);
+            probationary_.add(page, page->hypothetical_memory_usage(page_cache));
+        }
+
+        return probationary_.remove_oldish(page_out, access_time_offset, page_cache)
+            || protected_.remove_oldish(page_out, access_time_offset, page_cache);
+    }
+
+    void visit_bags(const std::function<void(const char *,
+                                             const eviction_bag_t *)> &cb) const final {
+        cb("evictable_disk_backed_probationary", &probationary_);
+        cb("evictable_disk_backed_protected", &protected_);
+    }
+
+private:
+    eviction_bag_t probationary_;
+    eviction_bag_t protected_;
+
+    DISABLE_COPYING(two_queue_eviction_policy_t);
+};
+
+scoped_ptr_t<eviction_policy_t> make_eviction_policy(eviction_policy_type_t type) {
+    switch (type) {
+    case eviction_policy_type_t::sampled_lru:
+        return scoped_ptr_t<eviction_policy_t>(new sampled_lru_eviction_policy_t());
+    case eviction_policy_type_t::two_queue:
+        return scoped_ptr_t<eviction_policy_t>(new two_queue_eviction_policy_t());
+    default:
+        unreachable();
+    }
+}
+
+}  // namespace alt
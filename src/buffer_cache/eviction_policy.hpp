@@ -0,0 +1,58 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef BUFFER_CACHE_EVICTION_POLICY_HPP_
+#define BUFFER_CACHE_EVICTION_POLICY_HPP_
+
+#include <stdint.h>
+
+#include <functional>
+
+#include "buffer_cache/eviction_bag.hpp"
+#include "containers/scoped.hpp"
+
+namespace alt {
+
+class page_t;
+class page_cache_t;
+
+enum class eviction_policy_type_t {
+    // Evicts the least recently accessed page out of a few randomly sampled ones.
+    sampled_lru,
+    // Keeps pages that have only been acquired once apart from pages that have been
+    // acquired again since they were loaded, and evicts the former first.  A table
+    // scan or a backfill therefore can't push the working set out of the cache.
+    two_queue
+};
+
+// An eviction_policy_t decides which of the evictable, disk-backed pages gets evicted
+// next.  It keeps these pages in eviction bags of its own.  Which of its bags a page
+// belongs in must only depend on the page's state, because the evicter (and
+// usage_adjuster_t) look it up again whenever the page changes.
+class eviction_policy_t {
+public:
+    virtual ~eviction_policy_t() { }
+
+    // Returns the bag that the evictable, disk-backed page belongs in.
+    virtual eviction_bag_t *correct_bag(page_t *page) = 0;
+
+    // Returns true if `bag` is one of this policy's bags.
+    virtual bool owns_bag(const eviction_bag_t *bag) const = 0;
+
+    // The total size of the pages in this policy's bags.
+    virtual uint64_t size() const = 0;
+
+    // Picks the next page to evict and removes it from its bag.  Returns false if
+    // there are no pages left to evict.
+    virtual bool remove_victim(page_t **page_out, uint64_t access_time_offset,
+                               page_cache_t *page_cache) = 0;
+
+    // Calls `cb` with the name and contents of each of this policy's bags, for the
+    // stats.
+    virtual void visit_bags(
+        const std::function<void(const char *, const eviction_bag_t *)> &cb) const = 0;
+};
+
+scoped_ptr_t<eviction_policy_t> make_eviction_policy(eviction_policy_type_t type);
+
+}  // namespace alt
+
+#endif  // BUFFER_CACHE_EVICTION_POLICY_HPP_
@@ -56,6 +56,7 @@ page_t::page_t(block_id_t _block_id, page_cache_t *page_cache)
     : block_id_(_block_id),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
+      touch_count_(0),
       snapshot_refcount_(0) {
     page_cache->evicter().add_deferred_loaded(this);
 
@@ -70,6 +71,7 @@ page_t::page_t(block_id_t _block_id, page_cache_t *page_cache,
     : block_id_(_block_id),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
+      touch_count_(0),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
 
@@ -86,6 +88,7 @@ page_t::page_t(block_id_t _block_id, buf_ptr_t buf,
       loader_(nullptr),
       buf_(std::move(buf)),
       access_time_(page_cache->evicter().next_access_time()),
+      touch_count_(0),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_unbacked(this);
@@ -100,6 +103,7 @@ page_t::page_t(block_id_t _block_id,
       buf_(std::move(buf)),
       block_token_(_block_token),
       access_time_(READ_AHEAD_ACCESS_TIME),
+      touch_count_(0),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_disk_backed(this);
@@ -109,6 +113,9 @@ page_t::page_t(page_t *copyee, page_cache_t *page_cache, cache_account_t *accoun
     : block_id_(copyee->block_id_),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
+      // The copy replaces the copyee as the block's current version, so it inherits
+      // how hot the block is.
+      touch_count_(copyee->touch_count_),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
     coro_t::spawn_now_dangerously(std::bind(&page_t::load_from_copyee,
@@ -413,6 +420,10 @@ void page_t::pulse_waiters_or_make_evictable(page_cache_t *page_cache) {
 void page_t::add_waiter(page_acq_t *acq, cache_account_t *account) {
     eviction_bag_t *old_bag
         = acq->page_cache()->evicter().correct_eviction_category(this);
+    old_bag->record_access(buf_.has());
+    if (touch_count_ < UINT8_MAX) {
+        ++touch_count_;
+    }
     waiters_.push_front(acq);
     acq->page_cache()->evicter().change_to_correct_eviction_bag(old_bag, this);
     if (buf_.has()) {
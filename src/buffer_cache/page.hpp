@@ -56,6 +56,11 @@ public:
     uint32_t hypothetical_memory_usage(page_cache_t *page_cache) const;
     uint64_t access_time() const { return access_time_; }
 
+    // How many times the page has been acquired since it was created, saturating
+    // at UINT8_MAX.  The eviction policy may lower it.
+    uint8_t touch_count() const { return touch_count_; }
+    void set_touch_count(uint8_t touch_count) { touch_count_ = touch_count; }
+
     bool is_loading() const {
         return loader_ != nullptr && page_t::loader_is_loading(loader_);
     }
@@ -132,6 +137,8 @@ private:
 
     uint64_t access_time_;
 
+    uint8_t touch_count_;
+
     // How many page_ptr_t's point at this page, expecting nothing to modify it,
     // other than themselves.
     size_t snapshot_refcount_;
@@ -146,7 +153,7 @@ private:
     // if loader_ is non-null:  unevictable_pages_
     // else if waiters_ is non-empty: unevictable_pages_
     // else if buf_ is null: evicted_pages_ (and block_token_ is non-null)
-    // else if block_token_ is non-null: evictable_disk_backed_pages_
+    // else if block_token_ is non-null: one of the eviction policy's bags
     // else: evictable_unbacked_pages_ (buf_ is non-null, block_token_ is null)
     //
     // So, when loader_, waiters_, buf_, or block_token_ is touched, we might
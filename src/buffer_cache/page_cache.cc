@@ -203,11 +203,12 @@ public:
 
 page_cache_t::page_cache_t(serializer_t *_serializer,
                            cache_balancer_t *balancer,
-                           alt_txn_throttler_t *throttler)
+                           alt_txn_throttler_t *throttler,
+                           eviction_policy_type_t eviction_policy)
     : max_block_size_(_serializer->max_block_size()),
       serializer_(_serializer),
       free_list_(_serializer),
-      evicter_(),
+      evicter_(eviction_policy),
       read_ahead_cb_(nullptr),
       drainer_(make_scoped<auto_drainer_t>()) {
 
@@ -1,6 +1,9 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "buffer_cache/stats.hpp"
 
+#include <string>
+#include <vector>
+
 #include "perfmon/perfmon.hpp"
 
 alt_cache_stats_t::alt_cache_stats_t(alt::page_cache_t *_page_cache,
@@ -11,6 +14,9 @@ alt_cache_stats_t::alt_cache_stats_t(alt::page_cache_t *_page_cache,
     in_use_bytes(this),
     in_use_bytes_membership(&cache_collection,
                             &in_use_bytes, "in_use_bytes"),
+    eviction_bags(this),
+    eviction_bags_membership(&cache_collection,
+                             &eviction_bags, "eviction_bags"),
     cache_collection_membership(&cache_collection) { }
 
 alt_cache_stats_t::perfmon_value_t::perfmon_value_t(alt_cache_stats_t *_parent) :
@@ -33,3 +39,45 @@ ql::datum_t alt_cache_stats_t::perfmon_value_t::end_stats(void *ptr) {
     delete value;
     return res;
 }
+
+struct eviction_bag_stats_t {
+    std::string name;
+    uint64_t hits;
+    uint64_t misses;
+};
+
+alt_cache_stats_t::perfmon_eviction_bags_t::perfmon_eviction_bags_t(
+        alt_cache_stats_t *_parent) :
+    parent(_parent) { }
+
+void *alt_cache_stats_t::perfmon_eviction_bags_t::begin_stats() {
+    return new std::vector<eviction_bag_stats_t>;
+}
+
+void alt_cache_stats_t::perfmon_eviction_bags_t::visit_stats(void *ptr) {
+    if (get_thread_id() == parent->home_thread()) {
+        auto *bags = reinterpret_cast<std::vector<eviction_bag_stats_t> *>(ptr);
+        parent->page_cache->evicter().visit_bags(
+            [&](const char *name, const alt::eviction_bag_t *bag) {
+                bags->push_back(eviction_bag_stats_t{name, bag->hits(), bag->misses()});
+            });
+    }
+}
+
+ql::datum_t alt_cache_stats_t::perfmon_eviction_bags_t::end_stats(void *ptr) {
+    auto *bags = reinterpret_cast<std::vector<eviction_bag_stats_t> *>(ptr);
+    ql::datum_object_builder_t builder;
+    for (const auto &bag : *bags) {
+        ql::datum_object_builder_t bag_builder;
+        bag_builder.overwrite("hits", ql::datum_t(static_cast<double>(bag.hits)));
+        bag_builder.overwrite("misses",
+                              ql::datum_t(static_cast<double>(bag.misses)));
+        const uint64_t accesses = bag.hits + bag.misses;
+        bag_builder.overwrite("hit_rate", accesses == 0
+            ? ql::datum_t::null()
+            : ql::datum_t(static_cast<double>(bag.hits) / accesses));
+        builder.overwrite(bag.name.c_str(), std::move(bag_builder).to_datum());
+    }
+    delete bags;
+    return std::move(builder).to_datum();
+}
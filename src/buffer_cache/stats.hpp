@@ -28,6 +28,21 @@ public:
     perfmon_value_t in_use_bytes;
     perfmon_membership_t in_use_bytes_membership;
 
+    // Reports how many page acquisitions found their page in each eviction bag,
+    // and how many of them found it loaded.
+    class perfmon_eviction_bags_t : public perfmon_t {
+    public:
+        explicit perfmon_eviction_bags_t(alt_cache_stats_t *_parent);
+        void *begin_stats();
+        void visit_stats(void *);
+        ql::datum_t end_stats(void *);
+    private:
+        alt_cache_stats_t *parent;
+        DISABLE_COPYING(perfmon_eviction_bags_t);
+    };
+    perfmon_eviction_bags_t eviction_bags;
+    perfmon_membership_t eviction_bags_membership;
+
 
     perfmon_multi_membership_t cache_collection_membership;
 };
@@ -28,6 +28,7 @@
 #include "concurrency/coro_pool.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/queue/limited_fifo.hpp"
+#include "config/args.hpp"
 #include "crypto/error.hpp"
 #include "perfmon/perfmon.hpp"
 #include "rapidjson/document.h"
@@ -195,6 +196,9 @@ query_server_t::query_server_t(rdb_context_t *_rdb_ctx,
         tls_ctx(_tls_ctx),
         rdb_ctx(_rdb_ctx),
         handler(_handler),
+        crypto_pool(AUTH_CRYPTO_THREAD_COUNT,
+                    AUTH_KEY_CACHE_SIZE,
+                    &rdb_ctx->stats.qe_stats_collection),
         http_conn_cache(http_timeout_sec),
         next_thread(0) {
     rassert(rdb_ctx != nullptr);
@@ -258,6 +262,7 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
     on_thread_t rethreader(chosen_thread);
 
     scoped_ptr_t<tcp_conn_t> conn;
+    const ticks_t handshake_start_ticks = get_ticks();
 
     try {
         nconn->make_server_connection(tls_ctx, &conn, &ct_keepalive);
@@ -311,7 +316,8 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
         } else if (version < 10) {
             // We'll get std::make_unique in C++14
             authenticator.reset(
-                new auth::plaintext_authenticator_t(rdb_ctx->get_auth_watchable()));
+                new auth::plaintext_authenticator_t(
+                    rdb_ctx->get_auth_watchable(), &crypto_pool));
 
             uint32_t auth_key_size;
             conn->read_buffered(&auth_key_size, sizeof(uint32_t), &ct_keepalive);
@@ -352,7 +358,8 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
             conn->write(success_msg, strlen(success_msg) + 1, &ct_keepalive);
         } else {
             authenticator.reset(
-                new auth::scram_authenticator_t(rdb_ctx->get_auth_watchable()));
+                new auth::scram_authenticator_t(
+                    rdb_ctx->get_auth_watchable(), &crypto_pool));
 
             {
                 ql::datum_object_builder_t datum_object_builder;
@@ -441,6 +448,9 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
         UNUSED bool peer_res = conn->getpeername(&client_addr_port);
 
         guarantee(authenticator != nullptr);
+        rdb_ctx->stats.client_handshake_latency.record(
+            get_ticks() - handshake_start_ticks);
+
         ql::query_cache_t query_cache(
             rdb_ctx,
             client_addr_port,
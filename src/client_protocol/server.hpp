@@ -17,6 +17,7 @@
 #include "arch/io/openssl.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/timing.hpp"
+#include "clustering/administration/auth/crypto_pool.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 #include "containers/archive/archive.hpp"
@@ -137,6 +138,9 @@ private:
     rdb_context_t *const rdb_ctx;
     query_handler_t *const handler;
 
+    // Must outlive the handshakes that `drainer` waits for.
+    auth::crypto_pool_t crypto_pool;
+
     /* WARNING: The order here is fragile. */
     auto_drainer_t drainer;
     http_conn_cache_t http_conn_cache;
@@ -0,0 +1,102 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/auth/crypto_pool.hpp"
+
+#include "arch/io/blocker_pool.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "crypto/compare_equal.hpp"
+#include "crypto/hash.hpp"
+#include "crypto/hmac.hpp"
+#include "crypto/pbkcs5_pbkdf2_hmac.hpp"
+
+namespace auth {
+
+crypto_pool_t::crypto_pool_t(
+        int num_threads, size_t cache_size, perfmon_collection_t *stats)
+    : blocker_pool(new blocker_pool_t(
+          num_threads, &linux_thread_pool_t::get_thread()->queue)),
+      caches(cache_size),
+      pm_membership(stats,
+                    &pm_key_derivations, "auth_key_derivations",
+                    &pm_cache_hits, "auth_key_cache_hits") { }
+
+crypto_pool_t::~crypto_pool_t() {
+    assert_thread();
+}
+
+bool crypto_pool_t::check_password(
+        username_t const &username,
+        password_t const &user_password,
+        std::string const &password) {
+    // The digest is keyed with the salted password, so remembering it doesn't make
+    // the password any easier to recover than the salted password itself.
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> digest =
+        crypto::hmac_sha256(user_password.get_hash(), password);
+    {
+        cache_entry_t *entry = get_cache_entry(username, user_password);
+        if (static_cast<bool>(entry->verified_password) &&
+                crypto::compare_equal(*entry->verified_password, digest)) {
+            ++pm_cache_hits;
+            return true;
+        }
+    }
+
+    ++pm_key_derivations;
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> hash;
+    run_in_pool([&]() {
+        hash = crypto::pbkcs5_pbkdf2_hmac_sha256(
+            password, user_password.get_salt(), user_password.get_iteration_count());
+    });
+    if (!crypto::compare_equal(user_password.get_hash(), hash)) {
+        return false;
+    }
+
+    // Other handshakes on this thread may have evicted the entry in the meantime.
+    get_cache_entry(username, user_password)->verified_password = digest;
+    return true;
+}
+
+scram_keys_t crypto_pool_t::get_scram_keys(
+        username_t const &username,
+        password_t const &user_password) {
+    cache_entry_t *entry = get_cache_entry(username, user_password);
+    if (static_cast<bool>(entry->scram_keys)) {
+        ++pm_cache_hits;
+        return *entry->scram_keys;
+    }
+
+    // These are only a few HMACs, so unlike PBKDF2 they are not worth a trip to the
+    // blocker pool.
+    scram_keys_t keys;
+    keys.client_key = crypto::hmac_sha256(user_password.get_hash(), "Client Key");
+    keys.stored_key = crypto::sha256(keys.client_key);
+    keys.server_key = crypto::hmac_sha256(user_password.get_hash(), "Server Key");
+    entry->scram_keys = keys;
+    return keys;
+}
+
+crypto_pool_t::cache_entry_t *crypto_pool_t::get_cache_entry(
+        username_t const &username,
+        password_t const &user_password) {
+    cache_t *cache = caches.get();
+    cache_t::iterator it = cache->find(username);
+    if (it != cache->end() && it->second.password == user_password) {
+        return &it->second;
+    }
+    cache_entry_t *entry = &(*cache)[username];
+    *entry = cache_entry_t();
+    entry->password = user_password;
+    return entry;
+}
+
+template <class Callable>
+void crypto_pool_t::run_in_pool(const Callable &fn) {
+    // `done()` runs on our home thread, and `notify_sometime()` takes care of
+    // resuming the coroutine on whichever thread it is on.
+    generic_job_t<Callable> job;
+    job.fn = &fn;
+    job.suspended = coro_t::self();
+    blocker_pool->do_job(&job);
+    coro_t::wait();
+}
+
+}  // namespace auth
@@ -0,0 +1,96 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_AUTH_CRYPTO_POOL_HPP
+#define CLUSTERING_ADMINISTRATION_AUTH_CRYPTO_POOL_HPP
+
+#include <openssl/sha.h>
+
+#include <array>
+#include <string>
+
+#include "errors.hpp"
+#include <boost/optional.hpp>
+
+#include "clustering/administration/auth/password.hpp"
+#include "clustering/administration/auth/username.hpp"
+#include "concurrency/one_per_thread.hpp"
+#include "containers/lru_cache.hpp"
+#include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
+#include "threading.hpp"
+
+class blocker_pool_t;
+
+namespace auth {
+
+struct scram_keys_t {
+    // ClientKey := HMAC(SaltedPassword, "Client Key")
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> client_key;
+    // StoredKey := H(ClientKey)
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> stored_key;
+    // ServerKey := HMAC(SaltedPassword, "Server Key")
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> server_key;
+};
+
+/* `crypto_pool_t` does the password hashing for the client handshakes of a
+`query_server_t`. PBKDF2 with the default iteration count takes milliseconds of CPU
+time, which used to be spent on the connection's thread, so a burst of reconnecting
+clients stalled every other coroutine on the server's threads. Instead it runs on a
+fixed number of dedicated threads, and handshakes queue up for them.
+
+It also caches what it derives per user, in a bounded LRU cache per thread. An entry
+is only used as long as the user's password is the one it was derived from, so
+changing a password invalidates it. For the plaintext authentication of old drivers,
+the cache remembers a keyed digest of the last password that was verified, so only
+wrong passwords and the first handshake with a new password pay for PBKDF2. */
+
+class crypto_pool_t : public home_thread_mixin_t {
+public:
+    crypto_pool_t(int num_threads, size_t cache_size, perfmon_collection_t *stats);
+    ~crypto_pool_t();
+
+    /* Returns whether `password` hashes to `user_password`, the current password of
+    `username`. Can be called on any thread. */
+    bool check_password(
+        username_t const &username,
+        password_t const &user_password,
+        std::string const &password);
+
+    /* Returns the SCRAM keys of `user_password`, the current password of
+    `username`. Can be called on any thread. */
+    scram_keys_t get_scram_keys(
+        username_t const &username,
+        password_t const &user_password);
+
+private:
+    struct cache_entry_t {
+        // The password the rest of the entry was derived from
+        password_t password;
+        boost::optional<scram_keys_t> scram_keys;
+        // HMAC(SaltedPassword, password) of the last password that was verified
+        boost::optional<std::array<unsigned char, SHA256_DIGEST_LENGTH> >
+            verified_password;
+    };
+    typedef lru_cache_t<username_t, cache_entry_t> cache_t;
+
+    // Returns the entry of `username` in this thread's cache, after resetting it if
+    // it was derived from a different password than `user_password`.
+    cache_entry_t *get_cache_entry(
+        username_t const &username,
+        password_t const &user_password);
+
+    template <class Callable>
+    void run_in_pool(const Callable &fn);
+
+    scoped_ptr_t<blocker_pool_t> blocker_pool;
+    one_per_thread_t<cache_t> caches;
+
+    perfmon_counter_t pm_key_derivations;
+    perfmon_counter_t pm_cache_hits;
+    perfmon_multi_membership_t pm_membership;
+
+    DISABLE_COPYING(crypto_pool_t);
+};
+
+}  // namespace auth
+
+#endif  // CLUSTERING_ADMINISTRATION_AUTH_CRYPTO_POOL_HPP
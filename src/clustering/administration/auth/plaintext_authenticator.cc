@@ -3,16 +3,16 @@
 
 #include "clustering/administration/auth/authentication_error.hpp"
 #include "clustering/administration/metadata.hpp"
-#include "crypto/compare_equal.hpp"
-#include "crypto/pbkcs5_pbkdf2_hmac.hpp"
 #include "crypto/saslprep.hpp"
 
 namespace auth {
 
 plaintext_authenticator_t::plaintext_authenticator_t(
         clone_ptr_t<watchable_t<auth_semilattice_metadata_t>> auth_watchable,
+        crypto_pool_t *crypto_pool,
         username_t const &username)
     : base_authenticator_t(auth_watchable),
+      m_crypto_pool(crypto_pool),
       m_username(username),
       m_is_authenticated(false) {
 }
@@ -34,13 +34,8 @@ plaintext_authenticator_t::plaintext_authenticator_t(
         throw authentication_error_t(17, "Unknown user");
     }
 
-    std::array<unsigned char, SHA256_DIGEST_LENGTH> hash =
-        crypto::pbkcs5_pbkdf2_hmac_sha256(
-            crypto::saslprep(password),
-            user->get_password().get_salt(),
-            user->get_password().get_iteration_count());
-
-    if (!crypto::compare_equal(user->get_password().get_hash(), hash)) {
+    if (!m_crypto_pool->check_password(
+            m_username, user->get_password(), crypto::saslprep(password))) {
         throw authentication_error_t(12, "Wrong password");
     }
 
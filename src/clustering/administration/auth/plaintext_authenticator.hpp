@@ -8,6 +8,7 @@
 #include <boost/optional.hpp>
 
 #include "clustering/administration/auth/base_authenticator.hpp"
+#include "clustering/administration/auth/crypto_pool.hpp"
 #include "clustering/administration/auth/user.hpp"
 
 namespace auth {
@@ -16,6 +17,7 @@ class plaintext_authenticator_t : public base_authenticator_t {
 public:
     plaintext_authenticator_t(
         clone_ptr_t<watchable_t<auth_semilattice_metadata_t>> auth_watchable,
+        crypto_pool_t *crypto_pool,
         username_t const &username = username_t("admin"));
 
     /* virtual */ std::string next_message(std::string const &)
@@ -24,6 +26,7 @@ public:
             THROWS_ONLY(authentication_error_t);
 
 private:
+    crypto_pool_t *m_crypto_pool;
     username_t m_username;
     bool m_is_authenticated;
 };
@@ -6,15 +6,16 @@
 #include "clustering/administration/auth/username.hpp"
 #include "crypto/base64.hpp"
 #include "crypto/error.hpp"
-#include "crypto/hash.hpp"
 #include "crypto/hmac.hpp"
 #include "crypto/random.hpp"
 
 namespace auth {
 
 scram_authenticator_t::scram_authenticator_t(
-        clone_ptr_t<watchable_t<auth_semilattice_metadata_t>> auth_watchable)
+        clone_ptr_t<watchable_t<auth_semilattice_metadata_t>> auth_watchable,
+        crypto_pool_t *crypto_pool)
     : base_authenticator_t(auth_watchable),
+      m_crypto_pool(crypto_pool),
       m_state(state_t::FIRST_MESSAGE) {
 }
 
@@ -85,13 +86,9 @@ std::string scram_authenticator_t::next_message(std::string const &message)
                     throw authentication_error_t(17, "Unknown user");
                 }
 
-                // ClientKey := HMAC(SaltedPassword, "Client Key")
-                std::array<unsigned char, SHA256_DIGEST_LENGTH> client_key =
-                    crypto::hmac_sha256(m_password.get_hash(), "Client Key");
-
-                // StoredKey := H(ClientKey)
-                std::array<unsigned char, SHA256_DIGEST_LENGTH> stored_key =
-                    crypto::sha256(client_key);
+                // ClientKey, StoredKey and ServerKey only depend on the password
+                scram_keys_t keys =
+                    m_crypto_pool->get_scram_keys(m_username, m_password);
 
                 /* AuthMessage := client-first-message-bare + "," +
                                   server-first-message + "," +
@@ -103,12 +100,12 @@ std::string scram_authenticator_t::next_message(std::string const &message)
 
                 // ClientSignature := HMAC(StoredKey, AuthMessage)
                 std::array<unsigned char, SHA256_DIGEST_LENGTH> client_signature =
-                    crypto::hmac_sha256(stored_key, auth_message);
+                    crypto::hmac_sha256(keys.stored_key, auth_message);
 
                 // ClientProof := ClientKey XOR ClientSignature
                 std::array<unsigned char, SHA256_DIGEST_LENGTH> client_proof;
                 for (size_t i = 0; i < SHA256_DIGEST_LENGTH; ++i) {
-                    client_proof[i] = (client_key[i] ^ client_signature[i]);
+                    client_proof[i] = (keys.client_key[i] ^ client_signature[i]);
                 }
 
                 std::map<char, std::string> attributes = split_attributes(message);
@@ -144,13 +141,9 @@ std::string scram_authenticator_t::next_message(std::string const &message)
                     throw authentication_error_t(10, "Invalid encoding");
                 }
 
-                // ServerKey := HMAC(SaltedPassword, "Server Key")
-                std::array<unsigned char, SHA256_DIGEST_LENGTH> server_key =
-                    crypto::hmac_sha256(m_password.get_hash(), "Server Key");
-
                 // ServerSignature := HMAC(ServerKey, AuthMessage)
                 std::array<unsigned char, SHA256_DIGEST_LENGTH> server_signature =
-                    crypto::hmac_sha256(server_key, auth_message);
+                    crypto::hmac_sha256(keys.server_key, auth_message);
 
                 return "v=" + crypto::base64_encode(server_signature);
             }
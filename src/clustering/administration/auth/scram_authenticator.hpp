@@ -6,6 +6,7 @@
 #include <string>
 
 #include "clustering/administration/auth/base_authenticator.hpp"
+#include "clustering/administration/auth/crypto_pool.hpp"
 #include "clustering/administration/auth/password.hpp"
 #include "clustering/administration/auth/username.hpp"
 #include "clustering/administration/metadata.hpp"
@@ -15,7 +16,8 @@ namespace auth {
 class scram_authenticator_t : public base_authenticator_t {
 public:
     scram_authenticator_t(
-        clone_ptr_t<watchable_t<auth_semilattice_metadata_t>> auth_watchable);
+        clone_ptr_t<watchable_t<auth_semilattice_metadata_t>> auth_watchable,
+        crypto_pool_t *crypto_pool);
 
     /* virtual */ std::string next_message(std::string const &)
             THROWS_ONLY(authentication_error_t);
@@ -26,6 +28,7 @@ public:
     static username_t saslname_decode(std::string const &saslname);
 
 private:
+    crypto_pool_t *m_crypto_pool;
     enum class state_t{FIRST_MESSAGE, FINAL_MESSAGE, ERROR, AUTHENTICATED} m_state;
     std::string m_client_first_message_bare;
     username_t m_username;
@@ -164,6 +164,7 @@ void jobs_manager_t::on_get_job_reports(
                     table_id,
                     backfill.second.is_ready,
                     backfill.second.progress,
+                    backfill.second.keys_received,
                     backfill.second.source_server_id,
                     server_id);
             }
@@ -55,6 +55,7 @@ backfill_job_report_t::backfill_job_report_t(
         namespace_id_t const &_table,
         bool _is_ready,
         double _progress,
+        uint64_t _keys_received,
         server_id_t const &_source_server,
         server_id_t const &_destination_server)
     : job_report_base_t<backfill_job_report_t>("backfill", _id, _duration, _server_id),
@@ -62,6 +63,7 @@ backfill_job_report_t::backfill_job_report_t(
       is_ready(_is_ready),
       progress_numerator(_progress),
       progress_denominator(1.0),
+      keys_received(_keys_received),
       source_server(_source_server),
       destination_server(_destination_server) {
     servers.insert({source_server, destination_server});
@@ -72,6 +74,7 @@ void backfill_job_report_t::merge_derived(
     is_ready &= job_report.is_ready;
     progress_numerator += job_report.progress_numerator;
     progress_denominator += job_report.progress_denominator;
+    keys_received += job_report.keys_received;
 }
 
 bool backfill_job_report_t::info_derived(
@@ -127,11 +130,17 @@ bool backfill_job_report_t::info_derived(
 
     info_builder_out->overwrite("progress",
         ql::datum_t(progress_numerator / progress_denominator));
+    // `duration` is the longest duration of the merged backfills, so this is the
+    // combined throughput of all of them.
+    info_builder_out->overwrite("keys_per_sec",
+        duration > 0
+            ? ql::datum_t(static_cast<double>(keys_received) / (duration / 1e6))
+            : ql::datum_t::null());
 
     return true;
 }
 
-RDB_IMPL_SERIALIZABLE_10_FOR_CLUSTER(
+RDB_IMPL_SERIALIZABLE_11_FOR_CLUSTER(
     backfill_job_report_t,
     type,
     id,
@@ -141,6 +150,7 @@ RDB_IMPL_SERIALIZABLE_10_FOR_CLUSTER(
     is_ready,
     progress_numerator,
     progress_denominator,
+    keys_received,
     source_server,
     destination_server);
 
@@ -59,6 +59,7 @@ public:
             namespace_id_t const &table,
             bool is_ready,
             double progress,
+            uint64_t keys_received,
             server_id_t const &source_server,
             server_id_t const &destination_server);
 
@@ -75,6 +76,7 @@ public:
     bool is_ready;
     double progress_numerator;
     double progress_denominator;
+    uint64_t keys_received;
     server_id_t source_server;
     server_id_t destination_server;
 };
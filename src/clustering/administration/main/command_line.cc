@@ -61,9 +61,11 @@
 #include "clustering/administration/persist/migrate/migrate_v1_16.hpp"
 #include "clustering/administration/persist/migrate/migrate_v2_1.hpp"
 #include "clustering/administration/servers/server_metadata.hpp"
+#include "clustering/immediate_consistency/remote_replicator_server.hpp"
 #include "containers/scoped.hpp"
 #include "crypto/random.hpp"
 #include "logger.hpp"
+#include "rdb_protocol/changefeed.hpp"
 
 #define RETHINKDB_EXPORT_SCRIPT "rethinkdb-export"
 #define RETHINKDB_IMPORT_SCRIPT "rethinkdb-import"
@@ -459,6 +461,62 @@ boost::optional<int> parse_join_delay_secs_option(
     }
 }
 
+int64_t parse_replication_batch_latency_ms_option(
+        const std::map<std::string, options::values_t> &opts) {
+    const std::string latency_opt =
+        get_single_option(opts, "--replication-batch-latency");
+    uint64_t latency_ms;
+    if (!strtou64_strict(latency_opt, 10, &latency_ms)) {
+        throw std::runtime_error(strprintf(
+                "ERROR: replication-batch-latency should be a number, got '%s'",
+                latency_opt.c_str()));
+    }
+    if (latency_ms > static_cast<uint64_t>(
+            remote_replicator_server_t::MAX_MAX_BATCH_LATENCY_MS)) {
+        throw std::runtime_error(strprintf(
+                "ERROR: replication-batch-latency is too large. Must be at most %"
+                    PRIi64,
+                remote_replicator_server_t::MAX_MAX_BATCH_LATENCY_MS));
+    }
+    return static_cast<int64_t>(latency_ms);
+}
+
+int64_t parse_changefeed_batch_window_ms_option(
+        const std::map<std::string, options::values_t> &opts) {
+    const std::string window_opt = get_single_option(opts, "--changefeed-batch-window");
+    uint64_t window_ms;
+    if (!strtou64_strict(window_opt, 10, &window_ms)) {
+        throw std::runtime_error(strprintf(
+                "ERROR: changefeed-batch-window should be a number, got '%s'",
+                window_opt.c_str()));
+    }
+    if (window_ms > static_cast<uint64_t>(
+            ql::changefeed::server_t::MAX_BATCH_WINDOW_MS)) {
+        throw std::runtime_error(strprintf(
+                "ERROR: changefeed-batch-window is too large. Must be at most %"
+                    PRIi64,
+                ql::changefeed::server_t::MAX_BATCH_WINDOW_MS));
+    }
+    return static_cast<int64_t>(window_ms);
+}
+
+size_t parse_changefeed_batch_max_msgs_option(
+        const std::map<std::string, options::values_t> &opts) {
+    const std::string size_opt = get_single_option(opts, "--changefeed-batch-size");
+    uint64_t max_msgs;
+    if (!strtou64_strict(size_opt, 10, &max_msgs)) {
+        throw std::runtime_error(strprintf(
+                "ERROR: changefeed-batch-size should be a number, got '%s'",
+                size_opt.c_str()));
+    }
+    if (max_msgs < 1 || max_msgs > ql::changefeed::server_t::MAX_BATCH_MAX_MSGS) {
+        throw std::runtime_error(strprintf(
+                "ERROR: changefeed-batch-size must be between 1 and %zu",
+                ql::changefeed::server_t::MAX_BATCH_MAX_MSGS));
+    }
+    return static_cast<size_t>(max_msgs);
+}
+
 boost::optional<int> parse_node_reconnect_timeout_secs_option(
         const std::map<std::string, options::values_t> &opts) {
     if (exists_option(opts, "--cluster-reconnect-timeout")) {
@@ -1045,6 +1103,7 @@ void run_rethinkdb_create(const base_path_t &base_path,
                           boost::optional<uint64_t> total_cache_size,
                           const file_direct_io_mode_t direct_io_mode,
                           const int max_concurrent_io_requests,
+                          const file_io_backend_t io_backend,
                           bool *const result_out) {
     server_id_t our_server_id = server_id_t::generate_server_id();
 
@@ -1058,7 +1117,7 @@ void run_rethinkdb_create(const base_path_t &base_path,
     server_config.config.cache_size_bytes = total_cache_size;
     server_config.version = 1;
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests, io_backend);
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -1139,6 +1198,7 @@ void run_rethinkdb_serve(const base_path_t &base_path,
                          const std::string &initial_password,
                          const file_direct_io_mode_t direct_io_mode,
                          const int max_concurrent_io_requests,
+                         const file_io_backend_t io_backend,
                          const boost::optional<boost::optional<uint64_t> >
                             &total_cache_size,
                          const server_id_t *our_server_id,
@@ -1156,7 +1216,7 @@ void run_rethinkdb_serve(const base_path_t &base_path,
 
     logNTC("Loading data from directory %s\n", base_path.path().c_str());
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests, io_backend);
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -1284,6 +1344,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
                              const std::string &initial_password,
                              const file_direct_io_mode_t direct_io_mode,
                              const int max_concurrent_io_requests,
+                             const file_io_backend_t io_backend,
                              const boost::optional<boost::optional<uint64_t> >
                                 &total_cache_size,
                              const bool new_directory,
@@ -1292,7 +1353,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
                              bool *const result_out) {
     if (!new_directory) {
         run_rethinkdb_serve(base_path, serve_info, initial_password, direct_io_mode,
-                            max_concurrent_io_requests, total_cache_size,
+                            max_concurrent_io_requests, io_backend, total_cache_size,
                             nullptr, nullptr, nullptr, data_directory_lock,
                             result_out);
     } else {
@@ -1328,7 +1389,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
         server_config.version = 1;
 
         run_rethinkdb_serve(base_path, serve_info, initial_password, direct_io_mode,
-                            max_concurrent_io_requests,
+                            max_concurrent_io_requests, io_backend,
                             boost::optional<boost::optional<uint64_t> >(),
                             &our_server_id, &server_config, &cluster_metadata,
                             data_directory_lock, result_out);
@@ -1407,6 +1468,12 @@ options::help_section_t get_file_options(std::vector<options::option_t> *options
                                              strprintf("%d", DEFAULT_MAX_CONCURRENT_IO_REQUESTS)));
     help.add("--io-threads n",
              "how many simultaneous I/O operations can happen at the same time");
+    options_out->push_back(options::option_t(options::names_t("--io-backend"),
+                                             options::OPTIONAL,
+                                             "pool"));
+    help.add("--io-backend pool|aio|io_uring",
+             "how I/O operations are handed to the kernel: blocking calls on a thread "
+             "pool, or submitted asynchronously through Linux AIO or io_uring");
 #ifndef _WIN32
     // TODO WINDOWS: accept this option, but error out if it is passed
     options_out->push_back(options::option_t(options::names_t("--direct-io"),
@@ -1624,6 +1691,35 @@ options::help_section_t get_network_options(const bool join_required, std::vecto
                                                     "before giving up, the default is "
                                                     "24 hours");
 
+    options_out->push_back(options::option_t(options::names_t("--cluster-compression"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--cluster-compression", "compress large messages to other servers that "
+                                      "support it");
+
+    options_out->push_back(options::option_t(
+        options::names_t("--replication-batch-latency"),
+        options::OPTIONAL,
+        strprintf("%" PRIi64,
+                  remote_replicator_server_t::DEFAULT_MAX_BATCH_LATENCY_MS)));
+    help.add("--replication-batch-latency ms", "how many milliseconds a primary replica "
+                                               "may hold back writes to send more of "
+                                               "them to the other replicas at once");
+
+    options_out->push_back(options::option_t(
+        options::names_t("--changefeed-batch-window"),
+        options::OPTIONAL,
+        strprintf("%" PRIi64, ql::changefeed::server_t::DEFAULT_BATCH_WINDOW_MS)));
+    help.add("--changefeed-batch-window ms", "how many milliseconds a server may hold "
+                                             "back changes to send more of them to a "
+                                             "changefeed at once");
+
+    options_out->push_back(options::option_t(
+        options::names_t("--changefeed-batch-size"),
+        options::OPTIONAL,
+        strprintf("%zu", ql::changefeed::server_t::DEFAULT_BATCH_MAX_MSGS)));
+    help.add("--changefeed-batch-size n", "the largest number of changes a server "
+                                          "sends to a changefeed at once");
+
     return help;
 }
 
@@ -1887,6 +1983,22 @@ MUST_USE bool parse_io_threads_option(const std::map<std::string, options::value
     return true;
 }
 
+MUST_USE bool parse_io_backend_option(const std::map<std::string, options::values_t> &opts,
+                                      file_io_backend_t *io_backend_out) {
+    const std::string io_backend = get_single_option(opts, "--io-backend");
+    if (io_backend == "pool") {
+        *io_backend_out = file_io_backend_t::blocker_pool;
+    } else if (io_backend == "aio") {
+        *io_backend_out = file_io_backend_t::linux_aio;
+    } else if (io_backend == "io_uring") {
+        *io_backend_out = file_io_backend_t::io_uring;
+    } else {
+        fprintf(stderr, "ERROR: io-backend must be one of 'pool', 'aio' or 'io_uring'\n");
+        return false;
+    }
+    return true;
+}
+
 update_check_t parse_update_checking_option(const std::map<std::string, options::values_t> &opts) {
     return exists_option(opts, "--no-update-check")
         ? update_check_t::do_not_perform
@@ -1929,6 +2041,11 @@ int main_rethinkdb_create(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        file_io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
         const int num_workers = get_cpu_count();
 
         bool is_new_directory = false;
@@ -1958,6 +2075,7 @@ int main_rethinkdb_create(int argc, char *argv[]) {
                                      total_cache_size,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      &result),
                            num_workers);
 
@@ -2057,6 +2175,11 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        file_io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
         update_check_t do_update_checking = parse_update_checking_option(opts);
 
         boost::optional<boost::optional<uint64_t> > total_cache_size =
@@ -2109,7 +2232,11 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                 node_reconnect_timeout_secs
                                     ? node_reconnect_timeout_secs.get()
                                     : cluster_defaults::reconnect_timeout,
-                                tls_configs);
+                                tls_configs,
+                                exists_option(opts, "--cluster-compression"),
+                                parse_replication_batch_latency_ms_option(opts),
+                                parse_changefeed_batch_window_ms_option(opts),
+                                parse_changefeed_batch_max_msgs_option(opts));
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
@@ -2120,6 +2247,7 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                      initial_password,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      total_cache_size,
                                      static_cast<server_id_t*>(nullptr),
                                      static_cast<server_config_versioned_t *>(nullptr),
@@ -2214,7 +2342,11 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
                                 node_reconnect_timeout_secs
                                     ? node_reconnect_timeout_secs.get()
                                     : cluster_defaults::reconnect_timeout,
-                                tls_configs);
+                                tls_configs,
+                                exists_option(opts, "--cluster-compression"),
+                                parse_replication_batch_latency_ms_option(opts),
+                                parse_changefeed_batch_window_ms_option(opts),
+                                parse_changefeed_batch_max_msgs_option(opts));
 
         bool result;
         run_in_thread_pool(
@@ -2332,6 +2464,11 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        file_io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
         update_check_t do_update_checking = parse_update_checking_option(opts);
 
         boost::optional<int> join_delay_secs = parse_join_delay_secs_option(opts);
@@ -2406,7 +2543,11 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                 node_reconnect_timeout_secs
                                     ? node_reconnect_timeout_secs.get()
                                     : cluster_defaults::reconnect_timeout,
-                                tls_configs);
+                                tls_configs,
+                                exists_option(opts, "--cluster-compression"),
+                                parse_replication_batch_latency_ms_option(opts),
+                                parse_changefeed_batch_window_ms_option(opts),
+                                parse_changefeed_batch_max_msgs_option(opts));
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
@@ -2418,6 +2559,7 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                      initial_password,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      total_cache_size,
                                      is_new_directory,
                                      &serve_info,
@@ -235,7 +235,8 @@ bool do_serve(io_backender_t *io_backender,
                 serve_info.ports.client_port,
                 semilattice_manager_heartbeat.get_root_view(),
                 semilattice_manager_auth.get_root_view(),
-                serve_info.tls_configs.cluster.get()));
+                serve_info.tls_configs.cluster.get(),
+                serve_info.cluster_compression));
         } catch (const address_in_use_exc_t &ex) {
             throw address_in_use_exc_t(strprintf("Could not bind to cluster port: %s", ex.what()));
         }
@@ -282,7 +283,11 @@ bool do_serve(io_backender_t *io_backender,
                               nullptr,   /* we'll fill this in later */
                               semilattice_manager_auth.get_root_view(),
                               &get_global_perfmon_collection(),
-                              serve_info.reql_http_proxy);
+                              serve_info.reql_http_proxy,
+                              io_backender,
+                              base_path,
+                              serve_info.changefeed_batch_window_ms,
+                              serve_info.changefeed_batch_max_msgs);
         {
             /* Extract a subview of the directory with all the table meta manager
             business cards. */
@@ -322,6 +327,7 @@ bool do_serve(io_backender_t *io_backender,
                     table_persistence_interface.get(),
                     base_path,
                     io_backender,
+                    serve_info.replication_batch_latency_ms,
                     &perfmon_collection_repo));
             } else {
                 /* Proxies still need a `multi_table_manager_t` because it takes care of
@@ -120,7 +120,11 @@ public:
                  std::vector<std::string> &&_argv,
                  const int _join_delay_secs,
                  const int _node_reconnect_timeout_secs,
-                 tls_configs_t _tls_configs) :
+                 tls_configs_t _tls_configs,
+                 bool _cluster_compression,
+                 int64_t _replication_batch_latency_ms,
+                 int64_t _changefeed_batch_window_ms,
+                 size_t _changefeed_batch_max_msgs) :
         joins(std::move(_joins)),
         reql_http_proxy(std::move(_reql_http_proxy)),
         web_assets(std::move(_web_assets)),
@@ -129,7 +133,11 @@ public:
         config_file(_config_file),
         argv(std::move(_argv)),
         join_delay_secs(_join_delay_secs),
-        node_reconnect_timeout_secs(_node_reconnect_timeout_secs)
+        node_reconnect_timeout_secs(_node_reconnect_timeout_secs),
+        cluster_compression(_cluster_compression),
+        replication_batch_latency_ms(_replication_batch_latency_ms),
+        changefeed_batch_window_ms(_changefeed_batch_window_ms),
+        changefeed_batch_max_msgs(_changefeed_batch_max_msgs)
     {
         tls_configs = _tls_configs;
     }
@@ -151,6 +159,15 @@ public:
     int join_delay_secs;
     int node_reconnect_timeout_secs;
     tls_configs_t tls_configs;
+    /* Whether to compress large messages to other servers that can decompress them. */
+    bool cluster_compression;
+    /* How long a primary replica waits for more sync writes before it sends them to a
+    secondary replica in one message. */
+    int64_t replication_batch_latency_ms;
+    /* How long a changefeed server collects changes for a client before it sends them
+    in one message, and how many changes it sends at most. */
+    int64_t changefeed_batch_window_ms;
+    size_t changefeed_batch_max_msgs;
 };
 
 /* This has been factored out from `command_line.hpp` because it takes a very
@@ -21,6 +21,25 @@ RDB_IMPL_SERIALIZABLE_1_SINCE_v2_1(heartbeat_semilattice_metadata_t, heartbeat_t
 RDB_IMPL_SEMILATTICE_JOINABLE_1(heartbeat_semilattice_metadata_t, heartbeat_timeout);
 RDB_IMPL_EQUALITY_COMPARABLE_1(heartbeat_semilattice_metadata_t, heartbeat_timeout);
 
+void semilattice_delta(const cluster_semilattice_metadata_t &base,
+                       const cluster_semilattice_metadata_t &added,
+                       cluster_semilattice_metadata_t *delta_out) {
+    semilattice_delta(base.databases.databases, added.databases.databases,
+                      &delta_out->databases.databases);
+}
+
+void semilattice_delta(const auth_semilattice_metadata_t &base,
+                       const auth_semilattice_metadata_t &added,
+                       auth_semilattice_metadata_t *delta_out) {
+    semilattice_delta(base.m_users, added.m_users, &delta_out->m_users);
+}
+
+void semilattice_delta(const heartbeat_semilattice_metadata_t &,
+                       const heartbeat_semilattice_metadata_t &added,
+                       heartbeat_semilattice_metadata_t *delta_out) {
+    *delta_out = added;
+}
+
 RDB_IMPL_SERIALIZABLE_9_FOR_CLUSTER(proc_directory_metadata_t,
     version,
     time_started,
@@ -34,6 +34,9 @@ public:
 
 RDB_DECLARE_SERIALIZABLE(cluster_semilattice_metadata_t);
 RDB_DECLARE_SEMILATTICE_JOINABLE(cluster_semilattice_metadata_t);
+void semilattice_delta(const cluster_semilattice_metadata_t &base,
+                       const cluster_semilattice_metadata_t &added,
+                       cluster_semilattice_metadata_t *delta_out);
 RDB_DECLARE_EQUALITY_COMPARABLE(cluster_semilattice_metadata_t);
 
 class auth_semilattice_metadata_t {
@@ -77,6 +80,9 @@ public:
 
 RDB_DECLARE_SERIALIZABLE(auth_semilattice_metadata_t);
 RDB_DECLARE_SEMILATTICE_JOINABLE(auth_semilattice_metadata_t);
+void semilattice_delta(const auth_semilattice_metadata_t &base,
+                       const auth_semilattice_metadata_t &added,
+                       auth_semilattice_metadata_t *delta_out);
 RDB_DECLARE_EQUALITY_COMPARABLE(auth_semilattice_metadata_t);
 
 class heartbeat_semilattice_metadata_t {
@@ -89,6 +95,9 @@ public:
 
 RDB_DECLARE_SERIALIZABLE(heartbeat_semilattice_metadata_t);
 RDB_DECLARE_SEMILATTICE_JOINABLE(heartbeat_semilattice_metadata_t);
+void semilattice_delta(const heartbeat_semilattice_metadata_t &base,
+                       const heartbeat_semilattice_metadata_t &added,
+                       heartbeat_semilattice_metadata_t *delta_out);
 RDB_DECLARE_EQUALITY_COMPARABLE(heartbeat_semilattice_metadata_t);
 
 enum cluster_directory_peer_type_t {
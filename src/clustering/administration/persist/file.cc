@@ -8,6 +8,7 @@
 #include "buffer_cache/serialize_onto_blob.hpp"
 #include "clustering/administration/persist/migrate/migrate_v1_16.hpp"
 #include "clustering/administration/persist/migrate/migrate_v2_1.hpp"
+#include "clustering/administration/persist/migrate/migrate_v2_4.hpp"
 #include "clustering/administration/persist/migrate/rewrite.hpp"
 #include "config/args.hpp"
 #include "logger.hpp"
@@ -25,7 +26,7 @@ ATTR_PACKED(struct metadata_disk_superblock_t {
 
 // Etymology: In version 1.13, the magic was 'RDmd', for "(R)ethink(D)B (m)eta(d)ata".
 // Every subsequent version, the last character has been incremented.
-static const block_magic_t metadata_sb_magic = { { 'R', 'D', 'm', 'l' } };
+static const block_magic_t metadata_sb_magic = { { 'R', 'D', 'm', 'm' } };
 
 void init_metadata_superblock(void *sb_void, size_t block_size) {
     memset(sb_void, 0, block_size);
@@ -56,13 +57,14 @@ cluster_version_t magic_to_version(block_magic_t magic) {
     case 'j': return cluster_version_t::v2_2;
     case 'k': return cluster_version_t::v2_3;
     case 'l': return cluster_version_t::v2_4;
+    case 'm': return cluster_version_t::v2_5;
     default:
         fail_due_to_user_error("You're trying to use an earlier version of RethinkDB "
             "to open a database created by a later version of RethinkDB.");
     }
     // This is here so you don't forget to add new versions above.
     // Please also update the value of metadata_sb_magic at the top of this file!
-    static_assert(cluster_version_t::LATEST_DISK == cluster_version_t::v2_4,
+    static_assert(cluster_version_t::LATEST_DISK == cluster_version_t::v2_5,
         "Please add new version to magic_to_version.");
 }
 
@@ -121,6 +123,9 @@ public:
     block_magic_t btree_leaf_magic() const {
         return block_magic_t { { 'R', 'D', 'l', 'n' } };
     }
+    bool btree_leaf_key_prefixes() const {
+        return true;
+    }
     max_block_size_t block_size() const {
         return bs;
     }
@@ -354,10 +359,17 @@ metadata_file_t::metadata_file_t(
             migrate_metadata_v2_1_to_v2_3(
                 metadata_version, &write_txn, &non_interruptor);
         } break;
-        case cluster_version_t::v2_3:
-            // TODO migration to 2.4
-            break;
-        case cluster_version_t::v2_4_is_latest:
+        case cluster_version_t::v2_3: // fallthrough intentional
+        case cluster_version_t::v2_4: {
+            update_metadata_superblock_version(sb_data);
+            sb_write.reset();
+            sb_lock.reset();
+
+            logNTC("Migrating cluster metadata to v2.5");
+            migrate_metadata_v2_4_to_v2_5(
+                metadata_version, &write_txn, &non_interruptor);
+        } break;
+        case cluster_version_t::v2_5_is_latest:
             break; // Up-to-date, do nothing
         default: unreachable();
         }
@@ -301,6 +301,8 @@ void migrate_table(const server_id_t &this_server_id,
             metadata_v1_16::write_ack_config_t::mode_t::single ?
                 ::write_ack_config_t::SINGLE : ::write_ack_config_t::MAJORITY;
     config.config.durability = old_config.config.durability;
+    config.config.cpu_shards = CPU_SHARDING_FACTOR;
+    config.config.block_compression = block_codec_t::none;
     config.shard_scheme.split_points = old_config.shard_scheme.split_points;
 
     // Scan the servers in the old shard config - need to remove deleted and nil servers
@@ -418,7 +420,7 @@ void check_for_obsolete_sindexes(io_backender_t *io_backender,
 
                 pmap(CPU_SHARDING_FACTOR, [&](int index) {
                         perfmon_collection_t inner_dummy_stats;
-                        store_t store(cpu_sharding_subspace(index),
+                        store_t store(cpu_sharding_subspace(index, CPU_SHARDING_FACTOR),
                                       multiplexer.proxies[index],
                                       &balancer,
                                       "table_migration",
@@ -467,7 +469,7 @@ void migrate_tables(io_backender_t *io_backender,
 
                 pmap(CPU_SHARDING_FACTOR, [&](int index) {
                         perfmon_collection_t inner_dummy_stats;
-                        store_t store(cpu_sharding_subspace(index),
+                        store_t store(cpu_sharding_subspace(index, CPU_SHARDING_FACTOR),
                                       multiplexer.proxies[index],
                                       &balancer,
                                       "table_migration",
@@ -558,7 +560,8 @@ void migrate_cluster_metadata_to_v2_1(io_backender_t *io_backender,
                       case cluster_version_t::v2_1:
                       case cluster_version_t::v2_2:
                       case cluster_version_t::v2_3:
-                      case cluster_version_t::v2_4_is_latest:
+                      case cluster_version_t::v2_4:
+                      case cluster_version_t::v2_5_is_latest:
                       default:
                         unreachable();
                       }
@@ -578,7 +581,8 @@ void migrate_cluster_metadata_to_v2_1(io_backender_t *io_backender,
                       case cluster_version_t::v2_1:
                       case cluster_version_t::v2_2:
                       case cluster_version_t::v2_3:
-                      case cluster_version_t::v2_4_is_latest:
+                      case cluster_version_t::v2_4:
+                      case cluster_version_t::v2_5_is_latest:
                       default:
                         unreachable();
                       }
@@ -653,7 +657,8 @@ void migrate_auth_metadata_to_v2_1(io_backender_t *io_backender,
                       case cluster_version_t::v2_1:
                       case cluster_version_t::v2_2:
                       case cluster_version_t::v2_3:
-                      case cluster_version_t::v2_4_is_latest:
+                      case cluster_version_t::v2_4:
+                      case cluster_version_t::v2_5_is_latest:
                       default:
                           unreachable();
                       }
@@ -674,7 +679,8 @@ void migrate_auth_metadata_to_v2_1(io_backender_t *io_backender,
                       case cluster_version_t::v2_1:
                       case cluster_version_t::v2_2:
                       case cluster_version_t::v2_3:
-                      case cluster_version_t::v2_4_is_latest:
+                      case cluster_version_t::v2_4:
+                      case cluster_version_t::v2_5_is_latest:
                       default:
                           unreachable();
                       }
@@ -0,0 +1,50 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/persist/migrate/migrate_v2_4.hpp"
+
+#include "clustering/administration/metadata.hpp"
+#include "clustering/administration/persist/file_keys.hpp"
+#include "clustering/administration/persist/migrate/rewrite.hpp"
+#include "clustering/administration/persist/raft_storage_interface.hpp"
+#include "clustering/table_manager/table_metadata.hpp"
+
+template <cluster_version_t W>
+void migrate_metadata_v2_4_to_v2_5(metadata_file_t::write_txn_t *txn,
+                                   signal_t *interruptor) {
+    // Rewrite all metadata so it's serialized under the latest version
+    rewrite_metadata_values<W>(mdkey_cluster_semilattices(), txn, interruptor);
+    rewrite_metadata_values<W>(mdkey_auth_semilattices(), txn, interruptor);
+    rewrite_metadata_values<W>(mdkey_heartbeat_semilattices(), txn, interruptor);
+    rewrite_metadata_values<W>(mdkey_server_id(), txn, interruptor);
+    rewrite_metadata_values<W>(mdkey_server_config(), txn, interruptor);
+
+    rewrite_metadata_values<W>(mdprefix_table_active(), txn, interruptor);
+    rewrite_metadata_values<W>(mdprefix_table_inactive(), txn, interruptor);
+    rewrite_metadata_values<W>(mdprefix_table_raft_header(), txn, interruptor);
+    rewrite_metadata_values<W>(mdprefix_table_raft_snapshot(), txn, interruptor);
+    rewrite_metadata_values<W>(mdprefix_table_raft_log(), txn, interruptor);
+    rewrite_metadata_values<W>(mdprefix_branch_birth_certificate(), txn, interruptor);
+}
+
+void migrate_metadata_v2_4_to_v2_5(cluster_version_t serialization_version,
+                                   metadata_file_t::write_txn_t *txn,
+                                   signal_t *interruptor) {
+    switch (serialization_version) {
+    case cluster_version_t::v2_3:
+        // Table configurations don't have a write hook in v2_3
+        migrate_metadata_v2_4_to_v2_5<cluster_version_t::v2_3>(txn, interruptor);
+        break;
+    case cluster_version_t::v2_4:
+        migrate_metadata_v2_4_to_v2_5<cluster_version_t::v2_4>(txn, interruptor);
+        break;
+    case cluster_version_t::v2_5_is_latest:
+        break;
+    case cluster_version_t::v1_14:
+    case cluster_version_t::v1_15:
+    case cluster_version_t::v1_16:
+    case cluster_version_t::v2_0:
+    case cluster_version_t::v2_1:
+    case cluster_version_t::v2_2:
+    default:
+        unreachable();
+    }
+}
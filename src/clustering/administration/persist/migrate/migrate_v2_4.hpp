@@ -0,0 +1,14 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_PERSIST_MIGRATE_MIGRATE_V2_4_HPP_
+#define CLUSTERING_ADMINISTRATION_PERSIST_MIGRATE_MIGRATE_V2_4_HPP_
+
+#include "clustering/administration/persist/file.hpp"
+
+// This will migrate all metadata from the v2_3 or v2_4 format to v2_5, which adds
+// the number of CPU shards to the table configurations.  `serialization_version` is
+// the version the metadata is currently serialized under.
+void migrate_metadata_v2_4_to_v2_5(cluster_version_t serialization_version,
+                                   metadata_file_t::write_txn_t *txn,
+                                   signal_t *interruptor);
+
+#endif /* CLUSTERING_ADMINISTRATION_PERSIST_MIGRATE_MIGRATE_V2_4_HPP_ */
@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <array>
+#include <vector>
 
 #include "clustering/administration/persist/branch_history_manager.hpp"
 #include "clustering/administration/persist/file_keys.hpp"
@@ -19,10 +20,12 @@ class real_multistore_ptr_t :
 public:
     real_multistore_ptr_t(
             const namespace_id_t &table_id,
+            size_t _num_cpu_shards,
             const serializer_filepath_t &path,
             scoped_ptr_t<real_branch_history_manager_t> &&bhm,
             const base_path_t &base_path,
             io_backender_t *io_backender,
+            block_codec_t block_codec,
             cache_balancer_t *cache_balancer,
             rdb_context_t *rdb_context,
             perfmon_collection_t *perfmon_collection_serializers,
@@ -32,6 +35,7 @@ public:
                 namespace_id_t, std::pair<real_multistore_ptr_t *, auto_drainer_t::lock_t>
             > *real_multistores) :
         branch_history_manager(std::move(bhm)),
+        stores(_num_cpu_shards),
         serializer_thread_allocation(std::move(serializer_thread)),
         store_thread_allocations(std::move(store_threads)),
         map_insertion_sentry(
@@ -62,8 +66,10 @@ public:
         // TODO: Could we handle failure when loading the serializer?  Right
         // now, we don't.
 
+        log_serializer_t::dynamic_config_t serializer_config;
+        serializer_config.block_codec = block_codec;
         scoped_ptr_t<serializer_t> inner_serializer(new log_serializer_t(
-            log_serializer_t::dynamic_config_t(),
+            serializer_config,
             &file_opener,
             perfmon_collection_serializers));
         serializer.init(new merger_serializer_t(
@@ -73,18 +79,22 @@ public:
         std::vector<serializer_t *> ptrs;
         ptrs.push_back(serializer.get());
         if (create) {
-            serializer_multiplexer_t::create(ptrs, CPU_SHARDING_FACTOR);
+            serializer_multiplexer_t::create(ptrs, stores.size());
         }
         multiplexer.init(new serializer_multiplexer_t(ptrs));
+        guarantee(multiplexer->proxies.size() == stores.size(),
+            "The data file of table %s has %zu CPU shards, but its configuration "
+            "says it should have %zu.",
+            uuid_to_str(table_id).c_str(), multiplexer->proxies.size(), stores.size());
 
-        pmap(CPU_SHARDING_FACTOR, [&](int ix) {
+        pmap(stores.size(), [&](int ix) {
             // TODO: Exceptions? If exceptions are being thrown in here, nothing is
             // handling them.
 
             on_thread_t thread_switcher_2(store_thread_allocations[ix]->get_thread());
 
             stores[ix].init(new store_t(
-                cpu_sharding_subspace(ix),
+                cpu_sharding_subspace(ix, stores.size()),
                 multiplexer->proxies[ix],
                 cache_balancer,
                 strprintf("shard_%d", ix),
@@ -123,7 +133,7 @@ public:
         store_thread_allocations.clear();
         map_insertion_sentry.reset();
         drainer.drain();
-        pmap(CPU_SHARDING_FACTOR, [this](int ix) {
+        pmap(stores.size(), [this](int ix) {
             if (stores[ix].has()) {
                 on_thread_t thread_switcher(stores[ix]->home_thread());
                 stores[ix].reset();
@@ -142,6 +152,10 @@ public:
         return branch_history_manager.get();
     }
 
+    size_t num_cpu_shards() {
+        return stores.size();
+    }
+
     serializer_t *get_serializer() {
         return serializer.get_or_null();
     }
@@ -167,7 +181,7 @@ private:
     scoped_ptr_t<real_branch_history_manager_t> branch_history_manager;
     scoped_ptr_t<serializer_t> serializer;
     scoped_ptr_t<serializer_multiplexer_t> multiplexer;
-    scoped_ptr_t<store_t> stores[CPU_SHARDING_FACTOR];
+    std::vector<scoped_ptr_t<store_t> > stores;
 
     scoped_ptr_t<thread_allocation_t> serializer_thread_allocation;
     std::vector<scoped_ptr_t<thread_allocation_t> > store_thread_allocations;
@@ -274,6 +288,8 @@ void real_table_persistence_interface_t::delete_metadata(
 
 void real_table_persistence_interface_t::load_multistore(
         const namespace_id_t &table_id,
+        size_t num_cpu_shards,
+        block_codec_t block_codec,
         metadata_file_t::read_txn_t *metadata_read_txn,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
@@ -285,16 +301,18 @@ void real_table_persistence_interface_t::load_multistore(
     scoped_ptr_t<thread_allocation_t> serializer_thread(
         new thread_allocation_t(&thread_allocator));
     std::vector<scoped_ptr_t<thread_allocation_t> > store_threads;
-    for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+    for (size_t i = 0; i < num_cpu_shards; ++i) {
         store_threads.emplace_back(new thread_allocation_t(&thread_allocator));
     }
 
     multistore_ptr_out->init(new real_multistore_ptr_t(
         table_id,
+        num_cpu_shards,
         file_name_for(table_id),
         std::move(bhm),
         base_path,
         io_backender,
+        block_codec,
         cache_balancer,
         rdb_context,
         perfmon_collection_serializers,
@@ -305,13 +323,15 @@ void real_table_persistence_interface_t::load_multistore(
 
 void real_table_persistence_interface_t::create_multistore(
         const namespace_id_t &table_id,
+        size_t num_cpu_shards,
+        block_codec_t block_codec,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers) {
     metadata_file_t::read_txn_t read_txn(metadata_file, interruptor);
     load_multistore(
-        table_id, &read_txn, multistore_ptr_out, interruptor,
-        perfmon_collection_serializers);
+        table_id, num_cpu_shards, block_codec, &read_txn, multistore_ptr_out,
+        interruptor, perfmon_collection_serializers);
 }
 
 void real_table_persistence_interface_t::destroy_multistore(
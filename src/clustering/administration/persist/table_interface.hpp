@@ -5,6 +5,7 @@
 #include "clustering/administration/perfmon_collection_repo.hpp"
 #include "clustering/administration/persist/raft_storage_interface.hpp"
 #include "clustering/table_manager/table_metadata.hpp"
+#include "serializer/log/config.hpp"
 
 class cache_balancer_t;
 class metadata_file_t;
@@ -57,12 +58,16 @@ public:
 
     void load_multistore(
         const namespace_id_t &table_id,
+        size_t num_cpu_shards,
+        block_codec_t block_codec,
         metadata_file_t::read_txn_t *metadata_read_txn,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers);
     void create_multistore(
         const namespace_id_t &table_id,
+        size_t num_cpu_shards,
+        block_codec_t block_codec,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers);
@@ -334,6 +334,8 @@ bool real_reql_cluster_interface_t::table_create(
 
         config.config.write_ack_config = write_ack_config_t::MAJORITY;
         config.config.durability = durability;
+        config.config.cpu_shards = config_params.cpu_shards;
+        config.config.block_compression = config_params.block_compression;
 
         table_id = generate_uuid();
         m_table_meta_client->create(table_id, config, &interruptor_on_home);
@@ -689,6 +691,8 @@ void real_reql_cluster_interface_t::reconfigure_internal(
     new_config.config.sindexes = old_config.config.sindexes;
     new_config.config.write_ack_config = old_config.config.write_ack_config;
     new_config.config.durability = old_config.config.durability;
+    new_config.config.cpu_shards = old_config.config.cpu_shards;
+    new_config.config.block_compression = old_config.config.block_compression;
 
     calculate_split_points_intelligently(
         table_id,
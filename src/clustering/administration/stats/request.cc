@@ -34,7 +34,10 @@ const char *table_server_stats_request_t::table_server_request_type = "table_ser
 parsed_stats_t::server_stats_t::server_stats_t() :
     responsive(false),
     queries_per_sec(0), queries_total(0),
-    client_connections(0), clients_active(0) { }
+    client_connections(0), clients_active(0),
+    query_latency(ql::datum_t::null()),
+    disk_read_latency(ql::datum_t::null()),
+    disk_write_latency(ql::datum_t::null()) { }
 
 parsed_stats_t::table_stats_t::table_stats_t() :
     read_docs_per_sec(0), read_docs_total(0),
@@ -42,7 +45,8 @@ parsed_stats_t::table_stats_t::table_stats_t() :
     in_use_bytes(0), metadata_bytes(0), data_bytes(0),
     garbage_bytes(0), preallocated_bytes(0),
     read_bytes_per_sec(0), read_bytes_total(0),
-    written_bytes_per_sec(0), written_bytes_total(0) { }
+    written_bytes_per_sec(0), written_bytes_total(0),
+    changefeed_messages_per_sec(0), changefeed_changes_per_sec(0) { }
 
 parsed_stats_t::parsed_stats_t(const std::vector<ql::datum_t> &stats) {
     for (auto const &s : stats) {
@@ -65,6 +69,8 @@ parsed_stats_t::parsed_stats_t(const std::vector<ql::datum_t> &stats) {
             std::pair<datum_string_t, ql::datum_t> perf_pair = s.get_pair(i);
             if (perf_pair.first == "query_engine") {
                 store_query_engine_stats(perf_pair.second, &serv_stats);
+            } else if (perf_pair.first == "io") {
+                store_io_stats(perf_pair.second, &serv_stats);
             } else {
                 namespace_id_t table_id;
                 res = str_to_uuid(perf_pair.first.to_std(), &table_id);
@@ -89,6 +95,17 @@ void parsed_stats_t::store_perfmon_value(const ql::datum_t &perf,
     }
 }
 
+void parsed_stats_t::store_perfmon_histogram(const ql::datum_t &perf,
+                                             const std::string &key,
+                                             ql::datum_t *value_out) {
+    ql::datum_t v = perf.get_field(key.c_str(), ql::throw_bool_t::NOTHROW);
+    // As above, a missing value means that the stat wasn't requested.
+    if (v.has()) {
+        r_sanity_check(v.get_type() == ql::datum_t::R_OBJECT);
+        *value_out = v;
+    }
+}
+
 void parsed_stats_t::add_perfmon_value(const ql::datum_t &perf,
                                        const std::string &key,
                                        double *value_out) {
@@ -125,6 +142,11 @@ void parsed_stats_t::store_shard_values(const ql::datum_t &shard_perf,
                 } else if (key == "cache") {
                     add_perfmon_value(sub_pair.second, "in_use_bytes",
                                       &stats_out->in_use_bytes);
+                } else if (key == "changefeeds") {
+                    add_perfmon_value(sub_pair.second, "messages_sent",
+                                      &stats_out->changefeed_messages_per_sec);
+                    add_perfmon_value(sub_pair.second, "changes_sent",
+                                      &stats_out->changefeed_changes_per_sec);
                 }
             }
         }
@@ -167,6 +189,18 @@ void parsed_stats_t::store_query_engine_stats(const ql::datum_t &qe_perf,
     store_perfmon_value(qe_perf, "queries_total", &stats_out->queries_total);
     store_perfmon_value(qe_perf, "client_connections", &stats_out->client_connections);
     store_perfmon_value(qe_perf, "clients_active", &stats_out->clients_active);
+    store_perfmon_histogram(qe_perf, "query_latency", &stats_out->query_latency);
+}
+
+void parsed_stats_t::store_io_stats(const ql::datum_t &io_perf,
+                                    server_stats_t *stats_out) {
+    r_sanity_check(io_perf.get_type() == ql::datum_t::R_OBJECT);
+    // The "stack" stats cover the whole time from submitting a disk operation until
+    // it completes, including the time spent in the queue.
+    store_perfmon_histogram(io_perf, "stack_read_latency",
+                            &stats_out->disk_read_latency);
+    store_perfmon_histogram(io_perf, "stack_write_latency",
+                            &stats_out->disk_write_latency);
 }
 
 void parsed_stats_t::store_table_stats(const namespace_id_t &table_id,
@@ -253,6 +287,7 @@ bool add_table_fields(const namespace_id_t &table_id,
 std::set<std::vector<std::string> > stats_request_t::global_stats_filter() {
     return std::set<std::vector<std::string> >(
         { {"query_engine"},
+          {"io", "stack_(read|write)_latency"},
           {"[0-9A-Fa-f-]+", "serializers" } });
 }
 
@@ -407,6 +442,7 @@ server_stats_request_t::server_stats_request_t(const server_id_t &_server_id) :
 std::set<std::vector<std::string> > server_stats_request_t::get_filter() const {
     return std::set<std::vector<std::string> >(
         { {"query_engine"},
+          {"io", "stack_(read|write)_latency"},
           {".*", "serializers", "shard_[0-9]+", "btree-.*" } });
 }
 
@@ -456,7 +492,15 @@ bool server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_SERVER_STAT(qe_builder, stats, server_id, read_docs_total);
         ADD_SERVER_STAT(qe_builder, stats, server_id, written_docs_per_sec);
         ADD_SERVER_STAT(qe_builder, stats, server_id, written_docs_total);
+        ADD_STAT(qe_builder, server_stats, query_latency);
         row_builder.overwrite("query_engine", std::move(qe_builder).to_datum());
+
+        ql::datum_object_builder_t se_builder;
+        ql::datum_object_builder_t se_disk_builder;
+        se_disk_builder.overwrite("read_latency", server_stats.disk_read_latency);
+        se_disk_builder.overwrite("write_latency", server_stats.disk_write_latency);
+        se_builder.overwrite("disk", std::move(se_disk_builder).to_datum());
+        row_builder.overwrite("storage_engine", std::move(se_builder).to_datum());
     }
     *result_out = std::move(row_builder).to_datum();
     return true;
@@ -549,6 +593,14 @@ bool table_server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_STAT(qe_builder, table_stats, read_docs_total);
         ADD_STAT(qe_builder, table_stats, written_docs_per_sec);
         ADD_STAT(qe_builder, table_stats, written_docs_total);
+        ADD_STAT(qe_builder, table_stats, changefeed_messages_per_sec);
+        // Changefeed messages carry batches of changes; this is how well the
+        // batching works.
+        qe_builder.overwrite("changefeed_changes_per_message", ql::datum_t(
+            table_stats.changefeed_messages_per_sec > 0
+                ? table_stats.changefeed_changes_per_sec
+                    / table_stats.changefeed_messages_per_sec
+                : 0.0));
 
         ql::datum_object_builder_t se_cache_builder;
         ADD_STAT(se_cache_builder, table_stats, in_use_bytes);
@@ -36,6 +36,8 @@ public:
         double read_bytes_total;
         double written_bytes_per_sec;
         double written_bytes_total;
+        double changefeed_messages_per_sec;
+        double changefeed_changes_per_sec;
     };
 
     struct server_stats_t {
@@ -47,6 +49,12 @@ public:
         double client_connections;
         double clients_active;
 
+        // Latency percentiles as reported by `perfmon_latency_histogram_t`. These
+        // can't be combined across servers, so they only show up in server rows.
+        ql::datum_t query_latency;
+        ql::datum_t disk_read_latency;
+        ql::datum_t disk_write_latency;
+
         std::map<namespace_id_t, table_stats_t> tables;
     };
 
@@ -81,6 +89,11 @@ private:
                              const std::string &key,
                              double *value_out);
 
+    // Stores the object of percentiles reported by a `perfmon_latency_histogram_t`.
+    void store_perfmon_histogram(const ql::datum_t &perf,
+                                 const std::string &key,
+                                 ql::datum_t *value_out);
+
     void store_shard_values(const ql::datum_t &shard_perf,
                             table_stats_t *stats_out);
 
@@ -90,6 +103,9 @@ private:
     void store_query_engine_stats(const ql::datum_t &qe_perf,
                                   server_stats_t *stats_out);
 
+    void store_io_stats(const ql::datum_t &io_perf,
+                        server_stats_t *stats_out);
+
     void store_table_stats(const namespace_id_t &table_id,
                            const ql::datum_t &table_perf,
                            server_stats_t *stats_out);
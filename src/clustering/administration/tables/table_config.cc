@@ -5,6 +5,7 @@
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/tables/generate_config.hpp"
 #include "clustering/administration/tables/split_points.hpp"
+#include "clustering/table_contract/cpu_sharding.hpp"
 #include "clustering/table_manager/table_meta_client.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 #include "containers/archive/string_stream.hpp"
@@ -227,6 +228,51 @@ bool convert_durability_from_datum(
     return true;
 }
 
+bool convert_cpu_shards_from_datum(
+        const ql::datum_t &datum,
+        size_t *cpu_shards_out,
+        admin_err_t *error_out) {
+    if (datum.get_type() == ql::datum_t::R_NUM) {
+        double cpu_shards = datum.as_num();
+        if (cpu_shards >= 1 && cpu_shards <= MAX_CPU_SHARDS
+                && static_cast<double>(static_cast<size_t>(cpu_shards)) == cpu_shards
+                && is_valid_cpu_shard_count(static_cast<size_t>(cpu_shards))) {
+            *cpu_shards_out = static_cast<size_t>(cpu_shards);
+            return true;
+        }
+    }
+    *error_out = admin_err_t{
+        strprintf("Expected a power of two between 1 and %d, got: %s",
+                  MAX_CPU_SHARDS, datum.print().c_str()),
+        query_state_t::FAILED};
+    return false;
+}
+
+ql::datum_t convert_block_compression_to_datum(block_codec_t block_compression) {
+    switch (block_compression) {
+    case block_codec_t::none: return ql::datum_t("none");
+    case block_codec_t::zlib: return ql::datum_t("zlib");
+    default: unreachable();
+    }
+}
+
+bool convert_block_compression_from_datum(
+        const ql::datum_t &datum,
+        block_codec_t *block_compression_out,
+        admin_err_t *error_out) {
+    if (datum == ql::datum_t("none")) {
+        *block_compression_out = block_codec_t::none;
+    } else if (datum == ql::datum_t("zlib")) {
+        *block_compression_out = block_codec_t::zlib;
+    } else {
+        *error_out = admin_err_t{
+            "Expected \"none\" or \"zlib\", got: " + datum.print(),
+            query_state_t::FAILED};
+        return false;
+    }
+    return true;
+}
+
 ql::datum_t convert_table_config_shard_to_datum(
         const table_config_t::shard_t &shard,
         admin_identifier_format_t identifier_format,
@@ -410,6 +456,10 @@ ql::datum_t convert_table_config_to_datum(
         convert_write_ack_config_to_datum(config.write_ack_config));
     builder.overwrite("durability",
         convert_durability_to_datum(config.durability));
+    builder.overwrite("cpu_shards",
+        ql::datum_t(static_cast<double>(config.cpu_shards)));
+    builder.overwrite("block_compression",
+        convert_block_compression_to_datum(config.block_compression));
     return std::move(builder).to_datum();
 }
 
@@ -480,7 +530,8 @@ bool convert_table_config_and_name_from_datum(
     }
 
     /* As a special case, we allow the user to omit `indexes`, `primary_key`, `shards`,
-    `write_acks`, and/or `durability` for newly-created tables. */
+    `write_acks`, `durability`, `cpu_shards` and/or `block_compression` for
+    newly-created tables. */
 
     if (converter.has("indexes")) {
         ql::datum_t indexes_datum;
@@ -603,6 +654,45 @@ bool convert_table_config_and_name_from_datum(
         config_out->durability = write_durability_t::HARD;
     }
 
+    if (existed_before || converter.has("cpu_shards")) {
+        ql::datum_t cpu_shards_datum;
+        if (!converter.get("cpu_shards", &cpu_shards_datum, error_out)) {
+            return false;
+        }
+        if (!convert_cpu_shards_from_datum(cpu_shards_datum,
+                &config_out->cpu_shards, error_out)) {
+            error_out->msg = "In `cpu_shards`: " + error_out->msg;
+            return false;
+        }
+        if (existed_before && config_out->cpu_shards != old_config.config.cpu_shards) {
+            error_out->msg = "The `cpu_shards` field can't be changed after the "
+                             "table has been created.";
+            return false;
+        }
+    } else {
+        config_out->cpu_shards = CPU_SHARDING_FACTOR;
+    }
+
+    if (existed_before || converter.has("block_compression")) {
+        ql::datum_t block_compression_datum;
+        if (!converter.get("block_compression", &block_compression_datum, error_out)) {
+            return false;
+        }
+        if (!convert_block_compression_from_datum(block_compression_datum,
+                &config_out->block_compression, error_out)) {
+            error_out->msg = "In `block_compression`: " + error_out->msg;
+            return false;
+        }
+        if (existed_before && config_out->block_compression
+                != old_config.config.block_compression) {
+            error_out->msg = "The `block_compression` field can't be changed after "
+                             "the table has been created.";
+            return false;
+        }
+    } else {
+        config_out->block_compression = block_codec_t::none;
+    }
+
     if (converter.has("write_hook")) {
         ql::datum_t write_hook_datum;
         if (!converter.get("write_hook", &write_hook_datum, error_out)) {
@@ -28,6 +28,21 @@ ql::datum_t convert_table_config_to_datum(
 ql::datum_t convert_write_hook_to_datum(
     const boost::optional<write_hook_config_t> &write_hook);
 
+/* This is publicly exposed so that it can be unit tested. Accepts a power of two
+between 1 and `MAX_CPU_SHARDS`. */
+bool convert_cpu_shards_from_datum(
+        const ql::datum_t &datum,
+        size_t *cpu_shards_out,
+        admin_err_t *error_out);
+
+/* These are publicly exposed so that they can be unit tested. Block compression is
+written as "none" or "zlib". */
+ql::datum_t convert_block_compression_to_datum(block_codec_t block_compression);
+bool convert_block_compression_from_datum(
+        const ql::datum_t &datum,
+        block_codec_t *block_compression_out,
+        admin_err_t *error_out);
+
 class table_config_artificial_table_backend_t :
     public common_table_artificial_table_backend_t
 {
@@ -37,6 +37,12 @@ void serialize(write_message_t *wm, const table_config_t &tc) {
 
     write_durability_t durability = tc.durability;
     serialize<W>(wm, durability);
+
+    uint64_t cpu_shards = tc.cpu_shards;
+    serialize<W>(wm, cpu_shards);
+
+    block_codec_t block_compression = tc.block_compression;
+    serialize<W>(wm, block_compression);
 }
 
 INSTANTIATE_SERIALIZE_FOR_CLUSTER_AND_DISK(table_config_t);
@@ -71,6 +77,51 @@ archive_result_t deserialize_table_config_pre_v2_4(
     tc->sindexes = std::move(sindexes);
     tc->write_ack_config = std::move(write_ack_config);
     tc->durability = std::move(durability);
+    tc->cpu_shards = CPU_SHARDING_FACTOR;
+    tc->block_compression = block_codec_t::none;
+
+    return res;
+}
+
+template <cluster_version_t W>
+archive_result_t deserialize_table_config_pre_v2_5(
+    read_stream_t *s, table_config_t *tc) {
+    archive_result_t res;
+
+    table_basic_config_t basic;
+    res = deserialize<W>(s, &basic);
+    if (bad(res)) { return res; }
+
+    std::vector<table_config_t::shard_t> shards;
+    res = deserialize<W>(s, &shards);
+    if (bad(res)) { return res; }
+
+    std::map<std::string, sindex_config_t> sindexes;
+    res = deserialize<W>(s, &sindexes);
+    if (bad(res)) { return res; }
+
+    boost::optional<write_hook_config_t> write_hook;
+    res = deserialize<W>(s, &write_hook);
+    if (bad(res)) { return res; }
+
+    write_ack_config_t write_ack_config;
+    res = deserialize<W>(s, &write_ack_config);
+    if (bad(res)) { return res; }
+
+    write_durability_t durability;
+    res = deserialize<W>(s, &durability);
+    if (bad(res)) { return res; }
+
+    // Tables used to always be split into `CPU_SHARDING_FACTOR` CPU shards, and their
+    // blocks weren't compressed
+    *tc = table_config_t{std::move(basic),
+                         std::move(shards),
+                         std::move(sindexes),
+                         std::move(write_hook),
+                         std::move(write_ack_config),
+                         std::move(durability),
+                         CPU_SHARDING_FACTOR,
+                         block_codec_t::none};
 
     return res;
 }
@@ -104,12 +155,22 @@ archive_result_t deserialize(
     res = deserialize<W>(s, &durability);
     if (bad(res)) { return res; }
 
+    uint64_t cpu_shards;
+    res = deserialize<W>(s, &cpu_shards);
+    if (bad(res)) { return res; }
+
+    block_codec_t block_compression;
+    res = deserialize<W>(s, &block_compression);
+    if (bad(res)) { return res; }
+
     *tc = table_config_t{std::move(basic),
                          std::move(shards),
                          std::move(sindexes),
                          std::move(write_hook),
                          std::move(write_ack_config),
-                         std::move(durability)};
+                         std::move(durability),
+                         cpu_shards,
+                         block_compression};
 
     return res;
 }
@@ -132,11 +193,18 @@ archive_result_t deserialize<cluster_version_t::v2_3>(
     return deserialize_table_config_pre_v2_4<cluster_version_t::v2_4>(s, tc);
 }
 
-template archive_result_t deserialize<cluster_version_t::v2_4_is_latest>(
+template <>
+archive_result_t deserialize<cluster_version_t::v2_4>(
+    read_stream_t *s, table_config_t *tc) {
+    return deserialize_table_config_pre_v2_5<cluster_version_t::v2_4>(s, tc);
+}
+
+template archive_result_t deserialize<cluster_version_t::v2_5_is_latest>(
     read_stream_t *, table_config_t *);
 
-RDB_IMPL_EQUALITY_COMPARABLE_6(table_config_t,
-    basic, shards, write_hook, sindexes, write_ack_config, durability);
+RDB_IMPL_EQUALITY_COMPARABLE_8(table_config_t,
+    basic, shards, write_hook, sindexes, write_ack_config, durability, cpu_shards,
+    block_compression);
 
 RDB_IMPL_SERIALIZABLE_1_SINCE_v1_16(table_shard_scheme_t, split_points);
 RDB_IMPL_EQUALITY_COMPARABLE_1(table_shard_scheme_t, split_points);
@@ -20,6 +20,7 @@
 #include "rpc/semilattice/joins/map.hpp"
 #include "rpc/semilattice/joins/versioned.hpp"
 #include "rpc/serialize_macros.hpp"
+#include "serializer/log/config.hpp"
 
 /* This is the metadata for a single table. */
 
@@ -74,6 +75,15 @@ public:
     boost::optional<write_hook_config_t> write_hook;
     write_ack_config_t write_ack_config;
     write_durability_t durability;
+    /* The number of hash shards that every replica splits its copy of the table into,
+    so that it can use that many threads. It's a power of two between 1 and
+    `MAX_CPU_SHARDS`, and it's fixed when the table is created, because it determines
+    the layout of the table's data files. */
+    size_t cpu_shards;
+    /* How the table's data blocks are compressed on disk. Like `cpu_shards`, it's fixed
+    when the table is created, because the replicas' serializers only pick it up when
+    they open the table's data files. */
+    block_codec_t block_compression;
 };
 
 RDB_DECLARE_EQUALITY_COMPARABLE(table_config_t);
@@ -223,6 +233,17 @@ private:
 
         result_type operator()(
                 const set_table_config_and_shards_t &set_table_config_and_shards) const {
+            if (set_table_config_and_shards.new_config_and_shards.config.cpu_shards !=
+                    table_config_and_shards->config.cpu_shards) {
+                /* The stores on every replica would have to be rebuilt. */
+                return false;
+            }
+            if (set_table_config_and_shards.new_config_and_shards.config
+                        .block_compression !=
+                    table_config_and_shards->config.block_compression) {
+                /* The serializers on every replica would have to be reopened. */
+                return false;
+            }
             *table_config_and_shards =
                 set_table_config_and_shards.new_config_and_shards;
             return true;
@@ -147,6 +147,8 @@ private:
                             *is_item_out = true;
                             *item_out = parent->items.front();
                             parent->items.pop_front();
+                            parent->parent->progress_tracker->keys_received +=
+                                item_out->pairs.size();
                             return continue_bool_t::CONTINUE;
                         } else if (!parent->items.empty_domain()) {
                             /* There aren't any more items left in the queue, but there's
@@ -4,6 +4,7 @@
 #include "clustering/immediate_consistency/backfill_throttler.hpp"
 #include "clustering/immediate_consistency/backfillee.hpp"
 #include "clustering/table_manager/backfill_progress_tracker.hpp"
+#include "concurrency/pmap.hpp"
 #include "stl_utils.hpp"
 #include "store_view.hpp"
 
@@ -167,7 +168,7 @@ remote_replicator_client_t::remote_replicator_client_t(
             ph::_1, ph::_2, ph::_3, ph::_4, ph::_5)),
     write_sync_mailbox_(mailbox_manager,
         std::bind(&remote_replicator_client_t::on_write_sync, this,
-            ph::_1, ph::_2, ph::_3, ph::_4, ph::_5, ph::_6)),
+            ph::_1, ph::_2, ph::_3)),
     dummy_write_mailbox_(mailbox_manager,
         std::bind(&remote_replicator_client_t::on_dummy_write, this,
             ph::_1, ph::_2)),
@@ -184,6 +185,7 @@ remote_replicator_client_t::remote_replicator_client_t(
     progress_tracker->start_time = current_microtime();
     progress_tracker->source_server_id = primary_server_id;
     progress_tracker->progress = 0.0;
+    progress_tracker->keys_received = 0;
 
     /* If the store is currently constructing a secondary index, wait until it finishes
     before we start the backfill. We'll also check again periodically during the
@@ -448,22 +450,34 @@ void remote_replicator_client_t::on_write_async(
 
 void remote_replicator_client_t::on_write_sync(
         signal_t *interruptor,
-        const write_t &write,
-        state_timestamp_t timestamp,
-        order_token_t order_token,
-        write_durability_t durability,
-        const mailbox_t<void(write_response_t)>::address_t &ack_addr)
+        const std::vector<remote_replicator_write_t> &writes,
+        const mailbox_t<void(std::vector<write_response_t>)>::address_t &ack_addr)
         THROWS_ONLY(interrupted_exc_t) {
     /* The current implementation of the dispatcher will never send us an async write
     once it's started sending sync writes, but we don't want to rely on that detail, so
     we pass sync writes through the timestamp enforcer too. */
-    timestamp_enforcer_->complete(timestamp);
+    for (const remote_replicator_write_t &write : writes) {
+        timestamp_enforcer_->complete(write.timestamp);
+    }
 
-    write_response_t response;
-    replica_->do_write(
-        write, timestamp, order_token, durability,
-        interruptor, &response);
-    send(mailbox_manager_, ack_addr, response);
+    /* The writes are ordered by timestamp, so `pmap` starts them in the order in which
+    `replica_` will perform them. Running them concurrently lets the store combine their
+    flushes to disk, rather than waiting for each write's flush in turn. */
+    std::vector<write_response_t> responses(writes.size());
+    bool interrupted = false;
+    pmap(writes.size(), [&](size_t i) {
+        try {
+            replica_->do_write(
+                writes[i].write, writes[i].timestamp, writes[i].order_token,
+                writes[i].durability, interruptor, &responses[i]);
+        } catch (const interrupted_exc_t &) {
+            interrupted = true;
+        }
+    });
+    if (interrupted) {
+        throw interrupted_exc_t();
+    }
+    send(mailbox_manager_, ack_addr, responses);
 }
 
 void remote_replicator_client_t::on_dummy_write(
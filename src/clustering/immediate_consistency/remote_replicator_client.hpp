@@ -3,6 +3,7 @@
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_CLIENT_HPP_
 
 #include <queue>
+#include <vector>
 
 #include "clustering/generic/registrant.hpp"
 #include "clustering/immediate_consistency/backfill_throttler.hpp"
@@ -91,11 +92,8 @@ private:
 
     void on_write_sync(
             signal_t *interruptor,
-            const write_t &write,
-            state_timestamp_t timestamp,
-            order_token_t order_token,
-            write_durability_t durability,
-            const mailbox_t<void(write_response_t)>::address_t &ack_addr)
+            const std::vector<remote_replicator_write_t> &writes,
+            const mailbox_t<void(std::vector<write_response_t>)>::address_t &ack_addr)
         THROWS_ONLY(interrupted_exc_t);
 
     void on_dummy_write(
@@ -2,6 +2,8 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_METADATA_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_METADATA_HPP_
 
+#include <vector>
+
 #include "clustering/generic/registration_metadata.hpp"
 #include "clustering/immediate_consistency/history.hpp"
 #include "rdb_protocol/protocol.hpp"
@@ -16,6 +18,18 @@ public:
 
 RDB_DECLARE_SERIALIZABLE(remote_replicator_client_intro_t);
 
+/* `remote_replicator_write_t` is one of the sync writes that the
+`remote_replicator_server_t` sends to a `remote_replicator_client_t` in a batch. */
+class remote_replicator_write_t {
+public:
+    write_t write;
+    state_timestamp_t timestamp;
+    order_token_t order_token;
+    write_durability_t durability;
+};
+
+RDB_DECLARE_SERIALIZABLE(remote_replicator_write_t);
+
 class remote_replicator_client_bcard_t {
 public:
     typedef mailbox_t<void(
@@ -25,9 +39,11 @@ public:
         write_t, state_timestamp_t, order_token_t,
         mailbox_t<void()>::address_t
         )> write_async_mailbox_t;
+    /* Sync writes are sent in batches, ordered by timestamp. The responses come back
+    in a single message, in the same order as the writes. */
     typedef mailbox_t<void(
-        write_t, state_timestamp_t, order_token_t, write_durability_t,
-        mailbox_t<void(write_response_t)>::address_t
+        std::vector<remote_replicator_write_t>,
+        mailbox_t<void(std::vector<write_response_t>)>::address_t
         )> write_sync_mailbox_t;
     typedef mailbox_t<void(
         mailbox_t<void(write_response_t)>::address_t
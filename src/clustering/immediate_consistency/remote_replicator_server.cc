@@ -1,13 +1,29 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/remote_replicator_server.hpp"
 
+#include <algorithm>
+
+#include "arch/timing.hpp"
+#include "concurrency/wait_any.hpp"
+
+/* The `primary_dispatcher_t` never has more sync writes in flight for one replica. */
+const size_t remote_replicator_server_t::MAX_WRITE_BATCH_SIZE = 64;
+const int64_t remote_replicator_server_t::DEFAULT_MAX_BATCH_LATENCY_MS = 0;
+const int64_t remote_replicator_server_t::MAX_MAX_BATCH_LATENCY_MS = 1000;
+
 remote_replicator_server_t::remote_replicator_server_t(
         mailbox_manager_t *_mailbox_manager,
-        primary_dispatcher_t *_primary) :
+        primary_dispatcher_t *_primary,
+        int64_t _max_batch_latency_ms) :
     mailbox_manager(_mailbox_manager),
     primary(_primary),
-    registrar(mailbox_manager, this)
-    { }
+    max_batch_latency_ms(_max_batch_latency_ms),
+    num_write_batches_sent(0),
+    num_batched_writes_sent(0),
+    registrar(mailbox_manager, this) {
+    guarantee(max_batch_latency_ms >= 0
+        && max_batch_latency_ms <= MAX_MAX_BATCH_LATENCY_MS);
+}
 
 remote_replicator_server_t::proxy_replica_t::proxy_replica_t(
         remote_replicator_server_t *_parent,
@@ -53,16 +69,75 @@ void remote_replicator_server_t::proxy_replica_t::do_write_sync(
         signal_t *interruptor,
         write_response_t *response_out) {
     guarantee(is_ready);
-    cond_t got_response;
-    mailbox_t<void(write_response_t)> response_mailbox(
-        parent->mailbox_manager,
-        [&](signal_t *, const write_response_t &response) {
-            *response_out = response;
-            got_response.pulse();
+    if (!open_write_batch.has()) {
+        open_write_batch = make_counted<write_batch_t>();
+        coro_t::spawn_sometime(std::bind(&proxy_replica_t::send_write_batch, this,
+            open_write_batch, write_batch_drainer.lock()));
+    }
+    counted_t<write_batch_t> batch = open_write_batch;
+    const size_t index = batch->writes.size();
+    batch->writes.push_back(
+        remote_replicator_write_t { write, timestamp, order_token, durability });
+    if (batch->writes.size() == MAX_WRITE_BATCH_SIZE) {
+        open_write_batch.reset();
+        batch->full.pulse();
+    }
+    wait_interruptible(&batch->done, interruptor);
+    *response_out = std::move(batch->responses[index]);
+}
+
+void remote_replicator_server_t::proxy_replica_t::send_write_batch(
+        counted_t<write_batch_t> batch,
+        auto_drainer_t::lock_t keepalive) {
+    try {
+        /* Give more writes a chance to join the batch. */
+        if (parent->max_batch_latency_ms > 0) {
+            signal_timer_t timer(parent->max_batch_latency_ms);
+            wait_any_t waiter(&timer, &batch->full);
+            wait_interruptible(&waiter, keepalive.get_drain_signal());
+        } else {
+            coro_t::yield();
+        }
+        if (open_write_batch.get() == batch.get()) {
+            open_write_batch.reset();
+        }
+
+        /* The writes may have been added out of order, since every write comes from a
+        different coroutine. Send them ordered by timestamp. */
+        std::vector<size_t> order(batch->writes.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return batch->writes[a].timestamp < batch->writes[b].timestamp;
         });
-    send(parent->mailbox_manager, client_bcard.write_sync_mailbox,
-        write, timestamp, order_token, durability, response_mailbox.get_address());
-    wait_interruptible(&got_response, interruptor);
+        std::vector<remote_replicator_write_t> ordered_writes;
+        ordered_writes.reserve(order.size());
+        for (size_t i : order) {
+            ordered_writes.push_back(batch->writes[i]);
+        }
+
+        cond_t got_response;
+        mailbox_t<void(std::vector<write_response_t>)> response_mailbox(
+            parent->mailbox_manager,
+            [&](signal_t *, std::vector<write_response_t> &&responses) {
+                guarantee(responses.size() == order.size());
+                batch->responses.resize(order.size());
+                for (size_t i = 0; i < order.size(); ++i) {
+                    batch->responses[order[i]] = std::move(responses[i]);
+                }
+                got_response.pulse();
+            });
+        send(parent->mailbox_manager, client_bcard.write_sync_mailbox,
+            ordered_writes, response_mailbox.get_address());
+        ++parent->num_write_batches_sent;
+        parent->num_batched_writes_sent += ordered_writes.size();
+        wait_interruptible(&got_response, keepalive.get_drain_signal());
+        batch->done.pulse();
+    } catch (const interrupted_exc_t &) {
+        /* The `proxy_replica_t` is being destroyed. The writes in the batch get
+        interrupted through their own interruptors. */
+    }
 }
 
 void remote_replicator_server_t::proxy_replica_t::do_dummy_write(
@@ -2,6 +2,8 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_SERVER_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_SERVER_HPP_
 
+#include <vector>
+
 #include "clustering/generic/registrar.hpp"
 #include "clustering/immediate_consistency/primary_dispatcher.hpp"
 #include "clustering/immediate_consistency/remote_replicator_metadata.hpp"
@@ -10,13 +12,25 @@
 and sends them over the network to `remote_replicator_client_t`s on other machines.
 
 There is one `remote_replicator_server_t` per shard. It lives on the primary replica
-server with the `primary_dispatcher_t`. */
+server with the `primary_dispatcher_t`.
+
+Sync writes aren't sent one by one. Consecutive writes for the same replica are grouped
+into a batch, which is sent in a single message and acked in a single message. A batch
+is sent once it has `MAX_WRITE_BATCH_SIZE` writes or once its first write has waited for
+`max_batch_latency_ms`. With a latency of zero, a batch only collects the writes that
+arrive before the sending coroutine gets to run. The latency is set with the
+`--replication-batch-latency` command line option. */
 
 class remote_replicator_server_t {
 public:
+    static const size_t MAX_WRITE_BATCH_SIZE;
+    static const int64_t DEFAULT_MAX_BATCH_LATENCY_MS;
+    static const int64_t MAX_MAX_BATCH_LATENCY_MS;
+
     remote_replicator_server_t(
         mailbox_manager_t *mailbox_manager,
-        primary_dispatcher_t *primary);
+        primary_dispatcher_t *primary,
+        int64_t max_batch_latency_ms = DEFAULT_MAX_BATCH_LATENCY_MS);
 
     remote_replicator_server_bcard_t get_bcard() {
         return remote_replicator_server_bcard_t {
@@ -25,6 +39,15 @@ public:
             registrar.get_business_card() };
     }
 
+    /* The number of sync write batches that were sent to replicas, and the number of
+    writes in them. These are only used by the unit tests. */
+    uint64_t get_num_write_batches_sent() const {
+        return num_write_batches_sent;
+    }
+    uint64_t get_num_batched_writes_sent() const {
+        return num_batched_writes_sent;
+    }
+
 private:
     /* Whenever a `remote_replicator_client_t` connects, the `registrar` will construct a
     `proxy_replica_t` to represent it. */
@@ -64,12 +87,36 @@ private:
             write_response_t *response_out);
 
     private:
+        /* A `write_batch_t` collects the sync writes that will be sent to the replica
+        in the same message. `responses` is in the same order as `writes`. */
+        class write_batch_t : public single_threaded_countable_t<write_batch_t> {
+        public:
+            std::vector<remote_replicator_write_t> writes;
+            std::vector<write_response_t> responses;
+            /* Pulsed when the batch reaches `MAX_WRITE_BATCH_SIZE` writes. */
+            cond_t full;
+            /* Pulsed when `responses` has been filled in. */
+            cond_t done;
+        };
+
         void on_ready(signal_t *interruptor);
 
+        /* `send_write_batch()` runs in its own coroutine for every batch. */
+        void send_write_batch(
+            counted_t<write_batch_t> batch,
+            auto_drainer_t::lock_t keepalive);
+
         remote_replicator_client_bcard_t client_bcard;
         remote_replicator_server_t *parent;
         bool is_ready;
 
+        /* The batch that new sync writes are added to, if it hasn't been sent yet. */
+        counted_t<write_batch_t> open_write_batch;
+
+        /* `write_batch_drainer` is destroyed after `registration`, so no more writes
+        can open a new batch while it's draining. */
+        auto_drainer_t write_batch_drainer;
+
         // The destruction order matters: The `ready_mailbox` callback assumes
         // that `registration` is still valid.
         scoped_ptr_t<primary_dispatcher_t::dispatchee_registration_t> registration;
@@ -78,6 +125,10 @@ private:
 
     mailbox_manager_t *mailbox_manager;
     primary_dispatcher_t *primary;
+    int64_t max_batch_latency_ms;
+
+    uint64_t num_write_batches_sent;
+    uint64_t num_batched_writes_sent;
 
     registrar_t<
         remote_replicator_client_bcard_t,
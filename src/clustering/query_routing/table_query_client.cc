@@ -1,6 +1,9 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/query_routing/table_query_client.hpp"
 
+#include <math.h>
+
+#include <algorithm>
 #include <functional>
 
 #include "clustering/query_routing/primary_query_client.hpp"
@@ -9,6 +12,7 @@
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/fifo_enforcer.hpp"
 #include "concurrency/watchable.hpp"
+#include "arch/timing.hpp"
 #include "rdb_protocol/env.hpp"
 
 table_query_client_t::table_query_client_t(
@@ -24,6 +28,7 @@ table_query_client_t::table_query_client_t(
       multi_table_manager(mtm),
       ctx(_ctx),
       m_table_meta_client(table_meta_client),
+      next_latency_sample(0),
       start_count(0),
       starting_up(true),
       subs(directory,
@@ -331,6 +336,154 @@ void table_query_client_t::perform_immediate_op(
     }
 }
 
+/* The weight of a new sample in a replica's moving average of direct read latencies. */
+static const double DIRECT_READ_LATENCY_EWMA_WEIGHT = 0.2;
+
+/* A replica's latency estimate is forgotten if we haven't sent it a read for this long,
+so that a replica that was slow at one point gets another chance eventually. */
+static const microtime_t DIRECT_READ_LATENCY_EXPIRATION_US = 10 * MILLION;
+
+/* We keep using the local replica for outdated reads unless it is expected to be
+this many times slower than the fastest remote one. */
+static const double LOCAL_REPLICA_LATENCY_ALLOWANCE = 4.0;
+
+void table_query_client_t::direct_read_stats_t::record_latency(double latency_ms) {
+    microtime_t now = current_microtime();
+    if (last_sample_time + DIRECT_READ_LATENCY_EXPIRATION_US < now) {
+        ewma_latency_ms = latency_ms;
+    } else {
+        ewma_latency_ms += DIRECT_READ_LATENCY_EWMA_WEIGHT
+            * (latency_ms - ewma_latency_ms);
+    }
+    last_sample_time = now;
+}
+
+bool table_query_client_t::direct_read_stats_t::estimate_latency(
+        double *latency_out) const {
+    if (last_sample_time + DIRECT_READ_LATENCY_EXPIRATION_US < current_microtime()) {
+        return false;
+    }
+    *latency_out = ewma_latency_ms * (1 + reads_in_flight);
+    return true;
+}
+
+std::vector<size_t> rank_outdated_read_candidates(
+        const std::vector<outdated_read_candidate_t> &candidates) {
+    double latency_sum = 0;
+    size_t num_latencies = 0;
+    for (const outdated_read_candidate_t &candidate : candidates) {
+        if (candidate.has_latency) {
+            latency_sum += candidate.latency_ms;
+            ++num_latencies;
+        }
+    }
+    std::vector<std::pair<double, size_t> > scores;
+    scores.reserve(candidates.size());
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        double score;
+        if (candidates[i].has_latency) {
+            score = candidates[i].latency_ms;
+        } else if (num_latencies != 0) {
+            score = latency_sum / num_latencies;
+        } else {
+            /* Nobody has a score, so all replicas tie and the local one goes first. */
+            score = 0;
+        }
+        if (candidates[i].is_local) {
+            score /= LOCAL_REPLICA_LATENCY_ALLOWANCE;
+        }
+        scores.push_back(std::make_pair(score, i));
+        std::swap(scores[i], scores[randint(i + 1)]);
+    }
+    std::stable_sort(scores.begin(), scores.end(),
+        [&](const std::pair<double, size_t> &a, const std::pair<double, size_t> &b) {
+            if (a.first != b.first) {
+                return a.first < b.first;
+            }
+            return candidates[a.second].is_local && !candidates[b.second].is_local;
+        });
+    std::vector<size_t> ranking;
+    ranking.reserve(scores.size());
+    for (const auto &score : scores) {
+        ranking.push_back(score.second);
+    }
+    return ranking;
+}
+
+/* `outdated_read_attempt_t` sends an outdated read to one replica and keeps the
+replica's `direct_read_stats_t` up to date. If the read is hedged, two attempts share
+`done` and the response of whichever replica answers first is used. */
+class table_query_client_t::outdated_read_attempt_t {
+public:
+    outdated_read_attempt_t(
+            table_query_client_t *parent,
+            relationship_t *_relationship,
+            const read_t &op,
+            read_response_t *response_out,
+            cond_t *_done) :
+        relationship(_relationship),
+        done(_done),
+        answered(false),
+        start_time(get_ticks()),
+        cont(parent->mailbox_manager,
+            [this, parent, response_out](signal_t *, const read_response_t &res) {
+                answered = true;
+                double latency_ms = ticks_to_secs(get_ticks() - start_time) * 1000;
+                relationship->direct_read_stats.record_latency(latency_ms);
+                if (!done->is_pulsed()) {
+                    parent->note_outdated_read_latency(latency_ms);
+                    *response_out = res;
+                    done->pulse();
+                }
+            }) {
+        ++relationship->direct_read_stats.reads_in_flight;
+        send(parent->mailbox_manager,
+            relationship->direct_bcard->read_mailbox,
+            op,
+            cont.get_address());
+    }
+
+    ~outdated_read_attempt_t() {
+        --relationship->direct_read_stats.reads_in_flight;
+        if (!answered && done->is_pulsed()) {
+            /* The other replica won the race. We don't know how long this one would
+            have taken, but at least as long as it took so far. */
+            relationship->direct_read_stats.record_latency(
+                ticks_to_secs(get_ticks() - start_time) * 1000);
+        }
+    }
+
+private:
+    relationship_t *relationship;
+    cond_t *done;
+    bool answered;
+    ticks_t start_time;
+    mailbox_t<void(read_response_t)> cont;
+
+    DISABLE_COPYING(outdated_read_attempt_t);
+};
+
+int64_t table_query_client_t::get_outdated_read_hedge_timeout() const {
+    if (OUTDATED_READ_HEDGE_PERCENTILE == 0
+        || outdated_read_latencies.size() < OUTDATED_READ_LATENCY_SAMPLES) {
+        return 0;
+    }
+    std::vector<double> latencies = outdated_read_latencies;
+    auto percentile = latencies.begin()
+        + (latencies.size() - 1) * OUTDATED_READ_HEDGE_PERCENTILE / 100;
+    std::nth_element(latencies.begin(), percentile, latencies.end());
+    return std::max<int64_t>(1, static_cast<int64_t>(ceil(*percentile)));
+}
+
+void table_query_client_t::note_outdated_read_latency(double latency_ms) {
+    if (outdated_read_latencies.size() < OUTDATED_READ_LATENCY_SAMPLES) {
+        outdated_read_latencies.push_back(latency_ms);
+    } else {
+        outdated_read_latencies[next_latency_sample] = latency_ms;
+    }
+    next_latency_sample = (next_latency_sample + 1) % OUTDATED_READ_LATENCY_SAMPLES;
+}
+
 void table_query_client_t::dispatch_outdated_read(
     const read_t &op,
     read_response_t *response,
@@ -341,38 +494,50 @@ void table_query_client_t::dispatch_outdated_read(
 
     std::vector<scoped_ptr_t<outdated_read_info_t> > replicas_to_contact;
 
+    const int64_t hedge_after_ms = get_outdated_read_hedge_timeout();
+
     scoped_ptr_t<outdated_read_info_t> new_op_info(new outdated_read_info_t());
     relationships.visit(region_t::universe(),
     [&](const region_t &region, const std::set<relationship_t *> &rels) {
         if (op.shard(region, &new_op_info->sharded_op)) {
-            std::vector<relationship_t *> potential_relationships;
-            relationship_t *chosen_relationship = nullptr;
+            std::vector<relationship_t *> replicas;
+            std::vector<outdated_read_candidate_t> candidates;
             for (auto jt = rels.begin(); jt != rels.end(); ++jt) {
                 // See the comment in `dispatch_immediate_op` about why we need to
                 // check that `region` and the relationship's region are the same.
                 if ((*jt)->direct_bcard != nullptr && (*jt)->region == region) {
-                    if ((*jt)->is_local) {
-                        chosen_relationship = *jt;
-                        break;
-                    } else {
-                        potential_relationships.push_back(*jt);
-                    }
+                    outdated_read_candidate_t candidate;
+                    candidate.is_local = (*jt)->is_local;
+                    candidate.has_latency =
+                        (*jt)->direct_read_stats.estimate_latency(&candidate.latency_ms);
+                    replicas.push_back(*jt);
+                    candidates.push_back(candidate);
                 }
             }
-            if (!chosen_relationship && !potential_relationships.empty()) {
-                chosen_relationship
-                    = potential_relationships[randint(potential_relationships.size())];
-            }
-            if (!chosen_relationship) {
+            if (candidates.empty()) {
                 /* Don't bother looking for masters; if there are no direct
                    readers, there won't be any masters either. */
                 throw cannot_perform_query_exc_t(
                     "no replica is available",
                     query_state_t::FAILED);
             }
-            new_op_info->direct_bcard = chosen_relationship->direct_bcard;
+            std::vector<size_t> ranking = rank_outdated_read_candidates(candidates);
+
+            relationship_t *chosen_relationship = replicas[ranking[0]];
+            if (chosen_relationship->is_local) {
+                ++ctx->stats.outdated_reads_local;
+            } else {
+                ++ctx->stats.outdated_reads_remote;
+            }
+            new_op_info->relationship = chosen_relationship;
             new_op_info->keepalive = auto_drainer_t::lock_t(
                 &chosen_relationship->drainer);
+            if (hedge_after_ms != 0 && candidates.size() > 1) {
+                new_op_info->hedge_relationship = replicas[ranking[1]];
+                new_op_info->hedge_keepalive = auto_drainer_t::lock_t(
+                    &replicas[ranking[1]]->drainer);
+                new_op_info->hedge_after_ms = hedge_after_ms;
+            }
             replicas_to_contact.push_back(std::move(new_op_info));
             new_op_info.init(new outdated_read_info_t());
         }
@@ -406,21 +571,44 @@ void table_query_client_t::perform_outdated_read(
 
     try {
         cond_t done;
-        mailbox_t<void(read_response_t)> cont(mailbox_manager,
-            [&](signal_t *, const read_response_t &res) {
-                results->at(i) = res;
-                done.pulse();
-            });
-
-        send(mailbox_manager,
-            replica_to_contact->direct_bcard->read_mailbox,
-            replica_to_contact->sharded_op,
-            cont.get_address());
+        read_response_t response;
+        outdated_read_attempt_t attempt(this, replica_to_contact->relationship,
+            replica_to_contact->sharded_op, &response, &done);
         wait_any_t waiter(replica_to_contact->keepalive.get_drain_signal(), &done);
-        wait_interruptible(&waiter, interruptor);
-        if (!done.is_pulsed()) {
-            /* `wait_interruptible()` returned because
-            `replica_to_contact->keepalive.get_drain_signal()` was pulsed */
+
+        scoped_ptr_t<outdated_read_attempt_t> hedge_attempt;
+        if (replica_to_contact->hedge_relationship != nullptr) {
+            signal_timer_t hedge_timer(replica_to_contact->hedge_after_ms);
+            wait_any_t hedge_waiter(&waiter, &hedge_timer);
+            wait_interruptible(&hedge_waiter, interruptor);
+            if (!waiter.is_pulsed()) {
+                ++ctx->stats.outdated_reads_hedged;
+                hedge_attempt.init(new outdated_read_attempt_t(this,
+                    replica_to_contact->hedge_relationship,
+                    replica_to_contact->sharded_op, &response, &done));
+            }
+        }
+
+        if (hedge_attempt.has()) {
+            /* Wait for either replica to answer. If we lose contact with one of them,
+            keep waiting for the other one. */
+            signal_t *drain_signal = replica_to_contact->keepalive.get_drain_signal();
+            signal_t *hedge_drain_signal =
+                replica_to_contact->hedge_keepalive.get_drain_signal();
+            wait_any_t hedge_waiter(&done, drain_signal, hedge_drain_signal);
+            wait_interruptible(&hedge_waiter, interruptor);
+            wait_any_t remaining_waiter(&done,
+                drain_signal->is_pulsed() ? hedge_drain_signal : drain_signal);
+            wait_interruptible(&remaining_waiter, interruptor);
+        } else {
+            wait_interruptible(&waiter, interruptor);
+        }
+
+        if (done.is_pulsed()) {
+            results->at(i) = std::move(response);
+        } else {
+            /* `wait_interruptible()` returned because the drain signals of the
+            replicas we sent the read to were pulsed */
             failures->at(i).assign("lost contact with replica");
         }
     } catch (const interrupted_exc_t &) {
@@ -445,9 +633,10 @@ void table_query_client_t::dispatch_debug_direct_read(
                 query_state_t::FAILED);
         }
         std::vector<read_response_t> responses;
-        pmap(CPU_SHARDING_FACTOR, [&](size_t shard_number) {
+        const size_t num_cpu_shards = multistore->num_cpu_shards();
+        pmap(num_cpu_shards, [&](size_t shard_number) {
             try {
-                region_t region = cpu_sharding_subspace(shard_number);
+                region_t region = cpu_sharding_subspace(shard_number, num_cpu_shards);
                 read_t subread;
                 if (!op.shard(region, &subread)) {
                     return;
@@ -16,11 +16,29 @@
 #include "concurrency/watchable_map.hpp"
 #include "protocol_api.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "time.hpp"
 
 class multi_table_manager_t;
 class primary_query_client_t;
 class table_meta_client_t;
 
+/* `outdated_read_candidate_t` describes one of the replicas that an outdated read
+could be sent to. `has_latency` is false if we don't have a recent latency sample for
+the replica, in which case `latency_ms` is meaningless. */
+class outdated_read_candidate_t {
+public:
+    bool is_local;
+    bool has_latency;
+    double latency_ms;
+};
+
+/* Returns the indices of `candidates` in the order in which we prefer to send an
+outdated read to them. Only replicas with latency samples are scored; the others rank
+like the average of the scored ones. The local replica wins all ties, including the
+case where there are no samples at all. Other ties are broken randomly. */
+std::vector<size_t> rank_outdated_read_candidates(
+        const std::vector<outdated_read_candidate_t> &candidates);
+
 /* `table_query_client_t` is responsible for sending queries to the cluster. It
 instantiates `primary_query_client_t` and `direct_query_client_t` internally; it covers
 the entire table whereas they cover single shards. */
@@ -68,12 +86,33 @@ public:
     std::set<region_t> get_sharding_scheme() THROWS_ONLY(cannot_perform_query_exc_t);
 
 private:
+    /* `direct_read_stats_t` keeps track of how fast a replica currently answers the
+    direct reads we send it, so that outdated reads can avoid replicas that are busy
+    with a backfill or otherwise slow. */
+    class direct_read_stats_t {
+    public:
+        direct_read_stats_t() :
+            ewma_latency_ms(0), last_sample_time(0), reads_in_flight(0) { }
+
+        void record_latency(double latency_ms);
+
+        /* Returns false if we don't have a recent enough sample to tell. Otherwise
+        returns the expected latency of a new read in `*latency_out`, taking the
+        reads that are still waiting for a response into account. */
+        bool estimate_latency(double *latency_out) const;
+
+        double ewma_latency_ms;
+        microtime_t last_sample_time;
+        int64_t reads_in_flight;
+    };
+
     class relationship_t {
     public:
         bool is_local;
         region_t region;
         primary_query_client_t *primary_client;
         const direct_query_bcard_t *direct_bcard;
+        direct_read_stats_t direct_read_stats;
         auto_drainer_t drainer;
     };
 
@@ -92,11 +131,20 @@ private:
 
     class outdated_read_info_t {
     public:
+        outdated_read_info_t() :
+            relationship(nullptr), hedge_relationship(nullptr), hedge_after_ms(0) { }
         read_t sharded_op;
-        const direct_query_bcard_t *direct_bcard;
+        relationship_t *relationship;
         auto_drainer_t::lock_t keepalive;
+        /* If `hedge_relationship` is set, the read is also sent to that replica in
+        case `relationship` doesn't answer within `hedge_after_ms`. */
+        relationship_t *hedge_relationship;
+        auto_drainer_t::lock_t hedge_keepalive;
+        int64_t hedge_after_ms;
     };
 
+    class outdated_read_attempt_t;
+
     template <class op_type, class fifo_enforcer_token_type, class op_response_type>
     void dispatch_immediate_op(
             /* `how_to_make_token` and `how_to_run_query` have type pointer-to-member-function. */
@@ -137,6 +185,11 @@ private:
             signal_t *interruptor)
         THROWS_NOTHING;
 
+    /* Returns how long an outdated read should wait for a replica before it is also
+    sent to a second one, or 0 if we shouldn't hedge reads (yet). */
+    int64_t get_outdated_read_hedge_timeout() const;
+    void note_outdated_read_latency(double latency_ms);
+
     void dispatch_debug_direct_read(
             const read_t &op,
             read_response_t *response,
@@ -160,6 +213,12 @@ private:
     rdb_context_t *const ctx;
     table_meta_client_t *m_table_meta_client;
 
+    /* The latencies of the most recent outdated reads, used to compute the timeout
+    after which we hedge a read. `next_latency_sample` is the index in
+    `outdated_read_latencies` that gets overwritten next. */
+    std::vector<double> outdated_read_latencies;
+    size_t next_latency_sample;
+
     std::map<std::pair<peer_id_t, uuid_u>, scoped_ptr_t<cond_t> > coro_stoppers;
     region_map_t<std::set<relationship_t *> > relationships;
 
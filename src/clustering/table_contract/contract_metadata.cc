@@ -215,10 +215,10 @@ table_raft_state_t make_new_table_raft_state(
                 contract_t::primary_t { shard_conf.primary_replica, boost::none });
         }
         contract.after_emergency_repair = false;
-        for (size_t j = 0; j < CPU_SHARDING_FACTOR; ++j) {
+        for (size_t j = 0; j < config.config.cpu_shards; ++j) {
             region_t region = region_intersection(
                 region_t(config.shard_scheme.get_shard_range(i)),
-                cpu_sharding_subspace(j));
+                cpu_sharding_subspace(j, config.config.cpu_shards));
             state.contracts.insert(std::make_pair(generate_uuid(),
                 std::make_pair(region, contract)));
         }
@@ -1,34 +1,44 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/table_contract/cpu_sharding.hpp"
 
-static const uint64_t CPU_SHARD_WIDTH = HASH_REGION_HASH_SIZE / CPU_SHARDING_FACTOR;
+bool is_valid_cpu_shard_count(size_t num_cpu_shards) {
+    return num_cpu_shards >= 1
+        && num_cpu_shards <= MAX_CPU_SHARDS
+        && (num_cpu_shards & (num_cpu_shards - 1)) == 0;
+}
+
+static uint64_t cpu_shard_width(size_t num_cpu_shards) {
+    guarantee(is_valid_cpu_shard_count(num_cpu_shards));
+    return HASH_REGION_HASH_SIZE / num_cpu_shards;
+}
 
-region_t cpu_sharding_subspace(int subregion_number) {
+region_t cpu_sharding_subspace(int subregion_number, size_t num_cpu_shards) {
     guarantee(subregion_number >= 0);
-    guarantee(subregion_number < CPU_SHARDING_FACTOR);
+    guarantee(static_cast<size_t>(subregion_number) < num_cpu_shards);
 
     /* Changing this implementation would break backwards compatibility in the disk
     format. */
 
     // We have to be careful with the math here, to avoid overflow.
-    uint64_t beg = CPU_SHARD_WIDTH * subregion_number;
-    uint64_t end = subregion_number + 1 == CPU_SHARDING_FACTOR
-        ? HASH_REGION_HASH_SIZE : beg + CPU_SHARD_WIDTH;
+    uint64_t width = cpu_shard_width(num_cpu_shards);
+    uint64_t beg = width * subregion_number;
+    uint64_t end = static_cast<size_t>(subregion_number) + 1 == num_cpu_shards
+        ? HASH_REGION_HASH_SIZE : beg + width;
 
     return region_t(beg, end, key_range_t::universe());
 }
 
-int get_cpu_shard_number(const region_t &region) {
-    int subregion_number = region.beg / CPU_SHARD_WIDTH;
-    guarantee(region.beg == subregion_number * CPU_SHARD_WIDTH);
+int get_cpu_shard_number(const region_t &region, size_t num_cpu_shards) {
+    uint64_t width = cpu_shard_width(num_cpu_shards);
+    int subregion_number = region.beg / width;
+    guarantee(region.beg == subregion_number * width);
     guarantee(region.end == (
-        subregion_number + 1 == CPU_SHARDING_FACTOR
+        static_cast<size_t>(subregion_number) + 1 == num_cpu_shards
             ? HASH_REGION_HASH_SIZE
-            : region.beg + CPU_SHARD_WIDTH));
+            : region.beg + width));
     return subregion_number;
 }
 
-int get_cpu_shard_approx_number(const region_t &region) {
-    return region.beg / CPU_SHARD_WIDTH;
+int get_cpu_shard_approx_number(const region_t &region, size_t num_cpu_shards) {
+    return region.beg / cpu_shard_width(num_cpu_shards);
 }
-
@@ -8,25 +8,37 @@
 
 class store_t;
 
-/* Changing this number would break backwards compatibility in the disk format. */
+/* The number of CPU shards of tables that were created before it could be configured
+per table. Changing this number would break backwards compatibility in the disk
+format. */
 #define CPU_SHARDING_FACTOR 8
 
+/* The number of CPU shards of a table can be any power of two up to `MAX_CPU_SHARDS`.
+It's fixed when the table is created. */
+#define MAX_CPU_SHARDS 64
+
+bool is_valid_cpu_shard_count(size_t num_cpu_shards);
+
 /* `cpu_sharding_subspace()` returns a `region_t` that contains the full key-range space
-but only 1/CPU_SHARDING_FACTOR of the shard space. */
-region_t cpu_sharding_subspace(int subregion_number);
+but only 1/num_cpu_shards of the shard space. */
+region_t cpu_sharding_subspace(
+    int subregion_number, size_t num_cpu_shards);
 
 /* `get_cpu_shard_number()` is the reverse of `cpu_sharding_subspace()`; it returns the
 subregion number for `region`'s hash subspace. It ignores `region`'s key boundaries. If
 `region`'s hash subspace doesn't exactly correspond to a specific CPU sharding region, it
 crashes. */
-int get_cpu_shard_number(const region_t &region);
+int get_cpu_shard_number(
+    const region_t &region, size_t num_cpu_shards);
 
 /* `get_cpu_shard_approx_number()` is like `get_cpu_shard_number()`, except that if the
 input doesn't correspond exactly to a CPU shard, it returns an estimate. */
-int get_cpu_shard_approx_number(const region_t &region);
+int get_cpu_shard_approx_number(
+    const region_t &region, size_t num_cpu_shards);
 
 /* `multistore_ptr_t` is a bundle of `store_view_t`s, one for each CPU shard. The rule
-is that `get_cpu_sharded_store(i)->get_region() == cpu_sharding_subspace(i)`. The
+is that `get_cpu_sharded_store(i)->get_region() ==
+cpu_sharding_subspace(i, num_cpu_shards())`. The
 individual stores' home threads may be different from the `multistore_ptr_t`'s home
 thread. */
 class multistore_ptr_t : public home_thread_mixin_t {
@@ -35,6 +47,8 @@ public:
 
     virtual branch_history_manager_t *get_branch_history_manager() = 0;
 
+    virtual size_t num_cpu_shards() = 0;
+
     virtual store_view_t *get_cpu_sharded_store(size_t i) = 0;
 
     /* The `sindex_manager_t` uses this interface to get at the underlying `store_t`s so
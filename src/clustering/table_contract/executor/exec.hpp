@@ -44,6 +44,9 @@ public:
         watchable_map_var_t<std::pair<server_id_t, branch_id_t>,
             contract_execution_bcard_t> *local_contract_execution_bcards;
         watchable_map_var_t<uuid_u, table_query_bcard_t> *local_table_query_bcards;
+        /* How long the `remote_replicator_server_t` of a primary waits for sync writes
+        to join a batch; see `remote_replicator_server_t`. */
+        int64_t replication_batch_latency_ms;
     };
 
     /* There is one `params` for each `execution_t`; it holds information that's specific
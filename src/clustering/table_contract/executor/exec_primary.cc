@@ -187,7 +187,8 @@ void primary_execution_t::run(auto_drainer_t::lock_t keepalive) {
 
         remote_replicator_server_t remote_replicator_server(
             context->mailbox_manager,
-            &primary_dispatcher);
+            &primary_dispatcher,
+            context->replication_batch_latency_ms);
 
         auto_drainer_t primary_dispatcher_drainer;
         assignment_sentry_t<auto_drainer_t *> our_dispatcher_drainer_assign(
@@ -18,7 +18,8 @@ public:
         parent(_parent), contract_id(_contract_id),
         store_subview(
             parent->multistore->get_cpu_sharded_store(
-                get_cpu_shard_number(key.region)),
+                get_cpu_shard_number(
+                    key.region, parent->multistore->num_cpu_shards())),
             key.region),
         perfmon_name(strprintf("%s-%d", key.role_name().c_str(), ++parent->perfmon_counter))
     {
@@ -127,6 +128,7 @@ contract_executor_t::contract_executor_t(
         io_backender_t *_io_backender,
         backfill_throttler_t *_backfill_throttler,
         backfill_progress_tracker_t *_backfill_progress_tracker,
+        int64_t _replication_batch_latency_ms,
         perfmon_collection_t *_perfmons) :
     server_id(_server_id),
     raft_state(_raft_state),
@@ -154,6 +156,7 @@ contract_executor_t::contract_executor_t(
     execution_context.local_contract_execution_bcards
         = &local_contract_execution_bcards;
     execution_context.local_table_query_bcards = &local_table_query_bcards;
+    execution_context.replication_batch_latency_ms = _replication_batch_latency_ms;
 
     multistore->assert_thread();
 
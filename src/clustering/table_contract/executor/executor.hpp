@@ -34,6 +34,7 @@ public:
         io_backender_t *io_backender,
         backfill_throttler_t *backfill_throttler,
         backfill_progress_tracker_t *backfill_progress_tracker,
+        int64_t replication_batch_latency_ms,
         perfmon_collection_t *perfmons);
     ~contract_executor_t();
 
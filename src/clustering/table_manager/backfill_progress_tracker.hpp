@@ -18,6 +18,9 @@ public:
         microtime_t start_time;
         server_id_t source_server_id;
         double progress;
+        /* The number of keys received from `source_server_id` so far, used to report
+        the backfill's throughput. */
+        uint64_t keys_received;
     };
 
     progress_tracker_t * insert_progress_tracker(const region_t &region);
@@ -18,6 +18,7 @@ multi_table_manager_t::multi_table_manager_t(
         table_persistence_interface_t *_persistence_interface,
         const base_path_t &_base_path,
         io_backender_t *_io_backender,
+        int64_t _replication_batch_latency_ms,
         perfmon_collection_repo_t *_perfmon_collection_repo) :
     is_proxy_server(false),
     server_id(_server_id),
@@ -29,6 +30,7 @@ multi_table_manager_t::multi_table_manager_t(
     persistence_interface(_persistence_interface),
     base_path(_base_path),
     io_backender(_io_backender),
+    replication_batch_latency_ms(_replication_batch_latency_ms),
     perfmon_collection_repo(_perfmon_collection_repo) {
 
     /* Resurrect any tables that were sitting on disk from when we last shut down */
@@ -45,8 +47,15 @@ multi_table_manager_t::multi_table_manager_t(
             perfmon_collection_repo_t::collections_t *perfmon_collections =
                 perfmon_collection_repo->get_perfmon_collections_for_namespace(table_id);
             table->status = table_t::status_t::ACTIVE;
+            /* The number of CPU shards and the block compression can't change after
+            the table is created, so it's safe to take them from the snapshot. */
+            const table_config_t &config =
+                raft_storage->get()->snapshot_state.config.config;
             persistence_interface->load_multistore(
-                table_id, metadata_read_txn, &table->multistore_ptr, &non_interruptor,
+                table_id,
+                config.cpu_shards,
+                config.block_compression,
+                metadata_read_txn, &table->multistore_ptr, &non_interruptor,
                 &perfmon_collections->serializers_collection);
             table->active = make_scoped<active_table_t>(
                 this, table, table_id, state.epoch, state.raft_member_id, raft_storage,
@@ -86,6 +95,7 @@ multi_table_manager_t::multi_table_manager_t(
     persistence_interface(nullptr),
     base_path(boost::none),
     io_backender(nullptr),
+    replication_batch_latency_ms(0),
     perfmon_collection_repo(nullptr)
 {
     help_construct();
@@ -129,9 +139,9 @@ multi_table_manager_t::active_table_t::active_table_t(
     table_id(_table_id),
     manager(parent->server_id, parent->mailbox_manager, parent->server_config_client,
         parent->table_manager_directory, &parent->backfill_throttler,
-        parent->connections_map, *parent->base_path, parent->io_backender, table_id,
-        epoch, member_id, raft_storage, start_election_immediately, multistore_ptr,
-        perfmon_collection_namespace),
+        parent->connections_map, *parent->base_path, parent->io_backender,
+        parent->replication_batch_latency_ms, table_id, epoch, member_id, raft_storage,
+        start_election_immediately, multistore_ptr, perfmon_collection_namespace),
     table_manager_bcard_copier(
         &parent->table_manager_bcards, table_id, manager.get_table_manager_bcard()),
     table_query_bcard_source(
@@ -402,6 +412,8 @@ void multi_table_manager_t::on_action(
             cond_t non_interruptor;
             persistence_interface->create_multistore(
                 table_id,
+                initial_raft_state->snapshot_state.config.config.cpu_shards,
+                initial_raft_state->snapshot_state.config.config.block_compression,
                 &table->multistore_ptr,
                 &non_interruptor,
                 &perfmon_collections->serializers_collection);
@@ -79,6 +79,7 @@ public:
         table_persistence_interface_t *_persistence_interface,
         const base_path_t &_base_path,
         io_backender_t *_io_backender,
+        int64_t _replication_batch_latency_ms,
         perfmon_collection_repo_t *_perfmon_collection_repo);
 
     /* This constructor is used on proxy servers. */
@@ -379,7 +380,8 @@ private:
 
     /* If we're a proxy server, then `is_proxy_server` will be `true`; `server_id` will
     be `nil_uuid()`; `persistence_interface` will be `nullptr`; `base_path` will be
-    empty; and `io_backender` will be `nullptr`. */
+    empty; `io_backender` will be `nullptr`; and `replication_batch_latency_ms` will be
+    unused. */
 
     bool is_proxy_server;
     server_id_t server_id;
@@ -395,6 +397,7 @@ private:
 
     boost::optional<base_path_t> base_path;
     io_backender_t *io_backender;
+    int64_t replication_batch_latency_ms;
 
     perfmon_collection_repo_t *perfmon_collection_repo;
 
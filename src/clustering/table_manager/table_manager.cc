@@ -16,6 +16,7 @@ table_manager_t::table_manager_t(
             *_connections_map,
         const base_path_t &_base_path,
         io_backender_t *_io_backender,
+        int64_t replication_batch_latency_ms,
         const namespace_id_t &_table_id,
         const multi_table_manager_timestamp_t::epoch_t &_epoch,
         const raft_member_id_t &_raft_member_id,
@@ -45,7 +46,7 @@ table_manager_t::table_manager_t(
             }),
         execution_bcard_read_manager.get_values(), multistore_ptr, _base_path,
         _io_backender, _backfill_throttler, &backfill_progress_tracker,
-        &perfmon_collection),
+        replication_batch_latency_ms, &perfmon_collection),
     execution_bcard_write_manager(
         mailbox_manager,
         contract_executor.get_local_contract_execution_bcards(),
@@ -25,6 +25,7 @@ public:
             *_connections_map,
         const base_path_t &_base_path,
         io_backender_t *_io_backender,
+        int64_t replication_batch_latency_ms,
         const namespace_id_t &_table_id,
         const multi_table_manager_timestamp_t::epoch_t &_epoch,
         const raft_member_id_t &raft_member_id,
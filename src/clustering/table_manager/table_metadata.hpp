@@ -340,14 +340,20 @@ public:
     virtual void delete_metadata(
         const namespace_id_t &table_id) = 0;
 
+    /* `load_multistore()` and `create_multistore()` open the table's data files, which
+    are split into `num_cpu_shards` stores. New blocks are written with `block_codec`. */
     virtual void load_multistore(
         const namespace_id_t &table_id,
+        size_t num_cpu_shards,
+        block_codec_t block_codec,
         metadata_file_t::read_txn_t *metadata_read_txn,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers) = 0;
     virtual void create_multistore(
         const namespace_id_t &table_id,
+        size_t num_cpu_shards,
+        block_codec_t block_codec,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers) = 0;
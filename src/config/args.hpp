@@ -111,6 +111,11 @@
 // then the page replacement algorithm will on average be unable to evict pages from the cache.
 #define PAGE_REPL_NUM_TRIES                       10
 
+// With the two-queue eviction policy, how much of the evictable memory (in percent)
+// may be taken up by pages that have been acquired more than once since they were
+// loaded.
+#define PAGE_REPL_PROTECTED_PERCENT               80
+
 // How large can the key be, in bytes?  This value needs to fit in a byte.
 #define MAX_KEY_SIZE                              250
 
@@ -153,6 +158,19 @@
 
 #define COROUTINE_STACK_SIZE                      131072
 
+// An outdated read that hasn't been answered after the
+// OUTDATED_READ_HEDGE_PERCENTILE-th percentile of recent outdated read latencies
+// is also sent to the next best replica, if there is one. Set the percentile to 0
+// to disable hedging.
+#define OUTDATED_READ_HEDGE_PERCENTILE            99
+#define OUTDATED_READ_LATENCY_SAMPLES             128
+
+// The password hashing of client handshakes runs on AUTH_CRYPTO_THREAD_COUNT
+// dedicated threads, and each thread caches the keys derived for up to
+// AUTH_KEY_CACHE_SIZE users.
+#define AUTH_CRYPTO_THREAD_COUNT                  2
+#define AUTH_KEY_CACHE_SIZE                       1024
+
 
 /**
  * Message scheduler configuration
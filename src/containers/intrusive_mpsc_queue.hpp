@@ -0,0 +1,98 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_INTRUSIVE_MPSC_QUEUE_HPP_
+#define CONTAINERS_INTRUSIVE_MPSC_QUEUE_HPP_
+
+#include <atomic>
+
+#include "containers/intrusive_list.hpp"
+#include "errors.hpp"
+
+template <class T> class intrusive_mpsc_queue_t;
+
+template <class T>
+class intrusive_mpsc_queue_node_t {
+protected:
+    intrusive_mpsc_queue_node_t() : mpsc_next_(nullptr) { }
+    ~intrusive_mpsc_queue_node_t() { }
+
+private:
+    friend class intrusive_mpsc_queue_t<T>;
+
+    intrusive_mpsc_queue_node_t *mpsc_next_;
+
+    DISABLE_COPYING(intrusive_mpsc_queue_node_t);
+};
+
+/* A lock-free queue that any number of threads can push onto, but only one thread
+(the consumer) can take things off of. Elements are handed over from and to
+`intrusive_list_t`s, so `T` has to derive from both `intrusive_list_node_t<T>` and
+`intrusive_mpsc_queue_node_t<T>`.
+
+Internally this is a stack: a push prepends its elements in reverse order with a
+single compare-and-swap, and `pop_all()` takes the whole stack with a single
+exchange and reverses it. Elements pushed by the same thread therefore come out in
+the order they went in, and so do the batches of different threads that are
+ordered with respect to each other.
+
+Pushing and popping are sequentially consistent, so that the consumer can clear a
+"woken up" flag before `pop_all()` and the producers can set it after `push_all()`
+without losing any wake-ups. */
+template <class T>
+class intrusive_mpsc_queue_t {
+public:
+    intrusive_mpsc_queue_t() : head_(nullptr) { }
+
+    ~intrusive_mpsc_queue_t() {
+        guarantee(head_.load() == nullptr, "non-empty intrusive mpsc queue destroyed");
+    }
+
+    // Moves all elements of `list` onto the queue. Can be called from any thread.
+    void push_all(intrusive_list_t<T> *list) {
+        if (list->empty()) {
+            return;
+        }
+        node_t *const last = node(list->head());
+        node_t *first = nullptr;
+        while (T *elem = list->head()) {
+            list->remove(elem);
+            node(elem)->mpsc_next_ = first;
+            first = node(elem);
+        }
+        node_t *old_head = head_.load(std::memory_order_relaxed);
+        do {
+            last->mpsc_next_ = old_head;
+        } while (!head_.compare_exchange_weak(old_head, first));
+    }
+
+    // Moves all elements of the queue onto the back of `out`, oldest first. Must
+    // only be called by the consumer.
+    void pop_all(intrusive_list_t<T> *out) {
+        node_t *n = head_.exchange(nullptr);
+        intrusive_list_t<T> popped;
+        while (n != nullptr) {
+            node_t *next = n->mpsc_next_;
+            n->mpsc_next_ = nullptr;
+            popped.push_front(static_cast<T *>(n));
+            n = next;
+        }
+        out->append_and_clear(&popped);
+    }
+
+    // Only a hint, unless called by the consumer while nobody is pushing.
+    bool empty() const {
+        return head_.load(std::memory_order_relaxed) == nullptr;
+    }
+
+private:
+    typedef intrusive_mpsc_queue_node_t<T> node_t;
+
+    static node_t *node(T *elem) {
+        return static_cast<node_t *>(elem);
+    }
+
+    std::atomic<node_t *> head_;
+
+    DISABLE_COPYING(intrusive_mpsc_queue_t);
+};
+
+#endif  // CONTAINERS_INTRUSIVE_MPSC_QUEUE_HPP_
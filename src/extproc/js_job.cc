@@ -153,7 +153,8 @@ enum js_task_t {
     TASK_EVAL,
     TASK_CALL,
     TASK_RELEASE,
-    TASK_EXIT
+    TASK_EXIT,
+    TASK_CALL_BATCH
 };
 
 // The job_t runs in the context of the main rethinkdb process
@@ -210,6 +211,35 @@ js_result_t js_job_t::call(js_id_t id, const std::vector<ql::datum_t> &args) {
     return result;
 }
 
+void js_job_t::call_batch(
+        js_id_t id, const std::vector<std::vector<ql::datum_t> > &args_batch) {
+    js_task_t task = js_task_t::TASK_CALL_BATCH;
+    write_message_t wm;
+    wm.append(&task, sizeof(task));
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, id);
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, args_batch);
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, limits);
+    {
+        int res = send_write_message(extproc_job.write_stream(), &wm);
+        if (res != 0) {
+            throw extproc_worker_exc_t("failed to send data to the worker");
+        }
+    }
+}
+
+js_result_t js_job_t::read_call_batch_result() {
+    js_result_t result;
+    archive_result_t res
+        = deserialize<cluster_version_t::LATEST_OVERALL>(extproc_job.read_stream(),
+                                                         &result);
+    if (bad(res)) {
+        throw extproc_worker_exc_t(strprintf("failed to deserialize call_batch result "
+                                             "from worker (%s)",
+                                             archive_result_as_str(res)));
+    }
+    return result;
+}
+
 void js_job_t::release(js_id_t id) {
     js_task_t task = js_task_t::TASK_RELEASE;
     write_message_t wm;
@@ -342,6 +372,43 @@ bool run_call(read_stream_t *stream_in,
     return send_js_result(stream_out, js_result);
 }
 
+// Calls the function once for each of the argument lists, and sends each result back
+// as soon as it's done, so that the caller can time out every call on its own.
+bool run_call_batch(read_stream_t *stream_in,
+                    write_stream_t *stream_out,
+                    js_env_t *js_env,
+                    uint64_t task_counter) {
+    js_id_t id;
+    std::vector<std::vector<ql::datum_t> > args_batch;
+    ql::configured_limits_t limits;
+    {
+        archive_result_t res
+            = deserialize<cluster_version_t::LATEST_OVERALL>(stream_in, &id);
+        if (bad(res)) { return false; }
+        res = deserialize<cluster_version_t::LATEST_OVERALL>(stream_in, &args_batch);
+        if (bad(res)) { return false; }
+        res = deserialize<cluster_version_t::LATEST_OVERALL>(stream_in, &limits);
+        if (bad(res)) { return false; }
+    }
+
+    for (const std::vector<ql::datum_t> &args : args_batch) {
+        js_result_t js_result;
+        try {
+            js_result = js_env->call(id, args, limits);
+        } catch (const std::exception &e) {
+            js_result = e.what();
+        } catch (...) {
+            js_result = std::string("encountered an unknown exception");
+        }
+
+        js_env->run_other_tasks(task_counter);
+        if (!send_js_result(stream_out, js_result)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool run_release(read_stream_t *stream_in,
                  write_stream_t *stream_out,
                  js_env_t *js_env,
@@ -386,6 +453,11 @@ bool js_job_t::worker_fn(read_stream_t *stream_in, write_stream_t *stream_out) {
                 return false;
             }
             break;
+        case TASK_CALL_BATCH:
+            if (!run_call_batch(stream_in, stream_out, &js_env, task_counter)) {
+                return false;
+            }
+            break;
         case TASK_RELEASE:
             if (!run_release(stream_in, stream_out, &js_env, task_counter)) {
                 return false;
@@ -24,6 +24,11 @@ public:
 
     js_result_t eval(const std::string &source);
     js_result_t call(js_id_t id, const std::vector<ql::datum_t> &args);
+    // Sends all of the argument lists to the worker in one message. The worker sends
+    // back one result per argument list, which `read_call_batch_result()` reads.
+    void call_batch(js_id_t id,
+                    const std::vector<std::vector<ql::datum_t> > &args_batch);
+    js_result_t read_call_batch_result();
     void release(js_id_t id);
     void exit();
 
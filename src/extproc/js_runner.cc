@@ -225,6 +225,72 @@ js_result_t js_runner_t::call(const std::string &source,
     return result;
 }
 
+std::vector<js_result_t> js_runner_t::call_batch(
+        const std::string &source,
+        const std::vector<std::vector<ql::datum_t> > &args_batch,
+        const req_config_t &config) {
+    assert_thread();
+    guarantee(job_data.has());
+
+    // This will retrieve the function from the cache if it's there, or re-eval it
+    js_result_t result = eval(source, config);
+    js_id_t *fn_id = boost::get<js_id_t>(&result);
+    if (fn_id == nullptr) {
+        if (boost::get<ql::datum_t>(&result) != nullptr) {
+            result = strprintf("Javascript query `%s` returned a value when it should "
+                               "have returned a function.", source.c_str());
+        }
+        return std::vector<js_result_t>(args_batch.size(), result);
+    }
+
+    std::vector<js_result_t> results;
+    results.reserve(args_batch.size());
+    object_buffer_t<js_timeout_t::sentry_t> sentry;
+
+    bool is_timeout = false;
+    try {
+        try {
+            sentry.create(&job_data->js_timeout, config.timeout_ms);
+            job_data->js_job.call_batch(*fn_id, args_batch);
+            for (size_t i = 0; i < args_batch.size(); ++i) {
+                if (i != 0) {
+                    // The worker sends each result as soon as it has it, so every
+                    // row gets the whole timeout.
+                    sentry.reset();
+                    sentry.create(&job_data->js_timeout, config.timeout_ms);
+                }
+                results.push_back(job_data->js_job.read_call_batch_result());
+            }
+        } catch (...) {
+            // This inner try-catch block deals with cleanup after an exception, but due
+            // to this we must store whether we triggered the timeout signal.
+            is_timeout = job_data->js_timeout.get_signal()->is_pulsed();
+
+            // Sentry must be destroyed before the js_timeout
+            sentry.reset();
+            // This will mark the worker as errored so we don't try to re-sync with it
+            //  on the next line (since we're in a catch statement, we aren't allowed)
+            job_data->js_job.worker_error();
+            job_data.reset();
+
+            throw;
+        }
+    } catch (interrupted_exc_t const &e) {
+        if (is_timeout) {
+            results.push_back(strprintf(
+                "JavaScript query `%s` timed out after %" PRIu64 ".%03" PRIu64 " seconds.",
+                source.c_str(), config.timeout_ms / 1000, config.timeout_ms % 1000));
+            return results;
+        } else {
+            throw;
+        }
+    }
+
+    // Unlike `call()`, we don't cache functions returned by the calls. They are
+    // released together with the worker.
+    return results;
+}
+
 void js_runner_t::cache_id(js_id_t id, const std::string &source) {
     guarantee(job_data.has());
     guarantee(id != INVALID_ID);
@@ -58,6 +58,15 @@ public:
                      const std::vector<ql::datum_t> &args,
                      const req_config_t &config);
 
+    // Calls a previously compiled function once for each of the argument lists in
+    // `args_batch`, sending all of them to the worker process in one message. Every
+    // call gets the whole timeout, like with `call()`. Returns one result per
+    // argument list, except that the results stop after a call that timed out.
+    std::vector<js_result_t> call_batch(
+        const std::string &source,
+        const std::vector<std::vector<ql::datum_t> > &args_batch,
+        const req_config_t &config);
+
 private:
     static const size_t CACHE_SIZE;
 
@@ -18,6 +18,10 @@ static const char *stat_per_sec = "per_sec";
 static const char *stat_count = "count";
 static const char *stat_mean = "mean";
 static const char *stat_std_dev = "std_dev";
+static const char *stat_p50 = "p50";
+static const char *stat_p90 = "p90";
+static const char *stat_p99 = "p99";
+static const char *stat_p999 = "p999";
 
 
 #ifdef FULL_PERFMON
@@ -301,6 +305,118 @@ ql::datum_t perfmon_rate_monitor_t::output_stat(const double &stat) {
     return ql::datum_t(stat / ticks_to_secs(length));
 }
 
+/* perfmon_latency_histogram_t */
+
+size_t perfmon_histogram::bucket_for_value(uint64_t value) {
+    if (value < 2 * sub_buckets) {
+        return value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - sub_bucket_bits;
+    if (shift > max_shift) {
+        return num_buckets - 1;
+    }
+    return sub_buckets * shift + (value >> shift);
+}
+
+uint64_t perfmon_histogram::bucket_upper_bound(size_t bucket) {
+    if (bucket < 2 * sub_buckets) {
+        return bucket;
+    }
+    uint64_t shift = bucket / sub_buckets - 1;
+    uint64_t mantissa = bucket - sub_buckets * shift;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+uint64_t perfmon_histogram::stats_t::percentile(double fraction) const {
+    rassert(count > 0);
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(ceil(fraction * count)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < num_buckets; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // The bucket's upper bound can be larger than anything we've actually
+            // seen, for example if all values were the same.
+            return std::min(bucket_upper_bound(i), max);
+        }
+    }
+    return max;
+}
+
+perfmon_latency_histogram_t::perfmon_latency_histogram_t(ticks_t _length)
+    : perfmon_perthread_t<stats_t>(), length(_length) { }
+
+perfmon_latency_histogram_t::~perfmon_latency_histogram_t() { }
+
+perfmon_latency_histogram_t::thread_info_t *
+perfmon_latency_histogram_t::get_thread_info(ticks_t now) {
+    int interval = now / length;
+    rassert(get_thread_id().threadnum >= 0);
+    std::unique_ptr<thread_info_t> *thread = &thread_data[get_thread_id().threadnum];
+
+    if (!*thread) {
+        thread->reset(new thread_info_t);
+        (*thread)->current_interval = interval;
+    } else if ((*thread)->current_interval == interval) {
+        /* We're up to date; nothing to do */
+    } else if ((*thread)->current_interval + 1 == interval) {
+        /* We're one step behind */
+        (*thread)->last_stats = (*thread)->current_stats;
+        (*thread)->current_stats = stats_t();
+        (*thread)->current_interval++;
+    } else {
+        /* We're more than one step behind */
+        (*thread)->last_stats = (*thread)->current_stats = stats_t();
+        (*thread)->current_interval = interval;
+    }
+    return thread->get();
+}
+
+void perfmon_latency_histogram_t::record(ticks_t duration) {
+    get_thread_info(get_ticks())->current_stats.record(duration / THOUSAND);
+}
+
+void perfmon_latency_histogram_t::get_thread_stat(stats_t *stat) {
+    rassert(get_thread_id().threadnum >= 0);
+    if (thread_data[get_thread_id().threadnum]) {
+        /* Like `perfmon_sampler_t`, we return the last complete interval. */
+        *stat = get_thread_info(get_ticks())->last_stats;
+    }
+}
+
+perfmon_latency_histogram_t::stats_t
+perfmon_latency_histogram_t::combine_stats(const stats_t *stats) {
+    stats_t aggregated;
+    for (int i = 0; i < get_num_threads(); i++) {
+        aggregated.aggregate(stats[i]);
+    }
+    return aggregated;
+}
+
+ql::datum_t perfmon_latency_histogram_t::output_stat(const stats_t &aggregated) {
+    ql::datum_object_builder_t builder;
+
+    builder.overwrite(stat_count, ql::datum_t(static_cast<double>(aggregated.count)));
+    const std::pair<const char *, double> percentiles[] = {
+        { stat_p50, 0.5 }, { stat_p90, 0.9 }, { stat_p99, 0.99 }, { stat_p999, 0.999 } };
+    for (const auto &p : percentiles) {
+        if (aggregated.count > 0) {
+            builder.overwrite(p.first, ql::datum_t(
+                aggregated.percentile(p.second) / static_cast<double>(MILLION)));
+        } else {
+            builder.overwrite(p.first, ql::datum_t::null());
+        }
+    }
+    if (aggregated.count > 0) {
+        builder.overwrite(stat_max,
+                          ql::datum_t(aggregated.max / static_cast<double>(MILLION)));
+    } else {
+        builder.overwrite(stat_max, ql::datum_t::null());
+    }
+
+    return std::move(builder).to_datum();
+}
+
 perfmon_duration_sampler_t::perfmon_duration_sampler_t(ticks_t length, bool _ignore_global_full_perfmon)
     : stat(), active(), total(), recent(length, true),
       active_membership(&stat, &active, "active_count"),
@@ -215,6 +215,84 @@ public:
     void record(double value = 1.0);
 };
 
+/* perfmon_latency_histogram_t records how long events take in a log-linear
+ * histogram, in the spirit of HdrHistogram. Durations are kept in microseconds;
+ * every power of two is split into `perfmon_histogram::sub_buckets` equally sized
+ * buckets, so a bucket is never wider than 1/16th of the values it holds. It
+ * reports the number of events and the 50th, 90th, 99th and 99.9th percentiles
+ * and the maximum over the last complete interval of `length` ticks, in seconds.
+ *
+ * Each thread only ever touches its own histograms, which are allocated the
+ * first time the thread records something, and they are merged when the stats
+ * are collected. So unlike `perfmon_sampler_t` this can tell you about the tail
+ * latency, not just the mean.
+ */
+namespace perfmon_histogram {
+
+// Values below `2 * sub_buckets` microseconds get a bucket each. Above that, the
+// bucket for `v` is `sub_buckets * shift + (v >> shift)`, where `shift` is chosen
+// so that `v >> shift` lies in `[sub_buckets, 2 * sub_buckets)`.
+static const int sub_bucket_bits = 4;
+static const uint64_t sub_buckets = 1 << sub_bucket_bits;
+// Durations of more than `2^(max_shift + sub_bucket_bits + 1)` microseconds (a bit
+// over 19 hours) end up in the last bucket.
+static const int max_shift = 32;
+static const size_t num_buckets = sub_buckets * (max_shift + 2);
+
+size_t bucket_for_value(uint64_t value);
+// The highest value that ends up in the given bucket.
+uint64_t bucket_upper_bound(size_t bucket);
+
+struct stats_t {
+    uint64_t count;
+    uint64_t max;
+    uint32_t buckets[num_buckets];
+
+    stats_t() : count(0), max(0) {
+        std::fill(buckets, buckets + num_buckets, 0);
+    }
+    void record(uint64_t v) {
+        ++count;
+        max = std::max(max, v);
+        ++buckets[bucket_for_value(v)];
+    }
+    void aggregate(const stats_t &s) {
+        count += s.count;
+        max = std::max(max, s.max);
+        for (size_t i = 0; i < num_buckets; ++i) {
+            buckets[i] += s.buckets[i];
+        }
+    }
+    // The smallest value that at least `fraction` of the recorded values are less
+    // than or equal to, within the precision of the buckets.
+    uint64_t percentile(double fraction) const;
+};
+
+}  // namespace perfmon_histogram
+
+class perfmon_latency_histogram_t
+    : public perfmon_perthread_t<perfmon_histogram::stats_t> {
+    typedef perfmon_histogram::stats_t stats_t;
+    struct thread_info_t {
+        stats_t current_stats, last_stats;
+        int current_interval;
+    };
+
+    std::unique_ptr<thread_info_t> thread_data[MAX_THREADS];
+
+    thread_info_t *get_thread_info(ticks_t now);
+
+    void get_thread_stat(stats_t *);
+    stats_t combine_stats(const stats_t *);
+    ql::datum_t output_stat(const stats_t &);
+
+    ticks_t length;
+public:
+    explicit perfmon_latency_histogram_t(ticks_t _length);
+    virtual ~perfmon_latency_histogram_t();
+    void record(ticks_t duration);
+};
+
 /* perfmon_duration_sampler_t is a perfmon_t that monitors events that have a
  * starting and ending time. When something starts, call begin(); when
  * something ends, call end() with the same value as begin. It will produce
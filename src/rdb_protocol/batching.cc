@@ -316,6 +316,7 @@ batcher_t::batcher_t(
       min_els_left(min_els),
       els_left(max_els),
       size_left(max_size),
+      has_size_limit(max_size != std::numeric_limits<int64_t>::max()),
       end_time(_end_time) { }
 
 } // namespace ql
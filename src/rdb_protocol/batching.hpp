@@ -44,7 +44,11 @@ public:
         seen_one_el = true;
         els_left -= 1;
         min_els_left -= 1;
-        size_left -= serialized_size<cluster_version_t::CLUSTER>(t);
+        // Computing the serialized size of a constructed datum means walking all of
+        // it, so we don't do that for batches that have no size limit anyway.
+        if (has_size_limit) {
+            size_left -= serialized_size<cluster_version_t::CLUSTER>(t);
+        }
         return should_send_batch();
     }
     bool should_send_batch(
@@ -55,6 +59,7 @@ public:
         min_els_left(std::move(other.min_els_left)),
         els_left(std::move(other.els_left)),
         size_left(std::move(other.size_left)),
+        has_size_limit(std::move(other.has_size_limit)),
         end_time(std::move(other.end_time)) { }
     microtime_t microtime_left() {
         microtime_t cur_time = current_microtime();
@@ -70,6 +75,7 @@ private:
     const batch_type_t batch_type;
     bool seen_one_el;
     int64_t min_els_left, els_left, size_left;
+    const bool has_size_limit;
     const microtime_t end_time;
 };
 
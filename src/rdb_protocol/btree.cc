@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <functional>
 #include <iterator>
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -13,13 +14,16 @@
 
 #include "btree/concurrent_traversal.hpp"
 #include "btree/get_distribution.hpp"
+#include "btree/leaf_node.hpp"
 #include "btree/operations.hpp"
 #include "btree/reql_specific.hpp"
 #include "btree/superblock.hpp"
 #include "buffer_cache/serialize_onto_blob.hpp"
+#include "concurrency/auto_drainer.hpp"
 #include "concurrency/coro_pool.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "concurrency/queue/unlimited_fifo.hpp"
+#include "concurrency/wait_any.hpp"
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/buffer_group_stream.hpp"
 #include "containers/archive/buffer_stream.hpp"
@@ -31,6 +35,7 @@
 #include "rdb_protocol/geo_traversal.hpp"
 #include "rdb_protocol/lazy_btree_val.hpp"
 #include "rdb_protocol/pseudo_geometry.hpp"
+#include "rdb_protocol/row_projection.hpp"
 #include "rdb_protocol/serialize_datum_onto_blob.hpp"
 #include "rdb_protocol/shards.hpp"
 #include "rdb_protocol/table_common.hpp"
@@ -64,6 +69,10 @@ block_magic_t rdb_value_sizer_t::btree_leaf_magic() const {
     return leaf_magic();
 }
 
+bool rdb_value_sizer_t::btree_leaf_key_prefixes() const {
+    return true;
+}
+
 max_block_size_t rdb_value_sizer_t::block_size() const { return block_size_; }
 
 bool btree_value_fits(max_block_size_t bs, int data_length, const rdb_value_t *value) {
@@ -636,7 +645,8 @@ public:
                region_t region,
                store_key_t last_key,
                sorting_t _sorting,
-               require_sindexes_t require_sindex_val)
+               require_sindexes_t require_sindex_val,
+               boost::optional<std::vector<datum_string_t> > &&_row_projection)
         : env(_env),
           batcher(make_scoped<ql::batcher_t>(batchspec.to_batcher())),
           sorting(_sorting),
@@ -646,7 +656,8 @@ public:
                                         std::move(last_key),
                                         sorting,
                                         batcher.get(),
-                                        require_sindex_val)) {
+                                        require_sindex_val)),
+          row_projection(std::move(_row_projection)) {
         for (size_t i = 0; i < _transforms.size(); ++i) {
             transformers.push_back(ql::make_op(_transforms[i]));
         }
@@ -664,6 +675,9 @@ private:
     std::vector<scoped_ptr_t<ql::op_t> > transformers;
     sorting_t sorting;
     scoped_ptr_t<ql::accumulator_t> accumulator;
+    // If set, the transformers and the accumulator only look at these fields of
+    // the rows, so we don't have to load the others.
+    boost::optional<std::vector<datum_string_t> > row_projection;
 };
 
 class rget_io_data_t {
@@ -690,7 +704,55 @@ public:
         concurrent_traversal_fifo_enforcer_signal_t waiter)
         THROWS_ONLY(interrupted_exc_t);
     void finish(continue_bool_t last_cb) THROWS_ONLY(interrupted_exc_t);
+
+    // Transforms and accumulates the rows that `handle_pair()` has buffered. Must be
+    // called after each traversal if there is more than one, because the next
+    // traversal depends on the active region range. Returns ABORT if `cont` is
+    // ABORT or the accumulator is done.
+    continue_bool_t finish_traversal(continue_bool_t cont) THROWS_ONLY(interrupted_exc_t);
 private:
+    // A row that has been loaded, but not been transformed and accumulated yet.
+    struct pending_row_t {
+        pending_row_t(store_key_t &&_key, ql::datum_t &&_val, size_t _copies,
+                      bool _must_check_copies)
+            : key(std::move(_key)), val(std::move(_val)), copies(_copies),
+              must_check_copies(_must_check_copies) { }
+        store_key_t key;
+        ql::datum_t val;
+        size_t copies;
+        bool must_check_copies;
+        ql::datum_t sindex_val_cache; // an empty `datum_t` until initialized
+        ql::groups_t data;
+    };
+
+    // How many rows we buffer if `batch_transforms` is set.
+    static const size_t TRANSFORM_BATCH_SIZE = 64;
+
+    continue_bool_t flush_pending_rows() THROWS_ONLY(interrupted_exc_t);
+
+    // Returns `true` if we must stop before the row with the given key, so that we
+    // don't stop in the middle of a truncated secondary index value.
+    bool stop_at_truncated_boundary(const store_key_t &key);
+    void update_active_region_range(const store_key_t &key);
+    // Returns the row's secondary index value, which it computes and stores in
+    // `*cache` the first time.
+    ql::datum_t get_sindex_val(const store_key_t &key,
+                               const ql::datum_t &val,
+                               ql::datum_t *cache);
+    continue_bool_t accumulate_row(const store_key_t &key,
+                                   ql::groups_t *data,
+                                   const std::function<ql::datum_t()> &lazy_sindex_val);
+    // Stores an `ql::exc_t` or `ql::datum_exc_t` in the response.
+    void report_error(const std::exception_ptr &error);
+
+    // Sets `*copies_out` to the number of times that the row with the given secondary
+    // index key has to be returned, as far as that can be told from the key alone.
+    // Returns `true` if it can't, in which case the row's secondary index value
+    // decides.
+    bool sindex_copies_from_key(const store_key_t &key,
+                                const boost::optional<std::string> &skey_left,
+                                size_t *copies_out) const;
+
     const rget_io_data_t io; // How do get data in/out.
     job_data_t job; // What to do next (stateful).
     const boost::optional<rget_sindex_data_t> sindex; // Optional sindex information.
@@ -702,6 +764,12 @@ private:
     boost::optional<std::string> last_truncated_secondary_for_abort;
     scoped_ptr_t<profile::disabler_t> disabler;
     scoped_ptr_t<profile::sampler_t> sampler;
+
+    // If one of the transformers is cheaper to apply to many rows at once (see
+    // `ql::op_t::is_batchable()`), `handle_pair()` collects up to
+    // `TRANSFORM_BATCH_SIZE` rows in `pending_rows` before it transforms them.
+    bool batch_transforms;
+    std::vector<scoped_ptr_t<pending_row_t> > pending_rows;
 };
 
 // This is the interface the btree code expects, but our actual callback needs a
@@ -735,7 +803,11 @@ rget_cb_t::rget_cb_t(rget_io_data_t &&_io,
     : io(std::move(_io)),
       job(std::move(_job)),
       sindex(std::move(_sindex)),
-      bad_init(false) {
+      bad_init(false),
+      batch_transforms(false) {
+    for (const auto &transformer : job.transformers) {
+        batch_transforms = batch_transforms || transformer->is_batchable();
+    }
 
     if (sindex) {
         // Secondary index functions are deterministic (so no need for an
@@ -755,9 +827,125 @@ rget_cb_t::rget_cb_t(rget_io_data_t &&_io,
 }
 
 void rget_cb_t::finish(continue_bool_t last_cb) THROWS_ONLY(interrupted_exc_t) {
+    last_cb = finish_traversal(last_cb);
     job.accumulator->finish(last_cb, &io.response->result);
 }
 
+continue_bool_t rget_cb_t::finish_traversal(continue_bool_t cont)
+    THROWS_ONLY(interrupted_exc_t) {
+    if (pending_rows.empty()) {
+        return cont;
+    }
+    continue_bool_t flush_cont = flush_pending_rows();
+    return cont == continue_bool_t::ABORT ? cont : flush_cont;
+}
+
+bool rget_cb_t::sindex_copies_from_key(
+        const store_key_t &key,
+        const boost::optional<std::string> &skey_left,
+        size_t *copies_out) const {
+    guarantee(sindex);
+    // We only need to check the secondary index value if we are on the boundary of
+    // the sindex range, and the involved keys are truncated.
+    /* Here's an attempt at explaining the different case distinctions handled in
+       this check (for the left bound; the right bound check is similar):
+       The case distinctions are as follows:
+       1. left_bound_is_truncated
+        If the left bound key had to be truncated, we first compare the prefix of
+        the current secondary key (skey_current), and the left bound key.
+        The comparison cannot be -1, because that would mean that we computed the
+        traversal key range incorrectly in the first place (there's no need to
+        consider keys that are *smaller* than the left bound).
+        If the comparison is 1, the current key's secondary part is larger than
+        the left bound, and we know that the corresponding datum_t value must
+        also be larger than the datum_t corresponding to the left bound.
+        Finally, since the left bound is truncated, the comparison can determine
+        that the prefix is equal for values in the btree with corresponding index
+        values that are either left of the bound (but match in the truncated
+        prefix), at the bound (which we want to include only if the left bound is
+        closed), or right of the bound (which we always want to include, as far
+        as the left bound id concerned). We can't determine which case we have,
+        by looking only at the keys. Hence we must check the number of copies for
+        `cmp == 0`. The only exception is if the current key was actually not
+        truncated, in which case we know that it will actually be smaller than
+        the left bound.
+       2. !left_bound_is_truncated && left_bound is closed
+        If the bound wasn't truncated, we know that the traversal range will not
+        include any values which are smaller than the left bound. Hence we can
+        skip the check for whether the sindex value is actually in the datum
+        range.
+       3. !left_bound_is_truncated && left_bound is open
+        In contrast, if the left bound is open, we compare the left bound and
+        current key. If they have the same size and their contents compare equal,
+        we actually know that they are outside the range and could set the number
+        of copies to 0. We do the slightly less optimal but simpler thing and
+        just check the number of copies in this case, so that we can share the
+        code path with case 1. */
+    const size_t max_trunc_size = ql::datum_t::max_trunc_size();
+    bool must_check_copies = false;
+    sindex->datumspec.visit<void>(
+    [&](const ql::datum_range_t &r) {
+        std::string skey_current =
+            ql::datum_t::extract_truncated_secondary(key_to_unescaped_str(key));
+        const bool left_bound_is_truncated =
+            sindex->lbound_trunc_key.size() == max_trunc_size;
+        if (left_bound_is_truncated
+            || r.left_bound_type == key_range_t::bound_t::open) {
+            int cmp = memcmp(
+                skey_current.data(),
+                sindex->lbound_trunc_key.data(),
+                std::min<size_t>(skey_current.size(),
+                                 sindex->lbound_trunc_key.size()));
+            if (skey_current.size() < sindex->lbound_trunc_key.size()) {
+                guarantee(cmp != 0);
+            }
+            guarantee(cmp >= 0);
+            if (cmp == 0
+                && skey_current.size() == sindex->lbound_trunc_key.size()) {
+                must_check_copies = true;
+            }
+        }
+        if (!must_check_copies) {
+            const bool right_bound_is_truncated =
+                sindex->rbound_trunc_key.size() == max_trunc_size;
+            if (right_bound_is_truncated
+                || r.right_bound_type == key_range_t::bound_t::open) {
+                int cmp = memcmp(
+                    skey_current.data(),
+                    sindex->rbound_trunc_key.data(),
+                    std::min<size_t>(skey_current.size(),
+                                     sindex->rbound_trunc_key.size()));
+                if (skey_current.size() > sindex->rbound_trunc_key.size()) {
+                    guarantee(cmp != 0);
+                }
+                guarantee(cmp <= 0);
+                if (cmp == 0
+                    && skey_current.size() == sindex->rbound_trunc_key.size()) {
+                    must_check_copies = true;
+                }
+            }
+        }
+        if (!must_check_copies) {
+            *copies_out = 1;
+        }
+    },
+    [&](const std::map<ql::datum_t, uint64_t> &) {
+        guarantee(skey_left);
+        std::string skey_current =
+            ql::datum_t::extract_secondary(key_to_unescaped_str(key));
+        const bool skey_current_is_truncated =
+            skey_current.size() >= max_trunc_size;
+        const bool skey_left_is_truncated = skey_left->size() >= max_trunc_size;
+
+        if (skey_current_is_truncated || skey_left_is_truncated) {
+            must_check_copies = true;
+        } else if (*skey_left != skey_current) {
+            *copies_out = 0;
+        }
+    });
+    return must_check_copies;
+}
+
 // Handle a keyvalue pair.  Returns whether or not we're done early.
 continue_bool_t rget_cb_t::handle_pair(
     scoped_key_value_t &&keyvalue,
@@ -778,14 +966,26 @@ continue_bool_t rget_cb_t::handle_pair(
     if (sindex && !sindex->pkey_range.contains_key(ql::datum_t::extract_primary(key))) {
         return continue_bool_t::CONTINUE;
     }
+    // Whether we need the row's secondary index value to know how many times to
+    // return it. This only depends on the key, so we can find out before loading
+    // the row.
+    size_t copies = default_copies;
+    const bool must_check_copies =
+        sindex && sindex_copies_from_key(key, skey_left, &copies);
+    if (copies == 0) {
+        return continue_bool_t::CONTINUE;
+    }
     lazy_btree_val_t row(static_cast<const rdb_value_t *>(keyvalue.value()),
-                         keyvalue.expose_buf());
+                         keyvalue.expose_buf(),
+                         job.row_projection ? &*job.row_projection : NULL);
     ql::datum_t val;
     // Count stats whether or not we deserialize the value
     io.slice->stats.pm_keys_read.record();
     io.slice->stats.pm_total_keys_read += 1;
-    // We only load the value if we actually use it (`count` does not).
-    if (job.accumulator->uses_val() || job.transformers.size() != 0 || sindex) {
+    // We only load the value if we actually use it (`count` does not, unless it
+    // has to compute the secondary index value of the row).
+    if (job.accumulator->uses_val() || job.transformers.size() != 0
+        || must_check_copies) {
         val = row.get();
     } else {
         row.reset();
@@ -798,49 +998,22 @@ continue_bool_t rget_cb_t::handle_pair(
     // STUFF THAT HAS TO HAPPEN IN ORDER GOES BELOW HERE //
     ///////////////////////////////////////////////////////
 
-    // If the sindex portion of the key is long enough that it might be >= the
-    // length of a truncated sindex, we need to rember the key so we can make
-    // sure not to stop in the middle of a sindex range where some of the values
-    // are out of order because of truncation.
-    bool remember_key_for_sindex_batching = sindex
-        ? (ql::datum_t::extract_secondary(key_to_unescaped_str(key)).size()
-           >= ql::datum_t::max_trunc_size())
-        : false;
-    if (last_truncated_secondary_for_abort) {
-        std::string cur_truncated_secondary =
-            ql::datum_t::extract_truncated_secondary(key_to_unescaped_str(key));
-        if (cur_truncated_secondary != *last_truncated_secondary_for_abort) {
-            // The semantics here are that we're returning the "last considered
-            // key", which we set specially here to preserve the invariant that
-            // unsharding either consumes all rows with a particular truncated
-            // sindex value or none of them.
-            store_key_t stop_key;
-            if (!reversed(job.sorting)) {
-                stop_key = store_key_t(cur_truncated_secondary);
-            } else {
-                stop_key = store_key_t(*last_truncated_secondary_for_abort);
-            }
-            stop_key.decrement();
-            job.accumulator->stop_at_boundary(std::move(stop_key));
-            return continue_bool_t::ABORT;
+    if (batch_transforms) {
+        // `flush_pending_rows()` transforms and accumulates the rows in this order.
+        pending_rows.push_back(make_scoped<pending_row_t>(
+            std::move(key), std::move(val), copies, must_check_copies));
+        if (pending_rows.size() < TRANSFORM_BATCH_SIZE) {
+            return continue_bool_t::CONTINUE;
         }
+        return flush_pending_rows();
+    }
+
+    if (stop_at_truncated_boundary(key)) {
+        return continue_bool_t::ABORT;
     }
 
     try {
-        // Update the active region range.
-        if (sindex) {
-            if (!reversed(job.sorting)) {
-                if (sindex->active_region_range_inout->left < key) {
-                    sindex->active_region_range_inout->left = key;
-                    sindex->active_region_range_inout->left.increment();
-                }
-            } else {
-                if (key < sindex->active_region_range_inout->right.key_or_max()) {
-                    sindex->active_region_range_inout->right =
-                        key_range_t::right_bound_t(key);
-                }
-            }
-        }
+        update_active_region_range(key);
 
         // There are certain transformations and accumulators that need the
         // secondary index value, though many don't. We don't want to compute
@@ -849,123 +1022,12 @@ continue_bool_t rget_cb_t::handle_pair(
         // lazily the first time it's called.
         ql::datum_t sindex_val_cache; // an empty `datum_t` until initialized
         auto lazy_sindex_val = [&]() -> ql::datum_t {
-            if (sindex && !sindex_val_cache.has()) {
-                sindex_val_cache =
-                    sindex->func->call(sindex_env.get(), val)->as_datum();
-                if (sindex->multi == sindex_multi_bool_t::MULTI
-                    && sindex_val_cache.get_type() == ql::datum_t::R_ARRAY) {
-                    boost::optional<uint64_t> tag = *ql::datum_t::extract_tag(key);
-                    guarantee(tag);
-                    sindex_val_cache = sindex_val_cache.get(*tag, ql::NOTHROW);
-                    guarantee(sindex_val_cache.has());
-                }
-            }
-            return sindex_val_cache;
+            return get_sindex_val(key, val, &sindex_val_cache);
         };
 
         // Check whether we're outside the sindex range.
-        // We only need to check this if we are on the boundary of the sindex range, and
-        // the involved keys are truncated.
-        size_t copies = default_copies;
-        if (sindex) {
-            /* Here's an attempt at explaining the different case distinctions handled in
-               this check (for the left bound; the right bound check is similar):
-               The case distinctions are as follows:
-               1. left_bound_is_truncated
-                If the left bound key had to be truncated, we first compare the prefix of
-                the current secondary key (skey_current), and the left bound key.
-                The comparison cannot be -1, because that would mean that we computed the
-                traversal key range incorrectly in the first place (there's no need to
-                consider keys that are *smaller* than the left bound).
-                If the comparison is 1, the current key's secondary part is larger than
-                the left bound, and we know that the corresponding datum_t value must
-                also be larger than the datum_t corresponding to the left bound.
-                Finally, since the left bound is truncated, the comparison can determine
-                that the prefix is equal for values in the btree with corresponding index
-                values that are either left of the bound (but match in the truncated
-                prefix), at the bound (which we want to include only if the left bound is
-                closed), or right of the bound (which we always want to include, as far
-                as the left bound id concerned). We can't determine which case we have,
-                by looking only at the keys. Hence we must check the number of copies for
-                `cmp == 0`. The only exception is if the current key was actually not
-                truncated, in which case we know that it will actually be smaller than
-                the left bound (that's encoded in line 825).
-               2. !left_bound_is_truncated && left_bound is closed
-                If the bound wasn't truncated, we know that the traversal range will not
-                include any values which are smaller than the left bound. Hence we can
-                skip the check for whether the sindex value is actually in the datum
-                range.
-               3. !left_bound_is_truncated && left_bound is open
-                In contrast, if the left bound is open, we compare the left bound and
-                current key. If they have the same size and their contents compare equal,
-                we actually know that they are outside the range and could set the number
-                of copies to 0. We do the slightly less optimal but simpler thing and
-                just check the number of copies in this case, so that we can share the
-                code path with case 1. */
-            const size_t max_trunc_size = ql::datum_t::max_trunc_size();
-            sindex->datumspec.visit<void>(
-            [&](const ql::datum_range_t &r) {
-                bool must_check_copies = false;
-                std::string skey_current =
-                    ql::datum_t::extract_truncated_secondary(key_to_unescaped_str(key));
-                const bool left_bound_is_truncated =
-                    sindex->lbound_trunc_key.size() == max_trunc_size;
-                if (left_bound_is_truncated
-                    || r.left_bound_type == key_range_t::bound_t::open) {
-                    int cmp = memcmp(
-                        skey_current.data(),
-                        sindex->lbound_trunc_key.data(),
-                        std::min<size_t>(skey_current.size(),
-                                         sindex->lbound_trunc_key.size()));
-                    if (skey_current.size() < sindex->lbound_trunc_key.size()) {
-                        guarantee(cmp != 0);
-                    }
-                    guarantee(cmp >= 0);
-                    if (cmp == 0
-                        && skey_current.size() == sindex->lbound_trunc_key.size()) {
-                        must_check_copies = true;
-                    }
-                }
-                if (!must_check_copies) {
-                    const bool right_bound_is_truncated =
-                        sindex->rbound_trunc_key.size() == max_trunc_size;
-                    if (right_bound_is_truncated
-                        || r.right_bound_type == key_range_t::bound_t::open) {
-                        int cmp = memcmp(
-                            skey_current.data(),
-                            sindex->rbound_trunc_key.data(),
-                            std::min<size_t>(skey_current.size(),
-                                             sindex->rbound_trunc_key.size()));
-                        if (skey_current.size() > sindex->rbound_trunc_key.size()) {
-                            guarantee(cmp != 0);
-                        }
-                        guarantee(cmp <= 0);
-                        if (cmp == 0
-                            && skey_current.size() == sindex->rbound_trunc_key.size()) {
-                            must_check_copies = true;
-                        }
-                    }
-                }
-                if (must_check_copies) {
-                    copies = sindex->datumspec.copies(lazy_sindex_val());
-                } else {
-                    copies = 1;
-                }
-            },
-            [&](const std::map<ql::datum_t, uint64_t> &) {
-                guarantee(skey_left);
-                std::string skey_current =
-                    ql::datum_t::extract_secondary(key_to_unescaped_str(key));
-                const bool skey_current_is_truncated =
-                    skey_current.size() >= max_trunc_size;
-                const bool skey_left_is_truncated = skey_left->size() >= max_trunc_size;
-
-                if (skey_current_is_truncated || skey_left_is_truncated) {
-                    copies = sindex->datumspec.copies(lazy_sindex_val());
-                } else if (*skey_left != skey_current) {
-                    copies = 0;
-                }
-            });
+        if (must_check_copies) {
+            copies = sindex->datumspec.copies(lazy_sindex_val());
             if (copies == 0) {
                 return continue_bool_t::CONTINUE;
             }
@@ -976,31 +1038,234 @@ continue_bool_t rget_cb_t::handle_pair(
         for (auto it = job.transformers.begin(); it != job.transformers.end(); ++it) {
             (**it)(job.env, &data, lazy_sindex_val);
         }
-        // We need lots of extra data for the accumulation because we might be
-        // accumulating `rget_item_t`s for a batch.
-        continue_bool_t cont = (*job.accumulator)(job.env, &data, key, lazy_sindex_val);
-        if (remember_key_for_sindex_batching) {
-            if (cont == continue_bool_t::ABORT) {
-                last_truncated_secondary_for_abort =
-                    ql::datum_t::extract_truncated_secondary(key_to_unescaped_str(key));
+        return accumulate_row(key, &data, lazy_sindex_val);
+    } catch (const ql::exc_t &e) {
+        io.response->result = e;
+        return continue_bool_t::ABORT;
+    } catch (const ql::datum_exc_t &e) {
+#ifndef NDEBUG
+        unreachable();
+#else
+        io.response->result = ql::exc_t(e, ql::backtrace_id_t::empty());
+        return continue_bool_t::ABORT;
+#endif // NDEBUG
+    }
+}
+
+continue_bool_t rget_cb_t::flush_pending_rows() THROWS_ONLY(interrupted_exc_t) {
+    std::vector<scoped_ptr_t<pending_row_t> > rows;
+    rows.swap(pending_rows);
+
+    // The rows are transformed one transformer at a time, and only accumulated
+    // afterwards. `num_ok` is the index of the first row for which something
+    // failed; we stop there, just like we would have done when handling the rows
+    // one by one.
+    size_t num_ok = rows.size();
+    std::exception_ptr error;
+    std::vector<ql::op_batch_item_t> items;
+    // The index of the row of each element of `items`
+    std::vector<size_t> item_rows;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        pending_row_t *row = rows[i].get();
+        auto lazy_sindex_val = [this, row]() -> ql::datum_t {
+            return get_sindex_val(row->key, row->val, &row->sindex_val_cache);
+        };
+        try {
+            if (row->must_check_copies) {
+                row->copies = sindex->datumspec.copies(lazy_sindex_val());
+            }
+        } catch (const ql::exc_t &) {
+            error = std::current_exception();
+        } catch (const ql::datum_exc_t &) {
+            error = std::current_exception();
+        }
+        if (error) {
+            num_ok = i;
+            break;
+        }
+        if (row->copies != 0) {
+            row->data = {{ql::datum_t(), ql::datums_t(row->copies, row->val)}};
+            items.push_back(ql::op_batch_item_t{&row->data, lazy_sindex_val});
+            item_rows.push_back(i);
+        }
+    }
+    for (auto it = job.transformers.begin(); it != job.transformers.end(); ++it) {
+        std::exception_ptr transformer_error;
+        size_t num_items = (*it)->apply_batch(job.env, items, &transformer_error);
+        if (num_items < items.size()) {
+            num_ok = item_rows[num_items];
+            error = transformer_error;
+            items.resize(num_items);
+        }
+    }
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        pending_row_t *row = rows[i].get();
+        if (stop_at_truncated_boundary(row->key)) {
+            return continue_bool_t::ABORT;
+        }
+        update_active_region_range(row->key);
+        if (i == num_ok) {
+            report_error(error);
+            return continue_bool_t::ABORT;
+        }
+        if (row->copies == 0) {
+            continue;
+        }
+        continue_bool_t cont;
+        try {
+            cont = accumulate_row(
+                row->key,
+                &row->data,
+                [this, row]() -> ql::datum_t {
+                    return get_sindex_val(row->key, row->val, &row->sindex_val_cache);
+                });
+        } catch (const ql::exc_t &) {
+            report_error(std::current_exception());
+            return continue_bool_t::ABORT;
+        } catch (const ql::datum_exc_t &) {
+            report_error(std::current_exception());
+            return continue_bool_t::ABORT;
+        }
+        if (cont == continue_bool_t::ABORT) {
+            return continue_bool_t::ABORT;
+        }
+    }
+    return continue_bool_t::CONTINUE;
+}
+
+bool rget_cb_t::stop_at_truncated_boundary(const store_key_t &key) {
+    if (last_truncated_secondary_for_abort) {
+        std::string cur_truncated_secondary =
+            ql::datum_t::extract_truncated_secondary(key_to_unescaped_str(key));
+        if (cur_truncated_secondary != *last_truncated_secondary_for_abort) {
+            // The semantics here are that we're returning the "last considered
+            // key", which we set specially here to preserve the invariant that
+            // unsharding either consumes all rows with a particular truncated
+            // sindex value or none of them.
+            store_key_t stop_key;
+            if (!reversed(job.sorting)) {
+                stop_key = store_key_t(cur_truncated_secondary);
+            } else {
+                stop_key = store_key_t(*last_truncated_secondary_for_abort);
+            }
+            stop_key.decrement();
+            job.accumulator->stop_at_boundary(std::move(stop_key));
+            return true;
+        }
+    }
+    return false;
+}
+
+void rget_cb_t::update_active_region_range(const store_key_t &key) {
+    if (sindex) {
+        if (!reversed(job.sorting)) {
+            if (sindex->active_region_range_inout->left < key) {
+                sindex->active_region_range_inout->left = key;
+                sindex->active_region_range_inout->left.increment();
             }
-            return continue_bool_t::CONTINUE;
         } else {
-            return cont;
+            if (key < sindex->active_region_range_inout->right.key_or_max()) {
+                sindex->active_region_range_inout->right =
+                    key_range_t::right_bound_t(key);
+            }
         }
+    }
+}
+
+ql::datum_t rget_cb_t::get_sindex_val(const store_key_t &key,
+                                      const ql::datum_t &val,
+                                      ql::datum_t *cache) {
+    if (sindex && !cache->has()) {
+        guarantee(val.has());
+        *cache = sindex->func->call(sindex_env.get(), val)->as_datum();
+        if (sindex->multi == sindex_multi_bool_t::MULTI
+            && cache->get_type() == ql::datum_t::R_ARRAY) {
+            boost::optional<uint64_t> tag = *ql::datum_t::extract_tag(key);
+            guarantee(tag);
+            *cache = cache->get(*tag, ql::NOTHROW);
+            guarantee(cache->has());
+        }
+    }
+    return *cache;
+}
+
+continue_bool_t rget_cb_t::accumulate_row(
+        const store_key_t &key,
+        ql::groups_t *data,
+        const std::function<ql::datum_t()> &lazy_sindex_val) {
+    // If the sindex portion of the key is long enough that it might be >= the
+    // length of a truncated sindex, we need to rember the key so we can make
+    // sure not to stop in the middle of a sindex range where some of the values
+    // are out of order because of truncation.
+    bool remember_key_for_sindex_batching = sindex
+        ? (ql::datum_t::extract_secondary(key_to_unescaped_str(key)).size()
+           >= ql::datum_t::max_trunc_size())
+        : false;
+    // We need lots of extra data for the accumulation because we might be
+    // accumulating `rget_item_t`s for a batch.
+    continue_bool_t cont = (*job.accumulator)(job.env, data, key, lazy_sindex_val);
+    if (remember_key_for_sindex_batching) {
+        if (cont == continue_bool_t::ABORT) {
+            last_truncated_secondary_for_abort =
+                ql::datum_t::extract_truncated_secondary(key_to_unescaped_str(key));
+        }
+        return continue_bool_t::CONTINUE;
+    } else {
+        return cont;
+    }
+}
+
+void rget_cb_t::report_error(const std::exception_ptr &error) {
+    try {
+        std::rethrow_exception(error);
     } catch (const ql::exc_t &e) {
         io.response->result = e;
-        return continue_bool_t::ABORT;
     } catch (const ql::datum_exc_t &e) {
 #ifndef NDEBUG
         unreachable();
 #else
         io.response->result = ql::exc_t(e, ql::backtrace_id_t::empty());
-        return continue_bool_t::ABORT;
 #endif // NDEBUG
     }
 }
 
+// Counts the live keys in a range one leaf at a time, without handing the
+// individual key/value pairs to a callback. Used for plain `count()` queries on the
+// primary index, which don't need to look at any rows.
+class count_leaf_entries_cb_t : public depth_first_traversal_callback_t {
+public:
+    count_leaf_entries_cb_t(const key_range_t &_range, btree_slice_t *_slice)
+        : range(_range), slice(_slice), count(0) { }
+
+    continue_bool_t handle_pre_leaf(
+            const counted_t<counted_buf_lock_and_read_t> &buf,
+            UNUSED const btree_key_t *left_excl_or_null,
+            UNUSED const btree_key_t *right_incl,
+            UNUSED signal_t *interruptor,
+            bool *skip_out) {
+        const leaf_node_t *lnode =
+            static_cast<const leaf_node_t *>(buf->read->get_data_read());
+        int n = leaf::count_live_entries(*lnode, range);
+        slice->stats.pm_keys_read.record(n);
+        slice->stats.pm_total_keys_read += n;
+        count += n;
+        *skip_out = true;
+        return continue_bool_t::CONTINUE;
+    }
+
+    continue_bool_t handle_pair(scoped_key_value_t &&, signal_t *) {
+        unreachable();
+    }
+
+    uint64_t get_count() const { return count; }
+
+private:
+    const key_range_t range;
+    btree_slice_t *const slice;
+    uint64_t count;
+};
+
 // TODO: Having two functions which are 99% the same sucks.
 void rdb_rget_slice(
         btree_slice_t *slice,
@@ -1021,6 +1286,20 @@ void rdb_rget_slice(
         "Do range scan on primary index.",
         ql_env->trace);
 
+    // A plain `count()` doesn't depend on the rows, so we can count the keys of
+    // each leaf without going through `rget_cb_t`. The `count` terminal never asks
+    // for a batch to be sent, so we always count the whole range at once.
+    if (!primary_keys && transforms.empty() && terminal
+        && boost::get<ql::count_wire_func_t>(&*terminal) != nullptr) {
+        count_leaf_entries_cb_t callback(range, slice);
+        btree_depth_first_traversal(
+            superblock, range, &callback, access_t::read,
+            reversed(sorting) ? BACKWARD : FORWARD,
+            release_superblock, ql_env->interruptor);
+        ql::count_terminal_result(callback.get_count(), &response->result);
+        return;
+    }
+
     rget_cb_t callback(
         rget_io_data_t(response, slice),
         job_data_t(ql_env,
@@ -1032,7 +1311,8 @@ void rdb_rget_slice(
                        ? range.left
                        : range.right.key_or_max(),
                    sorting,
-                   require_sindexes_t::NO),
+                   require_sindexes_t::NO,
+                   ql::infer_row_projection(transforms, terminal)),
         boost::none);
 
     direction_t direction = reversed(sorting) ? BACKWARD : FORWARD;
@@ -1112,7 +1392,9 @@ void rdb_rget_secondary_slice(
                        ? sindex_region_range.left
                        : sindex_region_range.right.key_or_max(),
                    sorting,
-                   require_sindex_val),
+                   require_sindex_val,
+                   // The secondary index function may need the whole row.
+                   boost::none),
         rget_sindex_data_t(
             pk_range,
             datumspec,
@@ -1132,12 +1414,12 @@ void rdb_rget_secondary_slice(
         key_range_t active_range = active_region_range.intersection(sindex_keyrange);
         // This can happen sometimes with truncated keys.
         if (active_range.is_empty()) return continue_bool_t::CONTINUE;
-        return btree_concurrent_traversal(
+        return callback.finish_traversal(btree_concurrent_traversal(
             superblock,
             active_range,
             &wrapper,
             direction,
-            is_last ? release_superblock : release_superblock_t::KEEP);
+            is_last ? release_superblock : release_superblock_t::KEEP));
     };
     continue_bool_t cont = datumspec.iter(sorting, cb);
     callback.finish(cont);
@@ -1654,7 +1936,8 @@ void deserialize_sindex_info(
     case cluster_version_t::v2_1:
     case cluster_version_t::v2_2:
     case cluster_version_t::v2_3:
-    case cluster_version_t::v2_4_is_latest:
+    case cluster_version_t::v2_4:
+    case cluster_version_t::v2_5_is_latest:
         success = deserialize_reql_version(
                 &read_stream,
                 &info_out->mapping_version_info.original_reql_version,
@@ -1691,7 +1974,8 @@ void deserialize_sindex_info(
     case cluster_version_t::v2_1: // fallthru
     case cluster_version_t::v2_2: // fallthru
     case cluster_version_t::v2_3: // fallthru
-    case cluster_version_t::v2_4_is_latest:
+    case cluster_version_t::v2_4: // fallthru
+    case cluster_version_t::v2_5_is_latest:
         success = deserialize_for_version(cluster_version, &read_stream, &info_out->geo);
         throw_if_bad_deserialization(success, "sindex description");
         break;
@@ -1998,34 +2282,33 @@ void rdb_update_sindexes(
     }
 }
 
+/* Post-constructs secondary indexes in sorted runs. The traversal callbacks compute
+the index keys of the rows concurrently and collect them in memory. Once a run has
+grown to `MAX_RUN_SIZE` bytes, it gets sorted by index key and inserted into the index
+trees in key order, `MAX_CHUNK_SIZE` entries per write transaction. Consecutive
+insertions then go to the same few leaf nodes instead of to a random leaf of the index
+each, which turns the construction into something close to a bottom-up bulk load of the
+index btree.
+A full run is inserted by a background coroutine, so the traversal can go on filling
+the next run in the meantime. The traversal only waits if the next run fills up before
+the previous one has been inserted. `finish()` inserts whatever is left at the end. */
 class post_construct_traversal_helper_t : public concurrent_traversal_callback_t {
 public:
     post_construct_traversal_helper_t(
             store_t *store,
-            const std::set<uuid_u> &sindexes_to_post_construct,
+            std::map<uuid_u, sindex_disk_info_t> &&sindex_infos,
             cond_t *on_indexes_deleted,
             const std::function<bool(int64_t)> &check_should_abort,
             signal_t *interruptor)
         : store_(store),
-          sindexes_to_post_construct_(sindexes_to_post_construct),
+          sindex_infos_(std::move(sindex_infos)),
           on_indexes_deleted_(on_indexes_deleted),
           interruptor_(interruptor),
           check_should_abort_(check_should_abort),
           pairs_constructed_(0),
           stopped_before_completion_(false),
-          current_chunk_size_(0) {
-        // Start an initial write transaction for the first chunk.
-        // (this acquisition should never block)
-        new_mutex_acq_t wtxn_acq(&wtxn_lock_);
-        start_write_transaction(&wtxn_acq);
-    }
-
-    ~post_construct_traversal_helper_t() {
-        sindexes_.clear();
-        if (wtxn_.has()) {
-            wtxn_->commit();
-        }
-    }
+          run_size_(0),
+          flush_interrupted_(false) { }
 
     continue_bool_t handle_pair(
             scoped_key_value_t &&keyvalue,
@@ -2040,63 +2323,48 @@ public:
         store_->btree->stats.pm_keys_read.record();
         store_->btree->stats.pm_total_keys_read += 1;
 
-        // Grab the key and value and construct a modification report for the key/value
-        // pair.
+        // Grab the key and value and compute the index entries for them. This happens
+        // concurrently for all the pairs that the traversal hands us at a time.
         const store_key_t primary_key(keyvalue.key());
         const rdb_value_t *rdb_value =
             static_cast<const rdb_value_t *>(keyvalue.value());
-        rdb_modification_report_t mod_report(primary_key);
         const max_block_size_t block_size =
             keyvalue.expose_buf().cache()->max_block_size();
-        mod_report.info.added
-            = std::make_pair(
-                get_data(rdb_value, buf_parent_t(keyvalue.expose_buf())),
-                std::vector<char>(rdb_value->value_ref(),
-                    rdb_value->value_ref() + rdb_value->inline_size(block_size)));
-
-        // Store the value into the secondary indexes
-        {
-            // We need this mutex because we don't want `wtxn` to be destructed,
-            // but also because only one coroutine can be traversing the indexes
-            // through `rdb_update_sindexes` at a time (or else the btree will get
-            // corrupted!).
-            new_mutex_acq_t wtxn_acq(&wtxn_lock_, interruptor_);
-            guarantee(wtxn_.has());
-            const rdb_post_construction_deletion_context_t deletion_context;
-            rdb_update_sindexes(store_,
-                                sindexes_,
-                                &mod_report,
-                                wtxn_.get(),
-                                &deletion_context,
-                                NULL,
-                                NULL,
-                                NULL);
+        ql::datum_t doc = get_data(rdb_value, buf_parent_t(keyvalue.expose_buf()));
+        const std::vector<char> value_ref(
+            rdb_value->value_ref(),
+            rdb_value->value_ref() + rdb_value->inline_size(block_size));
+        keyvalue.reset();
+
+        std::vector<std::pair<uuid_u, store_key_t> > entries;
+        for (const auto &info : sindex_infos_) {
+            if (deleted_sindexes_.count(info.first) != 0) {
+                continue;
+            }
+            std::vector<std::pair<store_key_t, ql::datum_t> > keys;
+            try {
+                compute_keys(primary_key, doc, info.second, &keys, nullptr);
+            } catch (const ql::base_exc_t &) {
+                // Just like `rdb_update_single_sindex`, we drop the row from the index.
+                continue;
+            }
+            for (auto &&key : keys) {
+                entries.push_back(std::make_pair(info.first, std::move(key.first)));
+            }
         }
 
-        // Account for the sindex writes in the stats
-        store_->btree->stats.pm_keys_set.record(sindexes_.size());
-        store_->btree->stats.pm_total_keys_set += sindexes_.size();
-
         // Update the traversed range boundary (everything below here will happen in
-        // key order).
-        // This can't be interrupted, because we have already called rdb_update_sindexes,
-        // so now we /must/ update traversed_right_bound.
+        // key order). The entries must become part of the run at the same time, so
+        // that everything up to the boundary is inserted by the time we're done.
         waiter.wait();
         traversed_right_bound_ = primary_key;
+        for (auto &&entry : entries) {
+            run_size_ += entry.second.size() + value_ref.size();
+            run_[entry.first].push_back(run_entry_t{std::move(entry.second), value_ref});
+        }
 
-        // Release the write transaction and secondary index locks once we've reached the
-        // designated chunk size. Then acquire a new transaction once the previous one
-        // has been flushed.
-        {
-            new_mutex_acq_t wtxn_acq(&wtxn_lock_, interruptor_);
-            ++current_chunk_size_;
-            if (current_chunk_size_ >= MAX_CHUNK_SIZE) {
-                current_chunk_size_ = 0;
-                sindexes_.clear();
-                wtxn_->commit();
-                wtxn_.reset();
-                start_write_transaction(&wtxn_acq);
-            }
+        if (run_size_ >= MAX_RUN_SIZE) {
+            start_flush();
         }
 
         ++pairs_constructed_;
@@ -2108,6 +2376,19 @@ public:
         }
     }
 
+    // Inserts what's left of the current run. Must be called once the traversal has
+    // completed, before the traversed range can be treated as constructed.
+    void finish() THROWS_ONLY(interrupted_exc_t) {
+        wait_for_flush();
+        run_t run;
+        run.swap(run_);
+        run_size_ = 0;
+        insert_run(&run, interruptor_);
+        if (on_indexes_deleted_->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+    }
+
     store_key_t get_traversed_right_bound() const {
         return traversed_right_bound_;
     }
@@ -2117,16 +2398,89 @@ public:
     }
 
 private:
-    // Number of key/value pairs we process before releasing the write transaction
+    // The amount of key and value data we collect before sorting the entries and
+    // inserting them into the indexes. While one run is being inserted in the
+    // background, the traversal keeps filling the next one, so we use up to twice this
+    // much memory.
+    static const size_t MAX_RUN_SIZE = 4 * MEGABYTE;
+
+    // Number of index entries we insert before releasing the write transaction
     // and waiting for the secondary index data to be flushed to disk.
-    // Also see the comment above `scoped_ptr_t<txn_t> wtxn;` below.
-    static const int MAX_CHUNK_SIZE = 32;
+    // We reset the transaction after each chunk because large write transactions can
+    // cause the cache to go into throttling, and that would interfere with other
+    // transactions on this table.
+    // Another aspect to keep in mind is that if we hold the write lock on the sindexes
+    // for too long, other concurrent writes to parts of the secondary index that
+    // are already live will also be delayed.
+    static const size_t MAX_CHUNK_SIZE = 256;
 
-    void start_write_transaction(new_mutex_acq_t *wtxn_acq) {
-        wtxn_acq->guarantee_is_holding(&wtxn_lock_);
-        guarantee(!wtxn_.has());
+    struct run_entry_t {
+        store_key_t key;
+        std::vector<char> value_ref;
+    };
+    typedef std::map<uuid_u, std::vector<run_entry_t> > run_t;
+
+    // Hands the current run over to a background coroutine for insertion. Waits for
+    // the previous run to be inserted first, which bounds the memory use to two runs.
+    void start_flush() THROWS_ONLY(interrupted_exc_t) {
+        wait_for_flush();
+        rassert(flushing_run_.empty());
+        flushing_run_.swap(run_);
+        run_size_ = 0;
+        flush_done_.init(new cond_t());
+        coro_t::spawn_sometime(
+            std::bind(&post_construct_traversal_helper_t::flush_in_background,
+                      this, auto_drainer_t::lock_t(&drainer_)));
+    }
+
+    void wait_for_flush() THROWS_ONLY(interrupted_exc_t) {
+        if (flush_done_.has()) {
+            wait_interruptible(flush_done_.get(), interruptor_);
+            flush_done_.reset();
+        }
+        if (flush_interrupted_) {
+            throw interrupted_exc_t();
+        }
+    }
 
-        // Start a write transaction and acquire the secondary indexes
+    void flush_in_background(auto_drainer_t::lock_t keepalive) {
+        wait_any_t interruptor(interruptor_, keepalive.get_drain_signal());
+        try {
+            insert_run(&flushing_run_, &interruptor);
+        } catch (const interrupted_exc_t &) {
+            flush_interrupted_ = true;
+        }
+        flushing_run_.clear();
+        flush_done_->pulse();
+    }
+
+    void insert_run(run_t *run, signal_t *interruptor)
+            THROWS_ONLY(interrupted_exc_t) {
+        for (auto &&pair : *run) {
+            std::vector<run_entry_t> *entries = &pair.second;
+            std::sort(entries->begin(), entries->end(),
+                      [](const run_entry_t &a, const run_entry_t &b) {
+                          return a.key < b.key;
+                      });
+            for (size_t begin = 0; begin < entries->size(); begin += MAX_CHUNK_SIZE) {
+                if (deleted_sindexes_.count(pair.first) != 0) {
+                    break;
+                }
+                const size_t end = entries->size() - begin > MAX_CHUNK_SIZE
+                    ? begin + MAX_CHUNK_SIZE
+                    : entries->size();
+                insert_chunk(pair.first, entries->begin() + begin,
+                             entries->begin() + end, interruptor);
+            }
+        }
+    }
+
+    void insert_chunk(const uuid_u &sindex_id,
+                      std::vector<run_entry_t>::const_iterator begin,
+                      std::vector<run_entry_t>::const_iterator end,
+                      signal_t *interruptor)
+            THROWS_ONLY(interrupted_exc_t) {
+        // Start a write transaction and acquire the secondary index
         write_token_t token;
         store_->new_write_token(&token);
 
@@ -2136,49 +2490,84 @@ private:
         // dirty page limit and bring down the whole table.
         // Other than that, the hard durability guarantee is not actually
         // needed here.
+        scoped_ptr_t<txn_t> txn;
         scoped_ptr_t<real_superblock_t> superblock;
         store_->acquire_superblock_for_write(
-                2 + MAX_CHUNK_SIZE,
+                2 + (end - begin),
                 write_durability_t::HARD,
                 &token,
-                &wtxn_,
+                &txn,
                 &superblock,
-                interruptor_);
+                interruptor);
 
         // Acquire the sindex block and release the superblock.
-        const block_id_t sindex_block_id = superblock->get_sindex_block_id();
-        buf_lock_t sindex_block(superblock->expose_buf(), sindex_block_id,
-                                access_t::write);
-        superblock.reset();
-        store_t::sindex_access_vector_t all_sindexes;
-        store_->acquire_sindex_superblocks_for_write(
-            sindexes_to_post_construct_,
-            &sindex_block,
-            &all_sindexes);
-
-        // Filter out indexes that are being deleted. No need to keep post-constructing
-        // those.
-        guarantee(sindexes_.empty());
-        for (auto &&access : all_sindexes) {
-            if (!access->sindex.being_deleted) {
-                sindexes_.emplace_back(std::move(access));
-            }
+        store_t::sindex_access_vector_t sindexes;
+        {
+            const block_id_t sindex_block_id = superblock->get_sindex_block_id();
+            buf_lock_t sindex_block(superblock->expose_buf(), sindex_block_id,
+                                    access_t::write);
+            superblock.reset();
+            std::set<uuid_u> sindex_ids;
+            sindex_ids.insert(sindex_id);
+            store_->acquire_sindex_superblocks_for_write(
+                sindex_ids,
+                &sindex_block,
+                &sindexes);
         }
-        if (sindexes_.empty()) {
-            // All indexes have been deleted. Interrupt the traversal.
-            on_indexes_deleted_->pulse_if_not_already_pulsed();
+
+        // No need to keep post-constructing indexes that are being deleted.
+        if (sindexes.empty() || sindexes[0]->sindex.being_deleted) {
+            sindexes.clear();
+            txn->commit();
+            deleted_sindexes_.insert(sindex_id);
+            if (deleted_sindexes_.size() == sindex_infos_.size()) {
+                // All indexes have been deleted. Interrupt the traversal.
+                on_indexes_deleted_->pulse_if_not_already_pulsed();
+            }
+            return;
         }
 
-        // We pretend that the indexes have been fully constructed, so that when we call
-        // `rdb_update_sindexes` above, it actually updates the range we're currently
-        // constructing. This is a bit hacky, but works.
-        for (auto &&access : sindexes_) {
-            access->sindex.needs_post_construction_range = key_range_t::empty();
+        superblock_t *sindex_superblock = sindexes[0]->superblock.get();
+        rdb_value_sizer_t sizer(sindex_superblock->cache()->max_block_size());
+        const rdb_post_construction_deletion_context_t deletion_context;
+        for (auto it = begin; it != end; ++it) {
+            promise_t<superblock_t *> return_superblock_local;
+            {
+                keyvalue_location_t kv_location;
+                find_keyvalue_location_for_write(
+                    &sizer,
+                    sindex_superblock,
+                    it->key.btree_key(),
+                    repli_timestamp_t::distant_past,
+                    deletion_context.balancing_detacher(),
+                    &kv_location,
+                    nullptr,
+                    &return_superblock_local);
+
+                ql::serialization_result_t res =
+                    kv_location_set(&kv_location, it->key, it->value_ref,
+                                    repli_timestamp_t::distant_past,
+                                    &deletion_context);
+                // this particular context cannot fail AT THE MOMENT.
+                guarantee(!bad(res));
+                // The keyvalue location gets destroyed here.
+            }
+            sindex_superblock = return_superblock_local.wait();
         }
+
+        // Account for the sindex writes in the stats
+        store_->btree->stats.pm_keys_set.record(end - begin);
+        store_->btree->stats.pm_total_keys_set += end - begin;
+
+        sindexes.clear();
+        txn->commit();
     }
 
     store_t *store_;
-    const std::set<uuid_u> sindexes_to_post_construct_;
+    // The definitions of the indexes we're constructing, and the ones among them that
+    // have been deleted since.
+    std::map<uuid_u, sindex_disk_info_t> sindex_infos_;
+    std::set<uuid_u> deleted_sindexes_;
     cond_t *on_indexes_deleted_;
     signal_t *interruptor_;
 
@@ -2189,19 +2578,18 @@ private:
     store_key_t traversed_right_bound_;
     bool stopped_before_completion_;
 
-    // We re-use a single write transaction and secondary index acquisition for a chunk
-    // of writes to get better efficiency when flushing the index writes to disk.
-    // We reset the transaction  after each chunk because large write transactions can
-    // cause the cache to go into throttling, and that would interfere with other
-    // transactions on this table.
-    // Another aspect to keep in mind is that if we hold the write lock on the sindexes
-    // for too long, other concurrent writes to parts of the secondary index that
-    // are already live will also be delayed.
-    scoped_ptr_t<txn_t> wtxn_;
-    store_t::sindex_access_vector_t sindexes_;
-    int current_chunk_size_;
-    // Controls access to `sindexes_` and `wtxn_`.
-    new_mutex_t wtxn_lock_;
+    // The index entries that haven't been inserted yet, and their total size.
+    run_t run_;
+    size_t run_size_;
+
+    // The run that is being inserted in the background, if any. `flush_done_` gets
+    // pulsed once the insertion has finished or has been interrupted.
+    run_t flushing_run_;
+    scoped_ptr_t<cond_t> flush_done_;
+    bool flush_interrupted_;
+
+    // Destroyed first, so that a background insertion is done before the rest goes.
+    auto_drainer_t drainer_;
 };
 
 void post_construct_secondary_index_range(
@@ -2234,13 +2622,35 @@ void post_construct_secondary_index_range(
         interruptor,
         true /* USE_SNAPSHOT */);
 
-    // Note: This starts a write transaction, which might get throttled.
-    // It is important that we construct the `traversal_cb` *after* we've started
-    // the snapshotted read transaction, or otherwise we might deadlock in the presence
-    // of additional (unrelated) write transactions..
+    // Look up the definitions of the indexes, so that we can compute their keys
+    // without holding on to a write transaction.
+    std::map<uuid_u, sindex_disk_info_t> sindex_infos;
+    {
+        buf_lock_t sindex_block(superblock->expose_buf(),
+                                superblock->get_sindex_block_id(),
+                                access_t::read);
+        for (const uuid_u &sindex_id : sindex_ids_to_post_construct) {
+            secondary_index_t sindex;
+            if (!get_secondary_index(&sindex_block, sindex_id, &sindex)
+                || sindex.being_deleted) {
+                continue;
+            }
+            try {
+                deserialize_sindex_info_or_crash(sindex.opaque_definition,
+                                                 &sindex_infos[sindex_id]);
+            } catch (const archive_exc_t &e) {
+                crash("%s", e.what());
+            }
+        }
+    }
+    if (sindex_infos.empty()) {
+        // All indexes have been deleted.
+        throw interrupted_exc_t();
+    }
+
     post_construct_traversal_helper_t traversal_cb(
         store,
-        sindex_ids_to_post_construct,
+        std::move(sindex_infos),
         &on_index_deleted_interruptor,
         check_should_abort,
         interruptor);
@@ -2259,6 +2669,7 @@ void post_construct_secondary_index_range(
         && (interruptor->is_pulsed() || on_index_deleted_interruptor.is_pulsed())) {
         throw interrupted_exc_t();
     }
+    traversal_cb.finish();
 
     // Update the left bound of the construction range
     if (!traversal_cb.stopped_before_completion()) {
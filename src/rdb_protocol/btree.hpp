@@ -43,6 +43,8 @@ public:
 
     block_magic_t btree_leaf_magic() const;
 
+    bool btree_leaf_key_prefixes() const;
+
     max_block_size_t block_size() const;
 
 private:
@@ -91,6 +91,7 @@ store_t::store_t(const region_t &_region,
       perfmon_collection(),
       io_backender_(io_backender), base_path_(base_path),
       perfmon_collection_membership(parent_perfmon_collection, &perfmon_collection, perfmon_name),
+      changefeed_stats(&perfmon_collection),
       ctx(_ctx),
       table_id(_table_id),
       write_superblock_acq_semaphore(WRITE_SUPERBLOCK_ACQ_WAITERS_LIMIT)
@@ -10,6 +10,7 @@
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/interruptor.hpp"
 #include "containers/archive/boost_types.hpp"
+#include "containers/archive/vector_stream.hpp"
 #include "rdb_protocol/artificial_table/backend.hpp"
 #include "rdb_protocol/btree.hpp"
 #include "rdb_protocol/env.hpp"
@@ -314,18 +315,49 @@ boost::optional<datum_t> apply_ops(
     }
 }
 
+server_stats_t::server_stats_t(perfmon_collection_t *parent)
+    : pm_messages_sent(secs_to_ticks(1)),
+      pm_changes_sent(secs_to_ticks(1)),
+      pm_membership(&collection,
+          &pm_messages_sent, "messages_sent",
+          &pm_total_messages_sent, "total_messages_sent",
+          &pm_changes_sent, "changes_sent",
+          &pm_total_changes_sent, "total_changes_sent"),
+      collection_membership(parent, &collection, "changefeeds") { }
+
+void server_stats_t::note_batch(size_t num_msgs) {
+    pm_messages_sent.record();
+    ++pm_total_messages_sent;
+    pm_changes_sent.record(num_msgs);
+    pm_total_changes_sent += num_msgs;
+}
+
 server_t::client_info_t::client_info_t()
-    : limit_clients(&opt_lt<std::string>),
+    : flush_scheduled(false),
+      limit_clients(&opt_lt<std::string>),
       limit_clients_lock(new rwlock_t()) { }
 
-server_t::server_t(mailbox_manager_t *_manager, store_t *_parent)
+const int64_t server_t::DEFAULT_BATCH_WINDOW_MS = 2;
+const int64_t server_t::MAX_BATCH_WINDOW_MS = 1000;
+const size_t server_t::DEFAULT_BATCH_MAX_MSGS = 256;
+const size_t server_t::MAX_BATCH_MAX_MSGS = 65536;
+
+server_t::server_t(mailbox_manager_t *_manager,
+                   store_t *_parent,
+                   int64_t _batch_window_ms,
+                   size_t _batch_max_msgs)
     : uuid(generate_uuid()),
       manager(_manager),
+      batch_window_ms(_batch_window_ms),
+      batch_max_msgs(_batch_max_msgs),
       parent(_parent),
       stop_mailbox(manager,
                    std::bind(&server_t::stop_mailbox_cb, this, ph::_1, ph::_2)),
       limit_stop_mailbox(manager, std::bind(&server_t::limit_stop_mailbox_cb,
-                                            this, ph::_1, ph::_2, ph::_3, ph::_4)) { }
+                                            this, ph::_1, ph::_2, ph::_3, ph::_4)) {
+    guarantee(batch_window_ms >= 0 && batch_window_ms <= MAX_BATCH_WINDOW_MS);
+    guarantee(batch_max_msgs >= 1 && batch_max_msgs <= MAX_BATCH_MAX_MSGS);
+}
 
 server_t::~server_t() { }
 
@@ -490,18 +522,7 @@ void server_t::add_client_cb(
     guarantee(erased == 1);
 }
 
-struct stamped_msg_t {
-    stamped_msg_t() { }
-    stamped_msg_t(uuid_u _server_uuid, uint64_t _stamp, msg_t _submsg)
-        : server_uuid(std::move(_server_uuid)),
-          stamp(_stamp),
-          submsg(std::move(_submsg)) { }
-    uuid_u server_uuid;
-    uint64_t stamp;
-    msg_t submsg;
-};
-
-RDB_MAKE_SERIALIZABLE_3(stamped_msg_t, server_uuid, stamp, submsg);
+RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(stamped_msg_t, server_uuid, stamp, submsg);
 
 // This function takes a `lock_t` to make sure you have one.  (We can't just
 // always acquire a drainer lock before sending because we sometimes send a
@@ -512,14 +533,47 @@ void server_t::send_one_with_lock(
         msg_t msg,
         const auto_drainer_t::lock_t &keepalive) {
     keepalive.assert_is_holding(&drainer);
-    uint64_t stamp;
+    std::vector<stamped_msg_t> batch;
     {
         // We don't need a write lock as long as we make sure the coroutine
         // doesn't block between reading and updating the stamp.
         ASSERT_NO_CORO_WAITING;
-        stamp = client->second.stamp++;
+        // Messages sent this way are rare and often urgent (e.g. `stop_t`), so we
+        // send them right away along with anything that's still buffered.
+        batch.swap(client->second.pending);
+        batch.push_back(
+            stamped_msg_t(uuid, client->second.stamp++, std::move(msg)));
+    }
+    send_batch(client->first, std::move(batch));
+}
+
+void server_t::send_batch(const client_t::addr_t &addr,
+                          std::vector<stamped_msg_t> &&batch) {
+    parent->changefeed_stats.note_batch(batch.size());
+    send(manager, addr, std::move(batch));
+}
+
+void server_t::flush_cb(client_t::addr_t addr, auto_drainer_t::lock_t keepalive) {
+    keepalive.assert_is_holding(&drainer);
+    try {
+        nap(batch_window_ms, keepalive.get_drain_signal());
+    } catch (const interrupted_exc_t &) {
+        // We still send what we have, since the client needs every stamp.
+    }
+    std::vector<stamped_msg_t> batch;
+    {
+        rwlock_acq_t acq(&clients_lock, access_t::read);
+        auto it = clients.find(addr);
+        if (it == clients.end()) {
+            return;
+        }
+        ASSERT_NO_CORO_WAITING;
+        it->second.flush_scheduled = false;
+        batch.swap(it->second.pending);
+    }
+    if (!batch.empty()) {
+        send_batch(addr, std::move(batch));
     }
-    send(manager, client->first, stamped_msg_t(uuid, stamp, std::move(msg)));
 }
 
 void server_t::send_all(
@@ -532,7 +586,16 @@ void server_t::send_all(
     stamp_spot->write_signal()->wait_lazily_unordered();
 
     rwlock_acq_t acq(&clients_lock, access_t::read);
-    std::map<client_t::addr_t, uint64_t> stamps;
+    // Rather than sending every change on its own, we add it to the client's
+    // `pending` buffer, which is sent once it's full or `flush_cb` gets to it.
+    // `real_feed_t` orders messages by stamp, so it doesn't matter that batches
+    // may be sent out of order.
+    // Each client is the `real_feed_t` of one server, which multiplexes all of
+    // that server's subscriptions to this table.  We send it every change in the
+    // client's regions, untransformed; `msg_visitor_t` on the receiving side
+    // applies the subscriptions' `filter`/`pluck`/`map`s, evaluating each
+    // distinct set of them once per change.
+    std::map<client_t::addr_t, std::vector<stamped_msg_t> > full_batches;
     for (auto &&pair : clients) {
         // We don't need a write lock as long as we make sure the coroutine
         // doesn't block between reading and updating the stamp.
@@ -540,13 +603,21 @@ void server_t::send_all(
         if (std::any_of(pair.second.regions.begin(),
                         pair.second.regions.end(),
                         std::bind(&region_contains_key, ph::_1, std::cref(key)))) {
-            stamps[pair.first] = pair.second.stamp++;
+            client_info_t *info = &pair.second;
+            info->pending.push_back(stamped_msg_t(uuid, info->stamp++, msg));
+            if (info->pending.size() >= batch_max_msgs) {
+                full_batches[pair.first].swap(info->pending);
+            } else if (!info->flush_scheduled) {
+                info->flush_scheduled = true;
+                coro_t::spawn_sometime(
+                    std::bind(&server_t::flush_cb, this, pair.first, keepalive));
+            }
         }
     }
     acq.reset();
     stamp_spot->reset(); // Done stamping, no need to hold onto it while we send.
-    for (const auto &pair : stamps) {
-        send(manager, pair.first, stamped_msg_t(uuid, pair.second, msg));
+    for (auto &&pair : full_batches) {
+        send_batch(pair.first, std::move(pair.second));
     }
 }
 
@@ -1611,6 +1682,11 @@ public:
 
     void each_range_sub(const auto_drainer_t::lock_t &lock,
                         const std::function<void(range_sub_t *)> &f) THROWS_NOTHING;
+    // Calls `f` once for each thread that has range subscriptions, on that thread,
+    // with all of the range subscriptions that live there.
+    void each_range_sub_group(
+        const auto_drainer_t::lock_t &lock,
+        const std::function<void(const std::set<range_sub_t *> &)> &f) THROWS_NOTHING;
     void update_stamps(uuid_u server_uuid, uint64_t stamp);
     std::map<uuid_u, uint64_t> get_stamps();
     void on_point_sub(
@@ -1657,6 +1733,12 @@ private:
         const auto_drainer_t::lock_t &lock,
         const std::function<void(Sub *)> &f) THROWS_NOTHING;
     template<class Sub>
+    void each_sub_group_in_vec(
+        const std::vector<std::set<Sub *> > &vec,
+        rwlock_in_line_t *spot,
+        const auto_drainer_t::lock_t &lock,
+        const std::function<void(const std::set<Sub *> &)> &f) THROWS_NOTHING;
+    template<class Sub>
     void each_sub_in_vec_cb(const std::function<void(Sub *)> &f,
                             const std::vector<std::set<Sub *> > &vec,
                             const std::vector<int> &sub_threads,
@@ -1730,14 +1812,14 @@ private:
     virtual void maybe_remove_feed() { client->maybe_remove_feed(client_lock, table_id); }
     virtual void stop_limit_sub(limit_sub_t *sub);
 
-    void mailbox_cb(signal_t *interruptor, stamped_msg_t msg);
+    void mailbox_cb(signal_t *interruptor, std::vector<stamped_msg_t> msgs);
     void constructor_cb();
 
     auto_drainer_t::lock_t client_lock;
     client_t *client;
     namespace_id_t table_id;
     mailbox_manager_t *manager;
-    mailbox_t<void(stamped_msg_t)> mailbox;
+    mailbox_t<void(std::vector<stamped_msg_t>)> mailbox;
     std::vector<server_t::addr_t> stop_addrs;
     std::vector<scoped_ptr_t<disconnect_watcher_t> > disconnect_watchers;
 
@@ -2175,6 +2257,19 @@ public:
         for (const auto &transform : spec.transforms) {
             ops.push_back(make_op(transform));
         }
+        if (has_ops()) {
+            // Two subscriptions with the same transforms evaluated in the same
+            // environment produce the same values, so `msg_visitor_t` uses this
+            // to evaluate each distinct set of transforms once per change.
+            write_message_t wm;
+            serialize<cluster_version_t::CLUSTER>(&wm, spec.transforms);
+            serialize<cluster_version_t::CLUSTER>(&wm, env->get_serializable_env());
+            vector_stream_t stream;
+            stream.reserve(wm.size());
+            int res = send_write_message(&stream, &wm);
+            guarantee(res == 0);
+            ops_key.assign(stream.vector().begin(), stream.vector().end());
+        }
         store_keys = spec.datumspec.primary_key_map();
         if (!store_keys) {
             store_key_range = spec.datumspec.covering_range().to_primary_keyrange();
@@ -2214,6 +2309,7 @@ public:
     }
 
     bool has_ops() { return ops.size() != 0; }
+    const std::string &get_ops_key() const { return ops_key; }
 
     boost::optional<datum_t> apply_ops(datum_t val) {
         guarantee(active());
@@ -2392,6 +2488,8 @@ private:
 
     scoped_ptr_t<env_t> env;
     std::vector<scoped_ptr_t<op_t> > ops;
+    // The serialized transforms and environment (empty if there are no `ops`).
+    std::string ops_key;
 
     // The stamp (see `stamped_msg_t`) associated with our `changefeed_stamp_t`
     // read.  We use these to make sure we don't see changes from writes before
@@ -2830,24 +2928,38 @@ public:
     }
     void operator()(const msg_t::change_t &change) const {
         datum_t null = datum_t::null();
-
-        feed->each_range_sub(*lock, [&](range_sub_t *sub) {
+        // `transformed` holds the transformed `(new_val, old_val)` pairs keyed by
+        // `range_sub_t::get_ops_key`, so that many feeds with the same
+        // `filter`/`pluck`/`map` only pay for one evaluation per change.
+        typedef std::map<std::string, std::pair<datum_t, datum_t> > transformed_t;
+        auto on_range_sub = [&](range_sub_t *sub, transformed_t *transformed) {
             datum_t new_val = null, old_val = null;
             if (!sub->active()) return;
             bool trivial = false;
             if (sub->has_ops()) {
-                if (change.new_val.has()) {
-                    if (boost::optional<datum_t> d = sub->apply_ops(change.new_val)) {
-                        new_val = *d;
+                auto cached = transformed->find(sub->get_ops_key());
+                if (cached != transformed->end()) {
+                    new_val = cached->second.first;
+                    old_val = cached->second.second;
+                } else {
+                    if (change.new_val.has()) {
+                        if (boost::optional<datum_t> d
+                                = sub->apply_ops(change.new_val)) {
+                            new_val = *d;
+                        }
                     }
-                }
-                if (!sub->active()) return;
-                if (change.old_val.has()) {
-                    if (boost::optional<datum_t> d = sub->apply_ops(change.old_val)) {
-                        old_val = *d;
+                    if (!sub->active()) return;
+                    if (change.old_val.has()) {
+                        if (boost::optional<datum_t> d
+                                = sub->apply_ops(change.old_val)) {
+                            old_val = *d;
+                        }
                     }
+                    if (!sub->active()) return;
+                    transformed->insert(
+                        std::make_pair(sub->get_ops_key(),
+                                       std::make_pair(new_val, old_val)));
                 }
-                if (!sub->active()) return;
                 // Duplicate values are caught before being written to disk and
                 // don't generate a `mod_report`, but if we have transforms the
                 // values might have changed.
@@ -2917,6 +3029,14 @@ public:
                     }
                 }
             }
+        };
+        feed->each_range_sub_group(*lock, [&](const std::set<range_sub_t *> &subs) {
+            // The cache is per thread, because `datum_t`s can't be shared between
+            // threads.
+            transformed_t transformed;
+            for (range_sub_t *sub : subs) {
+                on_range_sub(sub, &transformed);
+            }
         });
         feed->on_point_sub(
             change.pkey,
@@ -2957,7 +3077,7 @@ void msg_visit(feed_t *feed,
     feed->update_stamps(server_uuid, stamp);
 }
 
-void real_feed_t::mailbox_cb(signal_t *, stamped_msg_t msg) {
+void real_feed_t::mailbox_cb(signal_t *, std::vector<stamped_msg_t> msgs) {
     // We stop receiving messages when detached (we're only receiving
     // messages because we haven't managed to get a message to the
     // stop mailboxes for some of the primary replicas yet).  This also stops
@@ -2971,10 +3091,11 @@ void real_feed_t::mailbox_cb(signal_t *, stamped_msg_t msg) {
         wait_any_t wait_any(&queues_ready, lock.get_drain_signal());
         wait_any.wait_lazily_unordered();
         if (detached) return;
-        if (!lock.get_drain_signal()->is_pulsed()) {
-            // We don't need a lock for this because the set of `uuid_u`s never
-            // changes after it's initialized.
-            auto it = queues.find(msg.server_uuid);
+        if (!lock.get_drain_signal()->is_pulsed() && msgs.size() != 0) {
+            // All messages in a batch come from the same `server_t`.  We don't
+            // need a lock for this because the set of `uuid_u`s never changes
+            // after it's initialized.
+            auto it = queues.find(msgs[0].server_uuid);
             guarantee(it != queues.end());
             queue_t *queue = it->second.get();
             guarantee(queue != NULL);
@@ -2984,8 +3105,11 @@ void real_feed_t::mailbox_cb(signal_t *, stamped_msg_t msg) {
             if (detached) return;
 
             // Add us to the queue.
-            guarantee(msg.stamp >= queue->next);
-            queue->map.push(std::move(msg));
+            for (auto &&msg : msgs) {
+                guarantee(msg.server_uuid == it->first);
+                guarantee(msg.stamp >= queue->next);
+                queue->map.push(std::move(msg));
+            }
 
             // Read as much as we can from the queue (this enforces ordering.)
             while (queue->map.size() != 0 && queue->map.top().stamp == queue->next) {
@@ -3559,6 +3683,21 @@ void feed_t::each_sub_in_vec(
     rwlock_in_line_t *spot,
     const auto_drainer_t::lock_t &lock,
     const std::function<void(Sub *)> &f) THROWS_NOTHING {
+    each_sub_group_in_vec<Sub>(
+        vec, spot, lock,
+        [&f](const std::set<Sub *> &subs) {
+            for (Sub *sub : subs) {
+                f(sub);
+            }
+        });
+}
+
+template<class Sub>
+void feed_t::each_sub_group_in_vec(
+    const std::vector<std::set<Sub *> > &vec,
+    rwlock_in_line_t *spot,
+    const auto_drainer_t::lock_t &lock,
+    const std::function<void(const std::set<Sub *> &)> &f) THROWS_NOTHING {
     assert_thread();
     guarantee(lock.has_lock());
     spot->read_signal()->wait_lazily_unordered();
@@ -3573,9 +3712,7 @@ void feed_t::each_sub_in_vec(
          [&f, &vec, &subscription_threads](int i) {
              guarantee(vec[subscription_threads[i]].size() != 0);
              on_thread_t th((threadnum_t(subscription_threads[i])));
-             for (Sub *sub : vec[subscription_threads[i]]) {
-                 f(sub);
-             }
+             f(vec[subscription_threads[i]]);
          });
 }
 
@@ -3587,6 +3724,14 @@ void feed_t::each_range_sub(
     each_sub_in_vec(range_subs, &spot, lock, f);
 }
 
+void feed_t::each_range_sub_group(
+    const auto_drainer_t::lock_t &lock,
+    const std::function<void(const std::set<range_sub_t *> &)> &f) THROWS_NOTHING {
+    assert_thread();
+    rwlock_in_line_t spot(&range_subs_lock, access_t::read);
+    each_sub_group_in_vec(range_subs, &spot, lock, f);
+}
+
 void feed_t::each_point_sub_cb(const std::function<void(point_sub_t *)> &f, int i) {
     on_thread_t th((threadnum_t(i)));
     for (auto const &pair : point_subs) {
@@ -21,6 +21,7 @@
 #include "containers/counted.hpp"
 #include "containers/lifetime.hpp"
 #include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
 #include "protocol_api.hpp"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/datumspec.hpp"
@@ -126,9 +127,22 @@ struct msg_t {
 RDB_DECLARE_SERIALIZABLE(msg_t);
 
 class real_feed_t;
-struct stamped_msg_t;
 
-typedef mailbox_addr_t<void(stamped_msg_t)> client_addr_t;
+struct stamped_msg_t {
+    stamped_msg_t() { }
+    stamped_msg_t(uuid_u _server_uuid, uint64_t _stamp, msg_t _submsg)
+        : server_uuid(std::move(_server_uuid)),
+          stamp(_stamp),
+          submsg(std::move(_submsg)) { }
+    uuid_u server_uuid;
+    uint64_t stamp;
+    msg_t submsg;
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(stamped_msg_t);
+
+// `server_t` sends the messages for a client in batches (see `send_all`).  The
+// messages in a batch are in stamp order, but batches can arrive in any order.
+typedef mailbox_addr_t<void(std::vector<stamped_msg_t>)> client_addr_t;
 
 struct keyspec_t {
     struct range_t {
@@ -454,6 +468,20 @@ public:
     auto_drainer_t drainer;
 };
 
+// Tracks how many messages the `server_t`s of a `store_t` send to their clients
+// and how many changes those messages carry.
+class server_stats_t {
+public:
+    explicit server_stats_t(perfmon_collection_t *parent);
+    void note_batch(size_t num_msgs);
+private:
+    perfmon_collection_t collection;
+    perfmon_rate_monitor_t pm_messages_sent, pm_changes_sent;
+    perfmon_counter_t pm_total_messages_sent, pm_total_changes_sent;
+    perfmon_multi_membership_t pm_membership;
+    perfmon_membership_t collection_membership;
+};
+
 // There is one `server_t` per `store_t`, and it is used to send changes that
 // occur on that `store_t` to any subscribed `real_feed_t`s contained in a
 // `client_t`.
@@ -462,7 +490,17 @@ public:
     typedef server_addr_t addr_t;
     typedef mailbox_addr_t<void(client_t::addr_t, boost::optional<std::string>, uuid_u)>
         limit_addr_t;
-    explicit server_t(mailbox_manager_t *_manager, store_t *_parent);
+    // A `server_t` collects the changes for each subscribed client for up to
+    // `batch_window_ms` milliseconds, or until `batch_max_msgs` of them have
+    // accumulated, and then sends them to the client as a single message.
+    static const int64_t DEFAULT_BATCH_WINDOW_MS;
+    static const int64_t MAX_BATCH_WINDOW_MS;
+    static const size_t DEFAULT_BATCH_MAX_MSGS;
+    static const size_t MAX_BATCH_MAX_MSGS;
+    server_t(mailbox_manager_t *_manager,
+             store_t *_parent,
+             int64_t _batch_window_ms = DEFAULT_BATCH_WINDOW_MS,
+             size_t _batch_max_msgs = DEFAULT_BATCH_MAX_MSGS);
     ~server_t();
     void add_client(
         const client_t::addr_t &addr,
@@ -517,17 +555,27 @@ private:
         signal_t *stopped,
         client_t::addr_t addr,
         auto_drainer_t::lock_t keepalive);
+    // Sends whatever `send_all` buffered for `addr` once the batching window
+    // has passed.
+    void flush_cb(client_t::addr_t addr, auto_drainer_t::lock_t keepalive);
+    void send_batch(const client_t::addr_t &addr, std::vector<stamped_msg_t> &&batch);
 
     // The UUID of the server, used so that `real_feed_t`s can enforce on ordering on
     // changefeed messages on a per-server basis (and drop changefeed messages
     // from before their own creation timestamp on a per-server basis).
     const uuid_u uuid;
     mailbox_manager_t *const manager;
+    const int64_t batch_window_ms;
+    const size_t batch_max_msgs;
 
     struct client_info_t {
         client_info_t();
         scoped_ptr_t<cond_t> cond;
         uint64_t stamp;
+        // Messages that have been stamped but not sent yet, and whether a
+        // `flush_cb` is already going to send them.
+        std::vector<stamped_msg_t> pending;
+        bool flush_scheduled;
         std::vector<region_t> regions;
         std::map<boost::optional<std::string>,
                  std::vector<scoped_ptr_t<limit_manager_t> >,
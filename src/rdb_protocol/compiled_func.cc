@@ -0,0 +1,303 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/compiled_func.hpp"
+
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/ql2.pb.h"
+#include "rdb_protocol/term_storage.hpp"
+
+namespace ql {
+
+class compiled_func_builder_t : public func_visitor_t {
+public:
+    explicit compiled_func_builder_t(compiled_func_t *_out) : out(_out), ok(false) { }
+
+    void on_reql_func(const reql_func_t *reql_func) {
+        // `filter` and `map` always call their function with exactly one argument.
+        if (reql_func->arg_names.size() != 1) {
+            return;
+        }
+        arg_name = reql_func->arg_names[0];
+        scope = &reql_func->captured_scope;
+        var_visibility_t captured_visibility = scope->compute_visibility();
+        // `var_scope_t::with_func_arg_list` doesn't shadow a captured variable of the
+        // same name, so stay away from that case altogether.
+        if (captured_visibility.contains_var(arg_name)) {
+            return;
+        }
+        implicit_is_arg =
+            function_emits_implicit_variable(reql_func->arg_names)
+            && captured_visibility.get_implicit_depth() == 0;
+        ok = build(reql_func->body->get_src(), &out->root);
+    }
+
+    void on_js_func(const js_func_t *) { }
+
+    bool succeeded() const { return ok; }
+
+private:
+    typedef compiled_func_t::node_t node_t;
+    typedef compiled_func_t::opcode_t opcode_t;
+
+    bool build(const raw_term_t &term, size_t *index_out) {
+        if (term.num_optargs() != 0) {
+            return false;
+        }
+
+        node_t node;
+        node.children_begin = node.children_end = 0;
+        switch (static_cast<int>(term.type())) {
+        case Term::VAR: {
+            if (term.num_args() != 1 || term.arg(0).type() != Term::DATUM) {
+                return false;
+            }
+            datum_t name = term.arg(0).datum();
+            int64_t name_value;
+            if (name.get_type() != datum_t::R_NUM
+                || !number_as_integer(name.as_num(), &name_value)) {
+                return false;
+            }
+            sym_t varname(name_value);
+            if (varname.value == arg_name.value) {
+                node.opcode = opcode_t::ARG;
+            } else if (scope->compute_visibility().contains_var(varname)) {
+                node.opcode = opcode_t::CONSTANT;
+                node.constant = scope->lookup_var(varname);
+            } else {
+                return false;
+            }
+        } break;
+        case Term::IMPLICIT_VAR: {
+            if (!implicit_is_arg || term.num_args() != 0) {
+                return false;
+            }
+            node.opcode = opcode_t::ARG;
+        } break;
+        case Term::DATUM: {
+            // Literals are parsed without limits here, which is only equivalent for
+            // scalars.
+            datum_t d = term.datum();
+            switch (d.get_type()) {
+            case datum_t::R_NULL: // fallthru
+            case datum_t::R_BOOL: // fallthru
+            case datum_t::R_NUM: // fallthru
+            case datum_t::R_STR:
+                break;
+            case datum_t::UNINITIALIZED: // fallthru
+            case datum_t::MINVAL: // fallthru
+            case datum_t::R_ARRAY: // fallthru
+            case datum_t::R_BINARY: // fallthru
+            case datum_t::R_OBJECT: // fallthru
+            case datum_t::MAXVAL: // fallthru
+            default:
+                return false;
+            }
+            node.opcode = opcode_t::CONSTANT;
+            node.constant = std::move(d);
+        } break;
+        case Term::GET_FIELD: // fallthru
+        case Term::BRACKET: {
+            if (term.num_args() != 2 || term.arg(1).type() != Term::DATUM) {
+                return false;
+            }
+            // `BRACKET` with a number is `nth`, which we don't handle.
+            datum_t field = term.arg(1).datum();
+            if (field.get_type() != datum_t::R_STR) {
+                return false;
+            }
+            node.opcode = opcode_t::GET_FIELD;
+            node.field = field.as_str();
+            if (!build_args(term, 1, &node)) {
+                return false;
+            }
+        } break;
+        case Term::EQ: node.opcode = opcode_t::EQ; break;
+        case Term::NE: node.opcode = opcode_t::NE; break;
+        case Term::LT: node.opcode = opcode_t::LT; break;
+        case Term::LE: node.opcode = opcode_t::LE; break;
+        case Term::GT: node.opcode = opcode_t::GT; break;
+        case Term::GE: node.opcode = opcode_t::GE; break;
+        case Term::NOT: {
+            if (term.num_args() != 1) {
+                return false;
+            }
+            node.opcode = opcode_t::NOT;
+            if (!build_args(term, 1, &node)) {
+                return false;
+            }
+        } break;
+        case Term::AND: node.opcode = opcode_t::AND; break;
+        case Term::OR: node.opcode = opcode_t::OR; break;
+        default:
+            return false;
+        }
+
+        switch (node.opcode) {
+        case opcode_t::EQ: // fallthru
+        case opcode_t::NE: // fallthru
+        case opcode_t::LT: // fallthru
+        case opcode_t::LE: // fallthru
+        case opcode_t::GT: // fallthru
+        case opcode_t::GE:
+            // Let the interpreter report the arity error.
+            if (term.num_args() < 2 || !build_args(term, term.num_args(), &node)) {
+                return false;
+            }
+            break;
+        case opcode_t::AND: // fallthru
+        case opcode_t::OR:
+            if (!build_args(term, term.num_args(), &node)) {
+                return false;
+            }
+            break;
+        case opcode_t::ARG: // fallthru
+        case opcode_t::CONSTANT: // fallthru
+        case opcode_t::GET_FIELD: // fallthru
+        case opcode_t::NOT: // fallthru
+        default:
+            break;
+        }
+
+        *index_out = out->nodes.size();
+        out->nodes.push_back(std::move(node));
+        return true;
+    }
+
+    // Builds the first `count` arguments of `term` and records them as the
+    // children of `node`.
+    bool build_args(const raw_term_t &term, size_t count, node_t *node) {
+        std::vector<size_t> arg_indices(count);
+        for (size_t i = 0; i < count; ++i) {
+            if (!build(term.arg(i), &arg_indices[i])) {
+                return false;
+            }
+        }
+        node->children_begin = out->children.size();
+        out->children.insert(out->children.end(),
+                             arg_indices.begin(), arg_indices.end());
+        node->children_end = out->children.size();
+        return true;
+    }
+
+    compiled_func_t *out;
+    bool ok;
+    sym_t arg_name;
+    bool implicit_is_arg;
+    const var_scope_t *scope;
+};
+
+scoped_ptr_t<compiled_func_t> compiled_func_t::compile(
+        const counted_t<const func_t> &func) {
+    scoped_ptr_t<compiled_func_t> ret(new compiled_func_t());
+    compiled_func_builder_t builder(ret.get());
+    func->visit(&builder);
+    if (!builder.succeeded()) {
+        ret.reset();
+    }
+    return ret;
+}
+
+bool compiled_func_t::eval(const datum_t &arg, datum_t *out) const {
+    return eval_node(root, arg, out);
+}
+
+bool compiled_func_t::eval_node(
+        size_t index, const datum_t &arg, datum_t *out) const {
+    const node_t &node = nodes[index];
+    switch (node.opcode) {
+    case opcode_t::ARG:
+        *out = arg;
+        return true;
+    case opcode_t::CONSTANT:
+        *out = node.constant;
+        return true;
+    case opcode_t::GET_FIELD: {
+        datum_t obj;
+        if (!eval_node(children[node.children_begin], arg, &obj)) {
+            return false;
+        }
+        // Arrays (which `GET_FIELD` maps over), pseudotypes and missing fields all
+        // produce either a sequence or an error in the interpreter.
+        if (obj.get_type() != datum_t::R_OBJECT || obj.is_ptype()) {
+            return false;
+        }
+        *out = obj.get_field(node.field, NOTHROW);
+        return out->has();
+    }
+    case opcode_t::EQ: // fallthru
+    case opcode_t::NE: // fallthru
+    case opcode_t::LT: // fallthru
+    case opcode_t::LE: // fallthru
+    case opcode_t::GT: // fallthru
+    case opcode_t::GE:
+        return eval_comparison(node, arg, out);
+    case opcode_t::NOT: {
+        datum_t val;
+        if (!eval_node(children[node.children_begin], arg, &val)) {
+            return false;
+        }
+        *out = datum_t::boolean(!val.as_bool());
+        return true;
+    }
+    case opcode_t::AND: // fallthru
+    case opcode_t::OR: {
+        // Same short-circuiting and result as `and_term_t` and `or_term_t`: the
+        // first argument that decides the outcome, or the last one.
+        const bool is_and = node.opcode == opcode_t::AND;
+        *out = datum_t::boolean(is_and);
+        for (size_t i = node.children_begin; i < node.children_end; ++i) {
+            if (!eval_node(children[i], arg, out)) {
+                return false;
+            }
+            if (out->as_bool() != is_and) {
+                break;
+            }
+        }
+        return true;
+    }
+    default:
+        unreachable();
+    }
+}
+
+bool compiled_func_t::eval_comparison(
+        const node_t &node, const datum_t &arg, datum_t *out) const {
+    // Mirrors `predicate_term_t::eval_impl`, including evaluating the arguments
+    // lazily and stopping at the first pair that fails.
+    const bool invert = node.opcode == opcode_t::NE;
+    datum_t lhs;
+    if (!eval_node(children[node.children_begin], arg, &lhs)) {
+        return false;
+    }
+    for (size_t i = node.children_begin + 1; i < node.children_end; ++i) {
+        datum_t rhs;
+        if (!eval_node(children[i], arg, &rhs)) {
+            return false;
+        }
+        bool holds;
+        switch (node.opcode) {
+        case opcode_t::EQ: // fallthru
+        case opcode_t::NE: holds = lhs == rhs; break;
+        case opcode_t::LT: holds = lhs.cmp(rhs) < 0; break;
+        case opcode_t::LE: holds = lhs.cmp(rhs) <= 0; break;
+        case opcode_t::GT: holds = lhs.cmp(rhs) > 0; break;
+        case opcode_t::GE: holds = lhs.cmp(rhs) >= 0; break;
+        case opcode_t::ARG: // fallthru
+        case opcode_t::CONSTANT: // fallthru
+        case opcode_t::GET_FIELD: // fallthru
+        case opcode_t::NOT: // fallthru
+        case opcode_t::AND: // fallthru
+        case opcode_t::OR: // fallthru
+        default:
+            unreachable();
+        }
+        if (!holds) {
+            *out = datum_t::boolean(invert);
+            return true;
+        }
+        lhs = std::move(rhs);
+    }
+    *out = datum_t::boolean(!invert);
+    return true;
+}
+
+}  // namespace ql
@@ -0,0 +1,83 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_COMPILED_FUNC_HPP_
+#define RDB_PROTOCOL_COMPILED_FUNC_HPP_
+
+#include <vector>
+
+#include "containers/counted.hpp"
+#include "containers/scoped.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/datum_string.hpp"
+
+namespace ql {
+
+class compiled_func_builder_t;
+class func_t;
+class raw_term_t;
+class reql_func_t;
+
+// A `compiled_func_t` is a flat, interpreter-free form of a single-argument ReQL
+// function, used by `filter_trans_t` and `map_trans_t` to avoid allocating a
+// `scope_env_t` and one `val_t` per term for every row of a scan.  Only a small,
+// deterministic subset of terms can be compiled: the function's argument (or
+// `r.row`), captured variables, scalar literals, `GET_FIELD` and `BRACKET` with a
+// literal field name, the comparison operators, `NOT`, `AND` and `OR`.
+//
+// Evaluation never throws.  Whenever a row would take the compiled form off the
+// path where it provably matches the interpreter (a missing field, a field access
+// on something other than a plain object), `eval` returns false and the caller has
+// to run the original `func_t` on that row instead, which will produce the same
+// result or error as it always did.
+class compiled_func_t {
+public:
+    // Returns an empty pointer if `func` uses anything outside of the subset above.
+    static scoped_ptr_t<compiled_func_t> compile(const counted_t<const func_t> &func);
+
+    // Returns false if the interpreter has to be used for this argument.
+    bool eval(const datum_t &arg, datum_t *out) const;
+
+private:
+    enum class opcode_t {
+        ARG,
+        CONSTANT,
+        GET_FIELD,
+        EQ,
+        NE,
+        LT,
+        LE,
+        GT,
+        GE,
+        NOT,
+        AND,
+        OR
+    };
+
+    struct node_t {
+        opcode_t opcode;
+        // Range of `children` holding the indices of this node's arguments.
+        size_t children_begin;
+        size_t children_end;
+        // Only used by `CONSTANT`.
+        datum_t constant;
+        // Only used by `GET_FIELD`.
+        datum_string_t field;
+    };
+
+    friend class compiled_func_builder_t;
+
+    compiled_func_t() : root(0) { }
+
+    bool eval_node(size_t index, const datum_t &arg, datum_t *out) const;
+    bool eval_comparison(const node_t &node, const datum_t &arg, datum_t *out) const;
+
+    // Nodes are stored in post-order, so every node's arguments precede it.
+    std::vector<node_t> nodes;
+    std::vector<size_t> children;
+    size_t root;
+
+    DISABLE_COPYING(compiled_func_t);
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_COMPILED_FUNC_HPP_
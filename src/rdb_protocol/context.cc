@@ -72,13 +72,27 @@ rdb_context_t::stats_t::stats_t(perfmon_collection_t *global_stats)
       queries_per_sec_membership(&qe_stats_collection,
                                  &queries_per_sec, "queries_per_sec"),
       queries_total_membership(&qe_stats_collection,
-                               &queries_total, "queries_total") { }
+                               &queries_total, "queries_total"),
+      query_latency(secs_to_ticks(10)),
+      query_latency_membership(&qe_stats_collection,
+                               &query_latency, "query_latency"),
+      client_handshake_latency(secs_to_ticks(10)),
+      client_handshake_latency_membership(&qe_stats_collection,
+                                          &client_handshake_latency,
+                                          "client_handshake_latency"),
+      outdated_reads_membership(&qe_stats_collection,
+                                &outdated_reads_local, "outdated_reads_local",
+                                &outdated_reads_remote, "outdated_reads_remote",
+                                &outdated_reads_hedged, "outdated_reads_hedged") { }
 
 rdb_context_t::rdb_context_t()
     : extproc_pool(nullptr),
       cluster_interface(nullptr),
       manager(nullptr),
       reql_http_proxy(),
+      io_backender(nullptr),
+      changefeed_batch_window_ms(ql::changefeed::server_t::DEFAULT_BATCH_WINDOW_MS),
+      changefeed_batch_max_msgs(ql::changefeed::server_t::DEFAULT_BATCH_MAX_MSGS),
       stats(&get_global_perfmon_collection()) { }
 
 rdb_context_t::rdb_context_t(
@@ -90,6 +104,9 @@ rdb_context_t::rdb_context_t(
       cluster_interface(_cluster_interface),
       manager(nullptr),
       reql_http_proxy(),
+      io_backender(nullptr),
+      changefeed_batch_window_ms(ql::changefeed::server_t::DEFAULT_BATCH_WINDOW_MS),
+      changefeed_batch_max_msgs(ql::changefeed::server_t::DEFAULT_BATCH_MAX_MSGS),
       stats(&get_global_perfmon_collection()) {
     init_auth_watchables(auth_semilattice_view);
 }
@@ -101,11 +118,19 @@ rdb_context_t::rdb_context_t(
         boost::shared_ptr<semilattice_read_view_t<auth_semilattice_metadata_t>>
             auth_semilattice_view,
         perfmon_collection_t *global_stats,
-        const std::string &_reql_http_proxy)
+        const std::string &_reql_http_proxy,
+        io_backender_t *_io_backender,
+        const base_path_t &_base_path,
+        int64_t _changefeed_batch_window_ms,
+        size_t _changefeed_batch_max_msgs)
     : extproc_pool(_extproc_pool),
       cluster_interface(_cluster_interface),
       manager(_mailbox_manager),
       reql_http_proxy(_reql_http_proxy),
+      io_backender(_io_backender),
+      base_path(_base_path),
+      changefeed_batch_window_ms(_changefeed_batch_window_ms),
+      changefeed_batch_max_msgs(_changefeed_batch_max_msgs),
       stats(global_stats) {
     init_auth_watchables(auth_semilattice_view);
 }
@@ -25,6 +25,7 @@
 #include "rdb_protocol/geo/lon_lat_types.hpp"
 #include "rdb_protocol/shards.hpp"
 #include "rdb_protocol/wire_func.hpp"
+#include "serializer/log/config.hpp"
 
 namespace auth {
 
@@ -136,9 +137,13 @@ public:
         p.num_shards = 1;
         p.primary_replica_tag = name_string_t::guarantee_valid("default");
         p.num_replicas[p.primary_replica_tag] = 1;
+        p.cpu_shards = CPU_SHARDING_FACTOR;
+        p.block_compression = block_codec_t::none;
         return p;
     }
     size_t num_shards;
+    size_t cpu_shards;
+    block_codec_t block_compression;
     std::map<name_string_t, size_t> num_replicas;
     std::set<name_string_t> nonvoting_replica_tags;
     name_string_t primary_replica_tag;
@@ -450,6 +455,7 @@ protected:
     virtual ~reql_cluster_interface_t() { }   // silence compiler warnings
 };
 
+class io_backender_t;
 class mailbox_manager_t;
 
 class rdb_context_t {
@@ -470,7 +476,11 @@ public:
         boost::shared_ptr<semilattice_read_view_t<auth_semilattice_metadata_t>>
             auth_semilattice_view,
         perfmon_collection_t *global_stats,
-        const std::string &_reql_http_proxy);
+        const std::string &_reql_http_proxy,
+        io_backender_t *_io_backender,
+        const base_path_t &_base_path,
+        int64_t _changefeed_batch_window_ms,
+        size_t _changefeed_batch_max_msgs);
 
     ~rdb_context_t();
 
@@ -481,6 +491,16 @@ public:
 
     const std::string reql_http_proxy;
 
+    // Used to spill unindexed `orderBy`s that don't fit into memory to temporary
+    // files in `base_path`.  `io_backender` is `nullptr` on proxies and in unit
+    // tests, which sort in memory only.
+    io_backender_t *const io_backender;
+    const base_path_t base_path;
+
+    // Passed to the changefeed `server_t`s of the stores on this server.
+    const int64_t changefeed_batch_window_ms;
+    const size_t changefeed_batch_max_msgs;
+
     class stats_t {
     public:
         explicit stats_t(perfmon_collection_t *global_stats);
@@ -495,6 +515,15 @@ public:
         perfmon_membership_t queries_per_sec_membership;
         perfmon_counter_t queries_total;
         perfmon_membership_t queries_total_membership;
+        perfmon_latency_histogram_t query_latency;
+        perfmon_membership_t query_latency_membership;
+        perfmon_latency_histogram_t client_handshake_latency;
+        perfmon_membership_t client_handshake_latency_membership;
+        // How `table_query_client_t` routed outdated reads.
+        perfmon_counter_t outdated_reads_local;
+        perfmon_counter_t outdated_reads_remote;
+        perfmon_counter_t outdated_reads_hedged;
+        perfmon_multi_membership_t outdated_reads_membership;
     private:
         DISABLE_COPYING(stats_t);
     } stats;
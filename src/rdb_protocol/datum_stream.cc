@@ -4,6 +4,8 @@
 #include <map>
 
 #include "boost_utils.hpp"
+#include "containers/disk_backed_queue.hpp"
+#include "containers/uuid.hpp"
 #include "rdb_protocol/batching.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/func.hpp"
@@ -17,6 +19,7 @@
 #include "rdb_protocol/geo/s2/s2latlngrect.h"
 #include "rdb_protocol/geo/s2/s2polygon.h"
 #include "rdb_protocol/geo/s2/s2polyline.h"
+#include "rdb_protocol/serialize_datum.hpp"
 #include "rdb_protocol/term.hpp"
 #include "rdb_protocol/val.hpp"
 #include "utils.hpp"
@@ -1604,6 +1607,225 @@ indexed_sort_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batch
     return ret;
 }
 
+// EXTERNAL_SORT_DATUM_STREAM_T
+// How many rows of a run we write to disk in one transaction.
+static const size_t EXTERNAL_SORT_WRITE_CHUNK_SIZE = 1000;
+// How many runs of the same level we merge into one run of the next level.
+static const size_t EXTERNAL_SORT_MERGE_FAN_IN = 16;
+// Every spilled run has its own file, serializer and cache, so we never keep more
+// than this many of them around.  Once we reach it, we merge the newest runs even
+// if they're of different levels.
+static const size_t EXTERNAL_SORT_MAX_OPEN_RUNS = 64;
+static_assert(EXTERNAL_SORT_MAX_OPEN_RUNS >= EXTERNAL_SORT_MERGE_FAN_IN,
+              "EXTERNAL_SORT_MAX_OPEN_RUNS must be at least the merge fan-in");
+
+struct external_sort_datum_stream_t::run_t {
+    run_t(io_backender_t *io_backender,
+          const serializer_filepath_t &filepath,
+          size_t _level)
+        : level(_level), queue(io_backender, filepath, &stats) { }
+
+    // How many merge passes the rows of this run went through.
+    const size_t level;
+    // The queue's stats aren't interesting to anybody, so we don't attach them to
+    // the global perfmon collection.
+    perfmon_collection_t stats;
+    disk_backed_queue_t<datum_t> queue;
+};
+
+// Puts the smallest row on top of the heap.  Ties are broken by run, so that rows
+// that compare equal come out in the order in which they were handed to us.
+class external_sort_datum_stream_t::merge_greater_t {
+public:
+    merge_greater_t(env_t *_env, profile::sampler_t *_sampler, const lt_cmp_t *_lt)
+        : env(_env), sampler(_sampler), lt(_lt) { }
+    bool operator()(const merge_item_t &a, const merge_item_t &b) const {
+        if ((*lt)(env, sampler, b.value, a.value)) {
+            return true;
+        } else if ((*lt)(env, sampler, a.value, b.value)) {
+            return false;
+        } else {
+            return a.run > b.run;
+        }
+    }
+private:
+    env_t *env;
+    profile::sampler_t *sampler;
+    const lt_cmp_t *lt;
+};
+
+external_sort_datum_stream_t::external_sort_datum_stream_t(
+        io_backender_t *_io_backender,
+        const base_path_t &_base_path,
+        lt_cmp_t lt_cmp,
+        backtrace_id_t _bt)
+    : eager_datum_stream_t(_bt),
+      io_backender(_io_backender),
+      base_path(_base_path),
+      lt(std::move(lt_cmp)),
+      last_run_index(0),
+      finished(false) {
+    guarantee(io_backender != nullptr);
+}
+
+external_sort_datum_stream_t::~external_sort_datum_stream_t() { }
+
+void external_sort_datum_stream_t::spill_run(env_t *env, std::vector<datum_t> *rows) {
+    r_sanity_check(!finished);
+    {
+        profile::sampler_t sampler("Sorting in-memory.", env->trace);
+        std::stable_sort(rows->begin(), rows->end(),
+                         std::bind(lt, env, &sampler, ph::_1, ph::_2));
+    }
+
+    {
+        profile::sampler_t sampler("Writing sorted run to disk.", env->trace);
+        scoped_ptr_t<run_t> run = new_run(0);
+        for (size_t i = 0; i < rows->size(); i += EXTERNAL_SORT_WRITE_CHUNK_SIZE) {
+            size_t end = std::min(rows->size(), i + EXTERNAL_SORT_WRITE_CHUNK_SIZE);
+            run->queue.push_many(
+                std::vector<datum_t>(rows->begin() + i, rows->begin() + end));
+            sampler.new_sample();
+        }
+        spilled_runs.push_back(std::move(run));
+        rows->clear();
+    }
+
+    // We only ever merge the newest runs into one, which takes their place at the
+    // end of `spilled_runs`, so the runs stay in the order their rows were handed
+    // to us in and the sort stays stable.
+    while (spilled_runs.size() >= EXTERNAL_SORT_MERGE_FAN_IN) {
+        const size_t first = spilled_runs.size() - EXTERNAL_SORT_MERGE_FAN_IN;
+        bool same_level = true;
+        for (size_t run = first + 1; run < spilled_runs.size(); ++run) {
+            same_level = same_level
+                && spilled_runs[run]->level == spilled_runs[first]->level;
+        }
+        if (!same_level && spilled_runs.size() < EXTERNAL_SORT_MAX_OPEN_RUNS) {
+            break;
+        }
+        merge_runs(env, first);
+    }
+}
+
+scoped_ptr_t<external_sort_datum_stream_t::run_t>
+external_sort_datum_stream_t::new_run(size_t level) {
+    return make_scoped<run_t>(
+        io_backender,
+        serializer_filepath_t(base_path, "orderby_" + uuid_to_str(generate_uuid())),
+        level);
+}
+
+void external_sort_datum_stream_t::merge_runs(env_t *env, size_t first) {
+    r_sanity_check(first < spilled_runs.size());
+    profile::sampler_t sampler("Merging sorted runs on disk.", env->trace);
+    merge_greater_t greater(env, &sampler, &lt);
+
+    size_t level = 0;
+    std::vector<merge_item_t> merge_heads;
+    for (size_t run = first; run < spilled_runs.size(); ++run) {
+        level = std::max(level, spilled_runs[run]->level + 1);
+        datum_t head = next_in_run(run);
+        if (head.has()) {
+            merge_heads.push_back(merge_item_t{std::move(head), run});
+        }
+    }
+    std::make_heap(merge_heads.begin(), merge_heads.end(), greater);
+
+    scoped_ptr_t<run_t> merged = new_run(level);
+    std::vector<datum_t> chunk;
+    while (!merge_heads.empty()) {
+        std::pop_heap(merge_heads.begin(), merge_heads.end(), greater);
+        merge_item_t *item = &merge_heads.back();
+        chunk.push_back(std::move(item->value));
+        item->value = next_in_run(item->run);
+        if (item->value.has()) {
+            std::push_heap(merge_heads.begin(), merge_heads.end(), greater);
+        } else {
+            merge_heads.pop_back();
+        }
+        if (chunk.size() == EXTERNAL_SORT_WRITE_CHUNK_SIZE) {
+            merged->queue.push_many(chunk);
+            chunk.clear();
+        }
+        sampler.new_sample();
+    }
+    if (!chunk.empty()) {
+        merged->queue.push_many(chunk);
+    }
+
+    // Destroying the merged runs deletes their files.
+    spilled_runs.resize(first);
+    spilled_runs.push_back(std::move(merged));
+}
+
+void external_sort_datum_stream_t::finish(env_t *env, std::vector<datum_t> &&rows) {
+    r_sanity_check(!finished);
+    finished = true;
+
+    profile::sampler_t sampler("Sorting in-memory.", env->trace);
+    last_run = std::move(rows);
+    std::stable_sort(last_run.begin(), last_run.end(),
+                     std::bind(lt, env, &sampler, ph::_1, ph::_2));
+    last_run_index = 0;
+
+    // The last run gets the highest run number, because its rows were handed to us
+    // last.
+    for (size_t run = 0; run <= spilled_runs.size(); ++run) {
+        datum_t head = next_in_run(run);
+        if (head.has()) {
+            heads.push_back(merge_item_t{std::move(head), run});
+        }
+    }
+    std::make_heap(heads.begin(), heads.end(), merge_greater_t(env, &sampler, &lt));
+}
+
+bool external_sort_datum_stream_t::is_exhausted() const {
+    return heads.empty() && batch_cache_exhausted();
+}
+
+datum_t external_sort_datum_stream_t::next_in_run(size_t run) {
+    if (run < spilled_runs.size()) {
+        disk_backed_queue_t<datum_t> *queue = &spilled_runs[run]->queue;
+        if (queue->empty()) {
+            return datum_t();
+        }
+        datum_t ret;
+        queue->pop(&ret);
+        return ret;
+    } else {
+        r_sanity_check(run == spilled_runs.size());
+        if (last_run_index >= last_run.size()) {
+            return datum_t();
+        }
+        return std::move(last_run[last_run_index++]);
+    }
+}
+
+std::vector<datum_t>
+external_sort_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
+    r_sanity_check(finished);
+    std::vector<datum_t> ret;
+    batcher_t batcher = batchspec.to_batcher();
+
+    profile::sampler_t sampler("Merging sorted runs.", env->trace);
+    merge_greater_t greater(env, &sampler, &lt);
+    while (!heads.empty() && !batcher.should_send_batch()) {
+        std::pop_heap(heads.begin(), heads.end(), greater);
+        merge_item_t *item = &heads.back();
+        batcher.note_el(item->value);
+        ret.push_back(std::move(item->value));
+        item->value = next_in_run(item->run);
+        if (item->value.has()) {
+            std::push_heap(heads.begin(), heads.end(), greater);
+        } else {
+            heads.pop_back();
+        }
+        sampler.new_sample();
+    }
+    return ret;
+}
+
 // ORDERED_DISTINCT_DATUM_STREAM_T
 ordered_distinct_datum_stream_t::ordered_distinct_datum_stream_t(
     counted_t<datum_stream_t> _source) : wrapper_datum_stream_t(_source) { }
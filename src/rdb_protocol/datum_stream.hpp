@@ -28,6 +28,9 @@
 #include "rdb_protocol/shards.hpp"
 #include "rdb_protocol/val.hpp"
 
+template <class T> class disk_backed_queue_t;
+class io_backender_t;
+
 namespace ql {
 
 class env_t;
@@ -261,6 +264,74 @@ private:
     std::vector<datum_t> data;
 };
 
+/* Sorts a sequence that may be too large to fit into memory.  The caller hands
+over the rows in chunks of at most the array size limit.  `spill_run()` sorts a
+chunk and writes it to a temporary file, and `finish()` sorts the last chunk, which
+stays in memory.  Whenever enough runs have piled up on disk, `spill_run()` merges
+the newest of them into a single run, so the number of open temporary files stays
+bounded.  Reading the stream then merges the remaining runs lazily, keeping only the
+next row of each run in memory.  Rows that compare equal come out in the order they
+were handed over in, like with `std::stable_sort`.
+
+Every spilled run is a `disk_backed_queue_t` with its own file, serializer and 2 MB
+cache.  Merges of the same level happen at a fan-in of 16, so there are at most 15
+runs per level, and no more than 64 runs are ever kept, plus the one a merge is
+writing to.  A sort therefore holds at most 65 temporary files open and uses at most
+about 130 MB of cache, no matter how many rows it sorts, on top of the two chunks of
+rows it keeps in memory. */
+class external_sort_datum_stream_t : public eager_datum_stream_t {
+public:
+    external_sort_datum_stream_t(io_backender_t *io_backender,
+                                 const base_path_t &base_path,
+                                 lt_cmp_t lt_cmp,
+                                 backtrace_id_t bt);
+    ~external_sort_datum_stream_t();
+
+    // Sorts `rows`, writes them to a new run, and clears `rows`.
+    void spill_run(env_t *env, std::vector<datum_t> *rows);
+    // Sorts `rows` and keeps them as the last run.  Must be called exactly once,
+    // after the last `spill_run()` and before the stream is read.
+    void finish(env_t *env, std::vector<datum_t> &&rows);
+
+    bool is_exhausted() const final;
+    feed_type_t cfeed_type() const final { return feed_type_t::not_feed; }
+    bool is_infinite() const final { return false; }
+
+    // How many runs are currently on disk.  Used by the unit tests.
+    size_t num_spilled_runs() const { return spilled_runs.size(); }
+
+private:
+    struct run_t;
+    struct merge_item_t {
+        datum_t value;
+        size_t run;
+    };
+    class merge_greater_t;
+
+    bool is_array() const final { return false; }
+    std::vector<datum_t>
+    next_raw_batch(env_t *env, const batchspec_t &batchspec) final;
+
+    // Creates an empty run with a new temporary file.
+    scoped_ptr_t<run_t> new_run(size_t level);
+    // Merges `spilled_runs[first]` and all runs after it into a single run.
+    void merge_runs(env_t *env, size_t first);
+    // Returns the next row of the given run, or an empty `datum_t` if it's done.
+    datum_t next_in_run(size_t run);
+
+    io_backender_t *const io_backender;
+    const base_path_t base_path;
+    const lt_cmp_t lt;
+
+    std::vector<scoped_ptr_t<run_t> > spilled_runs;
+    std::vector<datum_t> last_run;
+    size_t last_run_index;
+
+    // A heap with the next row of every run that isn't done yet.
+    std::vector<merge_item_t> heads;
+    bool finished;
+};
+
 struct coro_info_t;
 class coro_stream_t;
 
@@ -136,6 +136,39 @@ scoped_ptr_t<val_t> js_func_t::call(
     }
 }
 
+std::vector<js_result_t> js_func_t::call_batch(
+        env_t *env, const std::vector<datum_t> &rows) const {
+    js_runner_t::req_config_t config;
+    config.timeout_ms = js_timeout_ms;
+
+    r_sanity_check(!js_source.empty());
+    std::vector<std::vector<datum_t> > args_batch;
+    args_batch.reserve(rows.size());
+    for (const datum_t &row : rows) {
+        args_batch.push_back(make_vector(row));
+    }
+
+    try {
+        return env->get_js_runner()->call_batch(js_source, args_batch, config);
+    } catch (const extproc_worker_exc_t &e) {
+        rfail(base_exc_t::INTERNAL,
+              "Javascript query `%s` caused a crash in a worker process.",
+              js_source.c_str());
+        unreachable();
+    }
+}
+
+scoped_ptr_t<val_t> js_func_t::result_to_val(const js_result_t &result) const {
+    try {
+        return scoped_ptr_t<val_t>(
+                boost::apply_visitor(
+                        js_result_visitor_t(js_source, js_timeout_ms, this), result));
+    } catch (const datum_exc_t &e) {
+        rfail(e.get_type(), "%s", e.what());
+        unreachable();
+    }
+}
+
 boost::optional<size_t> js_func_t::arity() const {
     return boost::none;
 }
@@ -318,13 +351,20 @@ bool js_func_t::filter_helper(env_t *env, datum_t arg) const {
 }
 
 bool func_t::filter_call(env_t *env, datum_t arg, counted_t<const func_t> default_filter_val) const {
+    return filter_call_with_default(
+        env, [&]() { return filter_helper(env, arg); }, default_filter_val);
+}
+
+bool func_t::filter_call_with_default(env_t *env,
+                                      const std::function<bool()> &filter_fn,
+                                      counted_t<const func_t> default_filter_val) {
     // We have to catch every exception type and save it so we can rethrow it later
     // So we don't trigger a coroutine wait in a catch statement
     std::exception_ptr saved_exception;
     base_exc_t::type_t exception_type;
 
     try {
-        return filter_helper(env, arg);
+        return filter_fn();
     } catch (const base_exc_t &e) {
         saved_exception = std::current_exception();
         exception_type = e.get_type();
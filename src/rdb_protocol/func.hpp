@@ -2,6 +2,7 @@
 #ifndef RDB_PROTOCOL_FUNC_HPP_
 #define RDB_PROTOCOL_FUNC_HPP_
 
+#include <functional>
 #include <map>
 #include <string>
 #include <utility>
@@ -25,7 +26,9 @@ class js_runner_t;
 
 namespace ql {
 
+class compiled_func_builder_t;
 class func_visitor_t;
+class row_projection_builder_t;
 
 class func_t : public slow_atomic_countable_t<func_t>, public bt_rcheckable_t {
 public:
@@ -70,6 +73,12 @@ public:
         return false;
     }
 
+    // Like `filter_call()`, but gets the result of the filter function from
+    // `filter_fn`.
+    static bool filter_call_with_default(env_t *env,
+                                         const std::function<bool()> &filter_fn,
+                                         counted_t<const func_t> default_filter_val);
+
 protected:
     explicit func_t(backtrace_id_t bt);
 
@@ -112,6 +121,8 @@ public:
 
 private:
     template <cluster_version_t> friend class wire_func_serialization_visitor_t;
+    friend class compiled_func_builder_t;
+    friend class row_projection_builder_t;
     bool filter_helper(env_t *env, datum_t arg) const;
 
     // Only contains the parts of the scope that `body` uses.
@@ -152,6 +163,15 @@ public:
 
     void visit(func_visitor_t *visitor) const;
 
+    // Calls the function once for each of the rows, sending all of them to the
+    // JavaScript worker process in a single message instead of paying for a round
+    // trip per row. The results are turned into values with `result_to_val()`, which
+    // raises the error if the call for that row failed. If a row fails, the results
+    // may stop after it.
+    std::vector<js_result_t> call_batch(env_t *env,
+                                        const std::vector<datum_t> &rows) const;
+    scoped_ptr_t<val_t> result_to_val(const js_result_t &result) const;
+
 private:
     template <cluster_version_t> friend class wire_func_serialization_visitor_t;
     bool filter_helper(env_t *env, datum_t arg) const;
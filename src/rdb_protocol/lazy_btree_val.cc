@@ -4,8 +4,15 @@
 #include "containers/archive/buffer_group_stream.hpp"
 #include "containers/archive/versioned.hpp"
 #include "rdb_protocol/blob_wrapper.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 
-ql::datum_t get_data(const rdb_value_t *value, buf_parent_t parent) {
+// Below this size, copying the whole value is cheaper than looking up fields in it
+// one by one.
+const int64_t MIN_PROJECTED_VALUE_SIZE = KILOBYTE;
+
+ql::datum_t get_data(const rdb_value_t *value,
+                     buf_parent_t parent,
+                     const std::vector<datum_string_t> *projection) {
     // TODO: Just use deserialize_from_blob?
     rdb_blob_wrapper_t blob(parent.cache()->max_block_size(),
                             const_cast<rdb_value_t *>(value)->value_ref(),
@@ -16,6 +23,13 @@ ql::datum_t get_data(const rdb_value_t *value, buf_parent_t parent) {
     blob_acq_t acq_group;
     buffer_group_t buffer_group;
     blob.expose_all(parent, access_t::read, &buffer_group, &acq_group);
+    if (projection != NULL && value->value_size() >= MIN_PROJECTED_VALUE_SIZE) {
+        data = ql::datum_deserialize_projection(const_view(&buffer_group),
+                                                *projection);
+        if (data.has()) {
+            return data;
+        }
+    }
     buffer_group_read_stream_t read_stream(const_view(&buffer_group));
     archive_result_t res
         = datum_deserialize(&read_stream, &data);
@@ -27,7 +41,8 @@ ql::datum_t get_data(const rdb_value_t *value, buf_parent_t parent) {
 const ql::datum_t &lazy_btree_val_t::get() const {
     guarantee(pointee.has());
     if (!pointee->ptr.has()) {
-        pointee->ptr = get_data(pointee->rdb_value, pointee->parent);
+        pointee->ptr = get_data(pointee->rdb_value, pointee->parent,
+                                pointee->projection);
         pointee->rdb_value = NULL;
         pointee->parent = buf_parent_t();
     }
@@ -2,6 +2,8 @@
 #ifndef RDB_PROTOCOL_LAZY_BTREE_VAL_HPP_
 #define RDB_PROTOCOL_LAZY_BTREE_VAL_HPP_
 
+#include <vector>
+
 #include "buffer_cache/alt.hpp"
 #include "buffer_cache/blob.hpp"
 #include "rdb_protocol/datum.hpp"
@@ -27,18 +29,23 @@ public:
     }
 };
 
+// If `projection` is non-NULL, the result may be an object with only those fields of
+// the value (see `ql::datum_deserialize_projection`).  The whole value is returned if
+// it isn't an object or lacks any of the fields.
 ql::datum_t get_data(const rdb_value_t *value,
-                     buf_parent_t parent);
+                     buf_parent_t parent,
+                     const std::vector<datum_string_t> *projection = NULL);
 
 class lazy_btree_val_pointee_t
         : public single_threaded_countable_t<lazy_btree_val_pointee_t> {
-    lazy_btree_val_pointee_t(const rdb_value_t *_rdb_value, buf_parent_t _parent)
-        : rdb_value(_rdb_value), parent(_parent) {
+    lazy_btree_val_pointee_t(const rdb_value_t *_rdb_value, buf_parent_t _parent,
+                             const std::vector<datum_string_t> *_projection)
+        : rdb_value(_rdb_value), parent(_parent), projection(_projection) {
         guarantee(rdb_value != NULL);
     }
 
     explicit lazy_btree_val_pointee_t(const ql::datum_t &_ptr)
-        : ptr(_ptr), rdb_value(NULL), parent() {
+        : ptr(_ptr), rdb_value(NULL), parent(), projection(NULL) {
         guarantee(ptr.has());
     }
 
@@ -52,6 +59,9 @@ class lazy_btree_val_pointee_t
     const rdb_value_t *rdb_value;
     buf_parent_t parent;
 
+    // The fields to load, if only some of them are needed.  Owned by the caller.
+    const std::vector<datum_string_t> *projection;
+
     DISABLE_COPYING(lazy_btree_val_pointee_t);
 };
 
@@ -60,8 +70,11 @@ public:
     explicit lazy_btree_val_t(const ql::datum_t &ptr)
         : pointee(new lazy_btree_val_pointee_t(ptr)) { }
 
-    lazy_btree_val_t(const rdb_value_t *rdb_value, buf_parent_t parent)
-        : pointee(new lazy_btree_val_pointee_t(rdb_value, parent)) { }
+    // If `projection` is non-NULL, `get()` may return an object with only those
+    // fields of the row.  `projection` has to outlive the loading of the value.
+    lazy_btree_val_t(const rdb_value_t *rdb_value, buf_parent_t parent,
+                     const std::vector<datum_string_t> *projection = NULL)
+        : pointee(new lazy_btree_val_pointee_t(rdb_value, parent, projection)) { }
 
     const ql::datum_t &get() const;
     bool references_parent() const;
@@ -252,8 +252,7 @@ void post_construct_and_drain_queue(
             // Pretend that the indexes in `sindexes` have been post-constructed up to
             // the new range. This is important to make the call to
             // `rdb_update_sindexes()` below actually update the indexes.
-            // We use the same trick in the `post_construct_traversal_helper_t`.
-            // TODO: Avoid this hackery (here and in `post_construct_traversal_helper_t`)
+            // TODO: Avoid this hackery
             for (auto &&access : sindexes) {
                 access->sindex.needs_post_construction_range = *construction_range_inout;
             }
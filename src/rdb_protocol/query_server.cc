@@ -34,6 +34,7 @@ void rdb_query_server_t::run_query(ql::query_params_t *query_params,
                                    signal_t *interruptor) {
     guarantee(interruptor != nullptr);
     guarantee(rdb_ctx->cluster_interface != nullptr);
+    ticks_t start_ticks = get_ticks();
     try {
         // TODO: make this perfmon correct now that we have parallelized queries
         scoped_perfmon_counter_t client_active(&rdb_ctx->stats.clients_active);
@@ -79,6 +80,11 @@ void rdb_query_server_t::run_query(ql::query_params_t *query_params,
 
     rdb_ctx->stats.queries_per_sec.record();
     ++rdb_ctx->stats.queries_total;
+    // `CONTINUE`s on changefeeds wait for changes for as long as it takes, so we
+    // only count how long it takes to answer a `START`.
+    if (query_params->type == Query::START) {
+        rdb_ctx->stats.query_latency.record(get_ticks() - start_ticks);
+    }
 }
 
 void rdb_query_server_t::fill_server_info(ql::response_t *out) {
@@ -0,0 +1,184 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/row_projection.hpp"
+
+#include <set>
+
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/ql2.pb.h"
+#include "rdb_protocol/term_storage.hpp"
+
+namespace ql {
+
+// Collects the fields that a single-argument function reads from its argument.
+// Fails as soon as the argument is used for anything else, since the function
+// might then notice that the other fields are missing.
+class row_projection_builder_t : public func_visitor_t {
+public:
+    row_projection_builder_t(bool _is_filter, std::set<datum_string_t> *_fields)
+        : is_filter(_is_filter), fields(_fields), ok(false) { }
+
+    void on_reql_func(const reql_func_t *reql_func) {
+        if (reql_func->arg_names.size() != 1) {
+            return;
+        }
+        arg_name = reql_func->arg_names[0];
+        var_visibility_t captured_visibility =
+            reql_func->captured_scope.compute_visibility();
+        if (captured_visibility.contains_var(arg_name)) {
+            return;
+        }
+        implicit_is_arg =
+            function_emits_implicit_variable(reql_func->arg_names)
+            && captured_visibility.get_implicit_depth() == 0;
+        raw_term_t body = reql_func->body->get_src();
+        // `reql_func_t::filter_helper` matches an object literal against the whole
+        // row.
+        if (is_filter
+            && (body.type() == Term::MAKE_OBJ || body.type() == Term::DATUM)) {
+            return;
+        }
+        ok = walk(body, 0);
+    }
+
+    void on_js_func(const js_func_t *) { }
+
+    bool succeeded() const { return ok; }
+
+private:
+    bool is_arg(const raw_term_t &term, size_t func_depth) const {
+        if (term.type() == Term::IMPLICIT_VAR) {
+            return func_depth == 0 && implicit_is_arg;
+        }
+        if (term.type() != Term::VAR
+            || term.num_args() != 1
+            || term.arg(0).type() != Term::DATUM) {
+            return false;
+        }
+        datum_t name = term.arg(0).datum();
+        int64_t name_value;
+        return name.get_type() == datum_t::R_NUM
+            && number_as_integer(name.as_num(), &name_value)
+            && name_value == arg_name.value;
+    }
+
+    bool add_literal_field(const raw_term_t &term) {
+        if (term.type() != Term::DATUM) {
+            return false;
+        }
+        datum_t field = term.datum();
+        if (field.get_type() != datum_t::R_STR) {
+            return false;
+        }
+        fields->insert(field.as_str());
+        return true;
+    }
+
+    bool walk(const raw_term_t &term, size_t func_depth) {
+        switch (static_cast<int>(term.type())) {
+        case Term::VAR:
+            return !is_arg(term, func_depth);
+        case Term::IMPLICIT_VAR:
+            // We don't bother figuring out which function `r.row` belongs to
+            // unless it's directly used to read a field.
+            return false;
+        case Term::GET_FIELD: // fallthru
+        case Term::BRACKET:
+            if (term.num_args() == 2
+                && term.num_optargs() == 0
+                && is_arg(term.arg(0), func_depth)) {
+                // `BRACKET` with a number is `nth`, which `add_literal_field`
+                // rejects.
+                return add_literal_field(term.arg(1));
+            }
+            break;
+        case Term::PLUCK: // fallthru
+        case Term::WITH_FIELDS: // fallthru
+        case Term::HAS_FIELDS:
+            if (term.num_args() >= 2 && is_arg(term.arg(0), func_depth)) {
+                for (size_t i = 1; i < term.num_args(); ++i) {
+                    if (!add_literal_field(term.arg(i))) {
+                        return false;
+                    }
+                }
+                return walk_optargs(term, func_depth);
+            }
+            break;
+        case Term::FUNC:
+            func_depth += 1;
+            break;
+        default:
+            break;
+        }
+        for (size_t i = 0; i < term.num_args(); ++i) {
+            if (!walk(term.arg(i), func_depth)) {
+                return false;
+            }
+        }
+        return walk_optargs(term, func_depth);
+    }
+
+    bool walk_optargs(const raw_term_t &term, size_t func_depth) {
+        bool res = true;
+        term.each_optarg([&](const raw_term_t &optarg, const std::string &) {
+            res = res && walk(optarg, func_depth);
+        });
+        return res;
+    }
+
+    const bool is_filter;
+    std::set<datum_string_t> *const fields;
+    bool ok;
+    sym_t arg_name;
+    bool implicit_is_arg;
+};
+
+bool collect_row_fields(const counted_t<const func_t> &func,
+                        bool is_filter,
+                        std::set<datum_string_t> *fields) {
+    row_projection_builder_t builder(is_filter, fields);
+    func->visit(&builder);
+    return builder.succeeded();
+}
+
+boost::optional<std::vector<datum_string_t> > infer_row_projection(
+        const std::vector<transform_variant_t> &transforms,
+        const boost::optional<terminal_variant_t> &terminal) {
+    std::set<datum_string_t> fields;
+    bool mapped = false;
+    for (const transform_variant_t &transform : transforms) {
+        if (const map_wire_func_t *map = boost::get<map_wire_func_t>(&transform)) {
+            if (!collect_row_fields(map->compile_wire_func(), false, &fields)) {
+                return boost::none;
+            }
+            mapped = true;
+        } else if (const concatmap_wire_func_t *concatmap =
+                       boost::get<concatmap_wire_func_t>(&transform)) {
+            if (!collect_row_fields(concatmap->compile_wire_func(), false, &fields)) {
+                return boost::none;
+            }
+            mapped = true;
+        } else if (const filter_wire_func_t *filter =
+                       boost::get<filter_wire_func_t>(&transform)) {
+            // The default value is called without an argument.
+            if (!collect_row_fields(filter->filter_func.compile_wire_func(),
+                                    true, &fields)) {
+                return boost::none;
+            }
+        } else {
+            return boost::none;
+        }
+        if (mapped) {
+            // Nothing after this sees the rows.
+            break;
+        }
+    }
+    // Without a `map`, the rows themselves reach the terminal, or get returned if
+    // there is none.  Only `count` doesn't look at them.
+    if (!mapped
+        && (!terminal || boost::get<count_wire_func_t>(&*terminal) == nullptr)) {
+        return boost::none;
+    }
+    return std::vector<datum_string_t>(fields.begin(), fields.end());
+}
+
+}  // namespace ql
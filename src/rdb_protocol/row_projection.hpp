@@ -0,0 +1,31 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_ROW_PROJECTION_HPP_
+#define RDB_PROTOCOL_ROW_PROJECTION_HPP_
+
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/optional.hpp>
+
+#include "rdb_protocol/datum_string.hpp"
+#include "rdb_protocol/shards.hpp"
+
+namespace ql {
+
+// Works out which top-level fields of each row a range scan's `transforms` and
+// `terminal` can look at, so that the scan only has to deserialize those.  This is
+// the case if the transforms are any number of `filter`s followed by a `map` or a
+// `concat_map` (or by a `count`), and if their functions only use the row to read
+// fields with literal names from it, e.g. through `pluck`, `with_fields` or
+// `r.row('field')`.
+//
+// Returns `boost::none` if the rows may be used as a whole.  Otherwise giving the
+// functions an object with only the returned fields has the same result as giving
+// them the whole row, as long as none of the fields is missing from the row.
+boost::optional<std::vector<datum_string_t> > infer_row_projection(
+        const std::vector<transform_variant_t> &transforms,
+        const boost::optional<terminal_variant_t> &terminal);
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_ROW_PROJECTION_HPP_
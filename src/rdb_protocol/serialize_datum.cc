@@ -1,6 +1,9 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/serialize_datum.hpp"
 
+#include <string.h>
+
+#include <algorithm>
 #include <cmath>
 #include <functional>
 #include <limits>
@@ -11,6 +14,7 @@
 #include "containers/archive/buffer_stream.hpp"
 #include "containers/archive/stl_types.hpp"
 #include "containers/archive/versioned.hpp"
+#include "containers/buffer_group.hpp"
 #include "containers/counted.hpp"
 #include "containers/shared_buffer.hpp"
 #include "rdb_protocol/datum.hpp"
@@ -264,6 +268,18 @@ size_t datum_array_serialized_size(const datum_t &datum,
         // We don't initialize element_sizes_out, but that's ok. We don't need it
         // if there already is a serialization.
         sz += read_inner_serialized_size_from_buf(*existing_buf_ref);
+    } else if (element_sizes_out == NULL) {
+        // Nobody is going to serialize the datum based on our result, so we don't
+        // have to build up the tree of sizes. That saves a lot of allocations for
+        // large documents.
+        size_t elem_sz = 0;
+        for (size_t i = 0; i < datum.arr_size(); ++i) {
+            elem_sz += datum_serialized_size(datum.get(i), check_errors, NULL);
+        }
+        datum_offset_size_t offset_size;
+        sz += elem_sz + offset_table_serialized_size(datum.arr_size(),
+                                                     elem_sz,
+                                                     &offset_size);
     } else {
         std::vector<size_tree_node_t> elem_sizes;
         elem_sizes.reserve(datum.arr_size());
@@ -277,9 +293,7 @@ size_t datum_array_serialized_size(const datum_t &datum,
         datum_offset_size_t offset_size;
         sz += datum_array_inner_serialized_size(datum, elem_sizes, &offset_size);
 
-        if (element_sizes_out != NULL) {
-            *element_sizes_out = std::move(elem_sizes);
-        }
+        *element_sizes_out = std::move(elem_sizes);
     }
 
     // The inner serialized size
@@ -369,6 +383,18 @@ size_t datum_object_serialized_size(const datum_t &datum,
         // We don't initialize element_sizes_out, but that's ok. We don't need it
         // if there already is a serialization.
         sz += read_inner_serialized_size_from_buf(*existing_buf_ref);
+    } else if (child_sizes_out == NULL) {
+        // See the comment in `datum_array_serialized_size`.
+        size_t elem_sz = 0;
+        for (size_t i = 0; i < datum.obj_size(); ++i) {
+            auto pair = datum.get_pair(i);
+            elem_sz += datum_serialized_size(pair.first);
+            elem_sz += datum_serialized_size(pair.second, check_errors, NULL);
+        }
+        datum_offset_size_t offset_size;
+        sz += elem_sz + offset_table_serialized_size(datum.obj_size(),
+                                                     elem_sz,
+                                                     &offset_size);
     } else {
         std::vector<size_tree_node_t> child_sizes;
         child_sizes.reserve(datum.obj_size() * 2);
@@ -385,9 +411,7 @@ size_t datum_object_serialized_size(const datum_t &datum,
         datum_offset_size_t offset_size;
         sz += datum_array_inner_serialized_size(datum, child_sizes, &offset_size);
 
-        if (child_sizes_out != NULL) {
-            *child_sizes_out = std::move(child_sizes);
-        }
+        *child_sizes_out = std::move(child_sizes);
     }
 
     // The inner serialized size
@@ -866,6 +890,182 @@ std::pair<datum_string_t, datum_t> datum_deserialize_pair_from_buf(
     return std::make_pair(std::move(key), std::move(value));
 }
 
+// Random access into a serialization that is spread over the buffers of a buffer
+// group, as it is when a value has been exposed from a blob.
+class buffer_group_reader_t {
+public:
+    explicit buffer_group_reader_t(const const_buffer_group_t *_group)
+        : group(_group) { }
+
+    // Copies up to `n` bytes starting at `offset` to `out`, and returns how many
+    // bytes were copied.  That is only less than `n` at the end of the group.
+    size_t read(size_t offset, size_t n, char *out) const {
+        size_t copied = 0;
+        size_t buf_start = 0;
+        for (size_t i = 0; i < group->num_buffers() && copied < n; ++i) {
+            const const_buffer_group_t::buffer_t buf = group->get_buffer(i);
+            const size_t buf_size = static_cast<size_t>(buf.size);
+            const size_t pos = offset + copied;
+            if (pos < buf_start + buf_size) {
+                const size_t chunk = std::min(n - copied, buf_start + buf_size - pos);
+                memcpy(out + copied,
+                       static_cast<const char *>(buf.data) + (pos - buf_start),
+                       chunk);
+                copied += chunk;
+            }
+            buf_start += buf_size;
+        }
+        return copied;
+    }
+
+    uint64_t read_varint(size_t *offset_inout) const {
+        // A varint takes at most 10 bytes for 64 bits.
+        char tmp[10];
+        const size_t n = read(*offset_inout, sizeof(tmp), tmp);
+        buffer_read_stream_t s(tmp, n);
+        uint64_t res;
+        guarantee_deserialization(deserialize_varint_uint64(&s, &res),
+                                  "datum projection varint");
+        *offset_inout += static_cast<size_t>(s.tell());
+        return res;
+    }
+
+    template <class T>
+    uint64_t read_universal(size_t offset) const {
+        char tmp[serialize_universal_size_t<T>::value];
+        guarantee(read(offset, sizeof(tmp), tmp) == sizeof(tmp),
+                  "Corrupted datum in storage (offset table out of range).");
+        buffer_read_stream_t s(tmp, sizeof(tmp));
+        T res;
+        guarantee_deserialization(deserialize_universal(&s, &res),
+                                  "datum projection offset");
+        return res;
+    }
+
+private:
+    const const_buffer_group_t *group;
+};
+
+// Keep in sync with datum_object_serialize.
+// Keep in sync with datum_get_element_offset.
+datum_t datum_deserialize_projection(const const_buffer_group_t *group,
+                                     const std::vector<datum_string_t> &fields) {
+    buffer_group_reader_t reader(group);
+
+    char type_byte;
+    if (reader.read(0, 1, &type_byte) != 1) {
+        return datum_t();
+    }
+    datum_serialized_type_t type;
+    {
+        buffer_read_stream_t s(&type_byte, 1);
+        guarantee_deserialization(datum_deserialize(&s, &type), "datum type");
+    }
+    if (type != datum_serialized_type_t::BUF_R_OBJECT) {
+        return datum_t();
+    }
+
+    size_t pos = 1;
+    const uint64_t ser_size = reader.read_varint(&pos);
+    const size_t inner_end = pos + static_cast<size_t>(ser_size);
+    const datum_offset_size_t offset_size = get_offset_size_from_inner_size(ser_size);
+    const size_t num_elements = static_cast<size_t>(reader.read_varint(&pos));
+    const size_t offset_table = pos;
+    size_t serialized_offset_size;
+    switch (offset_size) {
+    case datum_offset_size_t::U8BIT:
+        serialized_offset_size = serialize_universal_size_t<uint8_t>::value; break;
+    case datum_offset_size_t::U16BIT:
+        serialized_offset_size = serialize_universal_size_t<uint16_t>::value; break;
+    case datum_offset_size_t::U32BIT:
+        serialized_offset_size = serialize_universal_size_t<uint32_t>::value; break;
+    case datum_offset_size_t::U64BIT:
+        serialized_offset_size = serialize_universal_size_t<uint64_t>::value; break;
+    default:
+        unreachable();
+    }
+    const size_t data_offset = num_elements == 0
+        ? offset_table
+        : offset_table + (num_elements - 1) * serialized_offset_size;
+
+    // The offset of the pair with the given index, or the end of the object.
+    auto pair_offset = [&](size_t index) -> size_t {
+        if (index == 0) {
+            return data_offset;
+        } else if (index == num_elements) {
+            return inner_end;
+        }
+        const size_t at = offset_table + (index - 1) * serialized_offset_size;
+        uint64_t offset;
+        switch (offset_size) {
+        case datum_offset_size_t::U8BIT:
+            offset = reader.read_universal<uint8_t>(at); break;
+        case datum_offset_size_t::U16BIT:
+            offset = reader.read_universal<uint16_t>(at); break;
+        case datum_offset_size_t::U32BIT:
+            offset = reader.read_universal<uint32_t>(at); break;
+        case datum_offset_size_t::U64BIT:
+            offset = reader.read_universal<uint64_t>(at); break;
+        default:
+            unreachable();
+        }
+        return data_offset + static_cast<size_t>(offset);
+    };
+
+    // The same binary search as `datum_t::get_field`, except that only the keys
+    // we probe get copied out of the buffer group.  Sets `*value_begin_out` and
+    // `*value_end_out` to the extent of the field's serialized value.
+    auto find_field = [&](const datum_string_t &field,
+                          size_t *value_begin_out, size_t *value_end_out) -> bool {
+        size_t range_beg = 0;
+        size_t range_end = num_elements;
+        std::vector<char> key_buf;
+        while (range_beg < range_end) {
+            const size_t center = range_beg + ((range_end - range_beg) / 2);
+            size_t key_pos = pair_offset(center);
+            const size_t key_size = static_cast<size_t>(reader.read_varint(&key_pos));
+            key_buf.resize(key_size);
+            guarantee(reader.read(key_pos, key_size, key_buf.data()) == key_size,
+                      "Corrupted datum in storage (key out of range).");
+            const int cmp_res = field.compare(datum_string_t(key_size, key_buf.data()));
+            if (cmp_res == 0) {
+                *value_begin_out = key_pos + key_size;
+                *value_end_out = pair_offset(center + 1);
+                return true;
+            } else if (cmp_res < 0) {
+                range_end = center;
+            } else {
+                range_beg = center + 1;
+            }
+        }
+        return false;
+    };
+
+    size_t value_begin, value_end;
+    if (find_field(datum_t::reql_type_string, &value_begin, &value_end)) {
+        // Dropping fields from a pseudotype could change what it is.
+        return datum_t();
+    }
+
+    datum_object_builder_t builder;
+    for (const datum_string_t &field : fields) {
+        if (!find_field(field, &value_begin, &value_end)) {
+            return datum_t();
+        }
+        guarantee(value_begin < value_end,
+                  "Corrupted datum in storage (empty value).");
+        const size_t value_size = value_end - value_begin;
+        counted_t<shared_buf_t> buf = shared_buf_t::create(value_size);
+        guarantee(reader.read(value_begin, value_size, buf->data()) == value_size,
+                  "Corrupted datum in storage (value out of range).");
+        datum_t value = datum_deserialize_from_buf(
+            shared_buf_ref_t<char>(std::move(buf), 0), 0);
+        // Duplicate fields are harmless, they just get the same value twice.
+        builder.overwrite(field, std::move(value));
+    }
+    return std::move(builder).to_datum();
+}
+
 /* The format of `array` is:
      varint ser_size
      varint num_elements
@@ -2,6 +2,7 @@
 #define RDB_PROTOCOL_SERIALIZE_DATUM_HPP_
 
 #include <utility>
+#include <vector>
 
 #include "containers/archive/archive.hpp"
 #include "containers/archive/buffer_group_stream.hpp"
@@ -53,6 +54,14 @@ datum_t datum_deserialize_from_buf(const shared_buf_ref_t<char> &buf, size_t at_
 std::pair<datum_string_t, datum_t> datum_deserialize_pair_from_buf(
         const shared_buf_ref_t<char> &buf, size_t at_offset);
 
+// Deserializes only the given top-level `fields` of the object serialized in
+// `group`, using the object's offset table to skip over everything else.  Returns
+// an empty `datum_t` if the serialization isn't a `BUF_R_OBJECT`, if the object is a
+// pseudotype or if any of `fields` is missing from it; the caller then has to
+// deserialize the whole value instead.
+datum_t datum_deserialize_projection(const const_buffer_group_t *group,
+                                     const std::vector<datum_string_t> &fields);
+
 // Finds the offset of the given array element in the buffer
 size_t datum_get_element_offset(const shared_buf_ref_t<char> &array, size_t index);
 // Reads the number of elements in the array stored in the buffer
@@ -8,6 +8,7 @@
 #include <boost/variant.hpp>
 
 #include "debug.hpp"
+#include "rdb_protocol/compiled_func.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/profile.hpp"
 #include "rdb_protocol/protocol.hpp"
@@ -844,11 +845,36 @@ scoped_ptr_t<accumulator_t> make_terminal(const terminal_variant_t &t) {
             boost::apply_visitor(terminal_visitor_t<accumulator_t>(), t));
 }
 
+void count_terminal_result(uint64_t count, result_t *out) {
+    // Like `count_terminal_t`, we don't produce a group if there were no rows.
+    *out = grouped_t<uint64_t>();
+    if (count != 0) {
+        boost::get<grouped_t<uint64_t> >(*out).insert(std::make_pair(datum_t(), count));
+    }
+}
+
 scoped_ptr_t<eager_acc_t> make_eager_terminal(const terminal_variant_t &t) {
     return scoped_ptr_t<eager_acc_t>(
             boost::apply_visitor(terminal_visitor_t<eager_acc_t>(), t));
 }
 
+size_t op_t::apply_batch(env_t *env,
+                         const std::vector<op_batch_item_t> &items,
+                         std::exception_ptr *error_out) {
+    for (size_t i = 0; i < items.size(); ++i) {
+        try {
+            (*this)(env, items[i].groups, items[i].lazy_sindex_val);
+        } catch (const exc_t &) {
+            *error_out = std::current_exception();
+            return i;
+        } catch (const datum_exc_t &) {
+            *error_out = std::current_exception();
+            return i;
+        }
+    }
+    return items.size();
+}
+
 class ungrouped_op_t : public op_t {
 protected:
 private:
@@ -981,22 +1007,128 @@ private:
     backtrace_id_t bt;
 };
 
-class map_trans_t : public ungrouped_op_t {
+// Returns `f` as a `js_func_t`, or `nullptr` if it's a ReQL function.
+const js_func_t *get_js_func(const counted_t<const func_t> &f) {
+    class js_func_visitor_t : public func_visitor_t {
+    public:
+        js_func_visitor_t() : js_func(nullptr) { }
+        void on_reql_func(const reql_func_t *) { }
+        void on_js_func(const js_func_t *_js_func) { js_func = _js_func; }
+        const js_func_t *js_func;
+    } visitor;
+    f->visit(&visitor);
+    return visitor.js_func;
+}
+
+/* The base class of `map_trans_t` and `filter_trans_t`. If their function is an
+`r.js` function, they evaluate it for many rows at once, either for a whole list in
+`lst_transform()` or for all the documents in `apply_batch()`. The results are then
+taken from `prefetched_result()` in the order in which `lst_transform()` visits the
+rows. */
+class js_batching_op_t : public ungrouped_op_t {
+protected:
+    explicit js_batching_op_t(counted_t<const func_t> _f)
+        : f(std::move(_f)),
+          js_func(get_js_func(f)),
+          prefetched(false),
+          next_result(0) { }
+
+    // Prefetches the results for `rows` while it exists, unless there already are
+    // prefetched results.
+    class prefetch_sentry_t {
+    public:
+        prefetch_sentry_t(js_batching_op_t *_parent, env_t *env, const datums_t &rows)
+            : parent(_parent), owns_results(false) {
+            if (parent->js_func != nullptr && !parent->prefetched && rows.size() > 1) {
+                parent->results = parent->js_func->call_batch(env, rows);
+                parent->prefetched = true;
+                parent->next_result = 0;
+                owns_results = true;
+            }
+        }
+        ~prefetch_sentry_t() {
+            if (owns_results) {
+                parent->results.clear();
+                parent->prefetched = false;
+            }
+        }
+    private:
+        js_batching_op_t *parent;
+        bool owns_results;
+        DISABLE_COPYING(prefetch_sentry_t);
+    };
+
+    // Returns the prefetched result for the next row, or `nullptr` if there is none
+    // and the function has to be called directly.
+    const js_result_t *prefetched_result() {
+        if (!prefetched || next_result >= results.size()) {
+            return nullptr;
+        }
+        return &results[next_result++];
+    }
+
+    const counted_t<const func_t> f;
+    // `nullptr` unless `f` is an `r.js` function.
+    const js_func_t *const js_func;
+
+private:
+    bool is_batchable() const final {
+        return js_func != nullptr;
+    }
+
+    size_t apply_batch(env_t *env,
+                       const std::vector<op_batch_item_t> &items,
+                       std::exception_ptr *error_out) final {
+        datums_t rows;
+        for (const op_batch_item_t &item : items) {
+            for (const auto &pair : *item.groups) {
+                rows.insert(rows.end(), pair.second.begin(), pair.second.end());
+            }
+        }
+        scoped_ptr_t<prefetch_sentry_t> sentry;
+        try {
+            sentry.init(new prefetch_sentry_t(this, env, rows));
+        } catch (const exc_t &) {
+            // The worker process crashed, which would have happened for the first
+            // document if we had processed them one by one.
+            *error_out = std::current_exception();
+            return 0;
+        }
+        return op_t::apply_batch(env, items, error_out);
+    }
+
+    bool prefetched;
+    std::vector<js_result_t> results;
+    size_t next_result;
+};
+
+class map_trans_t : public js_batching_op_t {
 public:
     explicit map_trans_t(const map_wire_func_t &_f)
-        : f(_f.compile_wire_func()) { }
+        : js_batching_op_t(_f.compile_wire_func()),
+          compiled_f(compiled_func_t::compile(f)) { }
 private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const std::function<datum_t()> &) {
         try {
+            prefetch_sentry_t sentry(this, env, *lst);
             for (auto it = lst->begin(); it != lst->end(); ++it) {
-                *it = f->call(env, *it)->as_datum();
+                datum_t res;
+                const js_result_t *js_result;
+                if (compiled_f.has() && compiled_f->eval(*it, &res)) {
+                    *it = std::move(res);
+                } else if ((js_result = prefetched_result()) != nullptr) {
+                    *it = js_func->result_to_val(*js_result)->as_datum();
+                } else {
+                    *it = f->call(env, *it)->as_datum();
+                }
             }
         } catch (const datum_exc_t &e) {
             throw exc_t(e, f->backtrace(), 1);
         }
     }
-    counted_t<const func_t> f;
+    // Empty if `f` can't be compiled.
+    scoped_ptr_t<compiled_func_t> compiled_f;
 };
 
 // Note: this removes duplicates ONLY TO SAVE NETWORK TRAFFIC.  It's possible
@@ -1031,21 +1163,40 @@ private:
 };
 
 
-class filter_trans_t : public ungrouped_op_t {
+class filter_trans_t : public js_batching_op_t {
 public:
     explicit filter_trans_t(const filter_wire_func_t &_f)
-        : f(_f.filter_func.compile_wire_func()),
+        : js_batching_op_t(_f.filter_func.compile_wire_func()),
           default_val(_f.default_filter_val
                       ? _f.default_filter_val->compile_wire_func()
-                      : counted_t<const func_t>()) { }
+                      : counted_t<const func_t>()),
+          compiled_f(compiled_func_t::compile(f)) { }
 private:
+    bool filter_row(env_t *env, const datum_t &row) {
+        datum_t res;
+        if (compiled_f.has() && compiled_f->eval(row, &res)) {
+            // A compiled body never evaluates to an object literal, so this matches
+            // `reql_func_t::filter_helper`.
+            return res.as_bool();
+        }
+        if (const js_result_t *js_result = prefetched_result()) {
+            // This matches `js_func_t::filter_helper`.
+            return func_t::filter_call_with_default(
+                env,
+                [&]() { return js_func->result_to_val(*js_result)->as_datum().as_bool(); },
+                default_val);
+        }
+        return f->filter_call(env, row, default_val);
+    }
+
     virtual void lst_transform(
         env_t *env, datums_t *lst, const std::function<datum_t()> &) {
         auto it = lst->begin();
         auto loc = it;
         try {
+            prefetch_sentry_t sentry(this, env, *lst);
             for (it = lst->begin(); it != lst->end(); ++it) {
-                if (f->filter_call(env, *it, default_val)) {
+                if (filter_row(env, *it)) {
                     std::swap(*loc, *it);
                     ++loc;
                 }
@@ -1055,7 +1206,9 @@ private:
         }
         lst->erase(loc, lst->end());
     }
-    counted_t<const func_t> f, default_val;
+    counted_t<const func_t> default_val;
+    // Empty if `f` can't be compiled.
+    scoped_ptr_t<compiled_func_t> compiled_f;
 };
 
 class concatmap_trans_t : public ungrouped_op_t {
@@ -3,6 +3,7 @@
 #define RDB_PROTOCOL_SHARDS_HPP_
 
 #include <algorithm>
+#include <exception>
 #include <limits>
 #include <map>
 #include <utility>
@@ -356,6 +357,12 @@ typedef boost::variant<map_wire_func_t,
                        zip_wire_func_t
                        > transform_variant_t;
 
+// The data of a single document for `op_t::apply_batch()`.
+struct op_batch_item_t {
+    groups_t *groups;
+    std::function<datum_t()> lazy_sindex_val;
+};
+
 class op_t {
 public:
     op_t() { }
@@ -364,6 +371,18 @@ public:
                             groups_t *groups,
                             // Returns a datum that might be null
                             const std::function<datum_t()> &lazy_sindex_val) = 0;
+
+    // Whether `apply_batch()` is cheaper than applying the op to one document at a
+    // time. That's the case for ops that call an `r.js` function, which costs a
+    // round trip to a worker process per call otherwise.
+    virtual bool is_batchable() const { return false; }
+
+    // Applies the op to several documents, in order. If it fails for one of them, it
+    // stops there, stores the error in `*error_out` and returns the index of that
+    // document. Otherwise it returns `items.size()`.
+    virtual size_t apply_batch(env_t *env,
+                               const std::vector<op_batch_item_t> &items,
+                               std::exception_ptr *error_out);
 };
 
 struct limit_read_t {
@@ -428,6 +447,9 @@ scoped_ptr_t<accumulator_t> make_append(region_t region,
                                         require_sindexes_t require_sindex_val);
 scoped_ptr_t<accumulator_t> make_unsharding_append();
 scoped_ptr_t<accumulator_t> make_terminal(const terminal_variant_t &t);
+// Sets `*out` to what the `count` terminal produces for `count` rows. This lets the
+// B-tree count the keys in a range without handing every row to the terminal.
+void count_terminal_result(uint64_t count, result_t *out);
 scoped_ptr_t<eager_acc_t> make_to_array();
 scoped_ptr_t<eager_acc_t> make_eager_terminal(const terminal_variant_t &t);
 scoped_ptr_t<op_t> make_op(const transform_variant_t &tv);
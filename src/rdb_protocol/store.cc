@@ -1077,6 +1077,10 @@ std::pair<ql::changefeed::server_t *, auto_drainer_t::lock_t>
     auto it = changefeed_servers.insert(
         std::make_pair(
             region_t(_region),
-            make_scoped<ql::changefeed::server_t>(ctx->manager, this))).first;
+            make_scoped<ql::changefeed::server_t>(
+                ctx->manager,
+                this,
+                ctx->changefeed_batch_window_ms,
+                ctx->changefeed_batch_max_msgs))).first;
     return std::make_pair(it->second.get(), it->second->get_keepalive());
 }
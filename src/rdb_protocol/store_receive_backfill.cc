@@ -19,6 +19,11 @@ flushing our changes out to disk. This prevents the backfill from using too much
 cache's unsaved data limit, which would slow down queries on other shards. */
 static const int MAX_UNSAVED_CHANGES = 1000;
 
+/* `MAX_BULK_LOAD_PAIRS_PER_TXN` is the maximum number of keys we'll write in a single
+transaction when the range we're backfilling into is empty (see `apply_bulk_items()`).
+It must not be larger than `MAX_UNSAVED_CHANGES`. */
+static const int MAX_BULK_LOAD_PAIRS_PER_TXN = 128;
+
 void flush_cache(cache_conn_t *cache, UNUSED signal_t *interruptor) {
     scoped_ptr_t<txn_t> txn;
     {
@@ -382,6 +387,113 @@ void apply_multi_key_item(
     }
 }
 
+/* `apply_bulk_items()` is used instead of `apply_single_key_item()` and
+`apply_multi_key_item()` if there were no keys in the range that we're backfilling into
+when the backfill started, as is the case when we're adding a new replica. Since there's
+nothing to erase, it can apply the pairs of a whole batch of consecutive backfill items
+in one transaction. This way we acquire the superblock, the sindex block and the
+secondary index superblocks once per batch instead of once per key.
+The pairs are still inserted from the root down rather than by building leaves and
+internal nodes bottom-up. The range we receive is usually only part of the store's key
+space, so its subtree would have to be spliced into a B-tree that already holds the
+other ranges, with internal nodes split along the range boundary. The B-tree code has no
+such operation, and the backfilled part of the range takes live writes while we go. The
+secondary indexes are not bulk-built from sorted keys either: they interleave the rows
+of every range of the store, so there is no empty subtree to build, and the entries of a
+batch are few enough that sorting them wouldn't improve locality. */
+void apply_bulk_items(
+        const receive_backfill_tokens_t &tokens,
+        /* `items` is conceptually passed by move, but `std::bind()` isn't smart enough
+        to handle that. */
+        std::vector<backfill_item_t> &items   // NOLINT runtime/references
+        ) {
+    guarantee(!items.empty());
+    try {
+        scoped_ptr_t<txn_t> txn;
+        buf_lock_t sindex_block;
+        std::vector<rdb_modification_report_t> mod_reports;
+        {
+            fifo_enforcer_sink_t::exit_write_t exiter(
+                &tokens.info->btree_fifo_sink, tokens.write_token);
+            wait_interruptible(&exiter, tokens.keepalive.get_drain_signal());
+
+            size_t num_pairs = 0;
+            for (const backfill_item_t &item : items) {
+                num_pairs += item.pairs.size();
+            }
+            tokens.info->limiter->prepare_for_changes(
+                std::max<size_t>(num_pairs, 1), tokens.keepalive.get_drain_signal());
+
+            /* We must not throw within the transaction. So we check the drain signal
+            now. */
+            if (tokens.keepalive.get_drain_signal()->is_pulsed()) {
+                throw interrupted_exc_t();
+            }
+            cond_t non_interruptor;
+
+            scoped_ptr_t<real_superblock_t> superblock;
+            get_btree_superblock_and_txn_for_writing(tokens.info->cache_conn, nullptr,
+                write_access_t::write, 1, write_durability_t::SOFT, &superblock, &txn);
+
+            rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+            for (backfill_item_t &item : items) {
+                if (!item.is_single_key()) {
+                    btree_receive_backfill_item_update_deletion_timestamps(
+                        superblock.get(), release_superblock_t::KEEP, &sizer, item,
+                        &non_interruptor);
+                }
+                for (backfill_item_t::pair_t &pair : item.pairs) {
+                    promise_t<superblock_t *> pass_back_superblock;
+                    apply_item_pair(tokens.info->slice, superblock.get(),
+                        std::move(pair), &mod_reports, &pass_back_superblock);
+                    guarantee(superblock.get() == pass_back_superblock.assert_get_value());
+                }
+            }
+
+            /* Acquire the sindex block and update the metainfo */
+            sindex_block = buf_lock_t(superblock->expose_buf(),
+                superblock->get_sindex_block_id(), access_t::write);
+            tokens.update_metainfo_cb(items.back().range.right, superblock.get());
+        }
+
+        /* Notify that we're done and update the sindexes */
+        fifo_enforcer_sink_t::exit_write_t exiter(
+            &tokens.info->commit_fifo_sink, tokens.write_token);
+        /* Note: This must not be interruptible, or we might miss updating secondary
+        indexes. */
+        exiter.wait_lazily_unordered();
+        tokens.commit_cb(items.back().range.right, std::move(txn),
+            std::move(sindex_block), std::move(mod_reports));
+
+    } catch (const interrupted_exc_t &exc) {
+        /* The call to `receive_backfill()` was interrupted. Ignore. */
+    }
+}
+
+/* Returns `true` if the primary B-tree has no keys in `range`. */
+bool primary_range_is_empty(
+        cache_conn_t *cache_conn,
+        const key_range_t &range,
+        signal_t *interruptor) {
+    class find_any_key_cb_t : public depth_first_traversal_callback_t {
+    public:
+        find_any_key_cb_t() : found(false) { }
+        continue_bool_t handle_pair(scoped_key_value_t &&, signal_t *) {
+            found = true;
+            return continue_bool_t::ABORT;
+        }
+        bool found;
+    } callback;
+
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    get_btree_superblock_and_txn_for_reading(
+        cache_conn, CACHE_SNAPSHOTTED_NO, &superblock, &txn);
+    btree_depth_first_traversal(superblock.get(), range, &callback, access_t::read,
+        FORWARD, release_superblock_t::RELEASE, interruptor);
+    return !callback.found;
+}
+
 continue_bool_t store_t::receive_backfill(
         const region_t &_region,
         backfill_item_producer_t *item_producer,
@@ -393,6 +505,13 @@ continue_bool_t store_t::receive_backfill(
     receive_backfill_info_t info(
         general_cache_conn.get(), btree.get(), &unsaved_data_limiter);
 
+    /* Writes that arrive during the backfill are only applied to the part of the
+    key-space that has already been backfilled, so if `_region` is empty now, it will
+    stay empty except for the changes that we make ourselves. In that case we apply the
+    backfill items in batches using `apply_bulk_items()`. */
+    const bool bulk_load = primary_range_is_empty(
+        general_cache_conn.get(), _region.inner, interruptor);
+
     /* `spawn_threshold` is the point up to which we've spawned coroutines.
     `metainfo_threshold` is the point up to which we've applied the metainfo to the
     superblock. `commit_threshold` is the point up to which we've called
@@ -405,35 +524,15 @@ continue_bool_t store_t::receive_backfill(
     /* We'll set `result` to `false` to record if `item_producer` returns `ABORT`. */
     continue_bool_t result = continue_bool_t::CONTINUE;
 
-    /* Repeatedly request items from `item_producer` and spawn coroutines to handle them,
-    but limit the number of simultaneously active coroutines. */
-    while (spawn_threshold != _region.inner.right) {
-        bool is_item;
-        backfill_item_t item;
-        key_range_t::right_bound_t empty_range;
-        if (continue_bool_t::ABORT ==
-                item_producer->next_item(&is_item, &item, &empty_range)) {
-            /* By breaking out of the loop instead of returning immediately, we ensure
-            that we commit every item that we got from the item producer, as we are
-            required to. */
-            result = continue_bool_t::ABORT;
-            break;
-        }
-
+    /* Every coroutine we spawn gets a `receive_backfill_tokens_t` from `get_tokens()`.
+    The `apply_*()` functions will call back to `update_metainfo_cb` when they want to
+    apply the metainfo to the superblock, and to `commit_cb` when they're done applying
+    the changes for a given sub-region. They may make multiple calls to each, but the
+    last call will have `progress` equal to the right bound of the last item they were
+    given. */
+    auto get_tokens = [&]() {
         receive_backfill_tokens_t tokens(&info, interruptor);
 
-        if (is_item) {
-            rassert(key_range_t::right_bound_t(item.get_range().left)
-                >= spawn_threshold);
-            spawn_threshold = item.get_range().right;
-        } else {
-            rassert(empty_range >= spawn_threshold);
-            spawn_threshold = empty_range;
-        }
-
-        /* The `apply_*()` functions will call back to `update_metainfo_cb` when they
-        want to apply the metainfo to the superblock. They may make multiple calls, but
-        the last call will have `progress` equal to `item.get_range().right`. */
         tokens.update_metainfo_cb = [this, &_region, &metainfo_threshold, &item_producer,
                     &spawn_threshold](
                 const key_range_t::right_bound_t &progress,
@@ -454,9 +553,6 @@ continue_bool_t store_t::receive_backfill(
             metainfo->update(superblock, item_producer->get_metainfo()->mask(mask));
         };
 
-        /* The `apply_*()` functions will call back to `commit_cb` when they're done
-        applying the changes for a given sub-region. They may make multiple calls, but
-        the last call will have `progress` equal to `item.get_range().right`. */
         tokens.commit_cb = [this, item_producer, &commit_threshold, &metainfo_threshold](
                 const key_range_t::right_bound_t &progress,
                 scoped_ptr_t<txn_t> &&txn,
@@ -483,17 +579,71 @@ continue_bool_t store_t::receive_backfill(
             item_producer->on_commit(progress);
         };
 
+        return tokens;
+    };
+
+    /* In bulk-load mode, `bulk_batch` collects consecutive items until they have
+    `MAX_BULK_LOAD_PAIRS_PER_TXN` pairs between them, or until we get something that
+    can't go into the batch. */
+    std::vector<backfill_item_t> bulk_batch;
+    size_t bulk_batch_pairs = 0;
+    auto flush_bulk_batch = [&]() {
+        if (!bulk_batch.empty()) {
+            coro_t::spawn_sometime(std::bind(
+                &apply_bulk_items, get_tokens(), std::move(bulk_batch)));
+            bulk_batch.clear();
+            bulk_batch_pairs = 0;
+        }
+    };
+
+    /* Repeatedly request items from `item_producer` and spawn coroutines to handle them,
+    but limit the number of simultaneously active coroutines. */
+    while (spawn_threshold != _region.inner.right) {
+        bool is_item;
+        backfill_item_t item;
+        key_range_t::right_bound_t empty_range;
+        if (continue_bool_t::ABORT ==
+                item_producer->next_item(&is_item, &item, &empty_range)) {
+            /* By breaking out of the loop instead of returning immediately, we ensure
+            that we commit every item that we got from the item producer, as we are
+            required to. */
+            result = continue_bool_t::ABORT;
+            break;
+        }
+
+        if (is_item) {
+            rassert(key_range_t::right_bound_t(item.get_range().left)
+                >= spawn_threshold);
+            spawn_threshold = item.get_range().right;
+        } else {
+            rassert(empty_range >= spawn_threshold);
+            spawn_threshold = empty_range;
+        }
+
+        if (bulk_load && is_item
+                && item.pairs.size() <= static_cast<size_t>(MAX_BULK_LOAD_PAIRS_PER_TXN)) {
+            if (bulk_batch_pairs + item.pairs.size()
+                    > static_cast<size_t>(MAX_BULK_LOAD_PAIRS_PER_TXN)) {
+                flush_bulk_batch();
+            }
+            bulk_batch_pairs += item.pairs.size();
+            bulk_batch.push_back(std::move(item));
+            continue;
+        }
+        flush_bulk_batch();
+
         if (!is_item) {
             coro_t::spawn_sometime(std::bind(
-                &apply_empty_range, std::move(tokens), empty_range));
+                &apply_empty_range, get_tokens(), empty_range));
         } else if (item.is_single_key()) {
             coro_t::spawn_sometime(std::bind(
-                &apply_single_key_item, std::move(tokens), std::move(item)));
+                &apply_single_key_item, get_tokens(), std::move(item)));
         } else {
             coro_t::spawn_sometime(std::bind(
-                &apply_multi_key_item, std::move(tokens), std::move(item)));
+                &apply_multi_key_item, get_tokens(), std::move(item)));
         }
     }
+    flush_bulk_batch();
 
     /* Wait for any running coroutines to finish. We construct an `exit_write_t` instead
     of just destroying `info.drainer` because we don't want to interrupt the coroutines
@@ -7,6 +7,7 @@
 #include "clustering/administration/admin_op_exc.hpp"
 #include "clustering/administration/auth/permissions.hpp"
 #include "clustering/administration/auth/username.hpp"
+#include "clustering/table_contract/cpu_sharding.hpp"
 #include "containers/name_string.hpp"
 #include "rdb_protocol/datum_string.hpp"
 #include "rdb_protocol/op.hpp"
@@ -162,7 +163,7 @@ public:
         : meta_op_term_t(env, term, argspec_t(1, 2),
             optargspec_t({"primary_key", "shards", "replicas",
                           "nonvoting_replica_tags", "primary_replica_tag",
-                          "durability"})) { }
+                          "durability", "cpu_shards", "block_compression"})) { }
 private:
     virtual scoped_ptr_t<val_t> eval_impl(
             scope_env_t *env, args_t *args, eval_flags_t) const {
@@ -177,6 +178,32 @@ private:
             config_params.num_shards = shards_optarg->as_int();
         }
 
+        // Parse the 'cpu_shards' optarg
+        if (scoped_ptr_t<val_t> cpu_shards_optarg = args->optarg(env, "cpu_shards")) {
+            int64_t cpu_shards = cpu_shards_optarg->as_int();
+            rcheck_target(cpu_shards_optarg,
+                          cpu_shards > 0 && is_valid_cpu_shard_count(cpu_shards),
+                          base_exc_t::LOGIC,
+                          strprintf("`cpu_shards` must be a power of two between 1 "
+                                    "and %d.", MAX_CPU_SHARDS));
+            config_params.cpu_shards = cpu_shards;
+        }
+
+        // Parse the 'block_compression' optarg
+        if (scoped_ptr_t<val_t> block_compression_optarg =
+                args->optarg(env, "block_compression")) {
+            const datum_string_t &block_compression =
+                block_compression_optarg->as_str();
+            if (block_compression == "none") {
+                config_params.block_compression = block_codec_t::none;
+            } else if (block_compression == "zlib") {
+                config_params.block_compression = block_codec_t::zlib;
+            } else {
+                rfail_target(block_compression_optarg, base_exc_t::LOGIC,
+                             "`block_compression` must be \"none\" or \"zlib\".");
+            }
+        }
+
         // Parse the 'replicas', 'nonvoting_replica_tags', and
         // 'primary_replica_tag' optargs
         get_replicas_and_primary(args->optarg(env, "replicas"),
@@ -7,6 +7,7 @@
 #include "errors.hpp"
 #include <boost/bind.hpp>
 
+#include "rdb_protocol/context.hpp"
 #include "rdb_protocol/datum_stream.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/func.hpp"
@@ -106,6 +107,14 @@ private:
             }
             rcheck(!comparisons.empty(), base_exc_t::LOGIC,
                    "Must specify something to order by.");
+            // If the rows don't fit into an array, we sort them in chunks of the
+            // array size limit and merge the sorted chunks from disk.  We can only
+            // do that if we have somewhere to put the files, which proxies and
+            // some unit tests don't.
+            rdb_context_t *ctx = env->env->get_rdb_ctx();
+            const bool can_spill = ctx != nullptr && ctx->io_backender != nullptr;
+            const size_t array_size_limit = env->env->limits().array_size_limit();
+            counted_t<external_sort_datum_stream_t> external_sort;
             std::vector<datum_t> to_sort;
             batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
             for (;;) {
@@ -114,15 +123,30 @@ private:
                 if (data.size() == 0) {
                     break;
                 }
-                std::move(data.begin(), data.end(), std::back_inserter(to_sort));
+                for (auto &&d : data) {
+                    if (can_spill && to_sort.size() >= array_size_limit) {
+                        if (!external_sort.has()) {
+                            external_sort = make_counted<external_sort_datum_stream_t>(
+                                ctx->io_backender, ctx->base_path, lt_cmp,
+                                backtrace());
+                        }
+                        external_sort->spill_run(env->env, &to_sort);
+                    }
+                    to_sort.push_back(std::move(d));
+                }
                 rcheck_array_size(to_sort, env->env->limits());
             }
-            profile::sampler_t sampler("Sorting in-memory.", env->env->trace);
-            auto fn = boost::bind(lt_cmp, env->env, &sampler, _1, _2);
-            std::stable_sort(to_sort.begin(), to_sort.end(), fn);
-            seq = make_counted<array_datum_stream_t>(
-                datum_t(std::move(to_sort), env->env->limits()),
-                backtrace());
+            if (external_sort.has()) {
+                external_sort->finish(env->env, std::move(to_sort));
+                seq = external_sort;
+            } else {
+                profile::sampler_t sampler("Sorting in-memory.", env->env->trace);
+                auto fn = boost::bind(lt_cmp, env->env, &sampler, _1, _2);
+                std::stable_sort(to_sort.begin(), to_sort.end(), fn);
+                seq = make_counted<array_datum_stream_t>(
+                    datum_t(std::move(to_sort), env->env->limits()),
+                    backtrace());
+            }
         }
         return tbl_slice.has()
             ? new_val(make_counted<selection_t>(tbl_slice->get_tbl(), seq))
@@ -5,6 +5,8 @@
 #include <netinet/in.h>
 #endif
 
+#include <zlib.h>
+
 #include <algorithm>
 #include <functional>
 
@@ -31,12 +33,21 @@
 // Number of messages after which the message handling loop yields
 #define MESSAGE_HANDLER_MAX_BATCH_SIZE           16
 
+// Messages smaller than this are never compressed. Heartbeats and most mailbox
+// messages are small enough that compressing them would only cost us time.
+#define MIN_COMPRESSED_MESSAGE_SIZE              1024
+
+// Messages larger than this are never compressed, and we drop the connection if a peer
+// claims that a compressed message decompresses to more than this. Otherwise a peer
+// could make us allocate an arbitrary amount of memory with a small message.
+#define MAX_COMPRESSED_MESSAGE_SIZE              (256 * MEGABYTE)
+
 // The cluster communication protocol version.
-static_assert(cluster_version_t::CLUSTER == cluster_version_t::v2_4_is_latest,
+static_assert(cluster_version_t::CLUSTER == cluster_version_t::v2_5_is_latest,
               "We need to update CLUSTER_VERSION_STRING when we add a new cluster "
               "version.");
 
-#define CLUSTER_VERSION_STRING "2.4.0"
+#define CLUSTER_VERSION_STRING "2.5.0"
 
 const std::string connectivity_cluster_t::cluster_proto_header("RethinkDB cluster\n");
 const std::string connectivity_cluster_t::cluster_version_string(CLUSTER_VERSION_STRING);
@@ -131,12 +142,23 @@ void connectivity_cluster_t::connection_t::kill_connection() {
     }
 }
 
+ql::datum_t connectivity_cluster_t::connection_t::get_stats() {
+    on_thread_t thread_switcher(pm_collection.home_thread());
+    void *ctx = pm_collection.begin_stats();
+    pmap(get_num_threads(), [&](int thread) {
+        on_thread_t visit_thread_switcher((threadnum_t(thread)));
+        pm_collection.visit_stats(ctx);
+    });
+    return pm_collection.end_stats(ctx);
+}
+
 connectivity_cluster_t::connection_t::connection_t(
         run_t *_parent,
         const peer_id_t &_peer_id,
         const server_id_t &_server_id,
         keepalive_tcp_conn_stream_t *_conn,
-        const peer_address_t &_peer_address) THROWS_NOTHING :
+        const peer_address_t &_peer_address,
+        bool _compress_messages) THROWS_NOTHING :
     conn(_conn),
     peer_address(_peer_address),
     flusher([&](signal_t *) {
@@ -148,13 +170,20 @@ connectivity_cluster_t::connection_t::connection_t(
         // must be handled elsewhere.
         this->conn->flush_buffer();
     }, 1),
+    compress_messages(_compress_messages),
     pm_collection(),
     pm_bytes_sent(secs_to_ticks(1), true),
+    pm_send_latency(secs_to_ticks(10)),
     pm_collection_membership(
         &_parent->parent->connectivity_collection,
         &pm_collection,
         uuid_to_str(_peer_id.get_uuid())),
     pm_bytes_sent_membership(&pm_collection, &pm_bytes_sent, "bytes_sent"),
+    pm_send_latency_membership(&pm_collection, &pm_send_latency, "send_latency"),
+    pm_bytes_before_compression_membership(&pm_collection,
+        &pm_bytes_before_compression, "bytes_sent_before_compression_total"),
+    pm_bytes_after_compression_membership(&pm_collection,
+        &pm_bytes_after_compression, "bytes_sent_after_compression_total"),
     parent(_parent),
     peer_id(_peer_id),
     server_id(_server_id),
@@ -224,11 +253,13 @@ connectivity_cluster_t::run_t::run_t(
             _heartbeat_sl_view,
         boost::shared_ptr<semilattice_read_view_t<auth_semilattice_metadata_t> >
             _auth_sl_view,
-        tls_ctx_t *_tls_ctx)
+        tls_ctx_t *_tls_ctx,
+        bool _compress_messages)
         THROWS_ONLY(address_in_use_exc_t, tcp_socket_exc_t) :
     parent(_parent),
     server_id(_server_id),
     tls_ctx(_tls_ctx),
+    compress_messages(_compress_messages),
 
     /* Create the socket to use when listening for connections from peers */
     cluster_listener_socket(new tcp_bound_socket_t(local_addresses, port)),
@@ -260,7 +291,8 @@ connectivity_cluster_t::run_t::run_t(
     `connection_map` on each thread and notifying any listeners that we're now
     connected to ourself. The destructor will remove us from the
     `connection_map` and again notify any listeners. */
-    connection_to_ourself(this, parent->me, _server_id, nullptr, routing_table[parent->me]),
+    connection_to_ourself(this, parent->me, _server_id, nullptr, routing_table[parent->me],
+                          false),
 
     heartbeat_sl_view(_heartbeat_sl_view),
     auth_sl_view(_auth_sl_view),
@@ -725,6 +757,13 @@ public:
     static handshake_result_t success() {
         return handshake_result_t(handshake_result_code_t::SUCCESS);
     }
+    // `capabilities` is a space-separated list of optional protocol features that
+    // the sender supports. Servers that don't know about it just ignore it.
+    static handshake_result_t success(const std::string &capabilities) {
+        handshake_result_t res(handshake_result_code_t::SUCCESS);
+        res.additional_info = capabilities;
+        return res;
+    }
     static handshake_result_t error(handshake_result_code_t error_code,
                                     const std::string &additional_info) {
         return handshake_result_t(error_code, additional_info);
@@ -734,6 +773,13 @@ public:
         return code;
     }
 
+    bool has_capability(const std::string &capability) const {
+        guarantee(code == handshake_result_code_t::SUCCESS);
+        std::vector<std::string> capabilities = split_string(additional_info, ' ');
+        return std::find(capabilities.begin(), capabilities.end(), capability)
+            != capabilities.end();
+    }
+
     std::string get_error_reason() const {
         if (code == handshake_result_code_t::UNKNOWN_ERROR) {
             return error_code_string + " (" + additional_info + ")";
@@ -818,6 +864,65 @@ archive_result_t deserialize_universal(read_stream_t *s, handshake_result_t *out
     return res;
 }
 
+// A server that has this capability understands messages sent with
+// `connectivity_cluster_t::compressed_tag`.
+static const char *const zlib_messages_capability = "zlib_messages";
+
+/* Compresses a message with zlib. Returns `false` if that wouldn't make the message
+any smaller. */
+static bool compress_message(const std::vector<char> &message,
+                             std::vector<char> *compressed_out) {
+    // There's no point in letting zlib produce anything that's not smaller than the
+    // message itself.
+    uLongf compressed_size = message.size() - 1;
+    compressed_out->resize(compressed_size);
+    int res = compress2(reinterpret_cast<Bytef *>(compressed_out->data()),
+                        &compressed_size,
+                        reinterpret_cast<const Bytef *>(message.data()),
+                        message.size(),
+                        Z_BEST_SPEED);
+    if (res == Z_BUF_ERROR) {
+        return false;
+    }
+    guarantee(res == Z_OK, "Compressing a cluster message failed (%d).", res);
+    compressed_out->resize(compressed_size);
+    return true;
+}
+
+/* Reads the rest of a message that was sent with `compressed_tag`, i.e. the real
+tag of the message, its size, the size of the compressed message and the compressed
+message itself. Returns `false` on network errors and if the message is invalid. */
+static bool receive_compressed_message(read_stream_t *conn,
+                                       connectivity_cluster_t::message_tag_t *tag_out,
+                                       std::vector<char> *message_out) {
+    uint64_t size;
+    uint64_t compressed_size;
+    if (bad(deserialize_universal(conn, tag_out))
+        || bad(deserialize_universal(conn, &size))
+        || bad(deserialize_universal(conn, &compressed_size))) {
+        return false;
+    }
+    // We only ever send messages compressed if that makes them smaller.
+    if (*tag_out == connectivity_cluster_t::compressed_tag
+        || *tag_out == connectivity_cluster_t::heartbeat_tag
+        || compressed_size >= size
+        || size > static_cast<uint64_t>(MAX_COMPRESSED_MESSAGE_SIZE)) {
+        return false;
+    }
+    std::vector<char> compressed(compressed_size);
+    if (force_read(conn, compressed.data(), compressed_size)
+            != static_cast<int64_t>(compressed_size)) {
+        return false;
+    }
+    message_out->resize(size);
+    uLongf decompressed_size = size;
+    int res = uncompress(reinterpret_cast<Bytef *>(message_out->data()),
+                         &decompressed_size,
+                         reinterpret_cast<const Bytef *>(compressed.data()),
+                         compressed_size);
+    return res == Z_OK && decompressed_size == size;
+}
+
 void fail_handshake(keepalive_tcp_conn_stream_t *conn,
                     const char *peername,
                     const handshake_result_t &reason,
@@ -1040,10 +1145,12 @@ void connectivity_cluster_t::run_t::handle(
         return;
     }
 
+    bool peer_accepts_compressed_messages;
     {
-        // Tell the other node that we are happy to connect with it
+        // Tell the other node that we are happy to connect with it, and that it can
+        // send us compressed messages.
         write_message_t wm;
-        serialize_universal(&wm, handshake_result_t::success());
+        serialize_universal(&wm, handshake_result_t::success(zlib_messages_capability));
         if (send_write_message(conn, &wm)) {
             return; // network error.
         }
@@ -1059,6 +1166,8 @@ void connectivity_cluster_t::run_t::handle(
                    sanitize_for_logger(handshake_result.get_error_reason()).c_str());
             return;
         }
+        peer_accepts_compressed_messages =
+            handshake_result.has_capability(zlib_messages_capability);
     }
 
     // Look up the ip addresses for the other host
@@ -1278,7 +1387,8 @@ void connectivity_cluster_t::run_t::handle(
         constructor registers it in the `connectivity_cluster_t`'s connection
         map. */
         connection_t conn_structure(
-            this, other_id, remote_server_id, conn, *other_peer_addr.get());
+            this, other_id, remote_server_id, conn, *other_peer_addr.get(),
+            compress_messages && peer_accepts_compressed_messages);
 
         /* `heartbeat_manager` will periodically send a heartbeat message to
         other servers, and it will also close the connection if we don't
@@ -1303,6 +1413,16 @@ void connectivity_cluster_t::run_t::handle(
                 `keepalive_tcp_conn_stream_t` will have already notified the
                 `heartbeat_manager_t` as soon as the heartbeat arrived. */
                 if (tag != heartbeat_tag) {
+                    /* A compressed message is decompressed in full before we hand
+                    it to the message handler. */
+                    const bool is_compressed = tag == compressed_tag;
+                    std::vector<char> decompressed;
+                    if (is_compressed) {
+                        if (!receive_compressed_message(conn, &tag, &decompressed)) {
+                            throw fake_archive_exc_t();
+                        }
+                    }
+
                     cluster_message_handler_t *handler = parent->message_handlers[tag];
                     guarantee(handler != nullptr, "Got a message for an unfamiliar tag. "
                         "Apparently we aren't compatible with the cluster on the other "
@@ -1311,10 +1431,18 @@ void connectivity_cluster_t::run_t::handle(
                     /* If you really want to support old cluster versions, the
                     resolved_version should be passed into the on_message() handler. */
                     guarantee(resolved_version == cluster_version_t::CLUSTER);
-                    handler->on_message(
-                        &conn_structure,
-                        auto_drainer_t::lock_t(conn_structure.drainers.get()),
-                        conn); // might raise fake_archive_exc_t
+                    if (is_compressed) {
+                        vector_read_stream_t stream(std::move(decompressed));
+                        handler->on_message(
+                            &conn_structure,
+                            auto_drainer_t::lock_t(conn_structure.drainers.get()),
+                            &stream); // might raise fake_archive_exc_t
+                    } else {
+                        handler->on_message(
+                            &conn_structure,
+                            auto_drainer_t::lock_t(conn_structure.drainers.get()),
+                            conn); // might raise fake_archive_exc_t
+                    }
                 }
 
                 ++messages_handled_since_yield;
@@ -1486,6 +1614,20 @@ void connectivity_cluster_t::send_message(connection_t *connection,
         message_handlers[tag]->on_local_message(connection, connection_keepalive,
             std::move(buffer_data));
     } else {
+        // How long it takes until the message has been handed to the TCP stack,
+        // including the time spent waiting for other messages on the connection.
+        ticks_t start_ticks = get_ticks();
+
+        /* We compress before switching to the connection's thread, so that the work
+        gets spread out over the threads that send messages. */
+        std::vector<char> compressed;
+        const bool is_compressed = connection->compress_messages
+            && bytes_sent >= MIN_COMPRESSED_MESSAGE_SIZE
+            && bytes_sent <= static_cast<size_t>(MAX_COMPRESSED_MESSAGE_SIZE)
+            && compress_message(buffer.vector(), &compressed);
+        const std::vector<char> &payload =
+            is_compressed ? compressed : buffer.vector();
+
         on_thread_t threader(connection->conn->home_thread());
 
         /* Acquire the send-mutex so we don't collide with other things trying
@@ -1504,7 +1646,14 @@ void connectivity_cluster_t::send_message(connection_t *connection,
                               "changed, the cluster communication format has changed and "
                               "you need to ask yourself whether live cluster upgrades work."
                               );
-                serialize_universal(&wm, tag);
+                if (is_compressed) {
+                    serialize_universal(&wm, compressed_tag);
+                    serialize_universal(&wm, tag);
+                    serialize_universal(&wm, static_cast<uint64_t>(bytes_sent));
+                    serialize_universal(&wm, static_cast<uint64_t>(payload.size()));
+                } else {
+                    serialize_universal(&wm, tag);
+                }
                 make_buffered_tcp_conn_stream_wrapper_t buffered_conn(connection->conn);
                 int res = send_write_message(&buffered_conn, &wm);
                 if (res == -1) {
@@ -1520,15 +1669,15 @@ void connectivity_cluster_t::send_message(connection_t *connection,
 
             /* Write the message itself to the network */
             {
-                int64_t res = connection->conn->write_buffered(buffer.vector().data(),
-                                                               buffer.vector().size());
+                int64_t res = connection->conn->write_buffered(payload.data(),
+                                                               payload.size());
                 if (res == -1) {
                     if (connection->conn->is_read_open()) {
                         connection->conn->shutdown_read();
                     }
                     return;
                 } else {
-                    guarantee(res == static_cast<int64_t>(buffer.vector().size()));
+                    guarantee(res == static_cast<int64_t>(payload.size()));
                 }
             }
         } /* Releases the send_mutex */
@@ -1542,6 +1691,9 @@ void connectivity_cluster_t::send_message(connection_t *connection,
             }
             return;
         }
+        connection->pm_send_latency.record(get_ticks() - start_ticks);
+        connection->pm_bytes_before_compression += bytes_sent;
+        connection->pm_bytes_after_compression += payload.size();
     }
 
     connection->pm_bytes_sent.record(bytes_sent);
@@ -1556,6 +1708,9 @@ cluster_message_handler_t::cluster_message_handler_t(
     rassert(tag != connectivity_cluster_t::heartbeat_tag,
         "Tag %" PRIu8 " is reserved for heartbeat messages.",
         connectivity_cluster_t::heartbeat_tag);
+    rassert(tag != connectivity_cluster_t::compressed_tag,
+        "Tag %" PRIu8 " is reserved for compressed messages.",
+        connectivity_cluster_t::compressed_tag);
     rassert(connectivity_cluster->message_handlers[tag] == nullptr);
     connectivity_cluster->message_handlers[tag] = this;
 }
@@ -96,6 +96,11 @@ public:
     /* This tag is reserved exclusively for heartbeat messages. */
     static const message_tag_t heartbeat_tag = 'H';
 
+    /* This tag is reserved for messages that were compressed before being sent. It's
+    followed by the message's real tag and the compressed message; see
+    `send_message()`. */
+    static const message_tag_t compressed_tag = 'Z';
+
     class run_t;
 
     /* `connection_t` represents an open connection to another server. If we lose
@@ -135,6 +140,10 @@ public:
         /* Drops the connection. */
         void kill_connection();
 
+        /* Returns the stats of the connection, as they appear under `connectivity` in
+        the server's stats. */
+        ql::datum_t get_stats();
+
     private:
         friend class connectivity_cluster_t;
 
@@ -145,7 +154,8 @@ public:
             const peer_id_t &peer_id,
             const server_id_t &server_id,
             keepalive_tcp_conn_stream_t *,
-            const peer_address_t &peer_address) THROWS_NOTHING;
+            const peer_address_t &peer_address,
+            bool compress_messages) THROWS_NOTHING;
         ~connection_t() THROWS_NOTHING;
 
         /* NULL for the loopback connection (i.e. our "connection" to ourself) */
@@ -163,9 +173,20 @@ public:
         buffered write makes it to the TCP stack. */
         pump_coro_t flusher;
 
+        /* Whether we compress large messages before sending them. This is only the
+        case if we were asked to and the other server told us during the handshake
+        that it can decompress them. */
+        const bool compress_messages;
+
         perfmon_collection_t pm_collection;
         perfmon_sampler_t pm_bytes_sent;
-        perfmon_membership_t pm_collection_membership, pm_bytes_sent_membership;
+        perfmon_latency_histogram_t pm_send_latency;
+        /* The size of the messages we sent, and how many bytes they took up on the
+        wire. These only differ if `compress_messages` is true. */
+        perfmon_counter_t pm_bytes_before_compression, pm_bytes_after_compression;
+        perfmon_membership_t pm_collection_membership, pm_bytes_sent_membership,
+            pm_send_latency_membership, pm_bytes_before_compression_membership,
+            pm_bytes_after_compression_membership;
 
         /* We only hold this information so we can deregister ourself */
         run_t *parent;
@@ -194,7 +215,8 @@ public:
                   heartbeat_semilattice_metadata_t> > heartbeat_sl_view,
               boost::shared_ptr<semilattice_read_view_t<
                   auth_semilattice_metadata_t> > auth_sl_view,
-              tls_ctx_t *tls_ctx)
+              tls_ctx_t *tls_ctx,
+              bool compress_messages)
             THROWS_ONLY(address_in_use_exc_t, tcp_socket_exc_t);
 
         ~run_t();
@@ -281,6 +303,9 @@ public:
 
         tls_ctx_t *tls_ctx;
 
+        /* Whether we want to compress messages to servers that support it. */
+        const bool compress_messages;
+
         /* `attempt_table` is a table of all the host:port pairs we're currently
         trying to connect to or have connected to. If we are told to connect to
         an address already in this table, we'll just ignore it. That's important
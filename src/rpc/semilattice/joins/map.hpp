@@ -21,6 +21,23 @@ void semilattice_join(std::map<key_t, value_t> *a, const std::map<key_t, value_t
     }
 }
 
+/* `semilattice_delta()` is used by `semilattice_manager_t` to only send the entries
+of a map that actually changed over the network. It sets `*delta_out` to the entries
+of `added` that aren't in `base` with the same value, so that joining `*delta_out`
+into `base` has the same effect as joining `added` into it. */
+template<class key_t, class value_t>
+void semilattice_delta(const std::map<key_t, value_t> &base,
+                       const std::map<key_t, value_t> &added,
+                       std::map<key_t, value_t> *delta_out) {
+    delta_out->clear();
+    for (typename std::map<key_t, value_t>::const_iterator it = added.begin(); it != added.end(); it++) {
+        typename std::map<key_t, value_t>::const_iterator it2 = base.find(it->first);
+        if (it2 == base.end() || !(it2->second == it->second)) {
+            delta_out->insert(delta_out->end(), *it);
+        }
+    }
+}
+
 }   /* namespace std */
 
 #endif /* RPC_SEMILATTICE_JOINS_MAP_HPP_ */
@@ -3,8 +3,11 @@
 #define RPC_SEMILATTICE_SEMILATTICE_MANAGER_HPP_
 
 #include <map>
+#include <memory>
+#include <set>
 #include <utility>
 
+#include "perfmon/perfmon.hpp"
 #include "rpc/mailbox/mailbox.hpp"
 #include "rpc/semilattice/view.hpp"
 
@@ -29,6 +32,20 @@ constraints:
     such that `metadata_t` is a semilattice and `semilattice_join(a, b)` sets
     `*a` to the semilattice-join of `*a` and `b`.
 
+4. It must be equality comparable, and there must exist a function:
+
+        void semilattice_delta(const metadata_t &base, const metadata_t &added,
+                               metadata_t *delta_out);
+
+    such that joining `*delta_out` into `base` has the same effect as joining
+    `added` into it. `*delta_out` should be as small as possible.
+
+Every time a local `join()` changes the metadata, we bump `metadata_version` and send
+the peers only the delta between the old and the new metadata, tagged with the
+version it applies on top of. Changes that we get from a peer aren't sent on. A peer that has missed one of our versions (for example
+because messages got reordered) asks us for the full metadata instead. The full
+metadata is also sent whenever a new connection is established.
+
 Currently it's not thread-safe at all; all accesses to the metadata must be on
 the home thread of the `semilattice_manager_t`. */
 
@@ -62,6 +79,8 @@ private:
     };
 
     class metadata_writer_t;
+    class delta_writer_t;
+    class full_sync_query_writer_t;
     class sync_from_query_writer_t;
     class sync_from_reply_writer_t;
     class sync_to_query_writer_t;
@@ -74,7 +93,13 @@ private:
         const peer_id_t &peer_id,
         const connectivity_cluster_t::connection_pair_t *pair);
 
-    void join_metadata_locally(metadata_t);
+    /* If `is_local_change` is true, the change was made through our root view and is
+    sent to the peers as a delta. */
+    void join_metadata_locally(metadata_t, bool is_local_change);
+    void send_delta_to_peers(const metadata_t &delta,
+                             metadata_version_t base_version,
+                             metadata_version_t new_version);
+    void update_version_from_peer(peer_id_t peer, metadata_version_t version);
     void wait_for_version_from_peer(peer_id_t peer, metadata_version_t version, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t, sync_failed_exc_t);
 
     const boost::shared_ptr<root_view_t> root_view;
@@ -90,6 +115,10 @@ private:
     std::multimap<std::pair<peer_id_t, metadata_version_t>, cond_t *> version_waiters;
     mutex_assertion_t peer_version_mutex;
 
+    /* The peers that we've asked for their full metadata because we missed a version
+    from them, and haven't gotten a reply from yet. */
+    std::set<peer_id_t> full_syncs_requested;
+
     sync_from_query_id_t next_sync_from_query_id;
     std::map<sync_from_query_id_t, promise_t<metadata_version_t> *> sync_from_waiters;
 
@@ -100,6 +129,13 @@ private:
     first. */
     new_semaphore_t semaphore;
 
+    perfmon_collection_t stats;
+    perfmon_membership_t stats_membership;
+    /* How many bytes we send to all peers together for one change of the metadata */
+    perfmon_sampler_t pm_bytes_per_change;
+    perfmon_counter_t pm_full_syncs_requested;
+    perfmon_multi_membership_t pm_membership;
+
     /* Destructor order is important here. First we destroy the
     `connection_change_subscription`, so that we don't spawn any more coroutines. (We
     rely on the code that constructed us to make sure to delete the
@@ -15,6 +15,7 @@
 #include "concurrency/wait_any.hpp"
 #include "containers/archive/versioned.hpp"
 #include "logger.hpp"
+#include "utils.hpp"
 
 #define MAX_OUTSTANDING_SEMILATTICE_WRITES 4
 
@@ -29,6 +30,12 @@ semilattice_manager_t<metadata_t>::semilattice_manager_t(
     metadata(initial_metadata),
     next_sync_from_query_id(0), next_sync_to_query_id(0),
     semaphore(MAX_OUTSTANDING_SEMILATTICE_WRITES),
+    stats_membership(&get_global_perfmon_collection(), &stats,
+                     strprintf("semilattice_%c", message_tag)),
+    pm_bytes_per_change(secs_to_ticks(1), false),
+    pm_membership(&stats,
+                  &pm_bytes_per_change, "bytes_per_change",
+                  &pm_full_syncs_requested, "full_syncs_requested"),
     connection_change_subscription(
         get_connectivity_cluster()->get_connections(),
         std::bind(&semilattice_manager_t::on_connection_change, this, ph::_1, ph::_2),
@@ -67,33 +74,13 @@ void semilattice_manager_t<metadata_t>::root_view_t::join(const metadata_t &adde
     guarantee(parent, "accessing `semilattice_manager_t` root view when cluster no longer exists");
     parent->assert_thread();
 
-    metadata_version_t new_version = ++parent->metadata_version;
-    parent->join_metadata_locally(added_metadata);
-
-    /* Distribute changes to all peers we can currently see. If we can't
-    currently see a peer, that's OK; it will hear about the metadata change when
-    it reconnects, via the `semilattice_manager_t`'s `on_connections_change()`
-    handler. */
-    auto_drainer_t::lock_t parent_keepalive(parent->drainers.get());
-
-    for (const std::pair<peer_id_t, connectivity_cluster_t::connection_pair_t> &pair :
-            parent->last_connections) {
-        connectivity_cluster_t::connection_t *connection = pair.second.first;
-        auto_drainer_t::lock_t connection_keepalive = pair.second.second;
-        coro_t::spawn_sometime(
-            [this, parent_keepalive /* important to capture */,
-             connection, connection_keepalive /* important to capture */,
-             new_version, added_metadata]() {
-                metadata_writer_t writer(added_metadata, new_version);
-                new_semaphore_in_line_t acq(&parent->semaphore, 1);
-                acq.acquisition_signal()->wait();
-                parent->get_connectivity_cluster()->send_message(connection,
-                    connection_keepalive, parent->get_message_tag(), &writer);
-            });
-    }
+    /* This distributes the change to the peers, if there is one */
+    parent->join_metadata_locally(added_metadata, true);
 }
 
 static const char message_code_metadata = 'M';
+static const char message_code_delta = 'D';
+static const char message_code_full_sync_query = 'R';
 static const char message_code_sync_from_query = 'F';
 static const char message_code_sync_from_reply = 'f';
 static const char message_code_sync_to_query = 'T';
@@ -131,6 +118,58 @@ private:
     metadata_version_t mdv;
 };
 
+/* Deltas are sent to all peers, so `send_delta_to_peers()` serializes them only once
+and shares the message between the writers. */
+template <class metadata_t>
+class semilattice_manager_t<metadata_t>::delta_writer_t :
+        public cluster_send_message_write_callback_t
+{
+public:
+    explicit delta_writer_t(const std::shared_ptr<const write_message_t> &_wm) :
+        wm(_wm) { }
+
+    void write(write_stream_t *stream) {
+        int res = send_write_message(stream, wm.get());
+        if (res) { throw fake_archive_exc_t(); }
+    }
+
+#ifdef ENABLE_MESSAGE_PROFILER
+    const char *message_profiler_tag() const {
+        static const std::string tag =
+            strprintf("semilattice<%s>.delta", typeid(metadata_t).name());
+        return tag.c_str();
+    }
+#endif
+
+private:
+    std::shared_ptr<const write_message_t> wm;
+};
+
+template <class metadata_t>
+class semilattice_manager_t<metadata_t>::full_sync_query_writer_t :
+        public cluster_send_message_write_callback_t
+{
+public:
+    full_sync_query_writer_t() { }
+
+    void write(write_stream_t *stream) {
+        write_message_t wm;
+        // All cluster versions so far use a uint8_t code.
+        uint8_t code = message_code_full_sync_query;
+        serialize_universal(&wm, code);
+        int res = send_write_message(stream, &wm);
+        if (res) { throw fake_archive_exc_t(); }
+    }
+
+#ifdef ENABLE_MESSAGE_PROFILER
+    const char *message_profiler_tag() const {
+        static const std::string tag =
+            strprintf("semilattice<%s>.full_sync", typeid(metadata_t).name());
+        return tag.c_str();
+    }
+#endif
+};
+
 template <class metadata_t>
 class semilattice_manager_t<metadata_t>::sync_from_query_writer_t :
         public cluster_send_message_write_callback_t
@@ -357,7 +396,8 @@ void semilattice_manager_t<metadata_t>::on_message(
     threadnum_t original_thread = get_thread_id();
 
     switch (code) {
-        /* Another peer sent us a newer version of the metadata */
+        /* Another peer sent us its full metadata, either because we just connected to
+        it or because we asked for it */
         case message_code_metadata: {
             metadata_t added_metadata;
             metadata_version_t change_version;
@@ -373,23 +413,71 @@ void semilattice_manager_t<metadata_t>::on_message(
                     added_metadata, change_version, sender]() {
                 on_thread_t thread_switcher(home_thread());
                 /* This is the meat of the change */
-                this->join_metadata_locally(added_metadata);
-                /* Also notify anything that was waiting for us to reach this version */
-                DEBUG_VAR mutex_assertion_t::acq_t acq(&this->peer_version_mutex);
-                auto inserted = this->last_versions_seen.insert(
-                    std::make_pair(sender, change_version));
-                if (!inserted.second) {
-                    inserted.first->second =
-                        std::max(inserted.first->second, change_version);
+                this->join_metadata_locally(added_metadata, false);
+                this->full_syncs_requested.erase(sender);
+                this->update_version_from_peer(sender, change_version);
+            });
+            break;
+        }
+        /* Another peer changed its metadata. `base_version` is the version that the
+        delta applies on top of. */
+        case message_code_delta: {
+            metadata_t delta;
+            metadata_version_t base_version, change_version;
+            {
+                archive_result_t res =
+                    deserialize<cluster_version_t::CLUSTER>(stream, &delta);
+                if (bad(res)) { throw fake_archive_exc_t(); }
+                res = deserialize<cluster_version_t::CLUSTER>(stream, &base_version);
+                if (bad(res)) { throw fake_archive_exc_t(); }
+                res = deserialize<cluster_version_t::CLUSTER>(stream, &change_version);
+                if (bad(res)) { throw fake_archive_exc_t(); }
+            }
+            coro_t::spawn_sometime([this, this_keepalive /* important to capture */,
+                    connection, connection_keepalive /* important to capture */,
+                    delta, base_version, change_version, sender, original_thread]() {
+                on_thread_t thread_switcher(home_thread());
+                /* The delta is always safe to apply, even if we missed the versions
+                before it. */
+                this->join_metadata_locally(delta, false);
+                auto it = this->last_versions_seen.find(sender);
+                if (it != this->last_versions_seen.end() &&
+                        it->second >= base_version) {
+                    this->update_version_from_peer(sender, change_version);
+                    return;
                 }
-                for (auto it = version_waiters.begin();
-                          it != version_waiters.end();
-                          it++) {
-                    if (it->first.first == sender &&
-                            it->first.second <= change_version &&
-                            !it->second->is_pulsed()) {
-                        it->second->pulse();
-                    }
+                /* We missed one of the peer's versions, so we can't claim to be at
+                `change_version` until we have its full metadata. */
+                if (!this->full_syncs_requested.insert(sender).second) {
+                    return;
+                }
+                ++this->pm_full_syncs_requested;
+                full_sync_query_writer_t writer;
+                new_semaphore_in_line_t acq(&this->semaphore, 1);
+                acq.acquisition_signal()->wait();
+                {
+                    on_thread_t thread_switcher_2(original_thread);
+                    get_connectivity_cluster()->send_message(connection,
+                        connection_keepalive, get_message_tag(), &writer);
+                }
+            });
+            break;
+        }
+        /* A peer missed one of our versions and wants our full metadata. */
+        case message_code_full_sync_query: {
+            coro_t::spawn_sometime([this, this_keepalive /* important to capture */,
+                    connection, connection_keepalive /* important to capture */,
+                    original_thread]() {
+                on_thread_t thread_switcher(home_thread());
+                /* We copy the metadata because we send it from another thread */
+                metadata_t metadata_copy = metadata;
+                metadata_writer_t writer(metadata_copy, metadata_version);
+                new_semaphore_in_line_t acq(&this->semaphore, 1);
+                acq.acquisition_signal()->wait();
+                {
+                    on_thread_t thread_switcher_2(original_thread);
+                    get_connectivity_cluster()->send_message(connection,
+                        connection_keepalive, get_message_tag(), &writer);
                 }
             });
             break;
@@ -540,20 +628,92 @@ void semilattice_manager_t<metadata_t>::on_connection_change(
     }
     if (pair == nullptr && last_connections.count(peer_id) == 1) {
         last_connections.erase(peer_id);
+        full_syncs_requested.erase(peer_id);
     }
 }
 
 template<class metadata_t>
-void semilattice_manager_t<metadata_t>::join_metadata_locally(metadata_t added_metadata) {
+void semilattice_manager_t<metadata_t>::join_metadata_locally(
+        metadata_t added_metadata, bool is_local_change) {
     assert_thread();
     DEBUG_VAR rwi_lock_assertion_t::write_acq_t acq(&metadata_mutex);
-    semilattice_join(&metadata, added_metadata);
+    if (is_local_change) {
+        /* Changes that we got from a peer aren't sent on; the peer that made them
+        sent them to everybody it's connected to. */
+        metadata_t old_metadata = metadata;
+        semilattice_join(&metadata, added_metadata);
+        if (!(metadata == old_metadata)) {
+            metadata_version_t base_version = metadata_version++;
+            metadata_t delta;
+            semilattice_delta(old_metadata, metadata, &delta);
+            send_delta_to_peers(delta, base_version, metadata_version);
+        }
+    } else {
+        semilattice_join(&metadata, added_metadata);
+    }
     metadata_publisher.publish(
         [](const std::function<void()> &fun) {
             fun();
         });
 }
 
+template<class metadata_t>
+void semilattice_manager_t<metadata_t>::send_delta_to_peers(
+        const metadata_t &delta,
+        metadata_version_t base_version,
+        metadata_version_t new_version) {
+    assert_thread();
+    std::shared_ptr<write_message_t> wm = std::make_shared<write_message_t>();
+    // All cluster versions so far use a uint8_t code.
+    uint8_t code = message_code_delta;
+    serialize_universal(wm.get(), code);
+    serialize<cluster_version_t::CLUSTER>(wm.get(), delta);
+    serialize<cluster_version_t::CLUSTER>(wm.get(), base_version);
+    serialize<cluster_version_t::CLUSTER>(wm.get(), new_version);
+    pm_bytes_per_change.record(wm->size() * last_connections.size());
+
+    /* Distribute changes to all peers we can currently see. If we can't
+    currently see a peer, that's OK; it will hear about the metadata change when
+    it reconnects, via the `semilattice_manager_t`'s `on_connections_change()`
+    handler. */
+    auto_drainer_t::lock_t this_keepalive(drainers.get());
+    std::shared_ptr<const write_message_t> shared_wm = std::move(wm);
+    for (const std::pair<peer_id_t, connectivity_cluster_t::connection_pair_t> &pair :
+            last_connections) {
+        connectivity_cluster_t::connection_t *connection = pair.second.first;
+        auto_drainer_t::lock_t connection_keepalive = pair.second.second;
+        coro_t::spawn_sometime(
+            [this, this_keepalive /* important to capture */,
+             connection, connection_keepalive /* important to capture */,
+             shared_wm]() {
+                delta_writer_t writer(shared_wm);
+                new_semaphore_in_line_t acq(&this->semaphore, 1);
+                acq.acquisition_signal()->wait();
+                get_connectivity_cluster()->send_message(connection,
+                    connection_keepalive, get_message_tag(), &writer);
+            });
+    }
+}
+
+template<class metadata_t>
+void semilattice_manager_t<metadata_t>::update_version_from_peer(
+        peer_id_t peer, metadata_version_t version) {
+    assert_thread();
+    /* Notify anything that was waiting for us to reach this version */
+    DEBUG_VAR mutex_assertion_t::acq_t acq(&peer_version_mutex);
+    auto inserted = last_versions_seen.insert(std::make_pair(peer, version));
+    if (!inserted.second) {
+        inserted.first->second = std::max(inserted.first->second, version);
+    }
+    for (auto it = version_waiters.begin(); it != version_waiters.end(); it++) {
+        if (it->first.first == peer &&
+                it->first.second <= version &&
+                !it->second->is_pulsed()) {
+            it->second->pulse();
+        }
+    }
+}
+
 template<class metadata_t>
 void semilattice_manager_t<metadata_t>::wait_for_version_from_peer(peer_id_t peer, metadata_version_t version, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t, sync_failed_exc_t) {
     assert_thread();
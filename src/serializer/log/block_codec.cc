@@ -0,0 +1,101 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/log/block_codec.hpp"
+
+#include <string.h>
+#include <zlib.h>
+
+#include "config/args.hpp"
+#include "math.hpp"
+
+const size_t COMPRESSED_BLOCK_HEADER_SIZE =
+    sizeof(ls_buf_data_t) + sizeof(ls_compressed_buf_data_t);
+
+buf_ptr_t compress_block(block_codec_t codec,
+                         const ser_buffer_t *buf,
+                         block_size_t block_size) {
+    switch (codec) {
+    case block_codec_t::none:
+        return buf_ptr_t();
+    case block_codec_t::zlib: {
+        // Compressing is only worth it if we save at least one device block.  There's
+        // no point in letting zlib produce anything larger than that.
+        const uint32_t aligned_size = buf_ptr_t::compute_aligned_block_size(block_size);
+        if (aligned_size <= DEVICE_BLOCK_SIZE) {
+            return buf_ptr_t();
+        }
+        const uint32_t max_ser_size = aligned_size - DEVICE_BLOCK_SIZE;
+        if (max_ser_size <= COMPRESSED_BLOCK_HEADER_SIZE) {
+            return buf_ptr_t();
+        }
+
+        scoped_device_block_aligned_ptr_t<ser_buffer_t> compressed(max_ser_size);
+        char *const data = reinterpret_cast<char *>(compressed.get());
+        compressed->ser_header = buf->ser_header;
+        reinterpret_cast<ls_compressed_buf_data_t *>(data + sizeof(ls_buf_data_t))
+            ->codec = static_cast<uint8_t>(codec);
+
+        uLongf compressed_size = max_ser_size - COMPRESSED_BLOCK_HEADER_SIZE;
+        const int res = compress2(
+            reinterpret_cast<Bytef *>(data + COMPRESSED_BLOCK_HEADER_SIZE),
+            &compressed_size,
+            reinterpret_cast<const Bytef *>(buf->cache_data),
+            block_size.value(),
+            Z_BEST_SPEED);
+        if (res != Z_OK) {
+            // Most likely `Z_BUF_ERROR`, i.e. the block didn't compress well enough.
+            return buf_ptr_t();
+        }
+
+        // The buffer is larger than what `buf_ptr_t` thinks it is, but that's fine,
+        // since it only lives until the block has been written.
+        buf_ptr_t ret(block_size_t::unsafe_make(COMPRESSED_BLOCK_HEADER_SIZE
+                                                + compressed_size),
+                      std::move(compressed));
+        ret.fill_padding_zero();
+        return ret;
+    }
+    default:
+        unreachable();
+    }
+}
+
+buf_ptr_t decompress_block(const buf_ptr_t &disk_buf, block_size_t block_size) {
+    const uint32_t disk_ser_size = disk_buf.block_size().ser_value();
+    guarantee(disk_ser_size > COMPRESSED_BLOCK_HEADER_SIZE);
+    guarantee(disk_ser_size < block_size.ser_value());
+
+    const char *const data = reinterpret_cast<const char *>(disk_buf.ser_buffer());
+    const block_codec_t codec = static_cast<block_codec_t>(
+        reinterpret_cast<const ls_compressed_buf_data_t *>(
+            data + sizeof(ls_buf_data_t))->codec);
+
+    buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
+    ret.ser_buffer()->ser_header = disk_buf.ser_buffer()->ser_header;
+
+    switch (codec) {
+    case block_codec_t::zlib: {
+        uLongf decompressed_size = block_size.value();
+        const int res = uncompress(
+            reinterpret_cast<Bytef *>(ret.cache_data()),
+            &decompressed_size,
+            reinterpret_cast<const Bytef *>(data + COMPRESSED_BLOCK_HEADER_SIZE),
+            disk_ser_size - COMPRESSED_BLOCK_HEADER_SIZE);
+        guarantee(res == Z_OK && decompressed_size == block_size.value(),
+                  "Failed to decompress block %" PR_BLOCK_ID " (zlib error %d, "
+                  "%lu of %" PRIu32 " bytes).  The data file might be corrupted.",
+                  disk_buf.ser_buffer()->ser_header.block_id, res,
+                  static_cast<unsigned long>(decompressed_size),  // NOLINT(runtime/int)
+                  block_size.value());
+        break;
+    }
+    case block_codec_t::none:  // fallthrough
+    default:
+        crash("Block %" PR_BLOCK_ID " is stored with unknown codec %d.  The data file "
+              "might be corrupted, or it was written by a newer version of "
+              PRODUCT_NAME ".",
+              disk_buf.ser_buffer()->ser_header.block_id, static_cast<int>(codec));
+    }
+
+    ret.fill_padding_zero();
+    return ret;
+}
@@ -0,0 +1,29 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_BLOCK_CODEC_HPP_
+#define SERIALIZER_LOG_BLOCK_CODEC_HPP_
+
+#include "serializer/buf_ptr.hpp"
+#include "serializer/log/config.hpp"
+#include "serializer/types.hpp"
+
+/* A data block that the serializer stores compressed is laid out on disk as the usual
+`ls_buf_data_t` header, followed by an `ls_compressed_buf_data_t` header and the
+compressed contents of the block's cache data.  The LBA records the compressed size of
+the block as well as its size once decompressed, which is what the cache gets to see. */
+ATTR_PACKED(struct ls_compressed_buf_data_t {
+    // A `block_codec_t`.
+    uint8_t codec;
+});
+
+/* Compresses the block in `buf`, which is `block_size` large.  Returns an empty
+`buf_ptr_t` if `codec` is `block_codec_t::none` or if the compressed block wouldn't
+take up fewer device blocks than the uncompressed one. */
+buf_ptr_t compress_block(block_codec_t codec,
+                         const ser_buffer_t *buf,
+                         block_size_t block_size);
+
+/* Decompresses `disk_buf`, a block that `compress_block` compressed into
+`disk_buf.block_size()` bytes, back into a block of `block_size` bytes. */
+buf_ptr_t decompress_block(const buf_ptr_t &disk_buf, block_size_t block_size);
+
+#endif  // SERIALIZER_LOG_BLOCK_CODEC_HPP_
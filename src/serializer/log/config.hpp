@@ -9,12 +9,24 @@
 #include "serializer/types.hpp"
 #include "rpc/serialize_macros.hpp"
 
+/* How the serializer compresses data blocks before writing them to disk.  The LBA and
+the blocks themselves record whether and how each block was compressed, so this can be
+changed from run to run.  Every table picks its own codec, see
+`table_config_t::block_compression`.  Changes to the values change the on-disk format! */
+enum class block_codec_t : uint8_t {
+    none = 0,
+    zlib = 1
+};
+ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
+        block_codec_t, int8_t, block_codec_t::none, block_codec_t::zlib);
+
 /* Configuration for the serializer that can change from run to run */
 
 struct log_serializer_dynamic_config_t {
     log_serializer_dynamic_config_t() {
         read_ahead = true;
         io_batch_factor = DEFAULT_IO_BATCH_FACTOR;
+        block_codec = block_codec_t::none;
     }
 
     /* The (minimal) batch size of i/o requests being taken from a single i/o account.
@@ -24,6 +36,10 @@ struct log_serializer_dynamic_config_t {
 
     /* Enable reading more data than requested to let the cache warmup more quickly esp. on rotational drives */
     bool read_ahead;
+
+    /* The codec used to compress newly written data blocks.  Blocks only get stored
+    compressed if that makes them take up fewer device blocks on disk. */
+    block_codec_t block_codec;
 };
 
 /* This is equivalent to log_serializer_static_config_t below, but is an on-disk
@@ -4,6 +4,7 @@
 #include <inttypes.h>
 #include <sys/uio.h>
 
+#include <algorithm>
 #include <functional>
 
 #include "arch/arch.hpp"
@@ -13,12 +14,20 @@
 #include "errors.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/block_codec.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "stl_utils.hpp"
 
 // Max amount of bytes which can be read ahead in one i/o transaction (if enabled)
 const int64_t APPROXIMATE_READ_AHEAD_SIZE = 32 * DEFAULT_BTREE_BLOCK_SIZE;
 
+// Concurrent reads of blocks that are at most this far apart on disk get merged into
+// one i/o transaction, reading the unrelated blocks in between along with them.
+const int64_t MAX_COALESCED_READ_GAP = 4 * DEFAULT_BTREE_BLOCK_SIZE;
+
+// Max amount of bytes which can be read by one merged i/o transaction
+const int64_t MAX_COALESCED_READ_SIZE = 256 * DEFAULT_BTREE_BLOCK_SIZE;
+
 /*****************
  * GC Parameters *
  *****************/
@@ -59,7 +68,10 @@ class gc_entry_t : public intrusive_list_node_t<gc_entry_t> {
 private:
     struct block_info_t {
         uint32_t relative_offset;
+        // The size of the block once decompressed, and the number of bytes it
+        // actually takes up in the extent.
         block_size_t block_size;
+        block_size_t disk_block_size;
         bool token_referenced;
         bool index_referenced;
     };
@@ -125,17 +137,24 @@ public:
         return block_infos.empty()
             ? 0
             : block_infos.back().relative_offset
-            + aligned_value(block_infos.back().block_size);
+            + aligned_value(block_infos.back().disk_block_size);
     }
 
-    // Returns the ostensible size of the block_index'th block.  Note that
-    // block_boundaries[i] + block_size(i) <= block_boundaries[i + 1].
+    // Returns the ostensible size of the block_index'th block.
     block_size_t block_size(unsigned int _block_index) const {
         guarantee(state != state_reconstructing);
         guarantee(_block_index < block_infos.size());
         return block_infos[_block_index].block_size;
     }
 
+    // Returns the size of the block_index'th block on disk.  Note that
+    // block_boundaries[i] + disk_block_size(i) <= block_boundaries[i + 1].
+    block_size_t disk_block_size(unsigned int _block_index) const {
+        guarantee(state != state_reconstructing);
+        guarantee(_block_index < block_infos.size());
+        return block_infos[_block_index].disk_block_size;
+    }
+
     // Returns block_boundaries()[block_index].
     uint32_t relative_offset(unsigned int _block_index) const {
         guarantee(state != state_reconstructing);
@@ -155,22 +174,25 @@ public:
     }
 
     bool new_offset(block_size_t _block_size,
+                    block_size_t _disk_block_size,
                     uint32_t *relative_offset_out,
                     unsigned int *block_index_out) {
         // Returns true if there's enough room at the end of the extent for the new
         // block.
         guarantee(state == state_active);
-        guarantee(_block_size.ser_value() <= parent->static_config->extent_size());
+        guarantee(_disk_block_size.ser_value() <= parent->static_config->extent_size());
 
         uint32_t offset = back_relative_offset();
         guarantee(offset <= parent->static_config->extent_size());
 
-        if (offset > parent->static_config->extent_size() - _block_size.ser_value()) {
+        if (offset > parent->static_config->extent_size()
+                     - _disk_block_size.ser_value()) {
             return false;
         } else {
             *relative_offset_out = offset;
             *block_index_out = block_infos.size();
-            block_infos.push_back(block_info_t{offset, _block_size, false, false});
+            block_infos.push_back(
+                block_info_t{offset, _block_size, _disk_block_size, false, false});
             update_stats(nullptr, &block_infos.back());
             return true;
         }
@@ -222,7 +244,7 @@ public:
         uint32_t b = 0;
         for (auto it = block_infos.begin(); it < block_infos.end(); ++it) {
             if (it->token_referenced) {
-                b += aligned_value(it->block_size);
+                b += aligned_value(it->disk_block_size);
             }
         }
         return b;
@@ -239,22 +261,27 @@ public:
                                 &gc_entry_t::info_less);
     }
 
-    void mark_live_indexwise_with_offset(int64_t offset, block_size_t _block_size) {
+    void mark_live_indexwise_with_offset(int64_t offset, block_size_t _block_size,
+                                         block_size_t _disk_block_size) {
         guarantee(offset >= extent_ref.offset() && offset < extent_ref.offset() + UINT32_MAX);
 
         uint32_t _relative_offset = offset - extent_ref.offset();
 
         auto it = find_lower_bound_iter(_relative_offset);
         if (it == block_infos.end()) {
-            block_infos.push_back(block_info_t{_relative_offset, _block_size, false, true});
+            block_infos.push_back(block_info_t{_relative_offset, _block_size,
+                                               _disk_block_size, false, true});
             update_stats(nullptr, &block_infos.back());
         } else if (it->relative_offset > _relative_offset) {
-            guarantee(it->relative_offset >= _relative_offset + aligned_value(_block_size));
-            auto new_block = block_infos.insert(it, block_info_t{_relative_offset, _block_size, false, true});
+            guarantee(it->relative_offset
+                      >= _relative_offset + aligned_value(_disk_block_size));
+            auto new_block = block_infos.insert(it, block_info_t{_relative_offset,
+                _block_size, _disk_block_size, false, true});
             update_stats(nullptr, &*new_block);
         } else {
             guarantee(it->relative_offset == _relative_offset);
             guarantee(it->block_size == _block_size);
+            guarantee(it->disk_block_size == _disk_block_size);
             const block_info_t old_info = *it;
             it->index_referenced = true;
             update_stats(&old_info, &*it);
@@ -278,7 +305,7 @@ public:
         uint32_t b = 0;
         for (auto it = block_infos.begin(); it < block_infos.end(); ++it) {
             if (it->index_referenced) {
-                b += aligned_value(it->block_size);
+                b += aligned_value(it->disk_block_size);
             }
         }
         return b;
@@ -295,7 +322,7 @@ public:
         for (auto it = block_infos.begin(); it != block_infos.end(); ++it) {
             ret += strprintf("%s[%" PRIi64 "..+%" PRIu32 ") %c%c",
                              it == block_infos.begin() ? "" : separator,
-                             offset + it->relative_offset, it->block_size.ser_value(),
+                             offset + it->relative_offset, it->disk_block_size.ser_value(),
                              it->token_referenced ? 'T' : ' ',
                              it->index_referenced ? 'I' : ' ');
         }
@@ -320,14 +347,14 @@ private:
             if (old_block->token_referenced || old_block->index_referenced) {
                 // Block is live
                 num_live_blocks_stat -= 1;
-                garbage_bytes_stat += aligned_value(old_block->block_size);
+                garbage_bytes_stat += aligned_value(old_block->disk_block_size);
             }
         }
         // Apply new_block
         if (new_block->token_referenced || new_block->index_referenced) {
             // Block is live
             num_live_blocks_stat += 1;
-            garbage_bytes_stat -= aligned_value(new_block->block_size);
+            garbage_bytes_stat -= aligned_value(new_block->disk_block_size);
         }
     }
 
@@ -396,7 +423,8 @@ data_block_manager_t::data_block_manager_t(
       /* The capacity of the gc_index_write_semaphore will be scaled
       based on the active number of GC threads. */
       gc_index_write_semaphore(1),
-      gc_stats(stats)
+      gc_stats(stats),
+      reads_in_flight(0)
 {
     rassert(static_config != nullptr);
     rassert(extent_manager != nullptr);
@@ -405,6 +433,8 @@ data_block_manager_t::data_block_manager_t(
 
 data_block_manager_t::~data_block_manager_t() {
     guarantee(state == state_unstarted || state == state_shut_down);
+    guarantee(pending_reads.empty());
+    guarantee(reads_in_flight == 0);
 }
 
 void data_block_manager_t::prepare_initial_metablock(data_block_manager::metablock_mixin_t *mb) {
@@ -419,7 +449,8 @@ void data_block_manager_t::start_reconstruct() {
 // gc_entry_t in the entries table.  (This is used when we start up, when
 // everything is presumed to be garbage, until we mark it as
 // non-garbage.)
-void data_block_manager_t::mark_live(int64_t offset, block_size_t ser_block_size) {
+void data_block_manager_t::mark_live(int64_t offset, block_size_t block_size,
+                                     block_size_t disk_block_size) {
     uint64_t extent_id = static_config->extent_index(offset);
 
     if (entries.get(extent_id) == nullptr) {
@@ -430,7 +461,7 @@ void data_block_manager_t::mark_live(int64_t offset, block_size_t ser_block_size
     }
 
     gc_entry_t *entry = entries.get(extent_id);
-    entry->mark_live_indexwise_with_offset(offset, ser_block_size);
+    entry->mark_live_indexwise_with_offset(offset, block_size, disk_block_size);
 }
 
 void data_block_manager_t::end_reconstruct() {
@@ -573,6 +604,15 @@ void read_ahead_offset_and_size(int64_t off_in,
     *size_out = end_offset - offset;
 }
 
+// Turns a block the way it was read from disk into the block the cache expects.
+buf_ptr_t decompress_if_necessary(buf_ptr_t &&disk_buf, block_size_t block_size) {
+    if (disk_buf.block_size() == block_size) {
+        return std::move(disk_buf);
+    } else {
+        return decompress_block(disk_buf, block_size);
+    }
+}
+
 class dbm_read_ahead_t {
 public:
     static std::vector<uint32_t> get_boundaries(data_block_manager_t *parent,
@@ -650,15 +690,20 @@ public:
                     continue;
                 }
 
-                const block_size_t block_size = block_size_t::unsafe_make(info.ser_block_size);
-                buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(block_size);
+                const block_size_t block_size
+                    = block_size_t::unsafe_make(info.uncompressed_ser_block_size);
+                const block_size_t disk_block_size
+                    = block_size_t::unsafe_make(info.ser_block_size);
+                buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(disk_block_size);
                 memcpy(buf.ser_buffer(), current_buf, info.ser_block_size);
                 buf.fill_padding_zero();
                 guarantee(info.ser_block_size <= *(lower_it + 1) - *lower_it);
+                buf = decompress_if_necessary(std::move(buf), block_size);
 
                 counted_t<ls_block_token_pointee_t> ls_token
                     = parent->serializer->generate_block_token(current_offset,
-                                                               block_size);
+                                                               block_size,
+                                                               disk_block_size);
 
                 counted_t<standard_block_token_t> token
                     = to_standard_block_token(block_id, std::move(ls_token));
@@ -686,42 +731,142 @@ bool data_block_manager_t::should_perform_read_ahead(int64_t offset) {
 }
 
 buf_ptr_t data_block_manager_t::read(int64_t off_in, block_size_t block_size,
-                                   file_account_t *io_account) {
+                                     block_size_t disk_block_size,
+                                     file_account_t *io_account) {
     guarantee(state == state_ready);
     if (should_perform_read_ahead(off_in)) {
-        buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
-        dbm_read_ahead_t::perform_read_ahead(this, off_in, block_size.ser_value(),
+        buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(disk_block_size);
+        dbm_read_ahead_t::perform_read_ahead(this, off_in, disk_block_size.ser_value(),
                                              ret.ser_buffer(), io_account, stats);
         // We have to fill the padding with zero, since only the first part of the
         // buf got memcpy'd into.
         ret.fill_padding_zero();
-        return ret;
+        return decompress_if_necessary(std::move(ret), block_size);
     } else {
         if (divides(DEVICE_BLOCK_SIZE, off_in)) {
-            buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
-            co_read(dbfile, off_in, ret.aligned_block_size(),
-                    ret.ser_buffer(), io_account);
+            buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(disk_block_size);
+            coalesced_read(off_in, ret.aligned_block_size(),
+                           ret.ser_buffer(), io_account);
             stats->bytes_read(ret.aligned_block_size());
             // Blocks are written DEVICE_BLOCK_SIZE-aligned -- so the block on disk
             // should have been written with zero padding.
             ret.assert_padding_zero();
-            return ret;
+            return decompress_if_necessary(std::move(ret), block_size);
         } else {
             int64_t floor_off_in = floor_aligned(off_in, DEVICE_BLOCK_SIZE);
-            int64_t ceil_off_end = ceil_aligned(off_in + block_size.ser_value(),
+            int64_t ceil_off_end = ceil_aligned(off_in + disk_block_size.ser_value(),
                                                 DEVICE_BLOCK_SIZE);
             scoped_device_block_aligned_ptr_t<char> buf(ceil_off_end - floor_off_in);
-            co_read(dbfile, floor_off_in, ceil_off_end - floor_off_in,
-                    buf.get(), io_account);
+            coalesced_read(floor_off_in, ceil_off_end - floor_off_in,
+                           buf.get(), io_account);
 
-            buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
+            buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(disk_block_size);
             memcpy(ret.ser_buffer(), buf.get() + (off_in - floor_off_in),
-                   block_size.ser_value());
+                   disk_block_size.ser_value());
             stats->bytes_read(ret.aligned_block_size());
             // We have to fill the padding to zero, in this case.
             ret.fill_padding_zero();
-            return ret;
+            return decompress_if_necessary(std::move(ret), block_size);
+        }
+    }
+}
+
+void data_block_manager_t::coalesced_read(int64_t offset, int64_t length,
+                                          void *buf_out,
+                                          file_account_t *io_account) {
+    rassert(divides(DEVICE_BLOCK_SIZE, offset));
+    rassert(divides(DEVICE_BLOCK_SIZE, length));
+
+    // There's nothing to merge this read with, so don't wait for one.
+    if (pending_reads.empty() && reads_in_flight == 0) {
+        ++reads_in_flight;
+        co_read(dbfile, offset, length, buf_out, io_account);
+        --reads_in_flight;
+        return;
+    }
+
+    pending_read_t read;
+    read.offset = offset;
+    read.length = length;
+    read.buf_out = static_cast<char *>(buf_out);
+    read.io_account = io_account;
+
+    // Other reads are in flight, so more are likely to follow.  The first read of this
+    // pass of the event loop schedules the reads.  Everybody who calls `block_read`
+    // before that coroutine runs gets merged in.
+    if (pending_reads.empty()) {
+        coro_t::spawn_later_ordered(
+            std::bind(&data_block_manager_t::issue_pending_reads, this));
+    }
+    pending_reads.push_back(&read);
+    read.done.wait();
+}
+
+void data_block_manager_t::issue_pending_reads() {
+    std::vector<pending_read_t *> reads;
+    reads.swap(pending_reads);
+
+    // Reads on different accounts have different priorities, so we only merge reads
+    // on the same account.
+    std::sort(reads.begin(), reads.end(),
+              [](const pending_read_t *x, const pending_read_t *y) {
+                  return x->io_account != y->io_account
+                      ? std::less<file_account_t *>()(x->io_account, y->io_account)
+                      : x->offset < y->offset;
+              });
+
+    size_t group_begin = 0;
+    while (group_begin < reads.size()) {
+        const int64_t offset = reads[group_begin]->offset;
+        int64_t end_offset = offset + reads[group_begin]->length;
+        size_t group_end = group_begin + 1;
+        while (group_end < reads.size()) {
+            const pending_read_t *next = reads[group_end];
+            const int64_t next_end_offset =
+                std::max(end_offset, next->offset + next->length);
+            if (next->io_account != reads[group_begin]->io_account
+                || next->offset > end_offset + MAX_COALESCED_READ_GAP
+                || next_end_offset - offset > MAX_COALESCED_READ_SIZE) {
+                break;
+            }
+            end_offset = next_end_offset;
+            ++group_end;
+        }
+
+        std::vector<pending_read_t *> group(reads.begin() + group_begin,
+                                            reads.begin() + group_end);
+        ++reads_in_flight;
+        if (group_end == reads.size()) {
+            // We issue the last group from this coroutine.
+            read_and_distribute(group, offset, end_offset);
+        } else {
+            coro_t::spawn_sometime(
+                std::bind(&data_block_manager_t::read_and_distribute, this,
+                          std::move(group), offset, end_offset));
         }
+        group_begin = group_end;
+    }
+}
+
+void data_block_manager_t::read_and_distribute(
+        const std::vector<pending_read_t *> &reads,
+        int64_t offset, int64_t end_offset) {
+    guarantee(!reads.empty());
+    if (reads.size() == 1) {
+        co_read(dbfile, offset, end_offset - offset,
+                reads[0]->buf_out, reads[0]->io_account);
+    } else {
+        scoped_device_block_aligned_ptr_t<char> buf(end_offset - offset);
+        co_read(dbfile, offset, end_offset - offset,
+                buf.get(), reads[0]->io_account);
+        for (pending_read_t *read : reads) {
+            memcpy(read->buf_out, buf.get() + (read->offset - offset), read->length);
+        }
+        stats->pm_serializer_coalesced_block_reads += reads.size();
+    }
+    --reads_in_flight;
+    for (pending_read_t *read : reads) {
+        read->done.pulse();
     }
 }
 
@@ -729,15 +874,58 @@ std::vector<counted_t<ls_block_token_pointee_t> >
 data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
                                   file_account_t *io_account,
                                   iocallback_t *cb) {
-    // These tokens are grouped by extent.  You can do a contiguous write in each
-    // extent.
-    std::vector<std::vector<counted_t<ls_block_token_pointee_t> > > token_groups
-        = gimme_some_new_offsets(writes);
+    const block_codec_t codec = serializer->dynamic_config.block_codec;
 
     for (auto it = writes.begin(); it != writes.end(); ++it) {
         it->buf->ser_header.block_id = it->block_id;
     }
 
+    // Compressing a large flush is pure computation on buffers that nobody else
+    // touches until the writes have been issued, so we let an idle thread do it.
+    std::vector<buf_ptr_t> compressed(writes.size());
+    if (codec != block_codec_t::none) {
+        migratable_section_t migratable;
+        for (size_t i = 0; i < writes.size(); ++i) {
+            compressed[i] = compress_block(codec, writes[i].buf, writes[i].block_size);
+        }
+    }
+
+    std::vector<disk_write_t> disk_writes;
+    disk_writes.reserve(writes.size());
+    std::vector<buf_ptr_t> compressed_bufs;
+    for (size_t i = 0; i < writes.size(); ++i) {
+        const buf_write_info_t *it = &writes[i];
+        if (compressed[i].has()) {
+            stats->block_compressed(it->block_size.ser_value(),
+                                    compressed[i].block_size().ser_value());
+            disk_writes.push_back(disk_write_t{compressed[i].ser_buffer(),
+                                               it->block_size,
+                                               compressed[i].block_size()});
+            compressed_bufs.push_back(std::move(compressed[i]));
+        } else {
+            if (codec != block_codec_t::none) {
+                stats->block_compressed(it->block_size.ser_value(),
+                                        it->block_size.ser_value());
+            }
+            disk_writes.push_back(disk_write_t{it->buf,
+                                               it->block_size,
+                                               it->block_size});
+        }
+    }
+
+    return write_disk_blocks(disk_writes, std::move(compressed_bufs), io_account, cb);
+}
+
+std::vector<counted_t<ls_block_token_pointee_t> >
+data_block_manager_t::write_disk_blocks(const std::vector<disk_write_t> &writes,
+                                        std::vector<buf_ptr_t> &&owned_bufs,
+                                        file_account_t *io_account,
+                                        iocallback_t *cb) {
+    // These tokens are grouped by extent.  You can do a contiguous write in each
+    // extent.
+    std::vector<std::vector<counted_t<ls_block_token_pointee_t> > > token_groups
+        = gimme_some_new_offsets(writes);
+
     struct intermediate_cb_t : public iocallback_t {
         virtual void on_io_complete() {
             --ops_remaining;
@@ -750,9 +938,11 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
 
         size_t ops_remaining;
         iocallback_t *cb;
+        std::vector<buf_ptr_t> bufs;
     };
 
     intermediate_cb_t *const intermediate_cb = new intermediate_cb_t;
+    intermediate_cb->bufs = std::move(owned_bufs);
     // We add 1 for degenerate case where token_groups is empty -- we call
     // intermediate_cb->on_io_complete later.
     intermediate_cb->ops_remaining = token_groups.size() + 1;
@@ -763,7 +953,7 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
 
         const int64_t front_offset = token_groups[i].front()->offset();
         const int64_t back_offset = token_groups[i].back()->offset()
-            + gc_entry_t::aligned_value(token_groups[i].back()->block_size());
+            + gc_entry_t::aligned_value(token_groups[i].back()->disk_block_size());
 
         guarantee(divides(DEVICE_BLOCK_SIZE, front_offset));
 
@@ -776,14 +966,14 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
 
         for (size_t j = 0; j < token_groups[i].size(); ++j) {
             const int64_t j_offset = token_groups[i][j]->offset();
-            const block_size_t j_block_size = token_groups[i][j]->block_size();
+            const block_size_t j_disk_block_size = token_groups[i][j]->disk_block_size();
             guarantee(j_offset == last_written_offset);
-            const size_t j_aligned_size = gc_entry_t::aligned_value(j_block_size);
+            const size_t j_aligned_size = gc_entry_t::aligned_value(j_disk_block_size);
             total_aligned_size += j_aligned_size;
 
             // The behavior of gimme_some_new_offsets is supposed to retain order, so
             // we expect writes[write_number] to have the currently-relevant write.
-            guarantee(writes[write_number].block_size == j_block_size);
+            guarantee(writes[write_number].disk_block_size == j_disk_block_size);
 
             iovecs[j].iov_base = writes[write_number].buf;
             iovecs[j].iov_len = j_aligned_size;
@@ -944,7 +1134,7 @@ void data_block_manager_t::mark_garbage(int64_t offset, extent_transaction_t *tx
     // Add to old garbage count if necessary (works because of the
     // !entry->block_is_garbage(block_index) assertion above).
     if (entry->state == gc_entry_t::state_old && entry->block_is_garbage(block_index)) {
-        gc_stats.old_garbage_block_bytes += gc_entry_t::aligned_value(entry->block_size(block_index));
+        gc_stats.old_garbage_block_bytes += gc_entry_t::aligned_value(entry->disk_block_size(block_index));
     }
 
     check_and_handle_empty_extent(extent_id);
@@ -974,7 +1164,7 @@ void data_block_manager_t::mark_garbage_tokenwise_with_offset(int64_t offset) {
     // Add to old garbage count if necessary (works because of the
     // !entry->block_is_garbage(block_index) assertion above).
     if (entry->state == gc_entry_t::state_old && entry->block_is_garbage(block_index)) {
-        gc_stats.old_garbage_block_bytes += gc_entry_t::aligned_value(entry->block_size(block_index));
+        gc_stats.old_garbage_block_bytes += gc_entry_t::aligned_value(entry->disk_block_size(block_index));
     }
 
     check_and_handle_empty_extent(extent_id);
@@ -1102,7 +1292,8 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
 
                 const uint32_t end
                     = gc_state->current_entry->relative_offset(i)
-                    + gc_entry_t::aligned_value(gc_state->current_entry->block_size(i));
+                    + gc_entry_t::aligned_value(
+                        gc_state->current_entry->disk_block_size(i));
 
                 if (beg <= current_interval_end) {
                     current_interval_end = end;
@@ -1178,7 +1369,8 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
                     + gc_state->current_entry->relative_offset(i);
 
                 gc_writes.push_back(gc_write_t(block, block_offset,
-                    gc_state->current_entry->block_size(i)));
+                    gc_state->current_entry->block_size(i),
+                    gc_state->current_entry->disk_block_size(i)));
             }
             guarantee(gc_writes.size() == num_writes);
         }
@@ -1235,19 +1427,22 @@ void data_block_manager_t::write_gcs(
         // Step 1: Write buffers to disk and assemble index operations
         ASSERT_NO_CORO_WAITING;
 
-        std::vector<buf_write_info_t> the_writes;
+        // The blocks get copied exactly as they are stored, whether they are
+        // compressed or not.
+        std::vector<disk_write_t> the_writes;
         the_writes.reserve(writes.size());
         for (size_t i = 0; i < writes.size(); ++i) {
             old_block_tokens.push_back(serializer->generate_block_token(writes[i].old_offset,
-                                                                        writes[i].block_size));
+                                                                        writes[i].block_size,
+                                                                        writes[i].disk_block_size));
 
-            the_writes.push_back(buf_write_info_t(writes[i].buf,
-                                                  writes[i].block_size,
-                                                  writes[i].buf->ser_header.block_id));
+            the_writes.push_back(disk_write_t{writes[i].buf,
+                                              writes[i].block_size,
+                                              writes[i].disk_block_size});
         }
 
-        new_block_tokens = many_writes(the_writes, choose_gc_io_account(),
-                                       &block_write_cond);
+        new_block_tokens = write_disk_blocks(the_writes, std::vector<buf_ptr_t>(),
+                                             choose_gc_io_account(), &block_write_cond);
 
         guarantee(new_block_tokens.size() == writes.size());
     }
@@ -1419,7 +1614,7 @@ void data_block_manager_t::actually_shutdown() {
 }
 
 std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
-data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes) {
+data_block_manager_t::gimme_some_new_offsets(const std::vector<disk_write_t> &writes) {
     ASSERT_NO_CORO_WAITING;
 
     // Start a new extent if necessary.
@@ -1437,7 +1632,7 @@ data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t>
     for (auto it = writes.begin(); it != writes.end(); ++it) {
         uint32_t relative_offset = valgrind_undefined<uint32_t>(UINT32_MAX);
         unsigned int block_index = valgrind_undefined<unsigned int>(UINT_MAX);
-        if (!active_extent->new_offset(it->block_size,
+        if (!active_extent->new_offset(it->block_size, it->disk_block_size,
                                        &relative_offset, &block_index)) {
             // Move the active_extent gc_entry_t to the young extent queue (if it's
             // not already empty), and make a new gc_entry_t.
@@ -1454,6 +1649,7 @@ data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t>
 
             ++stats->pm_serializer_data_extents_allocated;
             const bool succeeded = active_extent->new_offset(it->block_size,
+                                                             it->disk_block_size,
                                                              &relative_offset,
                                                              &block_index);
             guarantee(succeeded);
@@ -1469,7 +1665,8 @@ data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t>
         active_extent->was_written = true;
         active_extent->mark_live_tokenwise(block_index);
 
-        tokens.push_back(serializer->generate_block_token(offset, it->block_size));
+        tokens.push_back(serializer->generate_block_token(offset, it->block_size,
+                                                          it->disk_block_size));
     }
 
     if (!tokens.empty()) {
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "arch/types.hpp"
+#include "concurrency/cond_var.hpp"
 #include "concurrency/new_semaphore.hpp"
 #include "concurrency/pump_coro.hpp"
 #include "containers/intrusive_list.hpp"
@@ -47,8 +48,10 @@ public:
     static void prepare_initial_metablock(data_block_manager::metablock_mixin_t *mb);
     void start_existing(file_t *dbfile, data_block_manager::metablock_mixin_t *last_metablock);
 
+    // Reads the `disk_block_size` bytes that the block takes up on disk, and
+    // decompresses them into a block of `block_size` if necessary.
     buf_ptr_t read(int64_t off_in, block_size_t block_size,
-                 file_account_t *io_account);
+                   block_size_t disk_block_size, file_account_t *io_account);
 
     /* exposed gc api */
     /* mark a buffer as garbage */
@@ -56,7 +59,8 @@ public:
 
     /* r{start,end}_reconstruct functions for safety */
     void start_reconstruct();
-    void mark_live(int64_t offset, block_size_t block_size);
+    void mark_live(int64_t offset, block_size_t block_size,
+                   block_size_t disk_block_size);
     void end_reconstruct();
 
     /* We must make sure that blocks which have tokens pointing to them don't
@@ -81,13 +85,22 @@ public:
     // ratio of garbage to blocks in the system
     double garbage_ratio() const;
 
+    // Compresses the blocks first, if the serializer is configured to do so.
     std::vector<counted_t<ls_block_token_pointee_t> >
     many_writes(const std::vector<buf_write_info_t> &writes,
                 file_account_t *io_account,
                 iocallback_t *cb);
 
+    // A block the way it gets written to disk.  `buf` holds the `disk_block_size`
+    // bytes that get written, which decompress to a block of `block_size`.
+    struct disk_write_t {
+        ser_buffer_t *buf;
+        block_size_t block_size;
+        block_size_t disk_block_size;
+    };
+
     std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
-    gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes);
+    gimme_some_new_offsets(const std::vector<disk_write_t> &writes);
 
     bool is_gc_active() const;
 
@@ -110,12 +123,21 @@ private:
         ser_buffer_t *buf;
         int64_t old_offset;
         block_size_t block_size;
+        block_size_t disk_block_size;
         gc_write_t(ser_buffer_t *b, int64_t _old_offset,
-                   block_size_t _block_size)
+                   block_size_t _block_size, block_size_t _disk_block_size)
             : buf(b), old_offset(_old_offset),
-              block_size(_block_size) { }
+              block_size(_block_size), disk_block_size(_disk_block_size) { }
     };
 
+    // Writes the blocks as they are.  `owned_bufs` are freed once the writes are
+    // done.
+    std::vector<counted_t<ls_block_token_pointee_t> >
+    write_disk_blocks(const std::vector<disk_write_t> &writes,
+                      std::vector<buf_ptr_t> &&owned_bufs,
+                      file_account_t *io_account,
+                      iocallback_t *cb);
+
     /* Runs in a coroutine and keeps calling `gc_one_extent()` for as long as
     we should keep GCing. */
     void run_gc(gc_state_t *gc_state);
@@ -159,6 +181,28 @@ private:
 
     bool should_perform_read_ahead(int64_t offset);
 
+    // A read waiting in `pending_reads` to be merged with reads of nearby blocks.
+    struct pending_read_t {
+        int64_t offset;
+        int64_t length;
+        char *buf_out;
+        file_account_t *io_account;
+        cond_t done;
+    };
+
+    // Reads `length` bytes at `offset`, both DEVICE_BLOCK_SIZE-aligned.  If no other
+    // read is in flight, the read is issued right away.  Otherwise reads that arrive
+    // during the same pass of the event loop are merged into as few disk reads as
+    // possible.  The blocks of a large blob get loaded concurrently and were mostly
+    // written next to each other, so this reads most of them with a single I/O.
+    // (This stands in for storing large values as one variable-size extent, which
+    // would need a new block type in the LBA, the GC and the page cache.)
+    void coalesced_read(int64_t offset, int64_t length, void *buf_out,
+                        file_account_t *io_account);
+    void issue_pending_reads();
+    void read_and_distribute(const std::vector<pending_read_t *> &reads,
+                             int64_t offset, int64_t end_offset);
+
     log_serializer_stats_t *const stats;
 
     // This is permitted to destroy the data_block_manager.
@@ -262,6 +306,12 @@ private:
 
     gc_stats_t gc_stats;
 
+    // Reads collected by `coalesced_read` that haven't been issued yet.
+    std::vector<pending_read_t *> pending_reads;
+
+    // The number of disk reads started by `coalesced_read` that haven't completed.
+    int64_t reads_in_flight;
+
     DISABLE_COPYING(data_block_manager_t);
 };
 
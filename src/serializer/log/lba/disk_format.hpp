@@ -68,8 +68,11 @@ ATTR_PACKED(struct lba_entry_t {
     // the first 16 bits, perhaps, as a version flag.
     uint32_t zero_reserved;
 
-    // This could be a uint16_t if you wanted it to be, as long as block sizes are
-    // all less than or equal to 4K (which is less than 64K).
+    // The lower 16 bits hold the number of bytes the block takes up on disk.  If the
+    // block is stored compressed, the upper 16 bits hold its size once decompressed,
+    // otherwise they are zero.  (Older versions refuse to load entries that have any
+    // of the upper bits set, instead of misreading compressed blocks.)  Use
+    // `pack_ser_block_size()` and `unpack_ser_block_size()` to access this.
     uint32_t ser_block_size;
 
     block_id_t block_id;
@@ -91,6 +94,22 @@ ATTR_PACKED(struct lba_entry_t {
         return entry;
     }
 
+    static uint32_t pack_ser_block_size(uint16_t ser_block_size,
+                                        uint16_t uncompressed_ser_block_size) {
+        return ser_block_size == uncompressed_ser_block_size
+            ? ser_block_size
+            : (static_cast<uint32_t>(uncompressed_ser_block_size) << 16) | ser_block_size;
+    }
+
+    static void unpack_ser_block_size(uint32_t packed,
+                                      uint16_t *ser_block_size_out,
+                                      uint16_t *uncompressed_ser_block_size_out) {
+        *ser_block_size_out = static_cast<uint16_t>(packed & 0xFFFF);
+        *uncompressed_ser_block_size_out = (packed >> 16) == 0
+            ? *ser_block_size_out
+            : static_cast<uint16_t>(packed >> 16);
+    }
+
     static bool is_padding(const lba_entry_t *entry) {
         return entry->block_id == PADDING_BLOCK_ID  && entry->offset.is_padding();
     }
@@ -12,25 +12,33 @@ ATTR_PACKED(struct index_block_info_t {
     index_block_info_t()
         : offset(flagged_off64_t::unused()),
           recency(repli_timestamp_t::invalid),
-          ser_block_size(0) { }
+          ser_block_size(0),
+          uncompressed_ser_block_size(0) { }
 
     index_block_info_t(flagged_off64_t _offset,
                        repli_timestamp_t _recency,
-                       uint16_t _ser_block_size)
+                       uint16_t _ser_block_size,
+                       uint16_t _uncompressed_ser_block_size)
         : offset(_offset),
           recency(_recency),
-          ser_block_size(_ser_block_size) { }
+          ser_block_size(_ser_block_size),
+          uncompressed_ser_block_size(_uncompressed_ser_block_size) { }
 
     // For two_level_array_t.
     bool operator==(const index_block_info_t &other) const {
         return offset == other.offset &&
             recency == other.recency &&
-            ser_block_size == other.ser_block_size;
+            ser_block_size == other.ser_block_size &&
+            uncompressed_ser_block_size == other.uncompressed_ser_block_size;
     }
 
     flagged_off64_t offset;
     repli_timestamp_t recency;
+    // The number of bytes the block takes up on disk...
     uint16_t ser_block_size;
+    // ... and its size once decompressed.  The two are the same unless the block is
+    // stored compressed.
+    uint16_t uncompressed_ser_block_size;
 });
 
 /* This is a reduced-size block info for auxiliary blocks (currently
@@ -39,21 +47,26 @@ timestamp, because we don't need it for those blocks. */
 ATTR_PACKED(struct index_aux_block_info_t {
     index_aux_block_info_t()
         : offset(flagged_off64_t::unused()),
-          ser_block_size(0) { }
+          ser_block_size(0),
+          uncompressed_ser_block_size(0) { }
 
     index_aux_block_info_t(flagged_off64_t _offset,
-                           uint16_t _ser_block_size)
+                           uint16_t _ser_block_size,
+                           uint16_t _uncompressed_ser_block_size)
         : offset(_offset),
-          ser_block_size(_ser_block_size) { }
+          ser_block_size(_ser_block_size),
+          uncompressed_ser_block_size(_uncompressed_ser_block_size) { }
 
     // For two_level_array_t.
     bool operator==(const index_aux_block_info_t &other) const {
         return offset == other.offset &&
-            ser_block_size == other.ser_block_size;
+            ser_block_size == other.ser_block_size &&
+            uncompressed_ser_block_size == other.uncompressed_ser_block_size;
     }
 
     flagged_off64_t offset;
     uint16_t ser_block_size;
+    uint16_t uncompressed_ser_block_size;
 });
 
 
@@ -73,7 +86,8 @@ public:
 
     index_block_info_t get_block_info(block_id_t id);
     void set_block_info(block_id_t id, repli_timestamp_t recency,
-                        flagged_off64_t offset, uint16_t ser_block_size);
+                        flagged_off64_t offset, uint16_t ser_block_size,
+                        uint16_t uncompressed_ser_block_size);
 
 };
 
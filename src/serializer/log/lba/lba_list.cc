@@ -101,15 +101,17 @@ public:
             // the metablock into the index:
             for (int32_t i = 0; i < owner->inline_lba_entries_count; ++i) {
                 lba_entry_t *e = &owner->inline_lba_entries[i];
-                // The on-disk format still stores 32 bit block sizes.
-                // We've never actually used them, and we now use 16 bit block sizes
-                // for the in-memory index to save a few bytes.
-                guarantee(e->ser_block_size <= std::numeric_limits<uint16_t>::max());
+                uint16_t ser_block_size;
+                uint16_t uncompressed_ser_block_size;
+                lba_entry_t::unpack_ser_block_size(e->ser_block_size,
+                                                   &ser_block_size,
+                                                   &uncompressed_ser_block_size);
                 owner->in_memory_index.set_block_info(
                         e->block_id,
                         e->recency,
                         e->offset,
-                        static_cast<uint16_t>(e->ser_block_size));
+                        ser_block_size,
+                        uncompressed_ser_block_size);
             }
 
             owner->state = lba_list_t::state_ready;
@@ -161,6 +163,10 @@ uint32_t lba_list_t::get_ser_block_size(block_id_t block) {
 }
 
 block_size_t lba_list_t::get_block_size(block_id_t block) {
+    return block_size_t::unsafe_make(get_block_info(block).uncompressed_ser_block_size);
+}
+
+block_size_t lba_list_t::get_disk_block_size(block_id_t block) {
     return block_size_t::unsafe_make(get_block_info(block).ser_block_size);
 }
 
@@ -192,13 +198,19 @@ segmented_vector_t<repli_timestamp_t> lba_list_t::get_block_recencies(block_id_t
 
 void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
                                 flagged_off64_t offset, uint32_t ser_block_size,
+                                uint32_t uncompressed_ser_block_size,
                                 file_account_t *io_account, extent_transaction_t *txn) {
     rassert(state == state_ready || state == state_gc_shutting_down);
 
     guarantee(ser_block_size <= std::numeric_limits<uint16_t>::max());
+    guarantee(uncompressed_ser_block_size <= std::numeric_limits<uint16_t>::max());
+    guarantee(ser_block_size <= uncompressed_ser_block_size);
     uint16_t ser_block_size_16 = static_cast<uint16_t>(ser_block_size);
+    uint16_t uncompressed_ser_block_size_16
+        = static_cast<uint16_t>(uncompressed_ser_block_size);
 
-    in_memory_index.set_block_info(block, recency, offset, ser_block_size_16);
+    in_memory_index.set_block_info(block, recency, offset, ser_block_size_16,
+                                   uncompressed_ser_block_size_16);
 
     // If the inline LBA is full, free it up first by moving its entries to
     // the LBA extents
@@ -207,7 +219,9 @@ void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
         rassert(!check_inline_lba_full());
     }
     // Then store the entry inline
-    add_inline_entry(block, recency, offset, ser_block_size_16);
+    add_inline_entry(block, recency, offset,
+                     lba_entry_t::pack_ser_block_size(ser_block_size_16,
+                                                      uncompressed_ser_block_size_16));
 }
 
 bool lba_list_t::check_inline_lba_full() const {
@@ -253,11 +267,11 @@ void lba_list_t::move_inline_entries_to_extents(file_account_t *io_account, exte
 }
 
 void lba_list_t::add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                                flagged_off64_t offset, uint16_t ser_block_size) {
+                                flagged_off64_t offset, uint32_t packed_ser_block_size) {
 
     rassert(!check_inline_lba_full());
     inline_lba_entries[inline_lba_entries_count++] =
-            lba_entry_t::make(block, recency, offset, ser_block_size);
+            lba_entry_t::make(block, recency, offset, packed_ser_block_size);
 }
 
 class lba_syncer_t :
@@ -348,11 +362,13 @@ void lba_list_t::gc(int lba_shard, auto_drainer_t::lock_t) {
 
         flagged_off64_t off = get_block_offset(id);
         if (off.has_value()) {
-            uint32_t ser_block_size = get_ser_block_size(id);
+            const index_block_info_t info = get_block_info(id);
             disk_structures[lba_shard]->add_entry(id,
-                                                  get_block_recency(id),
+                                                  info.recency,
                                                   off,
-                                                  ser_block_size,
+                                                  lba_entry_t::pack_ser_block_size(
+                                                      info.ser_block_size,
+                                                      info.uncompressed_ser_block_size),
                                                   gc_io_account.get(),
                                                   txns.back().get());
         }
@@ -45,7 +45,9 @@ public:
     // These return individual fields of get_block_info.
     flagged_off64_t get_block_offset(block_id_t block);
     uint32_t get_ser_block_size(block_id_t block);
+    // The size of the block once decompressed, and the size it takes up on disk.
     block_size_t get_block_size(block_id_t block);
+    block_size_t get_disk_block_size(block_id_t block);
     repli_timestamp_t get_block_recency(block_id_t block);
     segmented_vector_t<repli_timestamp_t> get_block_recencies(block_id_t first,
                                                               block_id_t step);
@@ -63,6 +65,7 @@ public:
 
     void set_block_info(block_id_t block, repli_timestamp_t recency,
                         flagged_off64_t offset, uint32_t ser_block_size,
+                        uint32_t uncompressed_ser_block_size,
                         file_account_t *io_account,
                         extent_transaction_t *txn);
 
@@ -117,7 +120,7 @@ private:
     bool check_inline_lba_full() const;
     void move_inline_entries_to_extents(file_account_t *io_account, extent_transaction_t *txn);
     void add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                                flagged_off64_t offset, uint16_t ser_block_size);
+                                flagged_off64_t offset, uint32_t packed_ser_block_size);
 
     lba_disk_structure_t *disk_structures[LBA_SHARD_FACTOR];
 
@@ -129,6 +129,10 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
       pm_serializer_data_extents_gced(),
       pm_serializer_old_garbage_block_bytes(),
       pm_serializer_old_total_block_bytes(),
+      pm_serializer_block_compression_ratio(secs_to_ticks(1), false),
+      pm_serializer_compressed_blocks_written(),
+      pm_serializer_compression_saved_bytes_total(),
+      pm_serializer_coalesced_block_reads(),
       pm_serializer_lba_gcs(),
       parent_collection_membership(parent, &serializer_collection, "serializer"),
       stats_membership(&serializer_collection,
@@ -149,6 +153,10 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
           &pm_serializer_data_extents_gced, "serializer_data_extents_gced",
           &pm_serializer_old_garbage_block_bytes, "serializer_old_garbage_block_bytes",
           &pm_serializer_old_total_block_bytes, "serializer_old_total_block_bytes",
+          &pm_serializer_block_compression_ratio, "serializer_block_compression_ratio",
+          &pm_serializer_compressed_blocks_written, "serializer_compressed_blocks_written",
+          &pm_serializer_compression_saved_bytes_total, "serializer_compression_saved_bytes_total",
+          &pm_serializer_coalesced_block_reads, "serializer_coalesced_block_reads",
           &pm_serializer_lba_gcs, "serializer_lba_gcs")
 { }
 
@@ -162,6 +170,18 @@ void log_serializer_stats_t::bytes_written(size_t count) {
     pm_serializer_written_bytes_total += count;
 }
 
+void log_serializer_stats_t::block_compressed(uint32_t ser_block_size,
+                                              uint32_t disk_ser_block_size) {
+    pm_serializer_block_compression_ratio.record(
+        static_cast<double>(ser_block_size) / disk_ser_block_size);
+    if (disk_ser_block_size < ser_block_size) {
+        ++pm_serializer_compressed_blocks_written;
+        pm_serializer_compression_saved_bytes_total +=
+            ceil_aligned(ser_block_size, DEVICE_BLOCK_SIZE)
+            - ceil_aligned(disk_ser_block_size, DEVICE_BLOCK_SIZE);
+    }
+}
+
 void log_serializer_t::create(serializer_file_opener_t *file_opener, static_config_t static_config) {
     log_serializer_on_disk_static_config_t *on_disk_config = &static_config;
 
@@ -307,7 +327,8 @@ struct ls_start_existing_fsm_t :
                     ser->lba_index->get_block_offset(next_block_to_reconstruct);
                 if (offset.has_value()) {
                     ser->data_block_manager->mark_live(offset.get_value(),
-                        ser->lba_index->get_block_size(next_block_to_reconstruct));
+                        ser->lba_index->get_block_size(next_block_to_reconstruct),
+                        ser->lba_index->get_disk_block_size(next_block_to_reconstruct));
                 }
 
                 ++next_block_to_reconstruct;
@@ -448,7 +469,7 @@ buf_ptr_t log_serializer_t::block_read(const counted_t<ls_block_token_pointee_t>
     stats->pm_serializer_block_reads.begin(&pm_time);
 
     buf_ptr_t ret = data_block_manager->read(token->offset_, token->block_size(),
-                                           io_account);
+                                             token->disk_block_size(), io_account);
 
     stats->pm_serializer_block_reads.end(&pm_time);
     return ret;
@@ -493,8 +514,10 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
              write_op_it != write_ops.end();
              ++write_op_it) {
             const index_write_op_t &op = *write_op_it;
-            flagged_off64_t offset = lba_index->get_block_offset(op.block_id);
-            uint32_t ser_block_size = lba_index->get_ser_block_size(op.block_id);
+            const index_block_info_t info = lba_index->get_block_info(op.block_id);
+            flagged_off64_t offset = info.offset;
+            uint32_t ser_block_size = info.ser_block_size;
+            uint32_t uncompressed_ser_block_size = info.uncompressed_ser_block_size;
 
             if (op.token) {
                 // Update the offset pointed to, and mark garbage/liveness as necessary.
@@ -509,21 +532,25 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                 // Write new token to index, or remove from index as appropriate.
                 if (token.has()) {
                     offset = flagged_off64_t::make(token->offset_);
-                    ser_block_size = token->block_size().ser_value();
+                    ser_block_size = token->disk_block_size().ser_value();
+                    uncompressed_ser_block_size = token->block_size().ser_value();
 
                     /* mark the life */
-                    data_block_manager->mark_live(offset.get_value(), token->block_size());
+                    data_block_manager->mark_live(offset.get_value(), token->block_size(),
+                                                  token->disk_block_size());
                 } else {
                     offset = flagged_off64_t::unused();
                     ser_block_size = 0;
+                    uncompressed_ser_block_size = 0;
                 }
             }
 
             repli_timestamp_t recency = op.recency ? op.recency.get()
-                : lba_index->get_block_recency(op.block_id);
+                : info.recency;
 
             lba_index->set_block_info(op.block_id, recency,
                                       offset, ser_block_size,
+                                      uncompressed_ser_block_size,
                                       index_writes_io_account.get(), &txn);
         }
     }
@@ -651,9 +678,11 @@ void log_serializer_t::write_metablock_sans_pipelining(const signal_t *safe_to_w
 }
 
 counted_t<ls_block_token_pointee_t>
-log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size) {
+log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size,
+                                       block_size_t disk_block_size) {
     assert_thread();
-    counted_t<ls_block_token_pointee_t> ret(new ls_block_token_pointee_t(this, offset, block_size));
+    counted_t<ls_block_token_pointee_t> ret(
+        new ls_block_token_pointee_t(this, offset, block_size, disk_block_size));
     return ret;
 }
 
@@ -797,7 +826,10 @@ counted_t<ls_block_token_pointee_t> log_serializer_t::index_read(block_id_t bloc
 
     index_block_info_t info = lba_index->get_block_info(block_id);
     if (info.offset.has_value()) {
-        return generate_block_token(info.offset.get_value(), block_size_t::unsafe_make(info.ser_block_size));
+        return generate_block_token(
+            info.offset.get_value(),
+            block_size_t::unsafe_make(info.uncompressed_ser_block_size),
+            block_size_t::unsafe_make(info.ser_block_size));
     } else {
         return counted_t<ls_block_token_pointee_t>();
     }
@@ -982,9 +1014,11 @@ bool log_serializer_t::should_perform_read_ahead() {
 
 ls_block_token_pointee_t::ls_block_token_pointee_t(log_serializer_t *serializer,
                                                    int64_t initial_offset,
-                                                   block_size_t initial_block_size)
+                                                   block_size_t initial_block_size,
+                                                   block_size_t initial_disk_block_size)
     : serializer_(serializer), ref_count_(0),
-      block_size_(initial_block_size), offset_(initial_offset) {
+      block_size_(initial_block_size), disk_block_size_(initial_disk_block_size),
+      offset_(initial_offset) {
     serializer_->assert_thread();
     serializer_->register_block_token(this, initial_offset);
 }
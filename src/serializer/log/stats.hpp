@@ -10,6 +10,7 @@ struct log_serializer_stats_t {
 
     void bytes_read(size_t count);
     void bytes_written(size_t count);
+    void block_compressed(uint32_t ser_block_size, uint32_t disk_ser_block_size);
 
     perfmon_duration_sampler_t pm_serializer_block_reads;
     perfmon_counter_t pm_serializer_index_reads;
@@ -35,6 +36,10 @@ struct log_serializer_stats_t {
     perfmon_counter_t pm_serializer_data_extents_gced;
     perfmon_counter_t pm_serializer_old_garbage_block_bytes;
     perfmon_counter_t pm_serializer_old_total_block_bytes;
+    perfmon_sampler_t pm_serializer_block_compression_ratio;
+    perfmon_counter_t pm_serializer_compressed_blocks_written;
+    perfmon_counter_t pm_serializer_compression_saved_bytes_total;
+    perfmon_counter_t pm_serializer_coalesced_block_reads;
 
     /* used in serializer/log/lba/lba_list.cc */
     perfmon_counter_t pm_serializer_lba_gcs;
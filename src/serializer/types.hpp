@@ -136,6 +136,9 @@ class ls_block_token_pointee_t {
 public:
     int64_t offset() const { return offset_; }
     block_size_t block_size() const { return block_size_; }
+    // The number of bytes that the block takes up on disk.  This is less than
+    // `block_size()` if the serializer stored the block compressed.
+    block_size_t disk_block_size() const { return disk_block_size_; }
 
 private:
     friend class log_serializer_t;
@@ -146,7 +149,8 @@ private:
 
     ls_block_token_pointee_t(log_serializer_t *serializer,
                              int64_t initial_offset,
-                             block_size_t initial_ser_block_size);
+                             block_size_t initial_ser_block_size,
+                             block_size_t initial_disk_block_size);
 
     log_serializer_t *serializer_;
     std::atomic<intptr_t> ref_count_;
@@ -154,6 +158,9 @@ private:
     // The block's size.
     block_size_t block_size_;
 
+    // The size of the block's representation on disk.
+    block_size_t disk_block_size_;
+
     // The block's offset on disk.
     int64_t offset_;
 
@@ -2,6 +2,7 @@
 
 #include "arch/runtime/coroutines.hpp"
 #include "arch/runtime/runtime.hpp"
+#include "arch/runtime/thread_pool.hpp"
 #include "errors.hpp"
 
 #ifndef NDEBUG
@@ -44,6 +45,20 @@ on_thread_t::~on_thread_t() {
     coro_t::move_to_thread(home_thread());
 }
 
+migratable_section_t::migratable_section_t() {
+    // Making the coroutine stealable costs a trip through the event loop, so we only
+    // do it if there's somebody to steal it.
+    if (coro_t::self() != nullptr
+        && linux_thread_pool_t::get_thread()->message_hub.has_idle_threads()) {
+        coro_t::yield_stealable();
+    }
+}
+migratable_section_t::~migratable_section_t() {
+    if (coro_t::self() != nullptr) {
+        coro_t::move_to_thread(home_thread());
+    }
+}
+
 
 // The last thread is used as a utility thread, and is the launching point for the
 // server.  This ensures that various system-level tasks are homed on the utility
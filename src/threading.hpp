@@ -92,6 +92,25 @@ public:
     ~on_thread_t();
 };
 
+/* `migratable_section_t` marks a stretch of CPU-bound work that doesn't care which
+thread it runs on. If other threads are idle, the constructor lets one of them steal
+the coroutine, and the destructor moves it back to the thread it came from. Outside of
+a coroutine it does nothing. For example:
+
+    {
+        migratable_section_t migratable;
+        compress_lots_of_data(owned_buffers);
+    }
+
+The code in the section must not touch anything that belongs to a particular thread:
+objects with a home thread (including signals and interruptors), thread-local
+variables, or non-atomic reference counts that are shared with other coroutines. */
+class migratable_section_t : public home_thread_mixin_t {
+public:
+    migratable_section_t();
+    ~migratable_section_t();
+};
+
 int get_num_db_threads();
 
 /* Tries to distribute allocations evenly across the db threads.
@@ -0,0 +1,34 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/tables/table_config.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(BlockCompressionConfigTest, TableConfigField) {
+    for (block_codec_t codec : {block_codec_t::none, block_codec_t::zlib}) {
+        block_codec_t parsed = codec == block_codec_t::none
+            ? block_codec_t::zlib : block_codec_t::none;
+        admin_err_t error;
+        EXPECT_TRUE(convert_block_compression_from_datum(
+            convert_block_compression_to_datum(codec), &parsed, &error));
+        EXPECT_EQ(codec, parsed);
+    }
+    EXPECT_EQ(ql::datum_t("zlib"),
+              convert_block_compression_to_datum(block_codec_t::zlib));
+
+    std::vector<ql::datum_t> invalid = {
+        ql::datum_t("lz4"),
+        ql::datum_t("ZLIB"),
+        ql::datum_t(1.0),
+        ql::datum_t::boolean(true),
+        ql::datum_t::null() };
+    for (const ql::datum_t &datum : invalid) {
+        block_codec_t codec = block_codec_t::none;
+        admin_err_t error;
+        EXPECT_FALSE(convert_block_compression_from_datum(datum, &codec, &error));
+        EXPECT_EQ(block_codec_t::none, codec);
+        EXPECT_NE(std::string::npos, error.msg.find("\"zlib\""));
+    }
+}
+
+}  // namespace unittest
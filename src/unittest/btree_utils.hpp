@@ -9,7 +9,8 @@ struct short_value_t;
 
 class short_value_sizer_t : public value_sizer_t {
 public:
-    explicit short_value_sizer_t(max_block_size_t bs) : block_size_(bs) { }
+    explicit short_value_sizer_t(max_block_size_t bs, bool key_prefixes = true)
+        : block_size_(bs), key_prefixes_(key_prefixes) { }
 
     int size(const void *value) const {
         int x = *reinterpret_cast<const uint8_t *>(value);
@@ -29,10 +30,13 @@ public:
         return magic;
     }
 
+    bool btree_leaf_key_prefixes() const { return key_prefixes_; }
+
     max_block_size_t block_size() const { return block_size_; }
 
 private:
     max_block_size_t block_size_;
+    bool key_prefixes_;
 
     DISABLE_COPYING(short_value_sizer_t);
 };
@@ -98,9 +98,12 @@ TPTEST(ClusteringBranch, ReadWrite) {
 }
 
 /* The `Backfill` test starts up a node with one mirror, inserts some data, and
-then adds another mirror. */
+then adds another mirror. Then it sends a burst of concurrent writes to both mirrors.
+The `BackfillBatchedWrites` variant lets the `remote_replicator_server_t` wait for
+sync writes to form larger batches, so the burst should go out in a single message. */
 
 void run_backfill_test(
+        int64_t max_batch_latency_ms,
         simple_mailbox_cluster_t *cluster,
         primary_dispatcher_t *dispatcher,
         mock_store_t *store1,
@@ -145,7 +148,8 @@ void run_backfill_test(
 
     remote_replicator_server_t remote_replicator_server(
         cluster->get_mailbox_manager(),
-        dispatcher);
+        dispatcher,
+        max_batch_latency_ms);
 
     standard_backfill_throttler_t backfill_throttler;
     backfill_progress_tracker_t backfill_progress_tracker;
@@ -177,6 +181,37 @@ void run_backfill_test(
     /* Let any lingering writes finish */
     let_stuff_happen();
 
+    /* Send a burst of writes that are all in flight at the same time */
+    const uint64_t batches_before =
+        remote_replicator_server.get_num_write_batches_sent();
+    const uint64_t writes_before =
+        remote_replicator_server.get_num_batched_writes_sent();
+    const size_t burst_size = 32;
+    std::vector<scoped_ptr_t<simple_write_callback_t> > burst_callbacks;
+    for (size_t i = 0; i < burst_size; ++i) {
+        std::string key = strprintf("burst%zu", i);
+        std::string value = strprintf("value%zu", i);
+        burst_callbacks.emplace_back(new simple_write_callback_t);
+        dispatcher->spawn_write(
+            mock_overwrite(key, value),
+            order_source->check_in("run_backfill_test(burst)"),
+            burst_callbacks.back().get());
+        (*inserter.values_inserted)[key] = value;
+    }
+    for (const auto &callback : burst_callbacks) {
+        callback->wait_lazily_unordered();
+    }
+    let_stuff_happen();
+
+    EXPECT_EQ(burst_size,
+        remote_replicator_server.get_num_batched_writes_sent() - writes_before);
+    const uint64_t burst_batches =
+        remote_replicator_server.get_num_write_batches_sent() - batches_before;
+    EXPECT_LE(1u, burst_batches);
+    if (max_batch_latency_ms > 0) {
+        EXPECT_EQ(1u, burst_batches);
+    }
+
     /* Confirm that both mirrors have all of the writes */
     for (std::map<std::string, std::string>::iterator it = inserter.values_inserted->begin();
             it != inserter.values_inserted->end(); it++) {
@@ -185,7 +220,13 @@ void run_backfill_test(
     }
 }
 TPTEST(ClusteringBranch, Backfill) {
-    run_with_primary(&run_backfill_test);
+    run_with_primary(std::bind(&run_backfill_test,
+        remote_replicator_server_t::DEFAULT_MAX_BATCH_LATENCY_MS,
+        ph::_1, ph::_2, ph::_3, ph::_4, ph::_5));
+}
+TPTEST(ClusteringBranch, BackfillBatchedWrites) {
+    run_with_primary(std::bind(&run_backfill_test, 5,
+        ph::_1, ph::_2, ph::_3, ph::_4, ph::_5));
 }
 
 }   /* namespace unittest */
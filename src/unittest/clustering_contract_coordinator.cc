@@ -52,6 +52,8 @@ public:
         cs.config.basic.primary_key = "id";
         cs.config.write_ack_config = write_ack_config_t::MAJORITY;
         cs.config.durability = write_durability_t::HARD;
+        cs.config.cpu_shards = CPU_SHARDING_FACTOR;
+        cs.config.block_compression = block_codec_t::none;
 
         key_range_t::right_bound_t prev_right(store_key_t::min());
         for (const quick_shard_args_t &qs : qss) {
@@ -82,7 +84,8 @@ public:
         for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
             res.contract_ids[i] = generate_uuid();
             state.contracts[res.contract_ids[i]] = std::make_pair(
-                region_intersection(region_t(res.range), cpu_sharding_subspace(i)),
+                region_intersection(
+                    region_t(res.range), cpu_sharding_subspace(i, CPU_SHARDING_FACTOR)),
                 contracts.contracts[i]);
         }
         return res;
@@ -93,7 +96,7 @@ public:
     range during the initial branch registration of a new primary. */
     void set_current_branches(const cpu_branch_ids_t &branches) {
         for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
-            region_t reg = cpu_sharding_subspace(i);
+            region_t reg = cpu_sharding_subspace(i, CPU_SHARDING_FACTOR);
             reg.inner = branches.range;
             state.current_branches.update(reg, branches.branch_ids[i]);
         }
@@ -216,7 +219,7 @@ public:
         }
         for (const auto &pair : state.contracts) {
             if (pair.second.first.inner == range) {
-                size_t i = get_cpu_shard_number(pair.second.first);
+                size_t i = get_cpu_shard_number(pair.second.first, CPU_SHARDING_FACTOR);
                 EXPECT_FALSE(found[i]);
                 found[i] = true;
                 res.contract_ids[i] = pair.first;
@@ -264,10 +267,10 @@ public:
         state.current_branches.visit(
             region_t(branches.range),
             [&](const region_t &reg, const branch_id_t &branch) {
-                int cs = get_cpu_shard_approx_number(reg);
+                int cs = get_cpu_shard_approx_number(reg, CPU_SHARDING_FACTOR);
                 /* Make sure the CPU shard matches exactly and fail otherwise. */
-                EXPECT_TRUE(cpu_sharding_subspace(cs).beg == reg.beg &&
-                    cpu_sharding_subspace(cs).end == reg.end);
+                region_t cpu_region = cpu_sharding_subspace(cs, CPU_SHARDING_FACTOR);
+                EXPECT_TRUE(cpu_region.beg == reg.beg && cpu_region.end == reg.end);
                 if (branch != branches.branch_ids[cs]) {
                     mismatched[cs] = true;
                 }
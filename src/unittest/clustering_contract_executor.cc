@@ -1,6 +1,7 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "unittest/gtest.hpp"
 
+#include "clustering/immediate_consistency/remote_replicator_server.hpp"
 #include "clustering/immediate_consistency/standard_backfill_throttler.hpp"
 #include "clustering/table_contract/executor/executor.hpp"
 #include "clustering/table_manager/backfill_progress_tracker.hpp"
@@ -50,7 +51,8 @@ public:
         for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
             res.contract_ids[i] = generate_uuid();
             state.contracts[res.contract_ids[i]] = std::make_pair(
-                region_intersection(region_t(res.range), cpu_sharding_subspace(i)),
+                region_intersection(
+                    region_t(res.range), cpu_sharding_subspace(i, CPU_SHARDING_FACTOR)),
                 contracts.contracts[i]);
         }
         return res;
@@ -62,7 +64,7 @@ public:
     }
     void set_current_branches(const cpu_branch_ids_t &branches) {
         for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
-            region_t reg = cpu_sharding_subspace(i);
+            region_t reg = cpu_sharding_subspace(i, CPU_SHARDING_FACTOR);
             reg.inner = branches.range;
             state.current_branches.update(reg, branches.branch_ids[i]);
         }
@@ -105,6 +107,9 @@ public:
     branch_history_manager_t *get_branch_history_manager() {
         return &branch_history_manager;
     }
+    size_t num_cpu_shards() {
+        return CPU_SHARDING_FACTOR;
+    }
     store_view_t *get_cpu_sharded_store(size_t i) {
         return stores[i].get();
     }
@@ -138,6 +143,7 @@ public:
             &context->io_backender,
             &context->backfill_throttler,
             &context->backfill_progress_tracker,
+            remote_replicator_server_t::DEFAULT_MAX_BATCH_LATENCY_MS,
             &get_global_perfmon_collection()));
 
         /* Copy our contract execution bcards into the context's map so that other
@@ -4,6 +4,7 @@
 #include "clustering/administration/admin_op_exc.hpp"
 #include "clustering/query_routing/primary_query_client.hpp"
 #include "clustering/query_routing/primary_query_server.hpp"
+#include "clustering/query_routing/table_query_client.hpp"
 #include "unittest/branch_history_manager.hpp"
 #include "unittest/clustering_utils.hpp"
 #include "rdb_protocol/protocol.hpp"
@@ -170,5 +171,62 @@ TPTEST(ClusteringQuery, Failure) {
     }
 }
 
+outdated_read_candidate_t make_candidate(bool is_local, double latency_ms = -1) {
+    outdated_read_candidate_t candidate;
+    candidate.is_local = is_local;
+    candidate.has_latency = latency_ms >= 0;
+    candidate.latency_ms = latency_ms;
+    return candidate;
+}
+
+/* Without any latency samples, outdated reads must keep going to the local replica
+rather than to a random one. */
+TEST(ClusteringQuery, OutdatedReadPrefersLocalWithoutSamples) {
+    for (size_t local = 0; local < 4; ++local) {
+        std::vector<outdated_read_candidate_t> candidates;
+        for (size_t i = 0; i < 4; ++i) {
+            candidates.push_back(make_candidate(i == local));
+        }
+        for (int attempt = 0; attempt < 20; ++attempt) {
+            std::vector<size_t> ranking = rank_outdated_read_candidates(candidates);
+            ASSERT_EQ(4u, ranking.size());
+            EXPECT_EQ(local, ranking[0]);
+        }
+    }
+}
+
+/* The local replica wins ties with remote replicas, but not against replicas that are
+more than `LOCAL_REPLICA_LATENCY_ALLOWANCE` times faster. */
+TEST(ClusteringQuery, OutdatedReadRanking) {
+    for (int attempt = 0; attempt < 20; ++attempt) {
+        /* A tie between the scored local replica and remote ones. */
+        std::vector<outdated_read_candidate_t> tied;
+        tied.push_back(make_candidate(false, 1.0));
+        tied.push_back(make_candidate(false, 0.5));
+        tied.push_back(make_candidate(true, 2.0));
+        EXPECT_EQ(2u, rank_outdated_read_candidates(tied)[0]);
+
+        /* The local replica has no samples yet, and ranks like the average of the
+        others. */
+        std::vector<outdated_read_candidate_t> unscored_local;
+        unscored_local.push_back(make_candidate(false, 1.0));
+        unscored_local.push_back(make_candidate(true));
+        unscored_local.push_back(make_candidate(false, 3.0));
+        EXPECT_EQ(1u, rank_outdated_read_candidates(unscored_local)[0]);
+
+        /* A much faster remote replica beats the local one. The second choice (which
+        a hedged read would go to) is the local replica. */
+        std::vector<outdated_read_candidate_t> fast_remote;
+        fast_remote.push_back(make_candidate(true, 10.0));
+        fast_remote.push_back(make_candidate(false, 1.0));
+        fast_remote.push_back(make_candidate(false));
+        std::vector<size_t> ranking = rank_outdated_read_candidates(fast_remote);
+        ASSERT_EQ(3u, ranking.size());
+        EXPECT_EQ(1u, ranking[0]);
+        EXPECT_EQ(0u, ranking[1]);
+        EXPECT_EQ(2u, ranking[2]);
+    }
+}
+
 }   /* namespace unittest */
 
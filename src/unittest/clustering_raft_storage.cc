@@ -4,9 +4,13 @@
 #include "arch/io/disk.hpp"
 #include "clustering/administration/persist/file.hpp"
 #include "clustering/administration/persist/file_keys.hpp"
+#include "clustering/administration/persist/migrate/migrate_v2_4.hpp"
 #include "clustering/administration/persist/raft_storage_interface.hpp"
 #include "clustering/administration/tables/split_points.hpp"
 #include "clustering/table_contract/contract_metadata.hpp"
+#include "containers/archive/boost_types.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/archive/string_stream.hpp"
 #include "unittest/clustering_utils_raft.hpp"
 #include "unittest/unittest_utils.hpp"
 
@@ -25,6 +29,8 @@ table_config_and_shards_t make_table_config_and_shards() {
     calculate_split_points_for_uuids(1, &table_config_and_shards.shard_scheme);
     table_config_and_shards.config.write_ack_config = write_ack_config_t::MAJORITY;
     table_config_and_shards.config.durability = write_durability_t::HARD;
+    table_config_and_shards.config.cpu_shards = CPU_SHARDING_FACTOR;
+    table_config_and_shards.config.block_compression = block_codec_t::none;
     table_config_and_shards.server_names.names[shard.primary_replica] =
         std::make_pair(0ul, name_string_t::guarantee_valid("primary"));
 
@@ -379,5 +385,115 @@ TPTEST(ClusteringRaft, StorageWriteSnapshot) {
         raft_persistent_state);
 }
 
-}   /* namespace unittest */
+/* Bytes that are written to the metadata file as they are, so that we can store
+metadata that's serialized under an older version. */
+struct raw_metadata_t {
+    std::string bytes;
+};
+
+template <cluster_version_t W>
+void serialize(write_message_t *wm, const raw_metadata_t &raw) {
+    wm->append(raw.bytes.data(), raw.bytes.size());
+}
+
+std::string write_message_to_string(const write_message_t &wm) {
+    string_stream_t stream;
+    int res = send_write_message(&stream, &wm);
+    guarantee(res == 0);
+    return stream.str();
+}
+
+/* Serializes `snapshot` the way `version` did. The table config comes first in a
+snapshot, and it's the only part of it whose format changed since v2_3. */
+raw_metadata_t serialize_legacy_snapshot(
+        cluster_version_t version,
+        const table_raft_stored_snapshot_t &snapshot) {
+    static const cluster_version_t W = cluster_version_t::LATEST_DISK;
+    const table_config_and_shards_t &config_and_shards =
+        snapshot.snapshot_state.config;
+    const table_config_t &config = config_and_shards.config;
+
+    write_message_t legacy_config_and_shards;
+    serialize<W>(&legacy_config_and_shards, config.basic);
+    serialize<W>(&legacy_config_and_shards, config.shards);
+    serialize<W>(&legacy_config_and_shards, config.sindexes);
+    if (version == cluster_version_t::v2_4) {
+        serialize<W>(&legacy_config_and_shards, config.write_hook);
+    }
+    serialize<W>(&legacy_config_and_shards, config.write_ack_config);
+    serialize<W>(&legacy_config_and_shards, config.durability);
+    serialize<W>(&legacy_config_and_shards, config_and_shards.shard_scheme);
+    serialize<W>(&legacy_config_and_shards, config_and_shards.server_names);
+
+    write_message_t latest_config_and_shards;
+    serialize<W>(&latest_config_and_shards, config_and_shards);
+    write_message_t latest_snapshot;
+    serialize<W>(&latest_snapshot, snapshot);
+
+    return raw_metadata_t{write_message_to_string(legacy_config_and_shards) +
+        write_message_to_string(latest_snapshot).substr(
+            latest_config_and_shards.size())};
+}
+
+void run_storage_migration_test(cluster_version_t version) {
+    temp_directory_t temp_dir;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    cond_t non_interruptor;
+    namespace_id_t table_id = generate_uuid();
+
+    table_raft_state_t table_raft_state =
+        make_new_table_raft_state(make_table_config_and_shards());
+    raft_member_id_t raft_member_id(generate_uuid());
+    raft_config_t raft_config;
+    raft_config.voting_members.insert(raft_member_id);
+    raft_persistent_state_t<table_raft_state_t> raft_persistent_state =
+        raft_persistent_state_t<table_raft_state_t>::make_initial(
+            table_raft_state, raft_config);
+
+    {
+        metadata_file_t metadata_file(
+            &io_backender,
+            temp_dir.path(),
+            &get_global_perfmon_collection(),
+            [&](metadata_file_t::write_txn_t *, signal_t *) { },
+            &non_interruptor);
+        {
+            metadata_file_t::write_txn_t write_txn(&metadata_file, &non_interruptor);
+            table_raft_storage_interface_t table_raft_storage_interface(
+                &metadata_file,
+                &write_txn,
+                table_id,
+                raft_persistent_state);
+            write_txn.commit();
+        }
 
+        /* Replace the snapshot with one in the old format, and migrate it. */
+        metadata_file_t::write_txn_t write_txn(&metadata_file, &non_interruptor);
+        table_raft_stored_snapshot_t snapshot = write_txn.read(
+            mdprefix_table_raft_snapshot().suffix(uuid_to_str(table_id)),
+            &non_interruptor);
+        write_txn.write(
+            metadata_file_t::key_t<raw_metadata_t>(
+                "table.snapshot/" + uuid_to_str(table_id)),
+            serialize_legacy_snapshot(version, snapshot),
+            &non_interruptor);
+        migrate_metadata_v2_4_to_v2_5(version, &write_txn, &non_interruptor);
+        write_txn.commit();
+    }
+
+    raft_persistent_state_t<table_raft_state_t> migrated_state =
+        raft_persistent_state_from_metadata_file(temp_dir, table_id);
+    EXPECT_EQ(CPU_SHARDING_FACTOR,
+              migrated_state.snapshot_state.config.config.cpu_shards);
+    EXPECT_EQ(raft_persistent_state, migrated_state);
+}
+
+TPTEST(ClusteringRaft, StorageMigrateV2_3) {
+    run_storage_migration_test(cluster_version_t::v2_3);
+}
+
+TPTEST(ClusteringRaft, StorageMigrateV2_4) {
+    run_storage_migration_test(cluster_version_t::v2_4);
+}
+
+}   /* namespace unittest */
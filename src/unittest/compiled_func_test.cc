@@ -0,0 +1,76 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/compiled_func.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/wire_func.hpp"
+#include "stl_utils.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+scoped_ptr_t<ql::compiled_func_t> compile_for_test(
+        const ql::raw_term_t &body, const ql::sym_t &arg) {
+    ql::map_wire_func_t wire_func(body, make_vector(arg));
+    return ql::compiled_func_t::compile(wire_func.compile_wire_func());
+}
+
+ql::datum_t make_row(const char *status, double age) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("status", ql::datum_t(status));
+    builder.overwrite("age", ql::datum_t(age));
+    return std::move(builder).to_datum();
+}
+
+TEST(CompiledFuncTest, Predicate) {
+    const ql::sym_t arg(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    scoped_ptr_t<ql::compiled_func_t> compiled = compile_for_test(
+        (r.var(arg)["status"] == "active" && r.var(arg)["age"] > 30.0).root_term(),
+        arg);
+    ASSERT_TRUE(compiled.has());
+
+    ql::datum_t res;
+    ASSERT_TRUE(compiled->eval(make_row("active", 31), &res));
+    EXPECT_EQ(ql::datum_t::boolean(true), res);
+    ASSERT_TRUE(compiled->eval(make_row("active", 30), &res));
+    EXPECT_EQ(ql::datum_t::boolean(false), res);
+    ASSERT_TRUE(compiled->eval(make_row("inactive", 31), &res));
+    EXPECT_EQ(ql::datum_t::boolean(false), res);
+
+    // A missing field is a non-existence error in the interpreter, so the compiled
+    // form has to give up.
+    ql::datum_object_builder_t builder;
+    builder.overwrite("age", ql::datum_t(40.0));
+    EXPECT_FALSE(compiled->eval(std::move(builder).to_datum(), &res));
+
+    // `GET_FIELD` on an array maps over it in the interpreter.
+    std::vector<ql::datum_t> rows;
+    rows.push_back(make_row("active", 31));
+    EXPECT_FALSE(compiled->eval(
+        ql::datum_t(std::move(rows), ql::configured_limits_t::unlimited), &res));
+}
+
+TEST(CompiledFuncTest, Mapping) {
+    const ql::sym_t arg(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    scoped_ptr_t<ql::compiled_func_t> compiled =
+        compile_for_test(r.var(arg)["age"].root_term(), arg);
+    ASSERT_TRUE(compiled.has());
+
+    ql::datum_t res;
+    ASSERT_TRUE(compiled->eval(make_row("active", 12), &res));
+    EXPECT_EQ(ql::datum_t(12.0), res);
+}
+
+TEST(CompiledFuncTest, Unsupported) {
+    const ql::sym_t arg(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    EXPECT_FALSE(compile_for_test(
+        (r.var(arg)["age"] + 1.0).root_term(), arg).has());
+    EXPECT_FALSE(compile_for_test(
+        r.var(arg).pluck("age").root_term(), arg).has());
+    EXPECT_FALSE(compile_for_test(
+        r.var(arg).nth(0.0).root_term(), arg).has());
+}
+
+}  // namespace unittest
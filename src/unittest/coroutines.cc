@@ -1,4 +1,5 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <atomic>
 
 #include "arch/runtime/coroutines.hpp"
 #include "arch/runtime/runtime.hpp"
@@ -106,6 +107,42 @@ TEST(CoroutinesTest, NotifyNow) {
     });
 }
 
+TEST(CoroutinesTest, MigratableSection) {
+    // Tests that idle threads steal coroutines in a `migratable_section_t`, and that
+    // the coroutines come back to their own thread at the end of the section.
+    int num_threads = 4;
+    int num_coros = 64;
+    run_in_thread_pool([&]() {
+        threadnum_t home = get_thread_id();
+        std::atomic<int> num_migrated(0);
+        std::atomic<uint64_t> sum(0);
+        auto_drainer_t drainer;
+        for (int i = 0; i < num_coros; ++i) {
+            auto_drainer_t::lock_t lock(&drainer);
+            coro_t::spawn_sometime([&, i, lock]() {
+                {
+                    migratable_section_t migratable;
+                    if (get_thread_id() != home) {
+                        ++num_migrated;
+                    }
+                    // Keep the thread busy for a while, so that the other threads
+                    // have a chance to wake up and steal the remaining coroutines.
+                    uint64_t x = i;
+                    for (int j = 0; j < 1000000; ++j) {
+                        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+                    }
+                    sum += x;
+                }
+                ASSERT_EQ(home, get_thread_id());
+            });
+        }
+        drainer.drain();
+        ASSERT_EQ(home, get_thread_id());
+        ASSERT_NE(0u, sum.load());
+        ASSERT_LT(0, num_migrated.load());
+    }, num_threads);
+}
+
 // The following test does not work on 32 bit architectures because it will exceed
 // their virtual memory.
 #if defined (__x86_64__) || defined (_WIN64)
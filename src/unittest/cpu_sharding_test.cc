@@ -0,0 +1,65 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/tables/table_config.hpp"
+#include "clustering/table_contract/cpu_sharding.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(CPUShardingTest, ValidCounts) {
+    EXPECT_FALSE(is_valid_cpu_shard_count(0));
+    EXPECT_TRUE(is_valid_cpu_shard_count(1));
+    EXPECT_TRUE(is_valid_cpu_shard_count(CPU_SHARDING_FACTOR));
+    EXPECT_FALSE(is_valid_cpu_shard_count(6));
+    EXPECT_TRUE(is_valid_cpu_shard_count(MAX_CPU_SHARDS));
+    EXPECT_FALSE(is_valid_cpu_shard_count(2 * MAX_CPU_SHARDS));
+}
+
+TEST(CPUShardingTest, Subspaces) {
+    for (size_t n = 1; n <= MAX_CPU_SHARDS; n *= 2) {
+        uint64_t prev_end = 0;
+        for (size_t i = 0; i < n; ++i) {
+            region_t region = cpu_sharding_subspace(i, n);
+            EXPECT_EQ(prev_end, region.beg);
+            EXPECT_LT(region.beg, region.end);
+            EXPECT_EQ(key_range_t::universe(), region.inner);
+            EXPECT_EQ(static_cast<int>(i), get_cpu_shard_number(region, n));
+            EXPECT_EQ(static_cast<int>(i), get_cpu_shard_approx_number(region, n));
+            prev_end = region.end;
+        }
+        EXPECT_EQ(HASH_REGION_HASH_SIZE, prev_end);
+    }
+
+    // The default has to match the layout of existing data files.
+    for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+        EXPECT_EQ(i * (HASH_REGION_HASH_SIZE / CPU_SHARDING_FACTOR),
+                  cpu_sharding_subspace(i, CPU_SHARDING_FACTOR).beg);
+    }
+}
+
+TEST(CPUShardingTest, TableConfigField) {
+    for (size_t n = 1; n <= MAX_CPU_SHARDS; n *= 2) {
+        size_t cpu_shards = 0;
+        admin_err_t error;
+        EXPECT_TRUE(convert_cpu_shards_from_datum(
+            ql::datum_t(static_cast<double>(n)), &cpu_shards, &error));
+        EXPECT_EQ(n, cpu_shards);
+    }
+
+    std::vector<ql::datum_t> invalid = {
+        ql::datum_t(0.0),
+        ql::datum_t(-8.0),
+        ql::datum_t(6.0),
+        ql::datum_t(2.5),
+        ql::datum_t(static_cast<double>(2 * MAX_CPU_SHARDS)),
+        ql::datum_t("8"),
+        ql::datum_t::null() };
+    for (const ql::datum_t &datum : invalid) {
+        size_t cpu_shards = 0;
+        admin_err_t error;
+        EXPECT_FALSE(convert_cpu_shards_from_datum(datum, &cpu_shards, &error));
+        EXPECT_EQ(0u, cpu_shards);
+        EXPECT_NE(std::string::npos, error.msg.find("power of two"));
+    }
+}
+
+}  // namespace unittest
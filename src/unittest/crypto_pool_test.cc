@@ -0,0 +1,53 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/auth/crypto_pool.hpp"
+#include "crypto/hash.hpp"
+#include "crypto/hmac.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TPTEST(CryptoPoolTest, CheckPassword) {
+    perfmon_collection_t stats;
+    auth::crypto_pool_t crypto_pool(2, 16, &stats);
+
+    auth::username_t username("alice");
+    auth::password_t password("secret", 16);
+
+    // The second time around the cached digest is used.
+    for (size_t i = 0; i < 2; ++i) {
+        EXPECT_TRUE(crypto_pool.check_password(username, password, "secret"));
+        EXPECT_FALSE(crypto_pool.check_password(username, password, "secreT"));
+        EXPECT_FALSE(crypto_pool.check_password(username, password, ""));
+    }
+
+    // A new password invalidates the cached entry.
+    auth::password_t new_password("other", 16);
+    EXPECT_FALSE(crypto_pool.check_password(username, new_password, "secret"));
+    EXPECT_TRUE(crypto_pool.check_password(username, new_password, "other"));
+    EXPECT_FALSE(crypto_pool.check_password(username, password, "other"));
+    EXPECT_TRUE(crypto_pool.check_password(username, password, "secret"));
+}
+
+TPTEST(CryptoPoolTest, ScramKeys) {
+    perfmon_collection_t stats;
+    auth::crypto_pool_t crypto_pool(1, 16, &stats);
+
+    auth::username_t username("bob");
+    for (size_t i = 0; i < 2; ++i) {
+        auth::password_t password("secret", 16);
+        std::array<unsigned char, SHA256_DIGEST_LENGTH> client_key =
+            crypto::hmac_sha256(password.get_hash(), "Client Key");
+
+        for (size_t j = 0; j < 2; ++j) {
+            auth::scram_keys_t keys = crypto_pool.get_scram_keys(username, password);
+            EXPECT_EQ(client_key, keys.client_key);
+            EXPECT_EQ(crypto::sha256(client_key), keys.stored_key);
+            EXPECT_EQ(
+                crypto::hmac_sha256(password.get_hash(), "Server Key"),
+                keys.server_key);
+        }
+    }
+}
+
+}  // namespace unittest
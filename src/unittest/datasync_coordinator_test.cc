@@ -0,0 +1,81 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <map>
+
+#include "arch/io/disk/datasync_coordinator.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "concurrency/cond_var.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+struct datasync_request_t {
+    datasync_request_t() : result(-1) { }
+    int result;
+    cond_t done;
+};
+
+void issue_datasync(datasync_coordinator_t *coordinator,
+                    fd_t fd,
+                    datasync_request_t *request) {
+    coro_t::spawn_now_dangerously([=]() {
+        request->result = coordinator->datasync(fd);
+        request->done.pulse();
+    });
+}
+
+TPTEST(DatasyncCoordinator, GroupsRequestsPerFile) {
+    perfmon_collection_t stats;
+    const fd_t slow_fd = 1, fast_fd = 2, failing_fd = 3;
+
+    // The first datasync of `slow_fd` blocks until `release_slow` is pulsed.
+    std::map<fd_t, int> num_datasyncs;
+    cond_t slow_started, release_slow;
+    datasync_coordinator_t coordinator(&stats, [&](fd_t fd) {
+        ++num_datasyncs[fd];
+        if (fd == slow_fd && num_datasyncs[fd] == 1) {
+            slow_started.pulse();
+            release_slow.wait_lazily_unordered();
+        }
+        return fd == failing_fd ? EIO : 0;
+    });
+
+    datasync_request_t first;
+    issue_datasync(&coordinator, slow_fd, &first);
+    slow_started.wait_lazily_unordered();
+
+    // These arrive while the first datasync is running, so they can't share it.
+    const size_t num_waiting = 5;
+    datasync_request_t waiting[num_waiting];
+    for (size_t i = 0; i < num_waiting; ++i) {
+        issue_datasync(&coordinator, slow_fd, &waiting[i]);
+    }
+
+    // Other files don't wait for the slow one.
+    datasync_request_t fast, failing;
+    issue_datasync(&coordinator, fast_fd, &fast);
+    issue_datasync(&coordinator, failing_fd, &failing);
+    fast.done.wait_lazily_unordered();
+    failing.done.wait_lazily_unordered();
+    EXPECT_EQ(0, fast.result);
+    EXPECT_EQ(EIO, failing.result);
+    EXPECT_FALSE(first.done.is_pulsed());
+    for (size_t i = 0; i < num_waiting; ++i) {
+        EXPECT_FALSE(waiting[i].done.is_pulsed());
+    }
+    EXPECT_EQ(1, num_datasyncs[slow_fd]);
+
+    // Once the first datasync is done, all of the waiting requests share one more.
+    release_slow.pulse();
+    first.done.wait_lazily_unordered();
+    EXPECT_EQ(0, first.result);
+    for (size_t i = 0; i < num_waiting; ++i) {
+        waiting[i].done.wait_lazily_unordered();
+        EXPECT_EQ(0, waiting[i].result);
+    }
+    EXPECT_EQ(2, num_datasyncs[slow_fd]);
+    EXPECT_EQ(1, num_datasyncs[fast_fd]);
+    EXPECT_EQ(1, num_datasyncs[failing_fd]);
+}
+
+}  // namespace unittest
@@ -1,9 +1,11 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 
 #include "containers/archive/string_stream.hpp"
+#include "rdb_protocol/batching.hpp"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/datum_string.hpp"
 #include "rdb_protocol/env.hpp"
+#include "time.hpp"
 #include "unittest/gtest.hpp"
 
 
@@ -15,6 +17,8 @@ void test_datum_serialization(const ql::datum_t datum) {
         string_stream_t write_stream;
         write_message_t wm;
         serialize<cluster_version_t::LATEST_OVERALL>(&wm, datum);
+        ASSERT_EQ(serialized_size<cluster_version_t::LATEST_OVERALL>(datum),
+                  wm.size());
         int write_res = send_write_message(&write_stream, &wm);
         ASSERT_EQ(0, write_res);
 
@@ -33,6 +37,9 @@ void test_datum_serialization(const ql::datum_t datum) {
         string_stream_t write_stream;
         write_message_t wm;
         serialize<cluster_version_t::LATEST_OVERALL>(&wm, deserialized_datum);
+        ASSERT_EQ(serialized_size<cluster_version_t::LATEST_OVERALL>(
+                      deserialized_datum),
+                  wm.size());
         int write_res = send_write_message(&write_stream, &wm);
         ASSERT_EQ(0, write_res);
 
@@ -205,4 +212,63 @@ TEST(DatumTest, OffsetScaling) {
     }
 }
 
+// This is not really a unit test, but a micro benchmark for how fast we can put
+// wide documents into batches, like a range scan does. No need to run this in
+// debug mode.
+#ifdef NDEBUG
+double batch_documents(const std::vector<ql::datum_t> &docs,
+                       const ql::batchspec_t &batchspec) {
+    ticks_t start_ticks = get_ticks();
+    size_t i = 0;
+    while (i < docs.size()) {
+        ql::batcher_t batcher = batchspec.to_batcher();
+        while (i < docs.size() && !batcher.note_el(docs[i])) {
+            ++i;
+        }
+        ++i;
+    }
+    return docs.size() / ticks_to_secs(get_ticks() - start_ticks);
+}
+
+TEST(DatumTest, BatchingBenchmark) {
+    const size_t num_docs = 20000;
+    const size_t num_fields = 100;
+    std::vector<ql::datum_t> constructed_docs;
+    std::vector<ql::datum_t> buffered_docs;
+    for (size_t i = 0; i < num_docs; ++i) {
+        std::map<datum_string_t, ql::datum_t> fields;
+        for (size_t j = 0; j < num_fields; ++j) {
+            fields[datum_string_t(strprintf("field%zu", j))] =
+                ql::datum_t(std::map<datum_string_t, ql::datum_t>
+                    {std::make_pair(datum_string_t("n"),
+                                    ql::datum_t(static_cast<double>(i * j))),
+                     std::make_pair(datum_string_t("s"),
+                                    ql::datum_t(datum_string_t("value")))});
+        }
+        constructed_docs.push_back(ql::datum_t(std::move(fields)));
+
+        // Documents that come from disk or from another server are backed by a
+        // buffer instead.
+        string_stream_t write_stream;
+        write_message_t wm;
+        serialize<cluster_version_t::CLUSTER>(&wm, constructed_docs.back());
+        ASSERT_EQ(0, send_write_message(&write_stream, &wm));
+        string_read_stream_t read_stream(std::move(write_stream.str()), 0);
+        ql::datum_t buffered_doc;
+        ASSERT_EQ(archive_result_t::SUCCESS,
+                  deserialize<cluster_version_t::CLUSTER>(&read_stream, &buffered_doc));
+        buffered_docs.push_back(buffered_doc);
+    }
+
+    ql::batchspec_t normal = ql::batchspec_t::default_for(ql::batch_type_t::NORMAL);
+    ql::batchspec_t all = ql::batchspec_t::all();
+    printf("constructed documents, normal batches: %.0f documents per second\n",
+           batch_documents(constructed_docs, normal));
+    printf("constructed documents, unlimited batches: %.0f documents per second\n",
+           batch_documents(constructed_docs, all));
+    printf("buffered documents, normal batches: %.0f documents per second\n",
+           batch_documents(buffered_docs, normal));
+}
+#endif  // NDEBUG
+
 }  // namespace unittest
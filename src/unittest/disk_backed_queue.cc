@@ -74,6 +74,38 @@ TEST(DiskBackedQueue, BigVals) {
     unittest::run_in_thread_pool(&run_big_values_test, 2);
 }
 
+void run_push_many_test() {
+    static const int NUM_BATCHES = 50;
+    static const int BATCH_SIZE = 100;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+
+    const serializer_filepath_t serializer_path = dbq_serializer_path();
+
+    disk_backed_queue_t<int> queue(&io_backender, serializer_path, &get_global_perfmon_collection());
+
+    for (int i = 0; i < NUM_BATCHES; ++i) {
+        std::vector<int> batch;
+        for (int j = 0; j < BATCH_SIZE; ++j) {
+            batch.push_back(i * BATCH_SIZE + j);
+        }
+        queue.push_many(batch);
+    }
+    queue.push_many(std::vector<int>());
+    EXPECT_EQ(NUM_BATCHES * BATCH_SIZE, queue.size());
+
+    for (int i = 0; i < NUM_BATCHES * BATCH_SIZE; ++i) {
+        EXPECT_FALSE(queue.empty());
+        int x;
+        queue.pop(&x);
+        EXPECT_EQ(i, x);
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(DiskBackedQueue, PushMany) {
+    unittest::run_in_thread_pool(&run_push_many_test, 2);
+}
+
 static void randomly_delay(int, signal_t *) {
     nap(randint(100));
 }
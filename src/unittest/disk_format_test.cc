@@ -74,6 +74,20 @@ TEST(DiskFormatTest, LbaEntryT) {
     deleteblock = flagged_off64_t::make(1);
     ent = lba_entry_t::make(1, repli_timestamp_t::invalid, deleteblock, 1234);
     ASSERT_FALSE(lba_entry_t::is_padding(&ent));
+
+    // Uncompressed blocks must be stored the way older versions stored them.
+    EXPECT_EQ(4104u, lba_entry_t::pack_ser_block_size(4104, 4104));
+    uint16_t ser_block_size;
+    uint16_t uncompressed_ser_block_size;
+    lba_entry_t::unpack_ser_block_size(4104, &ser_block_size,
+                                       &uncompressed_ser_block_size);
+    EXPECT_EQ(4104, ser_block_size);
+    EXPECT_EQ(4104, uncompressed_ser_block_size);
+    lba_entry_t::unpack_ser_block_size(lba_entry_t::pack_ser_block_size(1000, 4104),
+                                       &ser_block_size,
+                                       &uncompressed_ser_block_size);
+    EXPECT_EQ(1000, ser_block_size);
+    EXPECT_EQ(4104, uncompressed_ser_block_size);
 }
 
 TEST(DiskFormatTest, LbaExtentT) {
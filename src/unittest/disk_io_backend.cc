@@ -0,0 +1,128 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <sys/uio.h>
+
+#include "arch/io/disk.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "concurrency/cond_var.hpp"
+#include "containers/scoped.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+struct io_waiter_t : public iocallback_t, public cond_t {
+    void on_io_complete() {
+        pulse();
+    }
+};
+
+char block_fill_byte(int64_t block, int round) {
+    return 'a' + (block * 7 + round) % 26;
+}
+
+/* Writes and reads back a bunch of blocks, concurrently and through every kind of
+request that the disk manager knows about, so that both the requests that a backend
+handles itself and the ones that it passes on to the blocker pool get exercised. */
+void run_read_write_test(file_io_backend_t io_backend,
+                         file_direct_io_mode_t direct_io_mode) {
+    const int64_t num_blocks = 64;
+
+    temp_file_t temp_file;
+    io_backender_t io_backender(direct_io_mode, DEFAULT_MAX_CONCURRENT_IO_REQUESTS,
+                                io_backend);
+    scoped_ptr_t<file_t> file;
+    file_open_result_t res = open_file(temp_file.name().permanent_path().c_str(),
+                                       linux_file_t::mode_read
+                                       | linux_file_t::mode_write
+                                       | linux_file_t::mode_create,
+                                       &io_backender, &file);
+    ASSERT_NE(file_open_result_t::ERROR, res.outcome);
+    file->set_file_size_at_least(num_blocks * DEVICE_BLOCK_SIZE);
+
+    std::vector<scoped_device_block_aligned_ptr_t<char> > bufs;
+    for (int64_t i = 0; i < num_blocks; ++i) {
+        bufs.push_back(scoped_device_block_aligned_ptr_t<char>(DEVICE_BLOCK_SIZE));
+    }
+
+    for (int round = 0; round < 2; ++round) {
+        {
+            // The first half of the blocks are written separately, alternating between
+            // plain writes and writes wrapped in datasyncs...
+            std::vector<scoped_ptr_t<io_waiter_t> > waiters;
+            for (int64_t i = 0; i < num_blocks / 2; ++i) {
+                memset(bufs[i].get(), block_fill_byte(i, round), DEVICE_BLOCK_SIZE);
+                waiters.push_back(make_scoped<io_waiter_t>());
+                file->write_async(i * DEVICE_BLOCK_SIZE, DEVICE_BLOCK_SIZE,
+                                  bufs[i].get(), DEFAULT_DISK_ACCOUNT,
+                                  waiters.back().get(),
+                                  i % 2 == 0
+                                  ? file_t::NO_DATASYNCS
+                                  : file_t::WRAP_IN_DATASYNCS);
+            }
+
+            // ... and the second half in a single vectored write.
+            scoped_array_t<iovec> vecs(num_blocks / 2);
+            for (int64_t i = num_blocks / 2; i < num_blocks; ++i) {
+                memset(bufs[i].get(), block_fill_byte(i, round), DEVICE_BLOCK_SIZE);
+                vecs[i - num_blocks / 2].iov_base = bufs[i].get();
+                vecs[i - num_blocks / 2].iov_len = DEVICE_BLOCK_SIZE;
+            }
+            waiters.push_back(make_scoped<io_waiter_t>());
+            file->writev_async((num_blocks / 2) * DEVICE_BLOCK_SIZE,
+                               (num_blocks / 2) * DEVICE_BLOCK_SIZE,
+                               std::move(vecs), DEFAULT_DISK_ACCOUNT,
+                               waiters.back().get());
+
+            for (const auto &waiter : waiters) {
+                waiter->wait();
+            }
+        }
+
+        for (int64_t i = 0; i < num_blocks; ++i) {
+            memset(bufs[i].get(), 0, DEVICE_BLOCK_SIZE);
+        }
+
+        {
+            std::vector<scoped_ptr_t<io_waiter_t> > waiters;
+            for (int64_t i = num_blocks - 1; i >= 0; --i) {
+                waiters.push_back(make_scoped<io_waiter_t>());
+                file->read_async(i * DEVICE_BLOCK_SIZE, DEVICE_BLOCK_SIZE,
+                                 bufs[i].get(), DEFAULT_DISK_ACCOUNT,
+                                 waiters.back().get());
+            }
+            for (const auto &waiter : waiters) {
+                waiter->wait();
+            }
+        }
+
+        for (int64_t i = 0; i < num_blocks; ++i) {
+            for (int64_t j = 0; j < DEVICE_BLOCK_SIZE; ++j) {
+                ASSERT_EQ(block_fill_byte(i, round), bufs[i].get()[j]);
+            }
+        }
+    }
+}
+
+TPTEST(DiskIoBackend, BlockerPool) {
+    run_read_write_test(file_io_backend_t::blocker_pool,
+                        file_direct_io_mode_t::buffered_desired);
+}
+
+// If the kernel doesn't support the native backends, the `io_backender_t` falls back
+// to the blocker pool and these tests still pass.
+
+TPTEST(DiskIoBackend, LinuxAio) {
+    run_read_write_test(file_io_backend_t::linux_aio,
+                        file_direct_io_mode_t::buffered_desired);
+    run_read_write_test(file_io_backend_t::linux_aio,
+                        file_direct_io_mode_t::direct_desired);
+}
+
+TPTEST(DiskIoBackend, IoUring) {
+    run_read_write_test(file_io_backend_t::io_uring,
+                        file_direct_io_mode_t::buffered_desired);
+    run_read_write_test(file_io_backend_t::io_uring,
+                        file_direct_io_mode_t::direct_desired);
+}
+
+}  // namespace unittest
@@ -6,7 +6,9 @@
 #include "extproc/extproc_pool.hpp"
 #include "extproc/extproc_spawner.hpp"
 #include "extproc/extproc_job.hpp"
+#include "extproc/js_runner.hpp"
 #include "rpc/serialize_macros.hpp"
+#include "time.hpp"
 #include "unittest/extproc_test.hpp"
 #include "unittest/gtest.hpp"
 
@@ -496,3 +498,151 @@ SPAWNER_TEST(ExtProc, InterruptJobByPool) {
 
     done.wait();
 }
+
+std::vector<std::vector<ql::datum_t> > make_js_args_batch(size_t num_rows) {
+    std::vector<std::vector<ql::datum_t> > args_batch;
+    for (size_t i = 0; i < num_rows; ++i) {
+        args_batch.push_back(
+            std::vector<ql::datum_t>(1, ql::datum_t(static_cast<double>(i))));
+    }
+    return args_batch;
+}
+
+SPAWNER_TEST(ExtProc, JSCallBatch) {
+    extproc_pool_t extproc_pool(1);
+    js_runner_t js_runner;
+    ql::configured_limits_t limits;
+
+    js_runner.begin(&extproc_pool, nullptr, limits);
+
+    const std::string source_code =
+        "(function (x) { if (x === 7) { throw 'seven'; } return x + 1; })";
+
+    js_runner_t::req_config_t config;
+    config.timeout_ms = 10000;
+
+    const size_t num_rows = 100;
+    std::vector<std::vector<ql::datum_t> > args_batch = make_js_args_batch(num_rows);
+    std::vector<js_result_t> batch_results =
+        js_runner.call_batch(source_code, args_batch, config);
+    ASSERT_TRUE(js_runner.connected());
+    ASSERT_EQ(num_rows, batch_results.size());
+
+    for (size_t i = 0; i < num_rows; ++i) {
+        js_result_t single_result = js_runner.call(source_code, args_batch[i], config);
+        if (i == 7) {
+            // An error in one row doesn't affect the others.
+            ASSERT_TRUE(boost::get<std::string>(&single_result) != nullptr);
+            ASSERT_TRUE(boost::get<std::string>(&batch_results[i]) != nullptr);
+            continue;
+        }
+        ql::datum_t *single_datum = boost::get<ql::datum_t>(&single_result);
+        ql::datum_t *batch_datum = boost::get<ql::datum_t>(&batch_results[i]);
+        ASSERT_TRUE(single_datum != nullptr);
+        ASSERT_TRUE(batch_datum != nullptr);
+        ASSERT_EQ(static_cast<int64_t>(i + 1), batch_datum->as_int());
+        ASSERT_EQ(*single_datum, *batch_datum);
+    }
+}
+
+// The batch as a whole takes longer than the timeout, but every row is well within
+// it, so none of the rows should time out.
+SPAWNER_TEST(ExtProc, JSCallBatchSlowRows) {
+    extproc_pool_t extproc_pool(1);
+    js_runner_t js_runner;
+    ql::configured_limits_t limits;
+
+    js_runner.begin(&extproc_pool, nullptr, limits);
+
+    const std::string source_code =
+        "(function (x) { var end = Date.now() + 20; while (Date.now() < end) {} "
+        "return x; })";
+
+    js_runner_t::req_config_t config;
+    config.timeout_ms = 200;
+
+    const size_t num_rows = 30;
+    std::vector<js_result_t> results =
+        js_runner.call_batch(source_code, make_js_args_batch(num_rows), config);
+    ASSERT_TRUE(js_runner.connected());
+    ASSERT_EQ(num_rows, results.size());
+    for (size_t i = 0; i < num_rows; ++i) {
+        ql::datum_t *datum = boost::get<ql::datum_t>(&results[i]);
+        ASSERT_TRUE(datum != nullptr);
+        ASSERT_EQ(static_cast<int64_t>(i), datum->as_int());
+    }
+}
+
+SPAWNER_TEST(ExtProc, JSCallBatchTimeout) {
+    extproc_pool_t extproc_pool(1);
+    js_runner_t js_runner;
+    ql::configured_limits_t limits;
+
+    js_runner.begin(&extproc_pool, nullptr, limits);
+
+    const std::string source_code =
+        "(function (x) { if (x === 2) { for (var y = 0; y < 4e10; y++) {} } "
+        "return x; })";
+
+    js_runner_t::req_config_t config;
+    config.timeout_ms = 100;
+
+    std::vector<js_result_t> results =
+        js_runner.call_batch(source_code, make_js_args_batch(10), config);
+    ASSERT_FALSE(js_runner.connected());
+
+    // The results stop at the row that timed out.
+    ASSERT_EQ(3u, results.size());
+    ASSERT_TRUE(boost::get<ql::datum_t>(&results[0]) != nullptr);
+    ASSERT_TRUE(boost::get<ql::datum_t>(&results[1]) != nullptr);
+    std::string *error = boost::get<std::string>(&results[2]);
+    ASSERT_TRUE(error != nullptr);
+    ASSERT_EQ(strprintf("JavaScript query `%s` timed out after 0.100 seconds.",
+                        source_code.c_str()),
+              *error);
+}
+
+// This is not really a unit test, but a micro benchmark for how much faster calling
+// a JavaScript function for a batch of rows is than calling it once per row. No need
+// to run this in debug mode.
+#ifdef NDEBUG
+SPAWNER_TEST(ExtProc, JSCallBatchBenchmark) {
+    extproc_pool_t extproc_pool(1);
+    js_runner_t js_runner;
+    ql::configured_limits_t limits;
+
+    js_runner.begin(&extproc_pool, nullptr, limits);
+
+    const std::string source_code = "(function (x) { return x + 1; })";
+
+    js_runner_t::req_config_t config;
+    config.timeout_ms = 10000;
+
+    const size_t num_rows = 10000;
+    const size_t batch_size = 64;
+    std::vector<std::vector<ql::datum_t> > args_batch = make_js_args_batch(num_rows);
+
+    ticks_t start_ticks = get_ticks();
+    for (size_t i = 0; i < num_rows; ++i) {
+        js_result_t result = js_runner.call(source_code, args_batch[i], config);
+        ASSERT_TRUE(boost::get<ql::datum_t>(&result) != nullptr);
+    }
+    double single_secs = ticks_to_secs(get_ticks() - start_ticks);
+
+    start_ticks = get_ticks();
+    for (size_t i = 0; i < num_rows; i += batch_size) {
+        std::vector<std::vector<ql::datum_t> > batch(
+            args_batch.begin() + i,
+            args_batch.begin() + std::min(num_rows, i + batch_size));
+        std::vector<js_result_t> results =
+            js_runner.call_batch(source_code, batch, config);
+        ASSERT_EQ(batch.size(), results.size());
+    }
+    double batch_secs = ticks_to_secs(get_ticks() - start_ticks);
+
+    printf("r.js calls, one per row: %.0f rows per second\n",
+           num_rows / single_secs);
+    printf("r.js calls, batches of %zu rows: %.0f rows per second\n",
+           batch_size, num_rows / batch_secs);
+}
+#endif  // NDEBUG
@@ -5,6 +5,7 @@
 #include "btree/node.hpp"
 #include "containers/scoped.hpp"
 #include "repli_timestamp.hpp"
+#include "time.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
 #include "utils.hpp"
@@ -15,9 +16,9 @@ namespace unittest {
 
 class LeafNodeTracker {
 public:
-    LeafNodeTracker()
+    explicit LeafNodeTracker(bool key_prefixes = true)
         : bs_(max_block_size_t::unsafe_make(4096)),
-          sizer_(bs_),
+          sizer_(bs_, key_prefixes),
           node_(bs_.value()),
           tstamp_counter_(0),
           maximum_existing_tstamp_(repli_timestamp_t::distant_past) {
@@ -194,6 +195,27 @@ public:
         return leaf::is_underfull(&sizer_, node());
     }
 
+    bool IsMergable(LeafNodeTracker *sibling) {
+        return leaf::is_mergable(&sizer_, node(), sibling->node());
+    }
+
+    bool HasKeyPrefix() {
+        return node()->magic == leaf::prefix_leaf_magic(&sizer_);
+    }
+
+    size_t Size() {
+        return kv_.size();
+    }
+
+    bool Lookup(const store_key_t &key, std::string *value_out) {
+        short_value_buffer_t value_buf("");
+        if (!leaf::lookup(&sizer_, node(), key.btree_key(), value_buf.data())) {
+            return false;
+        }
+        *value_out = value_buf.as_str();
+        return true;
+    }
+
     bool ShouldHave(const store_key_t& key) {
         return kv_.end() != kv_.find(key);
     }
@@ -346,7 +368,8 @@ scoped_ptr_t<LeafNodeTracker> test_random_out_of_order(
         int num_ops,
         bool random_tstamps,
         store_key_t low_key = store_key_t::min(),
-        store_key_t high_key = store_key_t::max()) {
+        store_key_t high_key = store_key_t::max(),
+        const std::string &key_prefix = "") {
 
     scoped_ptr_t<LeafNodeTracker> tracker(new LeafNodeTracker());
 
@@ -355,7 +378,7 @@ scoped_ptr_t<LeafNodeTracker> test_random_out_of_order(
     std::vector<store_key_t> key_pool(num_keys);
     for (int i = 0; i < num_keys; ++i) {
         do {
-            key_pool[i] = store_key_t(random_letter_string(&rng, 0, 159));
+            key_pool[i] = store_key_t(key_prefix + random_letter_string(&rng, 0, 159));
         } while (key_pool[i].compare(low_key) < 0 || key_pool[i].compare(high_key) >= 0);
     }
 
@@ -397,12 +420,24 @@ TEST(LeafNodeTest, RandomOutOfOrderLowTstamp) {
     }
 }
 
+// Most of the keys share a long prefix, so that the nodes get full and start
+// storing their keys relative to it.
+const char *const long_key_prefix = "a_long_table_name/with_a_long_index_name/";
+
+TEST(LeafNodeTest, RandomOutOfOrderPrefixed) {
+    for (int try_num = 0; try_num < 10; ++try_num) {
+        test_random_out_of_order(50, 20000, try_num % 2 == 0, store_key_t::min(),
+                                 store_key_t::max(), long_key_prefix);
+    }
+}
+
 void make_node_underfull(LeafNodeTracker *tracker, rng_t *rng) {
     leaf_node_t *node = tracker->node();
     while (!tracker->IsUnderfull() ||
            (node->num_pairs > 0 && rng->randint(2) == 0)) {
         int chosen = rng->randint(node->num_pairs);
-        auto pair = *leaf_node_t::iterator(node, chosen);
+        leaf_node_t::iterator it(node, chosen);
+        auto pair = *it;
 
         // We might hit a removal entry; skip those.
         if (tracker->ShouldHave(store_key_t(pair.first))) {
@@ -437,18 +472,50 @@ TEST(LeafNodeTest, RandomMerging) {
     }
 }
 
-TEST(LeafNodeTest, RandomSplitting) {
+TEST(LeafNodeTest, RandomMergingPrefixed) {
+    rng_t rng;
+
+    for (int try_num = 0; try_num < 100; ++try_num) {
+        // Both nodes store their keys relative to a prefix, but only some of
+        // it is the same.
+        std::string split_key = random_letter_string(&rng, 4, 8);
+        std::string left_prefix = long_key_prefix + split_key.substr(0, 2) + "a";
+        std::string right_prefix = long_key_prefix + split_key + "z";
+
+        bool zero_timestamps = (try_num % 2) == 0;
+
+        scoped_ptr_t<LeafNodeTracker> left = test_random_out_of_order(
+                40, 200, zero_timestamps, store_key_t::min(),
+                store_key_t(long_key_prefix + split_key), left_prefix);
+        scoped_ptr_t<LeafNodeTracker> right = test_random_out_of_order(
+                40, 200, zero_timestamps, store_key_t(long_key_prefix + split_key),
+                store_key_t::max(), right_prefix);
+
+        make_node_underfull(left.get(), &rng);
+        make_node_underfull(right.get(), &rng);
+
+        if (right->IsMergable(left.get())) {
+            right->Merge(left.get());
+        } else {
+            bool could_level;
+            right->Level(1, left.get(), &could_level);
+        }
+    }
+}
+
+void test_random_splitting(const std::string &key_prefix) {
     rng_t rng;
 
     for (int try_num = 0; try_num < 100; ++try_num) {
         bool zero_timestamps = (try_num % 2) == 0;
 
         scoped_ptr_t<LeafNodeTracker> node = test_random_out_of_order(
-                40, 200, zero_timestamps);
+                40, 200, zero_timestamps, store_key_t::min(), store_key_t::max(),
+                key_prefix);
 
         // The node might not be full yet; add some values until it is.
         while (true) {
-            store_key_t key(random_letter_string(&rng, 0, 160));
+            store_key_t key(key_prefix + random_letter_string(&rng, 0, 160));
             std::string value = random_letter_string(&rng, 0, 160);
             if (node->IsFull(key, value)) {
                 break;
@@ -462,6 +529,14 @@ TEST(LeafNodeTest, RandomSplitting) {
     }
 }
 
+TEST(LeafNodeTest, RandomSplitting) {
+    test_random_splitting("");
+}
+
+TEST(LeafNodeTest, RandomSplittingPrefixed) {
+    test_random_splitting(long_key_prefix);
+}
+
 TEST(LeafNodeTest, DeletionTimestamp) {
     LeafNodeTracker tracker;
 
@@ -499,6 +574,34 @@ TEST(LeafNodeTest, DeletionTimestamp) {
     tracker.Verify();
 }
 
+TEST(LeafNodeTest, CountLiveEntries) {
+    LeafNodeTracker tracker;
+    for (char c = 'a'; c <= 'z'; ++c) {
+        tracker.Insert(store_key_t(std::string(3, c)), "value");
+    }
+    // The deletion entries left behind by these must not be counted.
+    tracker.Remove(store_key_t("ddd"));
+    tracker.Remove(store_key_t("zzz"));
+
+    ASSERT_EQ(24, leaf::count_live_entries(*tracker.node(), key_range_t::universe()));
+    ASSERT_EQ(4, leaf::count_live_entries(
+        *tracker.node(),
+        key_range_t(key_range_t::closed, store_key_t("ccc"),
+                    key_range_t::open, store_key_t("hhh"))));
+    ASSERT_EQ(5, leaf::count_live_entries(
+        *tracker.node(),
+        key_range_t(key_range_t::closed, store_key_t("ccc"),
+                    key_range_t::closed, store_key_t("hhh"))));
+    ASSERT_EQ(3, leaf::count_live_entries(
+        *tracker.node(),
+        key_range_t(key_range_t::open, store_key_t("w"),
+                    key_range_t::none, store_key_t())));
+    ASSERT_EQ(0, leaf::count_live_entries(
+        *tracker.node(),
+        key_range_t(key_range_t::closed, store_key_t("zzz"),
+                    key_range_t::none, store_key_t())));
+}
+
 TEST(LeafNodeTest, ZeroZeroMerging) {
     LeafNodeTracker left;
     LeafNodeTracker right;
@@ -541,23 +644,23 @@ TEST(LeafNodeTest, SimpleMerging) {
 
     // We use the largest value that will underflow.
     //
-    // key_cost = 251, max_possible_size() = 256, sizeof(uint16_t) = 2, sizeof(repli_timestamp) = 8.
+    // key_cost = 252, max_possible_size() = 256, sizeof(uint16_t) = 2, sizeof(repli_timestamp) = 8.
     //
-    // 4084 - 12 = 4072.  4072 / 2 = 2036.  2036 - (251 + 256 + 2
-    // + 8) = 2036 - 517 = 1519.  So 1518 is the max possible
+    // 4084 - 12 = 4072.  4072 / 2 = 2036.  2036 - (252 + 256 + 2
+    // + 8) = 2036 - 518 = 1518.  So 1517 is the max possible
     // mandatory_cost.  (See the is_underfull implementation.)
     //
     // With 5*8 mandatory timestamp bytes and 12 bytes per entry,
-    // that gives us 1478 / 12 as the loop boundary value that
+    // that gives us 1477 / 12 as the loop boundary value that
     // will underflow.  We get 12 byte entries if entries run from
     // a000 to a999.  But if we allow two-digit entries, that
-    // frees up 2 bytes per entry, so add 200, giving 1678.  If we
+    // frees up 2 bytes per entry, so add 200, giving 1677.  If we
     // allow one-digit entries, that gives us 20 more bytes to
-    // use, giving 1698 / 12 as the loop boundary.  That's an odd
+    // use, giving 1697 / 12 as the loop boundary.  That's an odd
     // way to look at the arithmetic, but if you don't like that,
     // you can go cry to your mommy.
 
-    for (int i = 0; i < 1698 / 12; ++i) {
+    for (int i = 0; i < 1697 / 12; ++i) {
         left.Insert(store_key_t(strprintf("a%d", i)), strprintf("A%d", i));
         right.Insert(store_key_t(strprintf("b%d", i)), strprintf("B%d", i));
     }
@@ -569,7 +672,7 @@ TEST(LeafNodeTest, MergingWithRemoves) {
     LeafNodeTracker left;
     LeafNodeTracker right;
 
-    for (int i = 0; i < (1698 * 5 / 6) / 12; ++i) {
+    for (int i = 0; i < (1697 * 5 / 6) / 12; ++i) {
         left.Insert(store_key_t(strprintf("a%d", i)), strprintf("A%d", i));
         right.Insert(store_key_t(strprintf("b%d", i)), strprintf("B%d", i));
         if (i % 5 == 0) {
@@ -711,4 +814,141 @@ TEST(LeafNodeTest, Fullness) {
     ASSERT_TRUE(node.IsFull(store_key_t(strprintf("a%d", i)), strprintf("A%d", i)));
 }
 
+// Fills a node with keys that only differ in their last few bytes, and returns
+// how many fit.
+int fill_with_prefixed_keys(LeafNodeTracker *tracker, const std::string &key_prefix) {
+    int i = 0;
+    while (tracker->Insert(store_key_t(key_prefix + strprintf("%05d", i)),
+                           strprintf("V%d", i))) {
+        ++i;
+    }
+    return i;
+}
+
+TEST(LeafNodeTest, PrefixCapacity) {
+    const std::string key_prefix = std::string(long_key_prefix) + std::string(60, 'x');
+
+    LeafNodeTracker plain(false);
+    int plain_count = fill_with_prefixed_keys(&plain, key_prefix);
+    ASSERT_FALSE(plain.HasKeyPrefix());
+
+    LeafNodeTracker prefixed(true);
+    int prefixed_count = fill_with_prefixed_keys(&prefixed, key_prefix);
+    ASSERT_TRUE(prefixed.HasKeyPrefix());
+
+    // Each plain entry takes 1 + 106 key bytes, 3 value bytes and 2 bytes of
+    // pair offset; a prefixed one only takes 2 + 5 key bytes.
+    ASSERT_GT(prefixed_count, 5 * plain_count);
+
+    // Inserting keys that don't start with the prefix still works.
+    prefixed.Remove(store_key_t(key_prefix + "00000"));
+    prefixed.Remove(store_key_t(key_prefix + "00001"));
+    ASSERT_TRUE(prefixed.Insert(store_key_t("a"), "A"));
+    ASSERT_TRUE(prefixed.HasKeyPrefix());
+}
+
+void remove_first_key(LeafNodeTracker *tracker) {
+    leaf_node_t::iterator it = leaf::begin(*tracker->node());
+    tracker->Remove(store_key_t((*it).first));
+}
+
+TEST(LeafNodeTest, PrefixLevelingAndMerging) {
+    const std::string left_prefix = std::string(long_key_prefix) + std::string(150, 'a');
+    const std::string right_prefix = std::string(long_key_prefix) + std::string(150, 'b');
+
+    {
+        LeafNodeTracker left;
+        LeafNodeTracker right;
+        fill_with_prefixed_keys(&left, left_prefix);
+        ASSERT_TRUE(left.HasKeyPrefix());
+        right.Insert(store_key_t(right_prefix + "00000"), "B");
+
+        // The right node stores whole keys, so the keys that move there take up a
+        // lot more space than they did in the left node.
+        bool could_level;
+        right.Level(1, &left, &could_level);
+        ASSERT_TRUE(could_level);
+    }
+
+    {
+        LeafNodeTracker left;
+        LeafNodeTracker right;
+        fill_with_prefixed_keys(&left, left_prefix);
+        fill_with_prefixed_keys(&right, right_prefix);
+        while (!left.IsUnderfull() || left.Size() > 50) {
+            remove_first_key(&left);
+        }
+        while (!right.IsUnderfull()) {
+            remove_first_key(&right);
+        }
+
+        // Both nodes are underfull, but the left node's keys only share
+        // `long_key_prefix` with the right node's prefix, so they wouldn't fit.
+        ASSERT_FALSE(right.IsMergable(&left));
+
+        // They do once the left node is small enough.  Its deletion entries
+        // would have to move as well, so we drop those.
+        while (left.Size() > 4) {
+            remove_first_key(&left);
+        }
+        leaf::erase_deletions(left.sizer(), left.node(),
+                              boost::optional<repli_timestamp_t>());
+        ASSERT_TRUE(right.IsMergable(&left));
+        right.Merge(&left);
+    }
+}
+
+// Not much of a benchmark, but it shows how many leaf nodes a table with long
+// keys needs in either format, and what storing keys relative to a prefix
+// costs lookups.
+void build_leaf_forest(bool key_prefixes, int num_keys,
+                       std::vector<scoped_ptr_t<LeafNodeTracker> > *leaves_out,
+                       std::vector<store_key_t> *medians_out) {
+    const std::string key_prefix = std::string(long_key_prefix) + "primary/";
+    leaves_out->push_back(make_scoped<LeafNodeTracker>(key_prefixes));
+    for (int i = 0; i < num_keys; ++i) {
+        store_key_t key(key_prefix + strprintf("%08d", i));
+        std::string value = strprintf("%d", i);
+        if (leaves_out->back()->IsFull(key, value)) {
+            leaves_out->push_back(make_scoped<LeafNodeTracker>(key_prefixes));
+            LeafNodeTracker *left = (*leaves_out)[leaves_out->size() - 2].get();
+            left->Split(leaves_out->back().get());
+            leaf_node_t::reverse_iterator it = leaf::rbegin(*left->node());
+            medians_out->push_back(store_key_t((*it).first));
+        }
+        ASSERT_TRUE(leaves_out->back()->Insert(key, value));
+    }
+}
+
+TEST(LeafNodeTest, PrefixCompressionBenchmark) {
+    const int num_keys = 20000;
+    size_t num_leaves[2];
+    for (int key_prefixes = 0; key_prefixes < 2; ++key_prefixes) {
+        std::vector<scoped_ptr_t<LeafNodeTracker> > leaves;
+        std::vector<store_key_t> medians;
+        build_leaf_forest(key_prefixes == 1, num_keys, &leaves, &medians);
+        num_leaves[key_prefixes] = leaves.size();
+
+        const std::string key_prefix = std::string(long_key_prefix) + "primary/";
+        ticks_t start = get_ticks();
+        int found = 0;
+        for (int i = 0; i < num_keys; ++i) {
+            store_key_t key(key_prefix + strprintf("%08d", (i * 7919) % num_keys));
+            size_t leaf_index = std::lower_bound(medians.begin(), medians.end(), key)
+                - medians.begin();
+            std::string value;
+            if (leaves[leaf_index]->Lookup(key, &value)) {
+                ++found;
+            }
+        }
+        double secs = ticks_to_secs(get_ticks() - start);
+        ASSERT_EQ(num_keys, found);
+
+        printf("%s leaf nodes: %zu nodes for %d keys, %.0f ns per lookup\n",
+               key_prefixes == 1 ? "prefix-compressed" : "plain",
+               leaves.size(), num_keys, secs * 1e9 / num_keys);
+    }
+    ASSERT_LT(num_leaves[1], num_leaves[0]);
+}
+
 }  // namespace unittest
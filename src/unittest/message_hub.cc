@@ -0,0 +1,99 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/pmap.hpp"
+#include "containers/intrusive_mpsc_queue.hpp"
+#include "time.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+struct mpsc_test_item_t : public intrusive_list_node_t<mpsc_test_item_t>,
+                          public intrusive_mpsc_queue_node_t<mpsc_test_item_t> {
+    int producer;
+    int seq;
+};
+
+TEST(MessageHubTest, MpscQueueOrdering) {
+    // Several threads push batches of items onto one queue.  Each producer's items
+    // must come out in the order that they were pushed in.
+    const int num_producers = 8;
+    const int num_items = 20000;
+    const int batch_size = 7;
+
+    std::vector<mpsc_test_item_t> items(num_producers * num_items);
+    for (int p = 0; p < num_producers; ++p) {
+        for (int i = 0; i < num_items; ++i) {
+            items[p * num_items + i].producer = p;
+            items[p * num_items + i].seq = i;
+        }
+    }
+
+    intrusive_mpsc_queue_t<mpsc_test_item_t> queue;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producers; ++p) {
+        producers.emplace_back([&items, &queue, p, num_items, batch_size]() {
+            for (int i = 0; i < num_items; i += batch_size) {
+                intrusive_list_t<mpsc_test_item_t> batch;
+                for (int j = i; j < std::min(i + batch_size, num_items); ++j) {
+                    batch.push_back(&items[p * num_items + j]);
+                }
+                queue.push_all(&batch);
+            }
+        });
+    }
+
+    std::vector<int> next_seq(num_producers, 0);
+    int num_received = 0;
+    while (num_received < num_producers * num_items) {
+        intrusive_list_t<mpsc_test_item_t> popped;
+        queue.pop_all(&popped);
+        while (mpsc_test_item_t *item = popped.head()) {
+            popped.remove(item);
+            ASSERT_EQ(next_seq[item->producer], item->seq);
+            ++next_seq[item->producer];
+            ++num_received;
+        }
+    }
+
+    for (auto &t : producers) {
+        t.join();
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+// This is not really a unit test, but a micro benchmark for the throughput of
+// cross-thread messages.  No need to run this in debug mode.
+#ifdef NDEBUG
+TEST(MessageHubTest, CrossThreadMessageBenchmark) {
+    const int coros_per_thread = 16;
+    const int hops_per_coro = 2000;
+    for (int num_threads = 2; num_threads <= 64; num_threads *= 2) {
+        double duration;
+        run_in_thread_pool([&]() {
+            ticks_t start_ticks = get_ticks();
+            // Every coroutine keeps hopping over to the next thread and back, which
+            // sends two cross-thread messages per hop.
+            pmap(num_threads * coros_per_thread, [&](int i) {
+                threadnum_t home(i % num_threads);
+                threadnum_t other((i + 1) % num_threads);
+                on_thread_t thread_switcher(home);
+                for (int j = 0; j < hops_per_coro; ++j) {
+                    on_thread_t hop(other);
+                }
+            });
+            duration = ticks_to_secs(get_ticks() - start_ticks);
+        }, num_threads);
+        double num_messages = 2.0 * num_threads * coros_per_thread * hops_per_coro;
+        printf("%2d threads: %.0f cross-thread messages per second\n",
+               num_threads, num_messages / duration);
+    }
+}
+#endif  // NDEBUG
+
+}  // namespace unittest
@@ -52,8 +52,10 @@ class test_cache_t : public page_cache_t {
 public:
     test_cache_t(serializer_t *_serializer,
                  cache_balancer_t *balancer,
-                 alt_txn_throttler_t *throttler)
-        : page_cache_t(_serializer, balancer, throttler),
+                 alt_txn_throttler_t *throttler,
+                 alt::eviction_policy_type_t eviction_policy
+                     = alt::eviction_policy_type_t::two_queue)
+        : page_cache_t(_serializer, balancer, throttler, eviction_policy),
           throttler_(throttler) { }
 
     void flush(scoped_ptr_t<test_txn_t> txn) {
@@ -1161,6 +1163,72 @@ private:
     page_txn_t *txn2_ptr;
 };
 
+// Reads the block with a fresh acquisition, so that it counts as another touch.
+void touch_block(test_cache_t *cache, block_id_t block_id) {
+    current_test_acq_t acq(cache, block_id, read_access_t());
+    test_acq_t page_acq;
+    page_acq.init(acq.current_page_for_read(), cache);
+    page_acq.buf_ready_signal()->wait();
+}
+
+uint64_t count_cache_misses(test_cache_t *cache) {
+    uint64_t misses = 0;
+    cache->evicter().visit_bags(
+        [&](const char *, const alt::eviction_bag_t *bag) {
+            misses += bag->misses();
+        });
+    return misses;
+}
+
+// Reads a small set of blocks a few times, then scans through many more blocks than
+// fit in the cache, and returns how many of the small set's blocks had to be loaded
+// again afterwards.
+uint64_t misses_after_scan(alt::eviction_policy_type_t eviction_policy) {
+    const size_t num_hot = 10;
+    const size_t num_cold = 200;
+
+    mock_ser_t mock;
+    std::vector<block_id_t> block_ids;
+    {
+        dummy_cache_balancer_t balancer(GIGABYTE);
+        test_cache_t cache(mock.ser.get(), &balancer, mock.throttler.get());
+        auto txn = make_scoped<test_txn_t>(&cache);
+        for (size_t i = 0; i < num_hot + num_cold; ++i) {
+            current_test_acq_t acq(txn.get(), alt_create_t::create);
+            block_ids.push_back(acq.block_id());
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_write(), &cache);
+            memset(page_acq.get_buf_write(), 0, 1);
+        }
+        cache.flush(std::move(txn));
+    }
+
+    // Room for about 40 blocks.
+    dummy_cache_balancer_t balancer(200 * KILOBYTE);
+    test_cache_t cache(mock.ser.get(), &balancer, mock.throttler.get(),
+                       eviction_policy);
+    for (int round = 0; round < 3; ++round) {
+        for (size_t i = 0; i < num_hot; ++i) {
+            touch_block(&cache, block_ids[i]);
+        }
+    }
+    for (size_t i = num_hot; i < num_hot + num_cold; ++i) {
+        touch_block(&cache, block_ids[i]);
+    }
+
+    const uint64_t misses_before = count_cache_misses(&cache);
+    for (size_t i = 0; i < num_hot; ++i) {
+        touch_block(&cache, block_ids[i]);
+    }
+    return count_cache_misses(&cache) - misses_before;
+}
+
+TPTEST(PageTest, ScanResistance, 4) {
+    EXPECT_EQ(0u, misses_after_scan(alt::eviction_policy_type_t::two_queue));
+    // The scan pushes the hot blocks out of the cache if we go purely by recency.
+    EXPECT_LT(0u, misses_after_scan(alt::eviction_policy_type_t::sampled_lru));
+}
+
 TPTEST(PageTest, BiggerTest, 4) {
     bigger_test_t test(GIGABYTE);
     test.run();
@@ -57,4 +57,51 @@ TEST(PerfmonTest, StddevComputation) {
     }
 }
 
+TEST(PerfmonTest, HistogramBuckets) {
+    using namespace perfmon_histogram;  // NOLINT(build/namespaces)
+
+    // Every value falls into a bucket whose bounds contain it, buckets are in the
+    // same order as their values, and no bucket is wider than 1/16th of its values.
+    size_t last_bucket = 0;
+    for (uint64_t v = 0; v < (1ull << 24); v += 1 + v / 64) {
+        size_t bucket = bucket_for_value(v);
+        ASSERT_LT(bucket, num_buckets);
+        ASSERT_LE(last_bucket, bucket);
+        ASSERT_LE(v, bucket_upper_bound(bucket));
+        if (bucket > 0) {
+            ASSERT_GT(v, bucket_upper_bound(bucket - 1));
+            ASSERT_LE(bucket_upper_bound(bucket) - bucket_upper_bound(bucket - 1),
+                      std::max<uint64_t>(1, v / sub_buckets));
+        }
+        last_bucket = bucket;
+    }
+    EXPECT_EQ(num_buckets - 1, bucket_for_value(std::numeric_limits<uint64_t>::max()));
+}
+
+TEST(PerfmonTest, HistogramPercentiles) {
+    perfmon_histogram::stats_t a, b;
+    for (uint64_t v = 1; v <= 1000; ++v) {
+        a.record(v);
+        b.record(v * 1000);
+    }
+    EXPECT_EQ(1000u, a.count);
+    EXPECT_EQ(1u, a.percentile(0.001));
+    EXPECT_EQ(1000u, a.percentile(1.0));
+    EXPECT_NEAR(500, a.percentile(0.5), 500 / 16.0);
+    EXPECT_NEAR(990, a.percentile(0.99), 990 / 16.0);
+
+    // Merging the histograms of two threads is the same as recording everything on
+    // one of them.
+    a.aggregate(b);
+    EXPECT_EQ(2000u, a.count);
+    EXPECT_EQ(1000000u, a.max);
+    EXPECT_NEAR(1000, a.percentile(0.5), 1000 / 16.0);
+    EXPECT_NEAR(999000, a.percentile(0.999), 999000 / 16.0);
+
+    // A single value is reported exactly, not as the upper bound of its bucket.
+    perfmon_histogram::stats_t c;
+    c.record(123456);
+    EXPECT_EQ(123456u, c.percentile(0.5));
+}
+
 }  // namespace unittest
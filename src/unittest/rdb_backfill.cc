@@ -2,6 +2,8 @@
 #include "unittest/gtest.hpp"
 
 #include "btree/backfill_debug.hpp"
+#include "btree/depth_first_traversal.hpp"
+#include "btree/reql_specific.hpp"
 #include "clustering/administration/metadata.hpp"
 #include "clustering/immediate_consistency/backfill_throttler.hpp"
 #include "clustering/immediate_consistency/local_replicator.hpp"
@@ -14,6 +16,7 @@
 #include "rapidjson/document.h"
 #include "rdb_protocol/minidriver.hpp"
 #include "rdb_protocol/env.hpp"
+#include "rdb_protocol/lazy_btree_val.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rdb_protocol/store.hpp"
 #include "rdb_protocol/sym.hpp"
@@ -543,5 +546,143 @@ TPTEST(RDBBackfill, FillBothQueuesAndPreemptOften) {
     run_backfill_test(cfg);
 }
 
+void create_value_sindex(store_t *store, const std::string &name) {
+    ql::sym_t one(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    ql::raw_term_t mapping = r.var(one)["value"].root_term();
+    sindex_config_t config(
+        ql::map_wire_func_t(mapping, make_vector(one)),
+        reql_version_t::LATEST,
+        sindex_multi_bool_t::SINGLE,
+        sindex_geo_bool_t::REGULAR);
+    cond_t non_interruptor;
+    store->sindex_create(name, config, &non_interruptor);
+}
+
+/* Returns every key of the B-tree under `superblock` and the document stored there. */
+std::map<store_key_t, ql::datum_t> read_btree_contents(superblock_t *superblock) {
+    class collect_cb_t : public depth_first_traversal_callback_t {
+    public:
+        continue_bool_t handle_pair(scoped_key_value_t &&keyvalue, signal_t *) {
+            contents[store_key_t(keyvalue.key())] = get_data(
+                static_cast<const rdb_value_t *>(keyvalue.value()),
+                buf_parent_t(keyvalue.expose_buf()));
+            return continue_bool_t::CONTINUE;
+        }
+        std::map<store_key_t, ql::datum_t> contents;
+    } callback;
+    cond_t non_interruptor;
+    btree_depth_first_traversal(superblock, key_range_t::universe(), &callback,
+        access_t::read, FORWARD, release_superblock_t::RELEASE, &non_interruptor);
+    return std::move(callback.contents);
+}
+
+/* If `sindex_name` is empty, returns the contents of the primary index. Otherwise
+waits for the secondary index to be ready and returns its contents. */
+std::map<store_key_t, ql::datum_t> read_store_contents(
+        store_t *store, const std::string &sindex_name) {
+    while (true) {
+        read_token_t token;
+        store->new_read_token(&token);
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        cond_t non_interruptor;
+        store->acquire_superblock_for_read(
+            &token, &txn, &superblock, &non_interruptor, false);
+        if (sindex_name.empty()) {
+            return read_btree_contents(superblock.get());
+        }
+        try {
+            scoped_ptr_t<sindex_superblock_t> sindex_sb;
+            std::vector<char> opaque_definition;
+            uuid_u sindex_uuid;
+            bool found = store->acquire_sindex_superblock_for_read(
+                sindex_name_t(sindex_name), "", superblock.get(), &sindex_sb,
+                &opaque_definition, &sindex_uuid);
+            guarantee(found);
+            return read_btree_contents(sindex_sb.get());
+        } catch (const sindex_not_ready_exc_t &) {
+            nap(100);
+        }
+    }
+}
+
+void expect_same_contents(
+        const std::map<store_key_t, ql::datum_t> &expected,
+        const std::map<store_key_t, ql::datum_t> &actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (auto it = expected.begin(), jt = actual.begin(); it != expected.end();
+            ++it, ++jt) {
+        EXPECT_EQ(key_to_debug_str(it->first), key_to_debug_str(jt->first));
+        EXPECT_EQ(it->second.print(), jt->second.print());
+    }
+}
+
+/* Backfills a table with a secondary index into an empty store. This goes through the
+bulk load path of `store_t::receive_backfill()`, and since there are many more keys than
+fit into one of its transactions, through many bulk transactions. The primary and the
+secondary index must end up with the same contents as on the source. */
+TPTEST(RDBBackfill, BulkLoadWithSindex) {
+    order_source_t order_source;
+    simple_mailbox_cluster_t cluster;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    extproc_pool_t extproc_pool(2);
+    dummy_semilattice_controller_t<auth_semilattice_metadata_t> auth_manager;
+    rdb_context_t ctx(&extproc_pool, nullptr, auth_manager.get_view());
+    cond_t non_interruptor;
+
+    in_memory_branch_history_manager_t bhm;
+    test_store_t store1(&io_backender, &order_source, &ctx);
+    test_store_t store2(&io_backender, &order_source, &ctx);
+
+    const std::string sindex_name = "value";
+    create_value_sindex(&store1.store, sindex_name);
+    create_value_sindex(&store2.store, sindex_name);
+
+    backfill_test_config_t cfg;
+    /* Don't preempt the backfill, so that it all goes into the empty store. */
+    cfg.min_preempt_ms = cfg.max_preempt_ms = 60 * 60 * 1000;
+
+    std::map<std::string, std::string> inserter_state;
+    {
+        primary_dispatcher_t dispatcher(
+            &get_global_perfmon_collection(),
+            region_map_t<version_t>(region_t::universe(), version_t::zero()));
+        local_replicator_t local_replicator(
+            cluster.get_mailbox_manager(), server_id_t::generate_server_id(),
+            &dispatcher, &store1.store, &bhm, &non_interruptor);
+        dispatcher_inserter_t inserter(
+            &dispatcher, &order_source, cfg.value_padding_length, &inserter_state,
+            false);
+        inserter.insert(2000);
+
+        remote_replicator_server_t remote_replicator_server(
+            cluster.get_mailbox_manager(),
+            &dispatcher);
+        stress_backfill_throttler_t backfill_throttler(cfg);
+        backfill_progress_tracker_t backfill_progress_tracker;
+        remote_replicator_client_t remote_replicator_client(&backfill_throttler,
+            cfg.backfill, &backfill_progress_tracker, cluster.get_mailbox_manager(),
+            server_id_t::generate_server_id(),
+            backfill_throttler_t::priority_t::critical_t::NO,
+            dispatcher.get_branch_id(), remote_replicator_server.get_bcard(),
+            local_replicator.get_replica_bcard(), server_id_t::generate_server_id(),
+            &store2.store, &bhm, &non_interruptor);
+    }
+
+    size_t num_present = 0;
+    for (const auto &pair : inserter_state) {
+        num_present += pair.second.empty() ? 0 : 1;
+    }
+    std::map<store_key_t, ql::datum_t> primary = read_store_contents(&store1.store, "");
+    EXPECT_EQ(num_present, primary.size());
+    expect_same_contents(primary, read_store_contents(&store2.store, ""));
+
+    std::map<store_key_t, ql::datum_t> sindex =
+        read_store_contents(&store1.store, sindex_name);
+    EXPECT_EQ(primary.size(), sindex.size());
+    expect_same_contents(sindex, read_store_contents(&store2.store, sindex_name));
+}
+
 }   /* namespace unittest */
 
@@ -26,9 +26,31 @@
 #define TOTAL_KEYS_TO_INSERT 1000
 #define MAX_RETRIES_FOR_SINDEX_POSTCONSTRUCT 50
 
+// Enough tags per row that a single post-construction pass collects more index
+// entries than fit into one sorted run.
+#define TAGGED_ROWS_TO_INSERT 600
+#define TAGS_PER_ROW 150
+
 namespace unittest {
 
-void insert_rows(int start, int finish, store_t *store) {
+std::string make_row(int i) {
+    return strprintf("{\"id\" : %d, \"sid\" : %d}", i, i * i);
+}
+
+std::string make_tag(int i, int j) {
+    return strprintf("tag_%d_%d_%s", i, j, std::string(24, 'x').c_str());
+}
+
+std::string make_tagged_row(int i) {
+    std::string tags;
+    for (int j = 0; j < TAGS_PER_ROW; ++j) {
+        tags += strprintf("%s\"%s\"", j == 0 ? "" : ", ", make_tag(i, j).c_str());
+    }
+    return strprintf("{\"id\" : %d, \"tags\" : [%s]}", i, tags.c_str());
+}
+
+void insert_rows(int start, int finish, store_t *store,
+                 const std::function<std::string(int)> &make_data = &make_row) {
     ql::configured_limits_t limits;
 
     guarantee(start <= finish);
@@ -47,7 +69,7 @@ void insert_rows(int start, int finish, store_t *store) {
                 superblock->get_sindex_block_id(),
                 access_t::write);
 
-            std::string data = strprintf("{\"id\" : %d, \"sid\" : %d}", i, i * i);
+            std::string data = make_data(i);
             point_write_response_t response;
 
             store_key_t pk(ql::datum_t(static_cast<double>(i)).print_primary());
@@ -87,15 +109,17 @@ void insert_rows_and_pulse_when_done(int start, int finish,
     pulse_when_done->pulse();
 }
 
-sindex_name_t create_sindex(store_t *store) {
+sindex_name_t create_sindex(store_t *store,
+                           const std::string &field = "sid",
+                           sindex_multi_bool_t multi = sindex_multi_bool_t::SINGLE) {
     std::string name = uuid_to_str(generate_uuid());
     ql::sym_t one(1);
     ql::minidriver_t r(ql::backtrace_id_t::empty());
-    ql::raw_term_t mapping = r.var(one)["sid"].root_term();
+    ql::raw_term_t mapping = r.var(one)[field].root_term();
     sindex_config_t config(
         ql::map_wire_func_t(mapping, make_vector(one)),
         reql_version_t::LATEST,
-        sindex_multi_bool_t::SINGLE,
+        multi,
         sindex_geo_bool_t::REGULAR);
 
     cond_t non_interruptor;
@@ -113,7 +137,7 @@ void spawn_writes(store_t *store, cond_t *background_inserts_done) {
 ql::grouped_t<ql::stream_t> read_row_via_sindex(
         store_t *store,
         const sindex_name_t &sindex_name,
-        int sindex_value) {
+        const ql::datum_t &sindex_value) {
     cond_t dummy_interruptor;
     read_token_t token;
     store->new_read_token(&token);
@@ -146,7 +170,7 @@ ql::grouped_t<ql::stream_t> read_row_via_sindex(
     }
 
     rget_read_response_t res;
-    ql::datum_range_t datum_range(ql::datum_t(static_cast<double>(sindex_value)));
+    ql::datum_range_t datum_range(sindex_value);
     /* The only thing this does is have a NULL `profile::trace_t *` in it which
      * prevents to profiling code from crashing. */
     ql::env_t dummy_env(&dummy_interruptor,
@@ -176,6 +200,14 @@ ql::grouped_t<ql::stream_t> read_row_via_sindex(
     return *groups;
 }
 
+ql::grouped_t<ql::stream_t> read_row_via_sindex(
+        store_t *store,
+        const sindex_name_t &sindex_name,
+        int sindex_value) {
+    return read_row_via_sindex(
+        store, sindex_name, ql::datum_t(static_cast<double>(sindex_value)));
+}
+
 void _check_keys_are_present(store_t *store,
         sindex_name_t sindex_name) {
     ql::configured_limits_t limits;
@@ -190,7 +222,7 @@ void _check_keys_are_present(store_t *store,
         ql::raw_stream_t *raw_stream = &stream->substreams.begin()->second.stream;
         ASSERT_EQ(1ul, raw_stream->size());
 
-        std::string expected_data = strprintf("{\"id\" : %d, \"sid\" : %d}", i, i * i);
+        std::string expected_data = make_row(i);
         rapidjson::Document expected_value;
         expected_value.Parse(expected_data.c_str());
         ASSERT_EQ(ql::to_datum(expected_value, limits, reql_version_t::LATEST),
@@ -284,6 +316,81 @@ TPTEST(RDBBtree, SindexPostConstruct) {
     check_keys_are_present(&store, sindex_name);
 }
 
+void _check_tags_are_present(store_t *store,
+        sindex_name_t sindex_name) {
+    ql::configured_limits_t limits;
+    for (int i = 0; i < TAGGED_ROWS_TO_INSERT; ++i) {
+        rapidjson::Document expected_value;
+        expected_value.Parse(make_tagged_row(i).c_str());
+        ql::datum_t expected_row =
+            ql::to_datum(expected_value, limits, reql_version_t::LATEST);
+        // Checking every tag would take a while, so we only look at a few per row.
+        for (int j : {0, i % TAGS_PER_ROW, TAGS_PER_ROW - 1}) {
+            ql::grouped_t<ql::stream_t> groups = read_row_via_sindex(
+                store, sindex_name, ql::datum_t(datum_string_t(make_tag(i, j))));
+            ASSERT_EQ(1, groups.size());
+            ql::stream_t *stream = &groups.begin()->second;
+            ASSERT_EQ(1ul, stream->substreams.size());
+            ql::raw_stream_t *raw_stream = &stream->substreams.begin()->second.stream;
+            ASSERT_EQ(1ul, raw_stream->size());
+            ASSERT_EQ(expected_row, raw_stream->front().data);
+        }
+    }
+}
+
+void check_tags_are_present(store_t *store,
+        sindex_name_t sindex_name) {
+    for (int i = 0; i < MAX_RETRIES_FOR_SINDEX_POSTCONSTRUCT; ++i) {
+        try {
+            _check_tags_are_present(store, sindex_name);
+            return;
+        } catch (const sindex_not_ready_exc_t&) { }
+        nap(500);
+    }
+    ADD_FAILURE() << "Sindex still not available after many tries.";
+}
+
+/* Post-constructs a multi index that has enough entries per row for the sorted runs to
+fill up in the middle of a pass, so that they get inserted in the background while the
+traversal continues. */
+TPTEST(RDBBtree, SindexPostConstructLargeRuns) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE);
+
+    insert_rows(0, TAGGED_ROWS_TO_INSERT, &store, &make_tagged_row);
+
+    sindex_name_t sindex_name =
+        create_sindex(&store, "tags", sindex_multi_bool_t::MULTI);
+
+    check_tags_are_present(&store, sindex_name);
+}
+
 TPTEST(RDBBtree, SindexEraseRange) {
     recreate_temporary_directory(base_path_t("."));
     temp_file_t temp_file;
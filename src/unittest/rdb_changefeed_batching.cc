@@ -0,0 +1,119 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/disk.hpp"
+#include "arch/timing.hpp"
+#include "buffer_cache/cache_balancer.hpp"
+#include "rdb_protocol/changefeed.hpp"
+#include "rdb_protocol/store.hpp"
+#include "rpc/mailbox/typed.hpp"
+#include "serializer/log/log_serializer.hpp"
+#include "unittest/clustering_utils.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+using ql::changefeed::msg_t;
+using ql::changefeed::stamped_msg_t;
+
+void send_change(ql::changefeed::server_t *server,
+                 store_t *store,
+                 size_t i,
+                 const auto_drainer_t::lock_t &keepalive) {
+    rwlock_in_line_t stamp_spot(&store->cfeed_stamp_lock, access_t::write);
+    server->send_all(
+        msg_t(msg_t::change_t{
+            index_vals_t(),
+            index_vals_t(),
+            store_key_t(ql::datum_t(static_cast<double>(i)).print_primary()),
+            ql::datum_t(),
+            ql::datum_t(static_cast<double>(i))}),
+        store_key_t(ql::datum_t(static_cast<double>(i)).print_primary()),
+        &stamp_spot,
+        keepalive);
+}
+
+/* Checks that `batch` holds the changes `first` to `first + size - 1`, in order. */
+void check_batch(const std::vector<stamped_msg_t> &batch,
+                 const uuid_u &server_uuid,
+                 size_t first,
+                 size_t size) {
+    ASSERT_EQ(size, batch.size());
+    for (size_t i = 0; i < size; ++i) {
+        EXPECT_EQ(server_uuid, batch[i].server_uuid);
+        EXPECT_EQ(first + i, batch[i].stamp);
+        const msg_t::change_t *change =
+            boost::get<msg_t::change_t>(&batch[i].submsg.op);
+        ASSERT_TRUE(change != nullptr);
+        EXPECT_EQ(ql::datum_t(static_cast<double>(first + i)), change->new_val);
+    }
+}
+
+TPTEST(RDBChangefeed, ServerBatchesChanges) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE);
+
+    simple_mailbox_cluster_t cluster;
+    std::vector<std::vector<stamped_msg_t> > batches;
+    mailbox_t<void(std::vector<stamped_msg_t>)> client_mailbox(
+        cluster.get_mailbox_manager(),
+        [&](signal_t *, std::vector<stamped_msg_t> batch) {
+            batches.push_back(std::move(batch));
+        });
+
+    const int64_t window_ms = 200;
+    const size_t max_msgs = 4;
+    ql::changefeed::server_t server(
+        cluster.get_mailbox_manager(), &store, window_ms, max_msgs);
+    auto_drainer_t::lock_t keepalive = server.get_keepalive();
+    server.add_client(client_mailbox.get_address(), region_t::universe(), keepalive);
+
+    /* Fewer changes than fit into a batch wait for the window to pass. */
+    for (size_t i = 0; i < max_msgs - 1; ++i) {
+        send_change(&server, &store, i, keepalive);
+    }
+    nap(window_ms / 10);
+    EXPECT_TRUE(batches.empty());
+    nap(window_ms * 2);
+    ASSERT_EQ(1u, batches.size());
+    check_batch(batches[0], server.get_uuid(), 0, max_msgs - 1);
+
+    /* A full batch is sent right away. */
+    for (size_t i = max_msgs - 1; i < 2 * max_msgs - 1; ++i) {
+        send_change(&server, &store, i, keepalive);
+    }
+    nap(window_ms / 10);
+    ASSERT_EQ(2u, batches.size());
+    check_batch(batches[1], server.get_uuid(), max_msgs - 1, max_msgs);
+
+    /* The flush that the first of those changes scheduled has nothing left to send. */
+    nap(window_ms * 2);
+    EXPECT_EQ(2u, batches.size());
+}
+
+}  // namespace unittest
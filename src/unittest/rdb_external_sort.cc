@@ -0,0 +1,90 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/disk.hpp"
+#include "rdb_protocol/datum_stream.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/order_util.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+/* Sorts rows of the form `{key: <number>, seq: <number>}` by `key`. `seq` is the
+position of the row in the input, which lets us check that the sort is stable. */
+ql::datum_t make_sort_row(size_t key, size_t seq) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("key", ql::datum_t(static_cast<double>(key)));
+    builder.overwrite("seq", ql::datum_t(static_cast<double>(seq)));
+    return std::move(builder).to_datum();
+}
+
+/* `ManyRuns` spills more runs than the sort keeps open at a time, so the runs have to
+be merged over several passes. There are only a few distinct keys, so that most rows
+tie with rows from other runs. */
+TPTEST(RDBExternalSort, ManyRuns) {
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    temp_directory_t temp_dir;
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    const ql::backtrace_id_t bt = ql::backtrace_id_t::empty();
+    ql::lt_cmp_t lt({std::make_pair(
+        ql::ASC, ql::new_get_field_func(ql::datum_t("key"), bt))});
+    counted_t<ql::external_sort_datum_stream_t> sort =
+        make_counted<ql::external_sort_datum_stream_t>(
+            &io_backender, temp_dir.path(), lt, bt);
+
+    const size_t num_runs = 300;
+    const size_t rows_per_run = 20;
+    const size_t num_keys = 37;
+    size_t seq = 0;
+    size_t max_spilled_runs = 0;
+    std::vector<ql::datum_t> rows;
+    for (size_t run = 0; run <= num_runs; ++run) {
+        for (size_t i = 0; i < rows_per_run; ++i) {
+            rows.push_back(make_sort_row((seq * 7919) % num_keys, seq));
+            ++seq;
+        }
+        if (run < num_runs) {
+            sort->spill_run(&env, &rows);
+            EXPECT_TRUE(rows.empty());
+            max_spilled_runs = std::max(max_spilled_runs, sort->num_spilled_runs());
+        } else {
+            sort->finish(&env, std::move(rows));
+        }
+    }
+    EXPECT_LE(max_spilled_runs, 64u);
+    /* 300 runs get merged into 18 runs of the first level and 12 unmerged runs, and
+    16 of the former into one run of the second level. */
+    EXPECT_EQ(15u, sort->num_spilled_runs());
+
+    std::vector<ql::datum_t> sorted;
+    for (;;) {
+        std::vector<ql::datum_t> batch = sort->next_batch(&env, ql::batchspec_t::all());
+        if (batch.empty()) {
+            break;
+        }
+        sorted.insert(sorted.end(), batch.begin(), batch.end());
+    }
+    EXPECT_TRUE(sort->is_exhausted());
+
+    ASSERT_EQ((num_runs + 1) * rows_per_run, sorted.size());
+    std::vector<bool> seen(sorted.size(), false);
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        const size_t row_seq = sorted[i].get_field("seq").as_int();
+        ASSERT_LT(row_seq, seen.size());
+        EXPECT_FALSE(seen[row_seq]);
+        seen[row_seq] = true;
+        if (i > 0) {
+            const double prev_key = sorted[i - 1].get_field("key").as_num();
+            const double key = sorted[i].get_field("key").as_num();
+            ASSERT_LE(prev_key, key);
+            if (prev_key == key) {
+                ASSERT_LT(sorted[i - 1].get_field("seq").as_int(), row_seq);
+            }
+        }
+    }
+}
+
+}  // namespace unittest
@@ -12,6 +12,7 @@
 #include "clustering/administration/artificial_reql_cluster_interface.hpp"
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/tables/name_resolver.hpp"
+#include "concurrency/pmap.hpp"
 #include "extproc/extproc_pool.hpp"
 #include "extproc/extproc_spawner.hpp"
 #include "rdb_protocol/changefeed.hpp"
@@ -1011,4 +1012,110 @@ TPTEST(RDBProtocol, ArtificialChangefeeds) {
     }
 }
 
+/* Two range changefeeds with the same transforms on different threads share the
+evaluation of the transforms per thread, and must each still see every change. */
+TPTEST(RDBProtocol, ArtificialChangefeedsSameTransforms, 2) {
+    using ql::changefeed::artificial_t;
+    using ql::changefeed::keyspec_t;
+    using ql::changefeed::msg_t;
+
+    extproc_pool_t extproc_pool(2);
+    dummy_semilattice_controller_t<auth_semilattice_metadata_t> auth_manager;
+    rdb_context_t rdb_context(&extproc_pool, nullptr, auth_manager.get_view());
+    artificial_reql_cluster_interface_t artificial_reql_cluster_interface(
+        auth_manager.get_view(),
+        &rdb_context);
+    dummy_semilattice_controller_t<cluster_semilattice_metadata_t> cluster_manager;
+    name_resolver_t name_resolver(
+        cluster_manager.get_view(),
+        nullptr,
+        make_lifetime(artificial_reql_cluster_interface));
+
+    class dummy_artificial_t : public artificial_t {
+    public:
+        explicit dummy_artificial_t(lifetime_t<name_resolver_t const &> name_resolver_)
+            : artificial_t(generate_uuid(), name_resolver_) { }
+        void maybe_remove() { }
+    };
+    dummy_artificial_t artificial_cfeed(make_lifetime(name_resolver));
+
+    const ql::sym_t arg(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    ql::raw_term_t mapping = r.var(arg)["v"].root_term();
+
+    /* Each thread gets its own `env_t` and subscription, and they're only used and
+    destroyed on that thread. */
+    struct thread_feed_t {
+        scoped_ptr_t<cond_t> interruptor;
+        scoped_ptr_t<ql::env_t> env;
+        counted_t<ql::datum_stream_t> feed;
+    };
+    const int num_threads = 2;
+    thread_feed_t thread_feeds[num_threads];
+    pmap(num_threads, [&](int thread) {
+        on_thread_t thread_switcher((threadnum_t(thread)));
+        thread_feed_t *tf = &thread_feeds[thread];
+        tf->interruptor.init(new cond_t);
+        tf->env.init(new ql::env_t(tf->interruptor.get(),
+                                   ql::return_empty_normal_batches_t::YES,
+                                   reql_version_t::LATEST));
+        ql::backtrace_id_t bt = ql::backtrace_id_t::empty();
+        std::vector<ql::transform_variant_t> transforms;
+        transforms.push_back(ql::map_wire_func_t(mapping, make_vector(arg)));
+        tf->feed = artificial_cfeed.subscribe(
+            tf->env.get(),
+            ql::changefeed::streamspec_t(
+                make_counted<ql::vector_datum_stream_t>(
+                    bt, std::vector<ql::datum_t>(), boost::none),
+                "test",
+                false,
+                false,
+                false,
+                ql::configured_limits_t(),
+                ql::datum_t::boolean(false),
+                keyspec_t::range_t{
+                    std::move(transforms),
+                    boost::optional<std::string>(),
+                    sorting_t::UNORDERED,
+                    ql::datumspec_t(ql::datum_range_t::universe()),
+                    boost::none}),
+            "id",
+            std::vector<ql::datum_t>(),
+            bt);
+    });
+
+    const size_t num_changes = 20;
+    for (size_t i = 0; i < num_changes; ++i) {
+        ql::datum_object_builder_t builder;
+        builder.overwrite("id", ql::datum_t(static_cast<double>(i)));
+        builder.overwrite("v", ql::datum_t(static_cast<double>(i * 10)));
+        artificial_cfeed.send_all(msg_t(msg_t::change_t{
+            index_vals_t(),
+            index_vals_t(),
+            store_key_t(ql::datum_t(static_cast<double>(i)).print_primary()),
+            ql::datum_t(),
+            std::move(builder).to_datum()}));
+    }
+
+    pmap(num_threads, [&](int thread) {
+        on_thread_t thread_switcher((threadnum_t(thread)));
+        thread_feed_t *tf = &thread_feeds[thread];
+        ql::batchspec_t bs(ql::batchspec_t::all()
+                           .with_new_batch_type(ql::batch_type_t::NORMAL)
+                           .with_max_dur(1000));
+        std::vector<ql::datum_t> changes = tf->feed->next_batch(tf->env.get(), bs);
+        EXPECT_EQ(num_changes, changes.size());
+        std::set<double> new_vals;
+        for (const ql::datum_t &change : changes) {
+            new_vals.insert(change.get_field("new_val").as_num());
+        }
+        for (size_t i = 0; i < num_changes; ++i) {
+            EXPECT_EQ(1u, new_vals.count(static_cast<double>(i * 10)));
+        }
+        tf->feed.reset();
+        tf->env.reset();
+        tf->interruptor.reset();
+    });
+}
+
 }   /* namespace unittest */
@@ -0,0 +1,93 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "containers/archive/string_stream.hpp"
+#include "containers/buffer_group.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/row_projection.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
+#include "rdb_protocol/wire_func.hpp"
+#include "stl_utils.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+std::string serialize_for_projection(const ql::datum_t &datum) {
+    string_stream_t write_stream;
+    write_message_t wm;
+    ql::datum_serialize(&wm, datum, ql::check_datum_serialization_errors_t::NO);
+    int write_res = send_write_message(&write_stream, &wm);
+    guarantee(write_res == 0);
+    return write_stream.str();
+}
+
+TEST(RowProjectionTest, Deserialization) {
+    ql::datum_object_builder_t builder;
+    for (int i = 0; i < 300; ++i) {
+        builder.overwrite(strprintf("field%03d", i).c_str(),
+                          ql::datum_t(std::string(i % 17, 'x')));
+    }
+    ql::datum_t row = std::move(builder).to_datum();
+    const std::string serialized = serialize_for_projection(row);
+
+    // Split the value up like a blob would, so that fields straddle buffers.
+    const_buffer_group_t group;
+    for (size_t offset = 0; offset < serialized.size(); offset += 1000) {
+        group.add_buffer(std::min<size_t>(1000, serialized.size() - offset),
+                         serialized.data() + offset);
+    }
+
+    std::vector<datum_string_t> fields;
+    fields.push_back(datum_string_t("field000"));
+    fields.push_back(datum_string_t("field150"));
+    fields.push_back(datum_string_t("field299"));
+    ql::datum_t projected = ql::datum_deserialize_projection(&group, fields);
+    ASSERT_TRUE(projected.has());
+    ASSERT_EQ(3u, projected.obj_size());
+    for (const datum_string_t &field : fields) {
+        EXPECT_EQ(row.get_field(field), projected.get_field(field));
+    }
+
+    // A missing field means the caller has to load the whole row.
+    fields.push_back(datum_string_t("field300"));
+    EXPECT_FALSE(ql::datum_deserialize_projection(&group, fields).has());
+
+    // So does anything that isn't an object.
+    const std::string serialized_str = serialize_for_projection(ql::datum_t("field"));
+    const_buffer_group_t str_group;
+    str_group.add_buffer(serialized_str.size(), serialized_str.data());
+    EXPECT_FALSE(ql::datum_deserialize_projection(
+        &str_group, std::vector<datum_string_t>()).has());
+}
+
+TEST(RowProjectionTest, Inference) {
+    const ql::sym_t arg(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    std::vector<ql::transform_variant_t> transforms;
+    transforms.push_back(ql::filter_wire_func_t(
+        ql::map_wire_func_t(
+            (r.var(arg)["age"] > 30.0).root_term(), make_vector(arg)),
+        boost::none));
+    transforms.push_back(ql::map_wire_func_t(
+        r.var(arg).pluck("name", "age").root_term(), make_vector(arg)));
+
+    boost::optional<std::vector<datum_string_t> > projection =
+        ql::infer_row_projection(transforms, boost::none);
+    ASSERT_TRUE(static_cast<bool>(projection));
+    ASSERT_EQ(2u, projection->size());
+    EXPECT_EQ(datum_string_t("age"), (*projection)[0]);
+    EXPECT_EQ(datum_string_t("name"), (*projection)[1]);
+
+    // Without the `map`, the rows are returned as they are.
+    transforms.pop_back();
+    EXPECT_FALSE(static_cast<bool>(ql::infer_row_projection(transforms, boost::none)));
+    EXPECT_TRUE(static_cast<bool>(ql::infer_row_projection(
+        transforms, ql::terminal_variant_t(ql::count_wire_func_t()))));
+
+    // The `map` uses the whole row.
+    transforms.push_back(ql::map_wire_func_t(
+        r.var(arg).merge(r.object(r.optarg("x", 1.0))).root_term(),
+        make_vector(arg)));
+    EXPECT_FALSE(static_cast<bool>(ql::infer_row_projection(transforms, boost::none)));
+}
+
+}  // namespace unittest
@@ -387,33 +387,39 @@ TPTEST(RPCConnectivityTest, Multiplexer) {
     c2aB.expect_undelivered(10065);
 }
 
-/* `BinaryData` makes sure that any octet can be sent over the wire. */
+/* `BinaryData` makes sure that any octet can be sent over the wire. The spectrum
+can be sent several times in one message, to make it large enough to be compressed. */
 
 class binary_test_application_t : public cluster_message_handler_t {
 public:
-    explicit binary_test_application_t(connectivity_cluster_t *cm) :
+    explicit binary_test_application_t(connectivity_cluster_t *cm, int _repeats = 1) :
         cluster_message_handler_t(cm, 'B'),
+        repeats(_repeats),
         got_spectrum(false)
         { }
     void send_spectrum(peer_id_t peer) {
         class dump_spectrum_writer_t :
             public cluster_send_message_write_callback_t {
         public:
+            explicit dump_spectrum_writer_t(int _repeats) : repeats(_repeats) { }
             virtual ~dump_spectrum_writer_t() { }
             void write(write_stream_t *stream) {
                 char spectrum[CHAR_MAX - CHAR_MIN + 1];
                 for (int i = CHAR_MIN; i <= CHAR_MAX; i++) {
                     spectrum[i - CHAR_MIN] = i;
                 }
-                int64_t res = stream->write(spectrum, CHAR_MAX - CHAR_MIN + 1);
-                if (res != CHAR_MAX - CHAR_MIN + 1) { throw fake_archive_exc_t(); }
+                for (int r = 0; r < repeats; ++r) {
+                    int64_t res = stream->write(spectrum, CHAR_MAX - CHAR_MIN + 1);
+                    if (res != CHAR_MAX - CHAR_MIN + 1) { throw fake_archive_exc_t(); }
+                }
             }
 #ifdef ENABLE_MESSAGE_PROFILER
             const char *message_profiler_tag() const {
                 return "unittest";
             }
 #endif
-        } writer;
+            int repeats;
+        } writer(repeats);
         auto_drainer_t::lock_t connection_keepalive;
         connectivity_cluster_t::connection_t *connection =
             get_connectivity_cluster()->get_connection(peer, &connection_keepalive);
@@ -424,15 +430,18 @@ public:
     void on_message(connectivity_cluster_t::connection_t *,
                     auto_drainer_t::lock_t,
                     read_stream_t *stream) {
-        char spectrum[CHAR_MAX - CHAR_MIN + 1];
-        int64_t res = force_read(stream, spectrum, CHAR_MAX - CHAR_MIN + 1);
-        if (res != CHAR_MAX - CHAR_MIN + 1) { throw fake_archive_exc_t(); }
+        for (int r = 0; r < repeats; ++r) {
+            char spectrum[CHAR_MAX - CHAR_MIN + 1];
+            int64_t res = force_read(stream, spectrum, CHAR_MAX - CHAR_MIN + 1);
+            if (res != CHAR_MAX - CHAR_MIN + 1) { throw fake_archive_exc_t(); }
 
-        for (int i = CHAR_MIN; i <= CHAR_MAX; i++) {
-            EXPECT_EQ(spectrum[i - CHAR_MIN], i);
+            for (int i = CHAR_MIN; i <= CHAR_MAX; i++) {
+                EXPECT_EQ(spectrum[i - CHAR_MIN], i);
+            }
         }
         got_spectrum = true;
     }
+    int repeats;
     bool got_spectrum;
 };
 
@@ -452,6 +461,59 @@ TPTEST_MULTITHREAD(RPCConnectivityTest, BinaryData, 3) {
     EXPECT_TRUE(a2.got_spectrum);
 }
 
+/* `CompressedData` sends a large message between servers that compress their
+messages, and between one that does and one that doesn't. Only the former should take
+up fewer bytes on the wire. */
+TPTEST_MULTITHREAD(RPCConnectivityTest, CompressedData, 3) {
+    connectivity_cluster_t c1, c2, c3;
+    binary_test_application_t a1(&c1, 64), a2(&c2, 64), a3(&c3, 64);
+    test_cluster_run_t cr1(&c1, peer_address_t(), true);
+    test_cluster_run_t cr2(&c2, peer_address_t(), true);
+    test_cluster_run_t cr3(&c3);
+    cr1.join(get_cluster_local_address(&c2), 0);
+    cr3.join(get_cluster_local_address(&c2), 0);
+
+    let_stuff_happen();
+
+    a1.send_spectrum(c2.get_me());
+    a2.send_spectrum(c3.get_me());
+    a3.send_spectrum(c1.get_me());
+
+    let_stuff_happen();
+
+    EXPECT_TRUE(a1.got_spectrum);
+    EXPECT_TRUE(a2.got_spectrum);
+    EXPECT_TRUE(a3.got_spectrum);
+
+    auto get_bytes_sent = [](connectivity_cluster_t *from, connectivity_cluster_t *to,
+                             int64_t *before_out, int64_t *after_out) {
+        auto_drainer_t::lock_t connection_keepalive;
+        connectivity_cluster_t::connection_t *connection =
+            from->get_connection(to->get_me(), &connection_keepalive);
+        ASSERT_TRUE(connection != nullptr);
+        ql::datum_t stats = connection->get_stats();
+        *before_out = stats.get_field("bytes_sent_before_compression_total").as_int();
+        *after_out = stats.get_field("bytes_sent_after_compression_total").as_int();
+    };
+    const int64_t spectrum_size = 64 * (CHAR_MAX - CHAR_MIN + 1);
+    int64_t before, after;
+
+    /* `c1` and `c2` both compress, so the spectrum shrinks on the wire. */
+    get_bytes_sent(&c1, &c2, &before, &after);
+    EXPECT_GE(before, spectrum_size);
+    EXPECT_LT(after, before - spectrum_size / 2);
+
+    /* `c3` can't decompress, so `c2` sends to it uncompressed. */
+    get_bytes_sent(&c2, &c3, &before, &after);
+    EXPECT_GE(before, spectrum_size);
+    EXPECT_EQ(before, after);
+
+    /* `c3` doesn't compress. */
+    get_bytes_sent(&c3, &c1, &before, &after);
+    EXPECT_GE(before, spectrum_size);
+    EXPECT_EQ(before, after);
+}
+
 /* `PeerIDSemantics` makes sure that `peer_id_t::is_nil()` works as expected. */
 TPTEST_MULTITHREAD(RPCConnectivityTest, PeerIDSemantics, 3) {
     peer_id_t nil_peer;
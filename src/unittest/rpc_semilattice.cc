@@ -29,6 +29,15 @@ inline void semilattice_join(sl_int_t *a, sl_int_t b) {
     a->i |= b.i;
 }
 
+inline bool operator==(const sl_int_t &a, const sl_int_t &b) {
+    return a.i == b.i;
+}
+
+inline void semilattice_delta(const sl_int_t &base, const sl_int_t &added,
+                              sl_int_t *delta_out) {
+    delta_out->i = added.i & ~base.i;
+}
+
 class sl_pair_t {
 public:
     sl_pair_t(sl_int_t _x, sl_int_t _y) : x(_x), y(_y) { }
@@ -96,6 +105,38 @@ TPTEST(RPCSemilatticeTest, MetadataExchange, 2) {
     EXPECT_EQ(7u, slm2.get_root_view()->get().i);
 }
 
+/* `DeltaExchange` makes sure that a series of changes is propagated as deltas in
+both directions, including changes that don't modify the metadata at all. */
+TPTEST(RPCSemilatticeTest, DeltaExchange, 2) {
+    connectivity_cluster_t cluster1, cluster2;
+    semilattice_manager_t<sl_int_t> slm1(&cluster1, 'S', sl_int_t(0)),
+                                    slm2(&cluster2, 'S', sl_int_t(0));
+    test_cluster_run_t run1(&cluster1);
+    test_cluster_run_t run2(&cluster2);
+
+    run1.join(get_cluster_local_address(&cluster2), 0);
+
+    /* Block until the connection is established */
+    signal_timer_t timeout;
+    timeout.start(1000);
+    cluster1.get_connections()->run_all_until_satisfied(
+        [](watchable_map_t<peer_id_t, connectivity_cluster_t::connection_pair_t> *map) {
+            return map->get_all().size() == 2;
+        }, &timeout);
+
+    cond_t non_interruptor;
+    for (uint64_t bit = 0; bit < 16; ++bit) {
+        slm1.get_root_view()->join(sl_int_t(uint64_t(1) << bit));
+        slm1.get_root_view()->join(sl_int_t(1));
+        slm2.get_root_view()->join(sl_int_t(uint64_t(1) << (bit + 16)));
+    }
+
+    slm1.get_root_view()->sync_to(cluster2.get_me(), &non_interruptor);
+    slm2.get_root_view()->sync_to(cluster1.get_me(), &non_interruptor);
+    EXPECT_EQ(0xffffffffu, slm1.get_root_view()->get().i);
+    EXPECT_EQ(0xffffffffu, slm2.get_root_view()->get().i);
+}
+
 TPTEST(RPCSemilatticeTest, SyncFrom, 2) {
     connectivity_cluster_t cluster1, cluster2;
     semilattice_manager_t<sl_int_t> slm1(&cluster1, 'S', sl_int_t(1)),
@@ -146,6 +187,28 @@ TPTEST(RPCSemilatticeTest, Watcher, 2) {
     EXPECT_TRUE(have_been_notified);
 }
 
+/* `MapDelta` tests the `semilattice_delta()` of `std::map`. */
+
+TEST(RPCSemilatticeTest, MapDelta) {
+    std::map<std::string, sl_int_t> base, added, delta;
+    base["foo"] = sl_int_t(1);
+    base["bar"] = sl_int_t(2);
+    added["foo"] = sl_int_t(1);
+    added["bar"] = sl_int_t(3);
+    added["baz"] = sl_int_t(4);
+
+    semilattice_delta(base, added, &delta);
+    EXPECT_EQ(0u, delta.count("foo"));
+    ASSERT_EQ(1u, delta.count("bar"));
+    EXPECT_EQ(3u, delta["bar"].i);
+    ASSERT_EQ(1u, delta.count("baz"));
+    EXPECT_EQ(4u, delta["baz"].i);
+
+    semilattice_join(&base, delta);
+    semilattice_delta(base, added, &delta);
+    EXPECT_TRUE(delta.empty());
+}
+
 /* `ViewController` tests `dummy_semilattice_controller_t`. */
 
 TPTEST_MULTITHREAD(RPCSemilatticeTest, ViewController, 3) {
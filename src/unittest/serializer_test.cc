@@ -1,7 +1,11 @@
 #include <functional>
 
+#include "arch/runtime/runtime.hpp"
 #include "arch/runtime/starter.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "concurrency/pmap.hpp"
+#include "perfmon/perfmon.hpp"
+#include "rdb_protocol/datum.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "unittest/mock_file.hpp"
@@ -90,5 +94,158 @@ TEST(SerializerTest, AddDeleteRepeatedlyWithIndex) {
     run_in_thread_pool(std::bind(run_AddDeleteRepeatedly, true), 4);
 }
 
+void write_blocks_and_index(log_serializer_t *ser, file_account_t *account,
+                            const std::vector<buf_write_info_t> &infos,
+                            std::vector<counted_t<standard_block_token_t> > *tokens_out) {
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+
+    *tokens_out = ser->block_writes(infos, account, &cb);
+    cb.wait();
+
+    std::vector<index_write_op_t> write_ops;
+    for (size_t i = 0; i < infos.size(); ++i) {
+        write_ops.push_back(index_write_op_t(infos[i].block_id, (*tokens_out)[i],
+                                             repli_timestamp_t::distant_past));
+    }
+    new_mutex_in_line_t dummy_acq;
+    ser->index_write(&dummy_acq, []{ }, write_ops);
+}
+
+TPTEST(SerializerTest, CompressedBlocks, 4) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+
+    // Block 0 compresses well, block 1 doesn't compress at all, and block 2 is a
+    // small block that doesn't take up more than one device block to begin with.
+    std::vector<buf_ptr_t> bufs;
+    {
+        log_serializer_t::dynamic_config_t config;
+        config.block_codec = block_codec_t::zlib;
+        log_serializer_t ser(config, &file_opener, &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+
+        bufs.push_back(buf_ptr_t::alloc_zeroed(ser.max_block_size()));
+        bufs.push_back(buf_ptr_t::alloc_zeroed(ser.max_block_size()));
+        bufs.push_back(buf_ptr_t::alloc_zeroed(block_size_t::make_from_cache(100)));
+        char *const data0 = static_cast<char *>(bufs[0].cache_data());
+        char *const data1 = static_cast<char *>(bufs[1].cache_data());
+        char *const data2 = static_cast<char *>(bufs[2].cache_data());
+        rng_t rng;
+        for (uint32_t i = 0; i < ser.max_block_size().value(); ++i) {
+            data0[i] = 'a' + (i / 64) % 4;
+            data1[i] = rng.randint(256);
+        }
+        memset(data2, 'x', 100);
+
+        std::vector<buf_write_info_t> infos;
+        for (size_t i = 0; i < bufs.size(); ++i) {
+            infos.push_back(buf_write_info_t(bufs[i].ser_buffer(), bufs[i].block_size(),
+                                             i));
+        }
+        std::vector<counted_t<standard_block_token_t> > tokens;
+        write_blocks_and_index(&ser, account.get(), infos, &tokens);
+
+        ASSERT_EQ(bufs.size(), tokens.size());
+        EXPECT_GT(tokens[0]->block_size().ser_value(),
+                  tokens[0]->disk_block_size().ser_value());
+        EXPECT_EQ(tokens[1]->block_size(), tokens[1]->disk_block_size());
+        EXPECT_EQ(tokens[2]->block_size(), tokens[2]->disk_block_size());
+
+        for (size_t i = 0; i < bufs.size(); ++i) {
+            buf_ptr_t read_buf = ser.block_read(tokens[i], account.get());
+            ASSERT_EQ(bufs[i].block_size(), read_buf.block_size());
+            EXPECT_EQ(0, memcmp(bufs[i].ser_buffer(), read_buf.ser_buffer(),
+                                bufs[i].block_size().ser_value()));
+        }
+    }
+
+    // The blocks can still be read after restarting without compression, and the
+    // cache still gets to see their decompressed size.
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(), &file_opener,
+                             &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+
+        for (size_t i = 0; i < bufs.size(); ++i) {
+            counted_t<standard_block_token_t> token = ser.index_read(i);
+            ASSERT_TRUE(token.has());
+            ASSERT_EQ(bufs[i].block_size(), token->block_size());
+            buf_ptr_t read_buf = ser.block_read(token, account.get());
+            ASSERT_EQ(bufs[i].block_size(), read_buf.block_size());
+            EXPECT_EQ(0, memcmp(bufs[i].ser_buffer(), read_buf.ser_buffer(),
+                                bufs[i].block_size().ser_value()));
+        }
+    }
+}
+
+// Returns the value of the `serializer_coalesced_block_reads` stat of the serializer
+// whose stats are in `stats`.
+int64_t get_coalesced_block_reads(perfmon_collection_t *stats) {
+    void *ctx = stats->begin_stats();
+    pmap(get_num_threads(), [&](int thread) {
+        on_thread_t thread_switcher((threadnum_t(thread)));
+        stats->visit_stats(ctx);
+    });
+    ql::datum_t datum = stats->end_stats(ctx);
+    return datum.get_field("serializer").get_field(
+        "serializer_coalesced_block_reads").as_int();
+}
+
+TPTEST(SerializerTest, ConcurrentReads, 4) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    perfmon_collection_t stats;
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(), &file_opener, &stats);
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+
+    // The blocks are written together, so they end up next to each other on disk and
+    // reading them concurrently lets the serializer merge the reads.
+    const size_t num_blocks = 40;
+    std::vector<buf_ptr_t> bufs;
+    std::vector<buf_write_info_t> infos;
+    for (size_t i = 0; i < num_blocks; ++i) {
+        bufs.push_back(buf_ptr_t::alloc_zeroed(ser.max_block_size()));
+        memset(bufs[i].cache_data(), 'a' + i % 26, ser.max_block_size().value());
+        infos.push_back(buf_write_info_t(bufs[i].ser_buffer(), bufs[i].block_size(),
+                                         i));
+    }
+    std::vector<counted_t<standard_block_token_t> > tokens;
+    write_blocks_and_index(&ser, account.get(), infos, &tokens);
+
+    // Every other block, the blocks at both ends, and then everything.  The first read
+    // of each set goes to disk right away.  The others arrive while it is in flight
+    // and get merged, except for the two blocks at the ends, which are too far apart.
+    std::vector<std::vector<size_t> > read_sets(3);
+    const std::vector<int64_t> expected_coalesced_reads = {
+        static_cast<int64_t>(num_blocks / 2 - 1),
+        0,
+        static_cast<int64_t>(num_blocks - 1) };
+    for (size_t i = 0; i < num_blocks; i += 2) {
+        read_sets[0].push_back(i);
+    }
+    read_sets[1].push_back(0);
+    read_sets[1].push_back(num_blocks - 1);
+    for (size_t i = 0; i < num_blocks; ++i) {
+        read_sets[2].push_back(i);
+    }
+
+    for (size_t k = 0; k < read_sets.size(); ++k) {
+        const std::vector<size_t> &read_set = read_sets[k];
+        const int64_t coalesced_reads_before = get_coalesced_block_reads(&stats);
+        pmap(read_set.size(), [&](size_t j) {
+            const size_t i = read_set[j];
+            buf_ptr_t read_buf = ser.block_read(tokens[i], account.get());
+            ASSERT_EQ(bufs[i].block_size(), read_buf.block_size());
+            EXPECT_EQ(0, memcmp(bufs[i].ser_buffer(), read_buf.ser_buffer(),
+                                bufs[i].block_size().ser_value()));
+        });
+        EXPECT_EQ(expected_coalesced_reads[k],
+                  get_coalesced_block_reads(&stats) - coalesced_reads_before);
+    }
+}
 
 }  // namespace unittest